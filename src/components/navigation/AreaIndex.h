@@ -0,0 +1,224 @@
+/*
+ Copyright (C) 2014 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef AREAINDEX_H_
+#define AREAINDEX_H_
+
+#include <wfmath/axisbox.h>
+#include <wfmath/rotbox.h>
+#include <wfmath/intersect.h>
+
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace Ember
+{
+namespace Navigation
+{
+
+/**
+ * @brief A uniform grid spatial index of 2d areas, keyed by some kind of identifier.
+ *
+ * Each area is registered in all grid cells its bounding box overlaps, which makes it cheap to find all areas
+ * within a small extent even when there are many areas in total.
+ * The cell size should preferably be about the same as the size of the extents normally queried.
+ *
+ * @tparam KeyT The key type. Must be hashable.
+ */
+template <typename KeyT>
+class AreaIndex
+{
+public:
+
+	/**
+	 * @brief Ctor.
+	 * @param cellSize The size of each grid cell, in world units.
+	 */
+	explicit AreaIndex(float cellSize) :
+			mCellSize(cellSize)
+	{
+	}
+
+	/**
+	 * @brief Adds an area, or replaces the existing area if the key already is registered.
+	 * @param key The key.
+	 * @param area The area.
+	 * @return True if the key wasn't registered before.
+	 */
+	bool insert(const KeyT& key, const WFMath::RotBox<2>& area)
+	{
+		auto result = mEntries.insert(std::make_pair(key, Entry()));
+		Entry& entry = result.first->second;
+		if (!result.second) {
+			removeFromCells(entry);
+		}
+		entry.area = area;
+		auto bbox = area.boundingBox();
+		entry.minX = cellIndex(bbox.lowCorner().x());
+		entry.maxX = cellIndex(bbox.highCorner().x());
+		entry.minY = cellIndex(bbox.lowCorner().y());
+		entry.maxY = cellIndex(bbox.highCorner().y());
+		for (int x = entry.minX; x <= entry.maxX; ++x) {
+			for (int y = entry.minY; y <= entry.maxY; ++y) {
+				mCells[cellKey(x, y)].push_back(&entry);
+			}
+		}
+		return result.second;
+	}
+
+	/**
+	 * @brief Removes an area.
+	 * @param key The key.
+	 * @return True if there was an area registered for the key.
+	 */
+	bool erase(const KeyT& key)
+	{
+		auto I = mEntries.find(key);
+		if (I == mEntries.end()) {
+			return false;
+		}
+		removeFromCells(I->second);
+		mEntries.erase(I);
+		return true;
+	}
+
+	/**
+	 * @brief Gets the area registered for the key.
+	 * @param key The key.
+	 * @return The area, or null if there's none registered.
+	 */
+	const WFMath::RotBox<2>* find(const KeyT& key) const
+	{
+		auto I = mEntries.find(key);
+		if (I == mEntries.end()) {
+			return nullptr;
+		}
+		return &I->second.area;
+	}
+
+	/**
+	 * @brief Finds all areas which are contained in or intersect the extent.
+	 * @param extent An extent in world units.
+	 * @param areas The found areas are added to this.
+	 */
+	void query(const WFMath::AxisBox<2>& extent, std::vector<WFMath::RotBox<2>>& areas) const
+	{
+		int minX = cellIndex(extent.lowCorner().x());
+		int maxX = cellIndex(extent.highCorner().x());
+		int minY = cellIndex(extent.lowCorner().y());
+		int maxY = cellIndex(extent.highCorner().y());
+		for (int x = minX; x <= maxX; ++x) {
+			for (int y = minY; y <= maxY; ++y) {
+				auto I = mCells.find(cellKey(x, y));
+				if (I == mCells.end()) {
+					continue;
+				}
+				for (const Entry* entry : I->second) {
+					//An area spanning many cells should only be reported once; do that in the first cell of the query it's in.
+					if (x != std::max(entry->minX, minX) || y != std::max(entry->minY, minY)) {
+						continue;
+					}
+					if (WFMath::Contains(extent, entry->area, false) || WFMath::Intersect(extent, entry->area, false)) {
+						areas.push_back(entry->area);
+					}
+				}
+			}
+		}
+	}
+
+	/**
+	 * @brief Gets the number of registered areas.
+	 * @return The number of areas.
+	 */
+	size_t size() const
+	{
+		return mEntries.size();
+	}
+
+	/**
+	 * @brief Removes all areas.
+	 */
+	void clear()
+	{
+		mEntries.clear();
+		mCells.clear();
+	}
+
+private:
+
+	struct Entry
+	{
+		WFMath::RotBox<2> area;
+		int minX;
+		int maxX;
+		int minY;
+		int maxY;
+	};
+
+	/**
+	 * @brief The size of each cell.
+	 */
+	float mCellSize;
+
+	/**
+	 * @brief All registered areas.
+	 *
+	 * Since elements in an unordered_map never are moved the cells can hold pointers to the entries.
+	 */
+	std::unordered_map<KeyT, Entry> mEntries;
+
+	/**
+	 * @brief The grid cells, with the entries overlapping each cell.
+	 */
+	std::unordered_map<int64_t, std::vector<const Entry*>> mCells;
+
+	int cellIndex(float coord) const
+	{
+		return static_cast<int>(std::floor(coord / mCellSize));
+	}
+
+	static int64_t cellKey(int x, int y)
+	{
+		return (static_cast<int64_t>(x) << 32) | static_cast<uint32_t>(y);
+	}
+
+	void removeFromCells(const Entry& entry)
+	{
+		for (int x = entry.minX; x <= entry.maxX; ++x) {
+			for (int y = entry.minY; y <= entry.maxY; ++y) {
+				auto I = mCells.find(cellKey(x, y));
+				if (I != mCells.end()) {
+					auto& cell = I->second;
+					cell.erase(std::remove(cell.begin(), cell.end(), &entry), cell.end());
+					if (cell.empty()) {
+						mCells.erase(I);
+					}
+				}
+			}
+		}
+	}
+
+};
+
+}
+}
+
+#endif /* AREAINDEX_H_ */
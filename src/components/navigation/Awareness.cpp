@@ -59,6 +59,10 @@
 
 #include "Awareness.h"
 #include "AwarenessUtils.h"
+#include "AreaIndex.h"
+#include "PathCorridor.h"
+#include "ObstacleAvoidanceSampler.h"
+#include "TileMemoryTracker.h"
 
 #include "DetourNavMesh.h"
 #include "DetourNavMeshQuery.h"
@@ -73,9 +77,14 @@
 
 #include "framework/LoggingInstance.h"
 #include "framework/Exception.h"
+#include "framework/Profiler.h"
+#include "framework/tasks/TaskQueue.h"
+#include "framework/tasks/ITask.h"
 
 #include <Eris/View.h>
+#include <Eris/EventService.h>
 #include <Eris/Avatar.h>
+#include <Eris/Connection.h>
 #include <Eris/Entity.h>
 #include <wfmath/wfmath.h>
 
@@ -83,19 +92,20 @@
 
 #include <sigc++/bind.h>
 
-#include <boost/multi_index_container.hpp>
-#include <boost/multi_index/hashed_index.hpp>
-#include <boost/multi_index/identity.hpp>
-#include <boost/multi_index/sequenced_index.hpp>
-
 #include <cmath>
 #include <vector>
+#include <algorithm>
 #include <cstring>
 #include <queue>
+#include <chrono>
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
 
 #define MAX_PATHPOLY      256 // max number of polygons in a path
 #define MAX_PATHVERT      512 // most verts in a path
-#define MAX_OBSTACLES_CIRCLES 4 // max number of circle obstacles to consider when doing avoidance
+#define MAX_OBSTACLES_CIRCLES 16 // max number of circle obstacles to consider when doing avoidance
 namespace Ember
 {
 namespace Navigation
@@ -104,44 +114,35 @@ namespace Navigation
 // This value specifies how many layers (or "floors") each navmesh tile is expected to have.
 static const int EXPECTED_LAYERS_PER_TILE = 1;
 
-using namespace boost::multi_index;
+// Identifies files in the tile disk cache.
+static const char TILE_CACHE_MAGIC[4] = { 'E', 'N', 'A', 'V' };
 
 /**
- * @brief A Most Recently Used list implemented using boost::multi_index.
- *
+ * @brief Calculates the distance from a point to a line segment.
  */
-template<typename TItem>
-class MRUList
+static float distanceToSegment(const WFMath::Point<2>& point, const WFMath::Segment<2>& segment)
 {
-public:
-
-	void insert(const TItem& item)
-	{
-		auto p = mItems.push_front(item);
-
-		if (!p.second) {
-			mItems.relocate(mItems.begin(), p.first);
-		}
-	}
-
-	TItem pop_back()
-	{
-		TItem back = mItems.back();
-		mItems.pop_back();
-		return back;
+	WFMath::Vector<2> direction = segment.endpoint(1) - segment.endpoint(0);
+	float lengthSquared = direction.sqrMag();
+	if (lengthSquared == 0) {
+		return WFMath::Distance(point, segment.endpoint(0));
 	}
+	float t = WFMath::Dot(point - segment.endpoint(0), direction) / lengthSquared;
+	t = std::max(0.0f, std::min(1.0f, t));
+	return WFMath::Distance(point, segment.endpoint(0) + (direction * t));
+}
 
-	std::size_t size() const
-	{
-		return mItems.size();
+/**
+ * @brief Adds the supplied bytes to a 64 bit FNV-1a hash.
+ */
+static void hashBytes(unsigned long long& hash, const void* data, size_t size)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
 	}
-
-
-private:
-	multi_index_container<TItem, indexed_by<sequenced<>, hashed_unique<identity<TItem> > > > mItems;
-
-};
-
+}
 
 struct InputGeometry
 {
@@ -166,11 +167,63 @@ protected:
 
 };
 
+/**
+ * @brief Rasterizes a tile in a background thread, and hands it back to the Awareness instance in the main thread.
+ */
+class TileBuildTask: public Tasks::ITask
+{
+public:
+	TileBuildTask(Awareness& awareness, TileBuildData* data) :
+			mAwareness(awareness), mData(data)
+	{
+	}
+
+	virtual ~TileBuildTask()
+	{
+		delete mData;
+	}
+
+	virtual void executeTaskInBackgroundThread(Tasks::TaskExecutionContext& context)
+	{
+		if (!mData->cachePath.empty() && Awareness::loadCachedTile(*mData)) {
+			return;
+		}
+		//Each thread needs its own context, since it keeps state.
+		AwarenessContext ctx;
+		ProfileZone zone("Awareness::rasterizeTileLayers");
+		mData->ntiles = Awareness::rasterizeTileLayers(ctx, *mData);
+		if (!mData->cachePath.empty() && mData->ntiles > 0) {
+			Awareness::saveCachedTile(*mData);
+		}
+	}
+
+	virtual void executeTaskInMainThread()
+	{
+		mAwareness.tileBuilt(mData);
+		mData = nullptr;
+	}
+
+	virtual std::string getName() const
+	{
+		return "TileBuildTask";
+	}
+
+private:
+	Awareness& mAwareness;
+	TileBuildData* mData;
+};
+
 Awareness::Awareness(Eris::View& view, IHeightProvider& heightProvider, int tileSize) :
-		mView(view), mHeightProvider(heightProvider), mAvatarEntity(view.getAvatar()->getEntity()), mCurrentLocation(mAvatarEntity->getLocation()), mTalloc(nullptr), mTcomp(nullptr), mTmproc(nullptr), mAvatarRadius(0.4f), mDesiredTilesAmount(128), mCtx(new AwarenessContext()), mTileCache(nullptr), mNavMesh(nullptr), mNavQuery(dtAllocNavMeshQuery()), mFilter(nullptr), mActiveTileList(nullptr)
+		mView(view), mHeightProvider(heightProvider), mAvatarEntity(view.getAvatar()->getEntity()), mCurrentLocation(mAvatarEntity->getLocation()), mTalloc(nullptr), mTcomp(nullptr), mTmproc(nullptr), mAvatarRadius(0.4f), mTileMemory(nullptr), mMaxTilesPerPrune(8), mCtx(new AwarenessContext()), mTileCache(nullptr), mNavMesh(nullptr), mNavQuery(dtAllocNavMeshQuery()), mFilter(nullptr), mObstacleAvoidanceSampler(nullptr), mObstacleAvoidanceParams(nullptr), mEntityAreas(nullptr), mObstacleUpdatesPending(false), mTaskQueue(nullptr), mMaxTilesInProgress(1), mCommitBudget(2000), mBulkRebuild(false), mBulkRebuildTileCount(0), mBulkRebuildThreshold(16), mTileCacheWorldId(0), mTileCacheConfigHash(0), mSlicedNavQuery(dtAllocNavMeshQuery()), mPathRequestCounter(0), mPathIterationBudget(256), mNavMeshGeneration(0)
 {
 	try {
-		mActiveTileList = new MRUList<std::pair<int, int>>();
+		mTileMemory = new TileMemoryTracker(16 * 1024 * 1024);
+
+		//Leave one core for the main thread, but use at least one thread for building tiles.
+		int numberOfThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+		mTaskQueue = new Tasks::TaskQueue(numberOfThreads, view.getEventService());
+		//Keep the threads busy while the main thread gathers input for the next tile.
+		mMaxTilesInProgress = numberOfThreads * 2;
 
 		mTalloc = new LinearAllocator(128000);
 		mTcomp = new FastLZCompressor;
@@ -242,6 +295,8 @@ Awareness::Awareness(Eris::View& view, IHeightProvider& heightProvider, int tile
 		mCfg.borderSize = mCfg.walkableRadius + 3; // Reserve enough padding.
 		mCfg.width = mCfg.tileSize + mCfg.borderSize * 2;
 		mCfg.height = mCfg.tileSize + mCfg.borderSize * 2;
+
+		mEntityAreas = new AreaIndex<Eris::Entity*>(mCfg.tileSize * mCfg.cs);
 	//	m_cfg.detailSampleDist = m_detailSampleDist < 0.9f ? 0 : m_cfg.cs * m_detailSampleDist;
 	//	m_cfg.detailSampleMaxError = m_cfg.m_cellHeight * m_detailSampleMaxError;
 
@@ -258,7 +313,8 @@ Awareness::Awareness(Eris::View& view, IHeightProvider& heightProvider, int tile
 		tcparams.walkableClimb = mCfg.walkableClimb;
 	//	tcparams.maxSimplificationError = m_edgeMaxError;
 		tcparams.maxTiles = tilewidth * tileheight * EXPECTED_LAYERS_PER_TILE;
-		tcparams.maxObstacles = 128;
+		//Moved entities are represented as obstacles, so make sure there's room for a fair amount of them.
+		tcparams.maxObstacles = 1024;
 
 		dtFreeTileCache(mTileCache);
 
@@ -298,8 +354,12 @@ Awareness::Awareness(Eris::View& view, IHeightProvider& heightProvider, int tile
 			throw Exception("buildTiledNavigation: Could not init Detour navmesh query");
 		}
 
-		mObstacleAvoidanceQuery = dtAllocObstacleAvoidanceQuery();
-		mObstacleAvoidanceQuery->init(MAX_OBSTACLES_CIRCLES, 0);
+		status = mSlicedNavQuery->init(mNavMesh, 2048);
+		if (dtStatusFailed(status)) {
+			throw Exception("buildTiledNavigation: Could not init Detour sliced navmesh query");
+		}
+
+		mObstacleAvoidanceSampler = new ObstacleAvoidanceSampler(MAX_OBSTACLES_CIRCLES);
 
 		mObstacleAvoidanceParams = new dtObstacleAvoidanceParams;
 		mObstacleAvoidanceParams->velBias = 0.4f;
@@ -347,15 +407,22 @@ Awareness::Awareness(Eris::View& view, IHeightProvider& heightProvider, int tile
 
 		EmberEntity* entity = static_cast<EmberEntity*>(mView.getTopLevel());
 		entity->accept(attachListenersFunction);
+		std::map<Eris::Entity*, WFMath::RotBox<2>> areas;
 		for (size_t i = 0; i < entity->numContained(); ++i) {
-			buildEntityAreas(*entity->getContained(i), mEntityAreas);
+			buildEntityAreas(*entity->getContained(i), areas);
+		}
+		for (auto& entry : areas) {
+			mEntityAreas->insert(entry.first, entry.second);
 		}
 	} catch (const std::exception& e) {
+		delete mTaskQueue;
+
 		delete mObstacleAvoidanceParams;
-		dtFreeObstacleAvoidanceQuery(mObstacleAvoidanceQuery);
+		delete mObstacleAvoidanceSampler;
 
 		dtFreeNavMesh(mNavMesh);
 		dtFreeNavMeshQuery(mNavQuery);
+		dtFreeNavMeshQuery(mSlicedNavQuery);
 		delete mFilter;
 
 		dtFreeTileCache(mTileCache);
@@ -365,7 +432,8 @@ Awareness::Awareness(Eris::View& view, IHeightProvider& heightProvider, int tile
 		delete mTalloc;
 
 		delete mCtx;
-		delete mActiveTileList;
+		delete mEntityAreas;
+		delete mTileMemory;
 		throw;
 	}
 }
@@ -382,11 +450,18 @@ Awareness::~Awareness()
 		observed.second.beingDeleted.disconnect();
 	}
 
+	//Deleting the queue will wait for all tiles being built, which then will be handed to tileBuilt().
+	delete mTaskQueue;
+	for (auto data : mBuiltTiles) {
+		delete data;
+	}
+
 	delete mObstacleAvoidanceParams;
-	dtFreeObstacleAvoidanceQuery(mObstacleAvoidanceQuery);
+	delete mObstacleAvoidanceSampler;
 
 	dtFreeNavMesh(mNavMesh);
 	dtFreeNavMeshQuery(mNavQuery);
+	dtFreeNavMeshQuery(mSlicedNavQuery);
 	delete mFilter;
 
 	dtFreeTileCache(mTileCache);
@@ -396,7 +471,8 @@ Awareness::~Awareness()
 	delete mTalloc;
 
 	delete mCtx;
-	delete mActiveTileList;
+	delete mEntityAreas;
+	delete mTileMemory;
 }
 
 void Awareness::View_EntitySeen(Eris::Entity* entity)
@@ -422,7 +498,7 @@ void Awareness::View_EntitySeen(Eris::Entity* entity)
 				buildEntityAreas(*entity, areas);
 				for (auto& entry : areas) {
 					markTilesAsDirty(entry.second.boundingBox());
-					mEntityAreas.insert(entry);
+					mEntityAreas->insert(entry.first, entry.second);
 				}
 
 				connections.moved = entity->Moved.connect(sigc::bind(sigc::mem_fun(*this, &Awareness::Entity_Moved), entity));
@@ -445,26 +521,49 @@ void Awareness::Entity_Moved(Eris::Entity* entity)
 		//No need to listen to more Moved events.
 		I->second.moved.disconnect();
 		I->second.isMoving = true;
-		auto existingI = mEntityAreas.find(entity);
-		if (existingI != mEntityAreas.end()) {
-			//The entity already was registered; mark those tiles where the entity previously were as dirty.
-			markTilesAsDirty(existingI->second.boundingBox());
-			mEntityAreas.erase(entity);
+		if (!removeDynamicObstacle(entity)) {
+			auto existingArea = mEntityAreas->find(entity);
+			if (existingArea) {
+				//The entity already was registered; mark those tiles where the entity previously were as dirty.
+				markTilesAsDirty(existingArea->boundingBox());
+				mEntityAreas->erase(entity);
+			}
 		}
 	} else {
 		std::map<Eris::Entity*, WFMath::RotBox<2>> areas;
 
 		buildEntityAreas(*entity, areas);
 
+		auto obstacleI = mDynamicObstacles.find(entity);
+		if (obstacleI != mDynamicObstacles.end()) {
+			auto areaI = areas.find(entity);
+			if (areaI != areas.end() && canBeObstacle(areaI->second)) {
+				//Just move the obstacle; there's no need to rebuild any tiles.
+				obstacleI->second.area = areaI->second;
+				markObstacleAsDirty(entity);
+				return;
+			}
+			//The entity can't be represented as an obstacle anymore, so treat it as static geometry again.
+			removeDynamicObstacle(entity);
+		}
+
 		for (auto& entry : areas) {
-			markTilesAsDirty(entry.second.boundingBox());
-			auto existingI = mEntityAreas.find(entry.first);
-			if (existingI != mEntityAreas.end()) {
-				//The entity already was registered; mark both those tiles where the entity previously were as well as the new tiles as dirty.
-				markTilesAsDirty(existingI->second.boundingBox());
-				existingI->second = entry.second;
+			auto existingArea = mEntityAreas->find(entry.first);
+			if (existingArea) {
+				//The entity already was registered, and is now moving. Its footprint needs to be removed from the tiles,
+				//but instead of rebuilding tiles each time it moves it's from now on represented as an obstacle.
+				markTilesAsDirty(existingArea->boundingBox());
+				if (canBeObstacle(entry.second)) {
+					mEntityAreas->erase(entry.first);
+					mDynamicObstacles.insert(std::make_pair(entry.first, DynamicObstacle { entry.second, 0 }));
+					markObstacleAsDirty(entry.first);
+				} else {
+					markTilesAsDirty(entry.second.boundingBox());
+					mEntityAreas->insert(entry.first, entry.second);
+				}
 			} else {
-				mEntityAreas.insert(entry);
+				markTilesAsDirty(entry.second.boundingBox());
+				mEntityAreas->insert(entry.first, entry.second);
 			}
 		}
 
@@ -482,8 +581,7 @@ bool Awareness::avoidObstacles(const WFMath::Point<2>& position, const WFMath::V
 		WFMath::Ball<2> viewRadius;
 	};
 
-	auto comp = []( EntityCollisionEntry& a, EntityCollisionEntry& b ) {return a.distance < b.distance;};
-	std::priority_queue<EntityCollisionEntry, std::vector<EntityCollisionEntry>, decltype( comp )> nearestEntities(comp);
+	std::vector<EntityCollisionEntry> nearestEntities;
 
 	WFMath::Ball<2> playerRadius(position, 5);
 
@@ -502,23 +600,24 @@ bool Awareness::avoidObstacles(const WFMath::Point<2>& position, const WFMath::V
 			WFMath::Ball<2> entityViewRadius(entityView2dPos, entity->getBBox().boundingSphereSloppy().radius());
 
 			if (WFMath::Intersect(playerRadius, entityViewRadius, false) || WFMath::Contains(playerRadius, entityViewRadius, false)) {
-				nearestEntities.push(EntityCollisionEntry( { WFMath::Distance(position, entityView2dPos), entity, entityView2dPos, entityViewRadius }));
+				nearestEntities.push_back(EntityCollisionEntry( { WFMath::Distance(position, entityView2dPos), entity, entityView2dPos, entityViewRadius }));
 			}
 		}
 
 	}
 
 	if (!nearestEntities.empty()) {
-		mObstacleAvoidanceQuery->reset();
-		int i = 0;
-		while (!nearestEntities.empty() && i < MAX_OBSTACLES_CIRCLES) {
-			const EntityCollisionEntry& entry = nearestEntities.top();
+		//Only consider the nearest entities.
+		size_t count = std::min<size_t>(nearestEntities.size(), MAX_OBSTACLES_CIRCLES);
+		std::partial_sort(nearestEntities.begin(), nearestEntities.begin() + count, nearestEntities.end(), [](const EntityCollisionEntry& a, const EntityCollisionEntry& b) {return a.distance < b.distance;});
+
+		mObstacleAvoidanceSampler->reset();
+		for (size_t i = 0; i < count; ++i) {
+			const EntityCollisionEntry& entry = nearestEntities[i];
 			auto entity = entry.entity;
 			float pos[] { entry.viewPosition.x(), 0, entry.viewPosition.y() };
 			float vel[] { entity->getPredictedVelocity().x(), 0, entity->getPredictedVelocity().y() };
-			mObstacleAvoidanceQuery->addCircle(pos, entry.viewRadius.radius(), vel, vel);
-			nearestEntities.pop();
-			++i;
+			mObstacleAvoidanceSampler->addCircle(pos, entry.viewRadius.radius(), vel);
 		}
 
 		float pos[] { position.x(), 0, position.y() };
@@ -527,7 +626,7 @@ bool Awareness::avoidObstacles(const WFMath::Point<2>& position, const WFMath::V
 		float nvel[] { 0, 0, 0 };
 		float desiredSpeed = desiredVelocity.mag();
 
-		auto samples = mObstacleAvoidanceQuery->sampleVelocityAdaptive(pos, mAvatarRadius, desiredSpeed, vel, dvel, nvel, mObstacleAvoidanceParams, nullptr);
+		auto samples = mObstacleAvoidanceSampler->sampleVelocityAdaptive(pos, mAvatarRadius, desiredSpeed, vel, dvel, nvel, *mObstacleAvoidanceParams);
 		if (samples > 0) {
 			if (!WFMath::Equal(vel[0], nvel[0]) || !WFMath::Equal(vel[2], nvel[2])) {
 				newVelocity.x() = nvel[0];
@@ -549,7 +648,7 @@ void Awareness::Entity_BeingDeleted(Eris::Entity* entity)
 		if (!I->second.isIgnored) {
 			if (I->second.isMoving) {
 				mMovingEntities.remove(entity);
-			} else {
+			} else if (!removeDynamicObstacle(entity)) {
 				std::map<Eris::Entity*, WFMath::RotBox<2>> areas;
 
 				buildEntityAreas(*entity, areas);
@@ -557,7 +656,7 @@ void Awareness::Entity_BeingDeleted(Eris::Entity* entity)
 				for (auto& entry : areas) {
 					markTilesAsDirty(entry.second.boundingBox());
 				}
-				mEntityAreas.erase(entity);
+				mEntityAreas->erase(entity);
 			}
 			mObservedEntities.erase(entity);
 		}
@@ -595,10 +694,11 @@ void Awareness::Entity_LocationChanged(Eris::Entity* oldLoc, Eris::Entity* entit
 					assert(connections.moved.connected());
 					connections.moved.disconnect();
 
-					auto areasI = mEntityAreas.find(entity);
-					if (areasI != mEntityAreas.end()) {
-						markTilesAsDirty(areasI->second.boundingBox());
-						mEntityAreas.erase(areasI);
+					removeDynamicObstacle(entity);
+					auto existingArea = mEntityAreas->find(entity);
+					if (existingArea) {
+						markTilesAsDirty(existingArea->boundingBox());
+						mEntityAreas->erase(entity);
 					}
 				}
 				connections.isIgnored = true;
@@ -637,57 +737,420 @@ void Awareness::markTilesAsDirty(int tileMinXIndex, int tileMaxXIndex, int tileM
 
 size_t Awareness::rebuildDirtyTile()
 {
-	if (!mDirtyAwareTiles.empty()) {
-		const auto tileIndexI = mDirtyAwareOrderedTiles.begin();
-		const auto& tileIndex = *tileIndexI;
+	if (mBulkRebuild) {
+		//Wait until all tiles are done, and then commit them all at once.
+		if (!mTilesInProgress.empty()) {
+			return mDirtyAwareTiles.size() + mTilesInProgress.size() + mBuiltTiles.size();
+		}
+		for (auto data : mBuiltTiles) {
+			commitTile(*data);
+			delete data;
+		}
+		mBuiltTiles.clear();
+		mBulkRebuild = false;
+
+		float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - mBulkRebuildStart).count();
+		S_LOG_INFO("Bulk rebuilt " << mBulkRebuildTileCount << " navmesh tiles in " << seconds << " seconds (" << (seconds > 0 ? mBulkRebuildTileCount / seconds : 0) << " tiles per second).");
+		EventBulkRebuildCompleted(mBulkRebuildTileCount, seconds);
+	}
+
+	//First commit tiles that have been built in the background, for as long as the budget allows.
+	auto start = std::chrono::steady_clock::now();
+	if (!mBuiltTiles.empty()) {
+		do {
+			TileBuildData* data = mBuiltTiles.front();
+			mBuiltTiles.pop_front();
+			commitTile(*data);
+			delete data;
+		} while (!mBuiltTiles.empty() && std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() < mCommitBudget);
+	}
 
-		float tilesize = mCfg.tileSize * mCfg.cs;
-		WFMath::AxisBox<2> adjustedArea(WFMath::Point<2>(mCfg.bmin[0] + (tileIndex.first * tilesize), mCfg.bmin[2] + (tileIndex.second * tilesize)), WFMath::Point<2>(mCfg.bmin[0] + ((tileIndex.first + 1) * tilesize), mCfg.bmin[2] + ((tileIndex.second + 1) * tilesize)));
+	//Moved entities only require the navmesh to be regenerated from the compressed layers, which can be done with what's left of the budget.
+	updateObstacles(std::max(0L, mCommitBudget - static_cast<long>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count())));
 
-		std::vector<WFMath::RotBox<2>> entityAreas;
-		findEntityAreas(adjustedArea, entityAreas);
+	//Then dispatch dirty tiles, in order of precedence.
+	auto I = mDirtyAwareOrderedTiles.begin();
+	while (I != mDirtyAwareOrderedTiles.end() && mTilesInProgress.size() < mMaxTilesInProgress) {
+		const auto tileIndex = *I;
+		if (mTilesInProgress.find(tileIndex) != mTilesInProgress.end()) {
+			//Wait for the current build to finish before building the tile again.
+			++I;
+			continue;
+		}
+		dispatchTileBuild(tileIndex);
 
-		rebuildTile(tileIndex.first, tileIndex.second, entityAreas);
 		mDirtyAwareTiles.erase(tileIndex);
-		mDirtyAwareOrderedTiles.erase(tileIndexI);
+		I = mDirtyAwareOrderedTiles.erase(I);
 	}
-	return mDirtyAwareTiles.size();
+	return mDirtyAwareTiles.size() + mTilesInProgress.size() + mBuiltTiles.size() + mDirtyObstacles.size() + mObstaclesToRemove.size() + (mObstacleUpdatesPending ? 1 : 0);
 }
 
-void Awareness::pruneTiles()
+bool Awareness::canBeObstacle(const WFMath::RotBox<2>& area) const
+{
+	//Obstacles can only touch a limited number of tiles, so larger entities must be baked into the tiles.
+	return area.boundingSphere().radius() <= (mCfg.tileSize * mCfg.cs) * 0.5f;
+}
+
+void Awareness::markObstacleAsDirty(Eris::Entity* entity)
 {
-	//remove any tiles that aren't used
-	if (mActiveTileList->size() > mAwareTiles.size()) {
-		if (mActiveTileList->size() > mDesiredTilesAmount) {
-			auto entry = mActiveTileList->pop_back();
-
-			dtCompressedTileRef tilesRefs[MAX_LAYERS];
-			const int ntiles = mTileCache->getTilesAt(entry.first, entry.second, tilesRefs, MAX_LAYERS);
-			for (int i = 0; i < ntiles; ++i) {
-				const dtCompressedTile* tile = mTileCache->getTileByRef(tilesRefs[i]);
-				float min[3];
-				int tx = tile->header->tx;
-				int ty = tile->header->ty;
-				int tlayer = tile->header->tlayer;
-				rcVcopy(min, tile->header->bmin);
-				mTileCache->removeTile(tilesRefs[i], NULL, NULL);
-				mNavMesh->removeTile(mNavMesh->getTileRefAt(tx,ty,tlayer), 0, 0);
-
-				EventTileRemoved(tx, ty, tlayer);
+	bool wasIdle = mDirtyObstacles.empty() && mObstaclesToRemove.empty();
+	mDirtyObstacles.insert(entity);
+	if (wasIdle && mDirtyAwareTiles.empty()) {
+		EventTileDirty();
+	}
+}
+
+bool Awareness::removeDynamicObstacle(Eris::Entity* entity)
+{
+	auto I = mDynamicObstacles.find(entity);
+	if (I == mDynamicObstacles.end()) {
+		return false;
+	}
+	if (I->second.ref) {
+		bool wasIdle = mDirtyObstacles.empty() && mObstaclesToRemove.empty();
+		mObstaclesToRemove.emplace_back(I->second.ref, I->second.area);
+		if (wasIdle && mDirtyAwareTiles.empty()) {
+			EventTileDirty();
+		}
+	}
+	mDirtyObstacles.erase(entity);
+	mDynamicObstacles.erase(I);
+	return true;
+}
+
+void Awareness::obstacleRequestSubmitted(const WFMath::RotBox<2>& area)
+{
+	//The obstacle is a cylinder around the area, which can reach further than the area itself.
+	WFMath::Ball<2> bounds = area.boundingSphere();
+	WFMath::Point<2> center = bounds.center();
+	WFMath::CoordType radius = bounds.radius();
+	WFMath::AxisBox<2> box(WFMath::Point<2>(center.x() - radius, center.y() - radius), WFMath::Point<2>(center.x() + radius, center.y() + radius));
+
+	int tileMinXIndex, tileMaxXIndex, tileMinYIndex, tileMaxYIndex;
+	findAffectedTiles(box, tileMinXIndex, tileMaxXIndex, tileMinYIndex, tileMaxYIndex);
+	for (int tx = tileMinXIndex; tx <= tileMaxXIndex; ++tx) {
+		for (int ty = tileMinYIndex; ty <= tileMaxYIndex; ++ty) {
+			mObstacleAffectedTiles.insert(std::make_pair(tx, ty));
+		}
+	}
+	mObstacleUpdatesPending = true;
+}
+
+void Awareness::updateObstacles(long budget)
+{
+	//The tile cache only accepts a limited number of requests between updates; whatever doesn't fit is submitted later.
+	while (!mObstaclesToRemove.empty()) {
+		auto& entry = mObstaclesToRemove.front();
+		if (dtStatusFailed(mTileCache->removeObstacle(entry.first))) {
+			break;
+		}
+		obstacleRequestSubmitted(entry.second);
+		mObstaclesToRemove.pop_front();
+	}
+
+	auto I = mDirtyObstacles.begin();
+	while (I != mDirtyObstacles.end()) {
+		DynamicObstacle& obstacle = mDynamicObstacles.find(*I)->second;
+		if (obstacle.ref) {
+			if (dtStatusFailed(mTileCache->removeObstacle(obstacle.ref))) {
+				break;
 			}
+			obstacleRequestSubmitted(obstacle.area);
+			obstacle.ref = 0;
+		}
+
+		//Obstacles are cylinders which extend through the whole height of the world, just as the areas used when rasterizing tiles.
+		WFMath::Point<2> center = obstacle.area.boundingSphere().center();
+		float pos[3] { (float)center.x(), mCfg.bmin[1], (float)center.y() };
+		float radius = obstacle.area.boundingSphere().radius();
+		dtStatus status = mTileCache->addObstacle(pos, radius, mCfg.bmax[1] - mCfg.bmin[1], &obstacle.ref);
+		if (dtStatusFailed(status)) {
+			obstacle.ref = 0;
+			if (dtStatusDetail(status, DT_OUT_OF_MEMORY)) {
+				S_LOG_WARNING("Could not add navigation obstacle; there are too many obstacles.");
+				I = mDirtyObstacles.erase(I);
+				continue;
+			}
+			break;
+		}
+		obstacleRequestSubmitted(obstacle.area);
+		I = mDirtyObstacles.erase(I);
+	}
+
+	if (mObstacleUpdatesPending) {
+		auto start = std::chrono::steady_clock::now();
+		bool upToDate = false;
+		//Each update processes pending requests or rebuilds at most one tile layer. Always do at least one.
+		do {
+			mTileCache->update(0, mNavMesh, &upToDate);
+			mNavMeshGeneration++;
+		} while (!upToDate && std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() < budget);
+
+		if (upToDate) {
+			mObstacleUpdatesPending = false;
+			for (auto& tileIndex : mObstacleAffectedTiles) {
+				//The navmesh tiles have been rebuilt with the obstacles, which changes their size.
+				updateTileMemory(tileIndex.first, tileIndex.second);
+				EventTileUpdated(tileIndex.first, tileIndex.second);
+			}
+			mObstacleAffectedTiles.clear();
+		}
+	}
+}
+
+void Awareness::dispatchTileBuild(const std::pair<int, int>& tileIndex)
+{
+	TileBuildData* data = new TileBuildData();
+	prepareTileBuild(tileIndex.first, tileIndex.second, *data);
+	mTilesInProgress.insert(tileIndex);
+	mTaskQueue->enqueueTask(new TileBuildTask(*this, data));
+}
+
+void Awareness::startBulkRebuild()
+{
+	if (mBulkRebuild) {
+		return;
+	}
+	mBulkRebuild = true;
+	mBulkRebuildTileCount = 0;
+	mBulkRebuildStart = std::chrono::steady_clock::now();
+
+	//Dispatch everything at once, ignoring the limit on tiles in progress, so that all threads are kept busy.
+	auto I = mDirtyAwareOrderedTiles.begin();
+	while (I != mDirtyAwareOrderedTiles.end()) {
+		const auto tileIndex = *I;
+		if (mTilesInProgress.find(tileIndex) != mTilesInProgress.end()) {
+			++I;
+			continue;
+		}
+		dispatchTileBuild(tileIndex);
+		++mBulkRebuildTileCount;
+
+		mDirtyAwareTiles.erase(tileIndex);
+		I = mDirtyAwareOrderedTiles.erase(I);
+	}
+	S_LOG_VERBOSE("Started bulk rebuild of " << mBulkRebuildTileCount << " navmesh tiles.");
+}
+
+bool Awareness::isBulkRebuilding() const
+{
+	return mBulkRebuild;
+}
+
+void Awareness::tileBuilt(TileBuildData* data)
+{
+	mTilesInProgress.erase(std::make_pair(data->tx, data->ty));
+	mBuiltTiles.push_back(data);
+}
+
+void Awareness::pruneTiles()
+{
+	if (!needsPruning()) {
+		return;
+	}
+
+	const float tileSize = mCfg.tileSize * mCfg.cs;
+
+	//Candidates are the least recently used tiles that aren't part of the awareness area.
+	//Tiles being built are skipped too, since they will be committed later on.
+	std::vector<std::pair<int, int>> lruTiles;
+	mTileMemory->collectPruneCandidates(mMaxTilesPerPrune * 4, [&](const std::pair<int, int>& index) {
+		return mAwareTiles.find(index) != mAwareTiles.end() || isTileBuildPending(index);
+	}, lruTiles);
+
+	std::vector<std::pair<float, std::pair<int, int>>> candidates;
+	for (auto& index : lruTiles) {
+		float distance = 0;
+		if (mFocusLine.isValid()) {
+			WFMath::Point<2> center(mCfg.bmin[0] + (index.first + 0.5f) * tileSize, mCfg.bmin[2] + (index.second + 0.5f) * tileSize);
+			distance = distanceToSegment(center, mFocusLine);
+		}
+		candidates.emplace_back(distance, index);
+	}
+
+	//Remove the tiles furthest away from the focus line first. The sort is stable, so that the least recently used tile is removed first when there's no focus line.
+	std::stable_sort(candidates.begin(), candidates.end(), [](const std::pair<float, std::pair<int, int>>& lhs, const std::pair<float, std::pair<int, int>>& rhs) {
+		return lhs.first > rhs.first;
+	});
+
+	size_t removed = 0;
+	for (auto& candidate : candidates) {
+		if (removed >= mMaxTilesPerPrune || mTileMemory->getUsage() <= mTileMemory->getLowWaterMark()) {
+			break;
+		}
+		removeTiles(candidate.second.first, candidate.second.second);
+		removed++;
+	}
+
+	if (removed) {
+		S_LOG_VERBOSE("Pruned " << removed << " navmesh tiles; tiles now use " << mTileMemory->getUsage() << " bytes.");
+	}
+}
+
+void Awareness::removeTiles(int tx, int ty)
+{
+	dtCompressedTileRef tilesRefs[MAX_LAYERS];
+	const int ntiles = mTileCache->getTilesAt(tx, ty, tilesRefs, MAX_LAYERS);
+	for (int i = 0; i < ntiles; ++i) {
+		const dtCompressedTile* tile = mTileCache->getTileByRef(tilesRefs[i]);
+		int tlayer = tile->header->tlayer;
+		mTileCache->removeTile(tilesRefs[i], NULL, NULL);
+		mNavMesh->removeTile(mNavMesh->getTileRefAt(tx, ty, tlayer), 0, 0);
+		mNavMeshGeneration++;
+
+		EventTileRemoved(tx, ty, tlayer);
+	}
+
+	mTileMemory->removeTile(std::make_pair(tx, ty));
+}
+
+void Awareness::updateTileMemory(int tx, int ty)
+{
+	size_t bytes = 0;
+
+	dtCompressedTileRef tilesRefs[MAX_LAYERS];
+	int ntiles = mTileCache->getTilesAt(tx, ty, tilesRefs, MAX_LAYERS);
+	for (int i = 0; i < ntiles; ++i) {
+		bytes += mTileCache->getTileByRef(tilesRefs[i])->dataSize;
+	}
+
+	const dtNavMesh* navMesh = mNavMesh;
+	const dtMeshTile* meshTiles[MAX_LAYERS];
+	ntiles = navMesh->getTilesAt(tx, ty, meshTiles, MAX_LAYERS);
+	for (int i = 0; i < ntiles; ++i) {
+		bytes += meshTiles[i]->dataSize;
+	}
+
+	mTileMemory->setTileMemory(std::make_pair(tx, ty), bytes);
+}
 
+bool Awareness::isTileBuildPending(const std::pair<int, int>& index) const
+{
+	if (mTilesInProgress.find(index) != mTilesInProgress.end()) {
+		return true;
+	}
+	for (auto data : mBuiltTiles) {
+		if (data->tx == index.first && data->ty == index.second) {
+			return true;
 		}
 	}
+	return false;
 }
 
 bool Awareness::needsPruning() const
 {
-	return (mActiveTileList->size() > mDesiredTilesAmount) && (mActiveTileList->size() > mAwareTiles.size());
+	return mTileMemory->isOverBudget() && (mTileMemory->getTileCount() > mAwareTiles.size());
 }
 
-void Awareness::setDesiredTilesAmount(size_t amount)
+void Awareness::setTileMemoryBudget(size_t bytes)
 {
-	mDesiredTilesAmount = amount;
+	mTileMemory->setBudget(bytes);
+}
+
+size_t Awareness::getTileMemoryUsage() const
+{
+	return mTileMemory->getUsage();
+}
+
+void Awareness::setTileCacheDirectory(const std::string& directory)
+{
+	mTileCacheDirectory = directory;
+
+	//Different servers and worlds have different tiles at the same indices, so they must not share cache files.
+	std::stringstream worldId;
+	worldId << mView.getAvatar()->getConnection()->getHost() << ":" << mView.getAvatar()->getConnection()->getPort() << "/" << mView.getTopLevel()->getId();
+	const std::string worldIdString = worldId.str();
+	mTileCacheWorldId = 14695981039346656037ULL;
+	hashBytes(mTileCacheWorldId, worldIdString.data(), worldIdString.size());
+
+	mTileCacheConfigHash = 14695981039346656037ULL;
+	hashBytes(mTileCacheConfigHash, &mCfg, sizeof(rcConfig));
+	hashBytes(mTileCacheConfigHash, &mAvatarRadius, sizeof(mAvatarRadius));
+}
+
+bool Awareness::loadCachedTile(TileBuildData& data)
+{
+	std::ifstream stream(data.cachePath.c_str(), std::ios::binary);
+	if (!stream) {
+		return false;
+	}
+
+	char magic[4];
+	int version = 0;
+	unsigned long long worldId = 0;
+	unsigned long long configHash = 0;
+	unsigned long long hash = 0;
+	int ntiles = 0;
+	stream.read(magic, 4);
+	stream.read(reinterpret_cast<char*>(&version), sizeof(version));
+	stream.read(reinterpret_cast<char*>(&worldId), sizeof(worldId));
+	stream.read(reinterpret_cast<char*>(&configHash), sizeof(configHash));
+	stream.read(reinterpret_cast<char*>(&hash), sizeof(hash));
+	stream.read(reinterpret_cast<char*>(&ntiles), sizeof(ntiles));
+	if (!stream || memcmp(magic, TILE_CACHE_MAGIC, 4) != 0 || version != DT_TILECACHE_VERSION || worldId != data.cacheWorldId || configHash != data.cacheConfigHash || hash != data.hash || ntiles < 0 || ntiles > MAX_LAYERS) {
+		return false;
+	}
+
+	//Frees any layers already read if the file turns out to be broken.
+	auto discard = [&data]() {
+		for (int i = 0; i < MAX_LAYERS; ++i) {
+			dtFree(data.tiles[i].data);
+			data.tiles[i].data = 0;
+			data.tiles[i].dataSize = 0;
+		}
+		return false;
+	};
+
+	for (int i = 0; i < ntiles; ++i) {
+		int dataSize = 0;
+		stream.read(reinterpret_cast<char*>(&dataSize), sizeof(dataSize));
+		if (!stream || dataSize <= 0) {
+			return discard();
+		}
+		//The tile cache will free the data with dtFree(), so it must be allocated with dtAlloc().
+		data.tiles[i].data = (unsigned char*)dtAlloc(dataSize, DT_ALLOC_PERM);
+		data.tiles[i].dataSize = dataSize;
+		if (!data.tiles[i].data) {
+			return discard();
+		}
+		stream.read(reinterpret_cast<char*>(data.tiles[i].data), dataSize);
+		if (!stream) {
+			return discard();
+		}
+	}
+	data.ntiles = ntiles;
+	return true;
+}
+
+void Awareness::saveCachedTile(const TileBuildData& data)
+{
+	//Write to a temporary file first, so that a half written file never is read.
+	std::string tempPath = data.cachePath + ".tmp";
+	{
+		std::ofstream stream(tempPath.c_str(), std::ios::binary | std::ios::trunc);
+		if (!stream) {
+			return;
+		}
+		int version = DT_TILECACHE_VERSION;
+		stream.write(TILE_CACHE_MAGIC, 4);
+		stream.write(reinterpret_cast<const char*>(&version), sizeof(version));
+		stream.write(reinterpret_cast<const char*>(&data.cacheWorldId), sizeof(data.cacheWorldId));
+		stream.write(reinterpret_cast<const char*>(&data.cacheConfigHash), sizeof(data.cacheConfigHash));
+		stream.write(reinterpret_cast<const char*>(&data.hash), sizeof(data.hash));
+		stream.write(reinterpret_cast<const char*>(&data.ntiles), sizeof(data.ntiles));
+		for (int i = 0; i < data.ntiles; ++i) {
+			stream.write(reinterpret_cast<const char*>(&data.tiles[i].dataSize), sizeof(data.tiles[i].dataSize));
+			stream.write(reinterpret_cast<const char*>(data.tiles[i].data), data.tiles[i].dataSize);
+		}
+		if (!stream) {
+			stream.close();
+			std::remove(tempPath.c_str());
+			return;
+		}
+	}
+	if (std::rename(tempPath.c_str(), data.cachePath.c_str()) != 0) {
+		std::remove(tempPath.c_str());
+	}
 }
 
 void Awareness::findAffectedTiles(const WFMath::AxisBox<2>& area, int& tileMinXIndex, int& tileMaxXIndex, int& tileMinYIndex, int& tileMaxYIndex) const
@@ -729,6 +1192,11 @@ void Awareness::findAffectedTiles(const WFMath::AxisBox<2>& area, int& tileMinXI
 }
 
 int Awareness::findPath(const WFMath::Point<3>& start, const WFMath::Point<3>& end, std::list<WFMath::Point<3>>& path) const
+{
+	return findPath(*mNavQuery, *mFilter, start, end, path);
+}
+
+int Awareness::findPath(const dtNavMeshQuery& navQuery, const dtQueryFilter& filter, const WFMath::Point<3>& start, const WFMath::Point<3>& end, std::list<WFMath::Point<3>>& path)
 {
 
 	float pStartPos[] { start.x(), start.z(), start.y() };
@@ -746,22 +1214,22 @@ int Awareness::findPath(const WFMath::Point<3>& start, const WFMath::Point<3>& e
 	int nVertCount = 0;
 
 // find the start polygon
-	status = mNavQuery->findNearestPoly(pStartPos, extent, mFilter, &StartPoly, StartNearest);
+	status = navQuery.findNearestPoly(pStartPos, extent, &filter, &StartPoly, StartNearest);
 	if ((status & DT_FAILURE) || (status & DT_STATUS_DETAIL_MASK))
 		return -1; // couldn't find a polygon
 
 // find the end polygon
-	status = mNavQuery->findNearestPoly(pEndPos, extent, mFilter, &EndPoly, EndNearest);
+	status = navQuery.findNearestPoly(pEndPos, extent, &filter, &EndPoly, EndNearest);
 	if ((status & DT_FAILURE) || (status & DT_STATUS_DETAIL_MASK))
 		return -2; // couldn't find a polygon
 
-	status = mNavQuery->findPath(StartPoly, EndPoly, StartNearest, EndNearest, mFilter, PolyPath, &nPathCount, MAX_PATHPOLY);
+	status = navQuery.findPath(StartPoly, EndPoly, StartNearest, EndNearest, &filter, PolyPath, &nPathCount, MAX_PATHPOLY);
 	if ((status & DT_FAILURE) || (status & DT_STATUS_DETAIL_MASK))
 		return -3; // couldn't create a path
 	if (nPathCount == 0)
 		return -4; // couldn't find a path
 
-	status = mNavQuery->findStraightPath(StartNearest, EndNearest, PolyPath, nPathCount, StraightPath, NULL, NULL, &nVertCount, MAX_PATHVERT);
+	status = navQuery.findStraightPath(StartNearest, EndNearest, PolyPath, nPathCount, StraightPath, NULL, NULL, &nVertCount, MAX_PATHVERT);
 	if ((status & DT_FAILURE) || (status & DT_STATUS_DETAIL_MASK))
 		return -5; // couldn't create a path
 	if (nVertCount == 0)
@@ -775,9 +1243,197 @@ int Awareness::findPath(const WFMath::Point<3>& start, const WFMath::Point<3>& e
 	return nVertCount;
 }
 
+unsigned int Awareness::requestPath(const WFMath::Point<3>& start, const WFMath::Point<3>& end, const PathCallback& callback)
+{
+	PathRequest request;
+	request.id = ++mPathRequestCounter;
+	if (request.id == 0) {
+		request.id = ++mPathRequestCounter;
+	}
+	request.start = start;
+	request.end = end;
+	request.callback = callback;
+	request.startRef = 0;
+	request.initialized = false;
+	request.navMeshGeneration = 0;
+	mPathRequests.push_back(request);
+	return request.id;
+}
+
+unsigned int Awareness::requestCorridorRepair(const PathCorridor& corridor, const PathCallback& callback)
+{
+	if (corridor.isEmpty()) {
+		return 0;
+	}
+	//Start from the point of the last polygon which is closest to the target.
+	float start[3];
+	if (dtStatusFailed(mNavQuery->closestPointOnPoly(corridor.getLastPoly(), corridor.getTarget(), start, nullptr))) {
+		return 0;
+	}
+	const float* target = corridor.getTarget();
+	unsigned int id = requestPath(WFMath::Point<3>(start[0], start[2], start[1]), WFMath::Point<3>(target[0], target[2], target[1]), callback);
+	mPathRequests.back().startRef = corridor.getLastPoly();
+	return id;
+}
+
+bool Awareness::moveCorridor(PathCorridor& corridor, const WFMath::Point<3>& position) const
+{
+	float pos[] { position.x(), position.z(), position.y() };
+	if (corridor.movePosition(pos, mNavQuery, mFilter)) {
+		return true;
+	}
+
+	//The start of the corridor is invalid; check if we're now within any other polygon of it.
+	float extent[] { 2, 100, 2 };
+	dtPolyRef ref = 0;
+	float nearest[3];
+	dtStatus status = mNavQuery->findNearestPoly(pos, extent, mFilter, &ref, nearest);
+	if (dtStatusFailed(status) || !ref) {
+		return false;
+	}
+	return corridor.fixPathStart(ref, nearest);
+}
+
+void Awareness::optimizeCorridor(PathCorridor& corridor) const
+{
+	corridor.optimizePathTopology(mNavQuery, mFilter);
+}
+
+size_t Awareness::trimCorridor(PathCorridor& corridor) const
+{
+	return corridor.trimInvalidPath(mNavQuery, mFilter);
+}
+
+int Awareness::getCorridorPath(const PathCorridor& corridor, std::list<WFMath::Point<3>>& path) const
+{
+	float straightPath[MAX_PATHVERT * 3];
+	int nVertCount = corridor.findStraightPath(mNavQuery, straightPath, MAX_PATHVERT);
+	for (int nVert = 0; nVert < nVertCount; nVert++) {
+		path.push_back(WFMath::Point<3>(straightPath[nVert * 3], straightPath[(nVert * 3) + 2], straightPath[(nVert * 3) + 1]));
+	}
+	return nVertCount;
+}
+
+void Awareness::cancelPathRequest(unsigned int requestId)
+{
+	for (auto I = mPathRequests.begin(); I != mPathRequests.end(); ++I) {
+		if (I->id == requestId) {
+			//Since the sliced query is only initialized for the first request nothing else needs to be done; the next request will reinitialize it.
+			mPathRequests.erase(I);
+			return;
+		}
+	}
+}
+
+int Awareness::initPathRequest(PathRequest& request)
+{
+	float pStartPos[] { request.start.x(), request.start.z(), request.start.y() };
+	float pEndPos[] { request.end.x(), request.end.z(), request.end.y() };
+	float extent[] { 2, 100, 2 }; //Look two meters in each direction
+
+	dtPolyRef startPoly;
+	dtPolyRef endPoly;
+	dtStatus status;
+
+	if (request.startRef) {
+		if (!mSlicedNavQuery->isValidPolyRef(request.startRef, mFilter))
+			return -1; // the polygon has disappeared
+		startPoly = request.startRef;
+		dtVcopy(request.startNearest, pStartPos);
+	} else {
+		status = mSlicedNavQuery->findNearestPoly(pStartPos, extent, mFilter, &startPoly, request.startNearest);
+		if ((status & DT_FAILURE) || (status & DT_STATUS_DETAIL_MASK))
+			return -1; // couldn't find a polygon
+	}
+
+	status = mSlicedNavQuery->findNearestPoly(pEndPos, extent, mFilter, &endPoly, request.endNearest);
+	if ((status & DT_FAILURE) || (status & DT_STATUS_DETAIL_MASK))
+		return -2; // couldn't find a polygon
+
+	status = mSlicedNavQuery->initSlicedFindPath(startPoly, endPoly, request.startNearest, request.endNearest, mFilter);
+	if (dtStatusFailed(status))
+		return -3; // couldn't create a path
+
+	request.initialized = true;
+	request.navMeshGeneration = mNavMeshGeneration;
+	return 0;
+}
+
+void Awareness::finishPathRequest(int result, const std::list<WFMath::Point<3>>& path, const PathCorridor& corridor)
+{
+	//Remove the request before calling the callback, since the callback might want to request a new path.
+	PathCallback callback = mPathRequests.front().callback;
+	mPathRequests.pop_front();
+	callback(result, path, corridor);
+}
+
+size_t Awareness::processPathRequests()
+{
+	int iterationsLeft = mPathIterationBudget;
+	while (!mPathRequests.empty() && iterationsLeft > 0) {
+		PathRequest& request = mPathRequests.front();
+		if (!request.initialized) {
+			int result = initPathRequest(request);
+			if (result < 0) {
+				finishPathRequest(result, std::list<WFMath::Point<3>>(), PathCorridor());
+				continue;
+			}
+		}
+
+		int iterations = 0;
+		dtStatus status = mSlicedNavQuery->updateSlicedFindPath(iterationsLeft, &iterations);
+		iterationsLeft -= std::max(1, iterations);
+
+		if (dtStatusFailed(status)) {
+			if (request.navMeshGeneration != mNavMeshGeneration) {
+				//The navmesh changed while searching; start over.
+				request.initialized = false;
+				continue;
+			}
+			finishPathRequest(-3, std::list<WFMath::Point<3>>(), PathCorridor());
+		} else if (dtStatusSucceed(status)) {
+			dtPolyRef polyPath[MAX_PATHPOLY];
+			int nPathCount = 0;
+			float straightPath[MAX_PATHVERT * 3];
+			int nVertCount = 0;
+
+			status = mSlicedNavQuery->finalizeSlicedFindPath(polyPath, &nPathCount, MAX_PATHPOLY);
+			if (dtStatusFailed(status)) {
+				finishPathRequest(-3, std::list<WFMath::Point<3>>(), PathCorridor());
+				continue;
+			}
+			if (nPathCount == 0) {
+				finishPathRequest(-4, std::list<WFMath::Point<3>>(), PathCorridor());
+				continue;
+			}
+
+			status = mSlicedNavQuery->findStraightPath(request.startNearest, request.endNearest, polyPath, nPathCount, straightPath, NULL, NULL, &nVertCount, MAX_PATHVERT);
+			if ((status & DT_FAILURE) || (status & DT_STATUS_DETAIL_MASK)) {
+				finishPathRequest(-5, std::list<WFMath::Point<3>>(), PathCorridor());
+				continue;
+			}
+			if (nVertCount == 0) {
+				finishPathRequest(-6, std::list<WFMath::Point<3>>(), PathCorridor());
+				continue;
+			}
+
+			std::list<WFMath::Point<3>> path;
+			for (int nVert = 0; nVert < nVertCount; nVert++) {
+				path.push_back(WFMath::Point<3>(straightPath[nVert * 3], straightPath[(nVert * 3) + 2], straightPath[(nVert * 3) + 1]));
+			}
+			PathCorridor corridor;
+			corridor.setCorridor(request.startNearest, request.endNearest, std::vector<dtPolyRef>(polyPath, polyPath + nPathCount));
+			finishPathRequest(nVertCount, path, corridor);
+		}
+	}
+	return mPathRequests.size();
+}
+
 void Awareness::setAwarenessArea(const WFMath::RotBox<2>& area, const WFMath::Segment<2>& focusLine)
 {
 
+	mFocusLine = focusLine;
+
 	WFMath::AxisBox<2> axisbox = area.boundingBox();
 
 //adjust area to fit with tiles
@@ -877,25 +1533,99 @@ void Awareness::setAwarenessArea(const WFMath::RotBox<2>& area, const WFMath::Se
 
 				mAwareTiles.insert(index);
 
-				mActiveTileList->insert(index);
+				mTileMemory->touch(index);
 			}
 		}
 	}
 
-	if (!wereDirtyTiles && !mDirtyAwareTiles.empty()) {
+	if (mDirtyAwareTiles.size() >= mBulkRebuildThreshold) {
+		startBulkRebuild();
+	}
+
+	if (!wereDirtyTiles && (!mDirtyAwareTiles.empty() || mBulkRebuild)) {
 		EventTileDirty();
 	}
 }
 
-void Awareness::rebuildTile(int tx, int ty, const std::vector<WFMath::RotBox<2>>& entityAreas)
+void Awareness::prepareTileBounds(const rcConfig& cfg, int tx, int ty, TileBuildData& data)
+{
+	data.tx = tx;
+	data.ty = ty;
+
+	const float tcs = cfg.tileSize * cfg.cs;
+
+	rcConfig& tcfg = data.cfg;
+	memcpy(&tcfg, &cfg, sizeof(tcfg));
+
+	tcfg.bmin[0] = cfg.bmin[0] + tx * tcs;
+	tcfg.bmin[1] = cfg.bmin[1];
+	tcfg.bmin[2] = cfg.bmin[2] + ty * tcs;
+	tcfg.bmax[0] = cfg.bmin[0] + (tx + 1) * tcs;
+	tcfg.bmax[1] = cfg.bmax[1];
+	tcfg.bmax[2] = cfg.bmin[2] + (ty + 1) * tcs;
+	tcfg.bmin[0] -= tcfg.borderSize * tcfg.cs;
+	tcfg.bmin[2] -= tcfg.borderSize * tcfg.cs;
+	tcfg.bmax[0] += tcfg.borderSize * tcfg.cs;
+	tcfg.bmax[2] += tcfg.borderSize * tcfg.cs;
+
+	//Get one extra vertex in each direction so that there's no cutoff at the tile's edges.
+	data.heightsXMin = std::floor(tcfg.bmin[0]) - 1;
+	data.heightsXMax = std::ceil(tcfg.bmax[0]) + 1;
+	data.heightsYMin = std::floor(tcfg.bmin[2]) - 1;
+	data.heightsYMax = std::ceil(tcfg.bmax[2]) + 1;
+}
+
+void Awareness::prepareTileBuild(int tx, int ty, TileBuildData& data)
 {
-	TileCacheData tiles[MAX_LAYERS];
-	memset(tiles, 0, sizeof(tiles));
+	ProfileZone zone("Awareness::prepareTileBuild");
+
+	const float tcs = mCfg.tileSize * mCfg.cs;
+
+	WFMath::AxisBox<2> adjustedArea(WFMath::Point<2>(mCfg.bmin[0] + (tx * tcs), mCfg.bmin[2] + (ty * tcs)), WFMath::Point<2>(mCfg.bmin[0] + ((tx + 1) * tcs), mCfg.bmin[2] + ((ty + 1) * tcs)));
+	findEntityAreas(adjustedArea, data.entityAreas);
+
+	prepareTileBounds(mCfg, tx, ty, data);
+	const rcConfig& tcfg = data.cfg;
+
+	//Blit height values with 1 meter interval. This is done here since the height provider isn't thread safe.
+	data.heights.resize((data.heightsXMax - data.heightsXMin) * (data.heightsYMax - data.heightsYMin));
+	mHeightProvider.blitHeights(data.heightsXMin, data.heightsXMax, data.heightsYMin, data.heightsYMax, data.heights);
+
+	if (!mTileCacheDirectory.empty()) {
+		//Everything which affects the resulting tile needs to be part of the hash.
+		//Note that the tile config includes the tile bounds.
+		unsigned long long hash = 14695981039346656037ULL;
+		hashBytes(hash, &tcfg, sizeof(rcConfig));
+		hashBytes(hash, data.heights.data(), data.heights.size() * sizeof(float));
+		for (auto& rotbox : data.entityAreas) {
+			for (size_t i = 0; i < 4; ++i) {
+				float corner[2] = { static_cast<float>(rotbox.getCorner(i).x()), static_cast<float>(rotbox.getCorner(i).y()) };
+				hashBytes(hash, corner, sizeof(corner));
+			}
+		}
+		data.hash = hash;
+		data.cacheWorldId = mTileCacheWorldId;
+		data.cacheConfigHash = mTileCacheConfigHash;
 
-	int ntiles = rasterizeTileLayers(entityAreas, tx, ty, tiles, MAX_LAYERS);
+		std::stringstream ss;
+		ss << mTileCacheDirectory << "navtile_" << std::hex << mTileCacheWorldId << "_" << mTileCacheConfigHash << std::dec << "_" << tx << "_" << ty << ".bin";
+		data.cachePath = ss.str();
+	}
+}
+
+void Awareness::commitTile(TileBuildData& data)
+{
+	ProfileZone zone("Awareness::commitTile");
+	std::pair<int, int> index(data.tx, data.ty);
+	//The awareness area might have changed while the tile was being built, and the tile pruned.
+	//In that case it's marked as dirty, so that it's rebuilt when it becomes part of the awareness area again.
+	if (mAwareTiles.find(index) == mAwareTiles.end()) {
+		mDirtyUnwareTiles.insert(index);
+		return;
+	}
 
-	for (int j = 0; j < ntiles; ++j) {
-		TileCacheData* tile = &tiles[j];
+	for (int j = 0; j < data.ntiles; ++j) {
+		TileCacheData* tile = &data.tiles[j];
 
 		dtTileCacheLayerHeader* header = (dtTileCacheLayerHeader*)tile->data;
 		dtTileRef tileRef = mTileCache->getTileRef(mTileCache->getTileAt(header->tx, header->ty, header->tlayer));
@@ -905,14 +1635,26 @@ void Awareness::rebuildTile(int tx, int ty, const std::vector<WFMath::RotBox<2>>
 		dtStatus status = mTileCache->addTile(tile->data, tile->dataSize, DT_COMPRESSEDTILE_FREE_DATA, 0);  // Add compressed tiles to tileCache
 		if (dtStatusFailed(status)) {
 			dtFree(tile->data);
-			tile->data = 0;
-			continue;
 		}
+		//Either the tile cache now owns the data, or it has been freed.
+		tile->data = 0;
 	}
 
-	mTileCache->buildNavMeshTilesAt(tx, ty, mNavMesh);
+	mTileCache->buildNavMeshTilesAt(data.tx, data.ty, mNavMesh);
+	mNavMeshGeneration++;
+	updateTileMemory(data.tx, data.ty);
+
+	//Obstacles only know about the tiles which existed when they were added, so any obstacles within the new tile need to be added again.
+	if (!mDynamicObstacles.empty()) {
+		WFMath::AxisBox<2> tileBounds(WFMath::Point<2>(data.cfg.bmin[0], data.cfg.bmin[2]), WFMath::Point<2>(data.cfg.bmax[0], data.cfg.bmax[2]));
+		for (auto& entry : mDynamicObstacles) {
+			if (WFMath::Intersect(tileBounds, entry.second.area, false) || WFMath::Contains(tileBounds, entry.second.area, false)) {
+				markObstacleAsDirty(entry.first);
+			}
+		}
+	}
 
-	EventTileUpdated(tx, ty);
+	EventTileUpdated(data.tx, data.ty);
 
 }
 
@@ -966,15 +1708,10 @@ void Awareness::buildEntityAreas(Eris::Entity& entity, std::map<Eris::Entity*, W
 
 void Awareness::findEntityAreas(const WFMath::AxisBox<2>& extent, std::vector<WFMath::RotBox<2> >& areas)
 {
-	for (auto& entry : mEntityAreas) {
-		auto& rotbox = entry.second;
-		if (WFMath::Contains(extent, rotbox, false) || WFMath::Intersect(extent, rotbox, false)) {
-			areas.push_back(rotbox);
-		}
-	}
+	mEntityAreas->query(extent, areas);
 }
 
-int Awareness::rasterizeTileLayers(const std::vector<WFMath::RotBox<2>>& entityAreas, const int tx, const int ty, TileCacheData* tiles, const int maxTiles)
+int Awareness::rasterizeTileLayers(rcContext& ctx, TileBuildData& data)
 {
 	std::vector<float> vertsVector;
 	std::vector<int> trisVector;
@@ -982,38 +1719,18 @@ int Awareness::rasterizeTileLayers(const std::vector<WFMath::RotBox<2>>& entityA
 	FastLZCompressor comp;
 	RasterizationContext rc;
 
-// Tile bounds.
-	const float tcs = mCfg.tileSize * mCfg.cs;
-
-	rcConfig tcfg;
-	memcpy(&tcfg, &mCfg, sizeof(tcfg));
+	const int tx = data.tx;
+	const int ty = data.ty;
+	const rcConfig& tcfg = data.cfg;
+	const std::vector<WFMath::RotBox<2>>& entityAreas = data.entityAreas;
 
-	tcfg.bmin[0] = mCfg.bmin[0] + tx * tcs;
-	tcfg.bmin[1] = mCfg.bmin[1];
-	tcfg.bmin[2] = mCfg.bmin[2] + ty * tcs;
-	tcfg.bmax[0] = mCfg.bmin[0] + (tx + 1) * tcs;
-	tcfg.bmax[1] = mCfg.bmax[1];
-	tcfg.bmax[2] = mCfg.bmin[2] + (ty + 1) * tcs;
-	tcfg.bmin[0] -= tcfg.borderSize * tcfg.cs;
-	tcfg.bmin[2] -= tcfg.borderSize * tcfg.cs;
-	tcfg.bmax[0] += tcfg.borderSize * tcfg.cs;
-	tcfg.bmax[2] += tcfg.borderSize * tcfg.cs;
+//First define all vertices.
+	int sizeX = data.heightsXMax - data.heightsXMin;
+	int sizeY = data.heightsYMax - data.heightsYMin;
 
-//First define all vertices. Get one extra vertex in each direction so that there's no cutoff at the tile's edges.
-	int heightsXMin = std::floor(tcfg.bmin[0]) - 1;
-	int heightsXMax = std::ceil(tcfg.bmax[0]) + 1;
-	int heightsYMin = std::floor(tcfg.bmin[2]) - 1;
-	int heightsYMax = std::ceil(tcfg.bmax[2]) + 1;
-	int sizeX = heightsXMax - heightsXMin;
-	int sizeY = heightsYMax - heightsYMin;
-
-//Blit height values with 1 meter interval
-	std::vector<float> heights(sizeX * sizeY);
-	mHeightProvider.blitHeights(heightsXMin, heightsXMax, heightsYMin, heightsYMax, heights);
-
-	float* heightData = heights.data();
-	for (int y = heightsYMin; y < heightsYMax; ++y) {
-		for (int x = heightsXMin; x < heightsXMax; ++x) {
+	const float* heightData = data.heights.data();
+	for (int y = data.heightsYMin; y < data.heightsYMax; ++y) {
+		for (int x = data.heightsXMin; x < data.heightsXMax; ++x) {
 			vertsVector.push_back(x);
 			vertsVector.push_back(*heightData);
 			vertsVector.push_back(y);
@@ -1044,25 +1761,25 @@ int Awareness::rasterizeTileLayers(const std::vector<WFMath::RotBox<2>>& entityA
 // Allocate voxel heightfield where we rasterize our input data to.
 	rc.solid = rcAllocHeightfield();
 	if (!rc.solid) {
-		mCtx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'solid'.");
+		ctx.log(RC_LOG_ERROR, "buildNavigation: Out of memory 'solid'.");
 		return 0;
 	}
-	if (!rcCreateHeightfield(mCtx, *rc.solid, tcfg.width, tcfg.height, tcfg.bmin, tcfg.bmax, tcfg.cs, tcfg.ch)) {
-		mCtx->log(RC_LOG_ERROR, "buildNavigation: Could not create solid heightfield.");
+	if (!rcCreateHeightfield(&ctx, *rc.solid, tcfg.width, tcfg.height, tcfg.bmin, tcfg.bmax, tcfg.cs, tcfg.ch)) {
+		ctx.log(RC_LOG_ERROR, "buildNavigation: Could not create solid heightfield.");
 		return 0;
 	}
 
 // Allocate array that can hold triangle flags.
 	rc.triareas = new unsigned char[ntris];
 	if (!rc.triareas) {
-		mCtx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'm_triareas' (%d).", ntris / 3);
+		ctx.log(RC_LOG_ERROR, "buildNavigation: Out of memory 'm_triareas' (%d).", ntris / 3);
 		return 0;
 	}
 
 	memset(rc.triareas, 0, ntris * sizeof(unsigned char));
-	rcMarkWalkableTriangles(mCtx, tcfg.walkableSlopeAngle, verts, nverts, tris, ntris, rc.triareas);
+	rcMarkWalkableTriangles(&ctx, tcfg.walkableSlopeAngle, verts, nverts, tris, ntris, rc.triareas);
 
-	rcRasterizeTriangles(mCtx, verts, nverts, tris, rc.triareas, ntris, *rc.solid, tcfg.walkableClimb);
+	rcRasterizeTriangles(&ctx, verts, nverts, tris, rc.triareas, ntris, *rc.solid, tcfg.walkableClimb);
 
 // Once all geometry is rasterized, we do initial pass of filtering to
 // remove unwanted overhangs caused by the conservative rasterization
@@ -1076,17 +1793,17 @@ int Awareness::rasterizeTileLayers(const std::vector<WFMath::RotBox<2>>& entityA
 
 	rc.chf = rcAllocCompactHeightfield();
 	if (!rc.chf) {
-		mCtx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'chf'.");
+		ctx.log(RC_LOG_ERROR, "buildNavigation: Out of memory 'chf'.");
 		return 0;
 	}
-	if (!rcBuildCompactHeightfield(mCtx, tcfg.walkableHeight, tcfg.walkableClimb, *rc.solid, *rc.chf)) {
-		mCtx->log(RC_LOG_ERROR, "buildNavigation: Could not build compact data.");
+	if (!rcBuildCompactHeightfield(&ctx, tcfg.walkableHeight, tcfg.walkableClimb, *rc.solid, *rc.chf)) {
+		ctx.log(RC_LOG_ERROR, "buildNavigation: Could not build compact data.");
 		return 0;
 	}
 
 // Erode the walkable area by agent radius.
-	if (!rcErodeWalkableArea(mCtx, tcfg.walkableRadius, *rc.chf)) {
-		mCtx->log(RC_LOG_ERROR, "buildNavigation: Could not erode.");
+	if (!rcErodeWalkableArea(&ctx, tcfg.walkableRadius, *rc.chf)) {
+		ctx.log(RC_LOG_ERROR, "buildNavigation: Could not erode.");
 		return 0;
 	}
 
@@ -1110,16 +1827,16 @@ int Awareness::rasterizeTileLayers(const std::vector<WFMath::RotBox<2>>& entityA
 		verts[10] = 0;
 		verts[11] = rotbox.getCorner(0).y();
 
-		rcMarkConvexPolyArea(mCtx, verts, 4, tcfg.bmin[1], tcfg.bmax[1], DT_TILECACHE_NULL_AREA, *rc.chf);
+		rcMarkConvexPolyArea(&ctx, verts, 4, tcfg.bmin[1], tcfg.bmax[1], DT_TILECACHE_NULL_AREA, *rc.chf);
 	}
 
 	rc.lset = rcAllocHeightfieldLayerSet();
 	if (!rc.lset) {
-		mCtx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'lset'.");
+		ctx.log(RC_LOG_ERROR, "buildNavigation: Out of memory 'lset'.");
 		return 0;
 	}
-	if (!rcBuildHeightfieldLayers(mCtx, *rc.chf, tcfg.borderSize, tcfg.walkableHeight, *rc.lset)) {
-		mCtx->log(RC_LOG_ERROR, "buildNavigation: Could not build heighfield layers.");
+	if (!rcBuildHeightfieldLayers(&ctx, *rc.chf, tcfg.borderSize, tcfg.walkableHeight, *rc.lset)) {
+		ctx.log(RC_LOG_ERROR, "buildNavigation: Could not build heighfield layers.");
 		return 0;
 	}
 
@@ -1158,8 +1875,8 @@ int Awareness::rasterizeTileLayers(const std::vector<WFMath::RotBox<2>>& entityA
 
 // Transfer ownership of tile data from build context to the caller.
 	int n = 0;
-	for (int i = 0; i < rcMin(rc.ntiles, maxTiles); ++i) {
-		tiles[n++] = rc.tiles[i];
+	for (int i = 0; i < rcMin(rc.ntiles, MAX_LAYERS); ++i) {
+		data.tiles[n++] = rc.tiles[i];
 		rc.tiles[i].data = 0;
 		rc.tiles[i].dataSize = 0;
 	}
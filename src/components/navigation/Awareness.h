@@ -23,6 +23,8 @@
 
 #include <wfmath/axisbox.h>
 #include <wfmath/point.h>
+#include <wfmath/rotbox.h>
+#include <wfmath/segment.h>
 
 #include <sigc++/signal.h>
 #include <sigc++/trackable.h>
@@ -34,6 +36,7 @@
 #include <map>
 #include <unordered_map>
 #include <functional>
+#include <chrono>
 
 class dtNavMeshQuery;
 class dtNavMesh;
@@ -42,8 +45,9 @@ class dtTileCachePolyMesh;
 class dtTileCacheLayer;
 class dtCompressedTile;
 class dtQueryFilter;
-class dtObstacleAvoidanceQuery;
 struct dtObstacleAvoidanceParams;
+typedef unsigned int dtObstacleRef;
+typedef unsigned int dtPolyRef;
 
 namespace Eris
 {
@@ -54,13 +58,22 @@ class Entity;
 namespace Ember
 {
 class IHeightProvider;
+namespace Tasks
+{
+class TaskQueue;
+}
 namespace Navigation
 {
-template <typename T>
-class MRUList;
+class TileMemoryTracker;
+template <typename KeyT>
+class AreaIndex;
 
 struct TileCacheData;
+struct TileBuildData;
 struct InputGeometry;
+class TileBuildTask;
+class PathCorridor;
+class ObstacleAvoidanceSampler;
 
 enum PolyAreas
 {
@@ -108,15 +121,28 @@ struct EntityConnections
  *
  * Internally this class uses a dtTileCache to manage the tiles. Since the world is dynamic we need to manage the
  * navmeshes through tiles in order to keep the resource usage down.
+ *
+ * Tiles are rasterized and compressed in background threads. The input data (heights and entity areas) is gathered
+ * on the main thread when a tile is dispatched, and the finished tiles are committed to the tile cache and the navmesh
+ * on the main thread in rebuildDirtyTile(), within a time budget.
  */
 class Awareness
 {
+friend class TileBuildTask;
 public:
 	/**
 	 * A callback function for processing tiles.
 	 */
 	typedef std::function<void(unsigned int, dtTileCachePolyMesh&, float* origin, float cellsize, float cellheight, dtTileCacheLayer& layer)> TileProcessor;
 
+	/**
+	 * A callback function for asynchronous path requests.
+	 * The first argument is the result, with the same semantics as the return value of findPath().
+	 * The second argument is the waypoints of the path.
+	 * The third argument is the polygon corridor of the path.
+	 */
+	typedef std::function<void(int, const std::list<WFMath::Point<3>>&, const PathCorridor&)> PathCallback;
+
 	/**
 	 * @brief Ctor.
 	 * @param view The world view.
@@ -136,11 +162,32 @@ public:
 	void setAwarenessArea(const WFMath::RotBox<2>& area, const WFMath::Segment<2>& focusLine);
 
 	/**
-	 * @brief Rebuilds a dirty tile if any such exists.
-	 * @return The number of dirty tiles remaining.
+	 * @brief Processes dirty tiles.
+	 *
+	 * Tiles which have been built in the background are committed to the navmesh, for as long as the commit budget allows
+	 * (at least one tile is always committed). Dirty tiles are then dispatched to be built in background threads.
+	 * Call this regularly (for example once per frame) as long as it returns a non zero value.
+	 * @return The number of tiles remaining to be processed, including those being built and those waiting to be committed.
 	 */
 	size_t rebuildDirtyTile();
 
+	/**
+	 * @brief Starts a bulk rebuild of all dirty tiles within the awareness area.
+	 *
+	 * All dirty tiles are dispatched to the background threads at once, and are then all committed together
+	 * when the last one is done, rather than being trickled in within the commit budget.
+	 * This is done automatically from setAwarenessArea() when many tiles become dirty at once, such as when
+	 * entering the world or when moving a long way. Progress is still driven by calling rebuildDirtyTile().
+	 * When completed, EventBulkRebuildCompleted is emitted.
+	 */
+	void startBulkRebuild();
+
+	/**
+	 * @brief Returns true if a bulk rebuild is in progress.
+	 * @return True if a bulk rebuild is in progress.
+	 */
+	bool isBulkRebuilding() const;
+
 	/**
 	 * @brief Finds a path from the start to the finish.
 	 * @param start A starting position.
@@ -150,6 +197,72 @@ public:
 	 */
 	int findPath(const WFMath::Point<3>& start, const WFMath::Point<3>& end, std::list<WFMath::Point<3>>& path) const;
 
+	/**
+	 * @brief Requests a path from the start to the finish, to be found asynchronously.
+	 *
+	 * The path search is spread out over multiple calls to processPathRequests(), using Detour's sliced path queries,
+	 * so that long paths don't stall the main thread. Requests are processed in order.
+	 * @param start A starting position.
+	 * @param end A finish position.
+	 * @param callback Called from processPathRequests() when the request is done.
+	 * @return An id for the request, which can be used to cancel it. Never 0.
+	 */
+	unsigned int requestPath(const WFMath::Point<3>& start, const WFMath::Point<3>& end, const PathCallback& callback);
+
+	/**
+	 * @brief Requests a path from the end of a corridor which doesn't reach its target, to the target.
+	 *
+	 * This is used to repair a corridor after parts of it have become invalid (see trimCorridor()), without having to search
+	 * for the whole path again. The resulting corridor starts with the last polygon of the supplied corridor.
+	 * @param corridor A corridor.
+	 * @param callback Called from processPathRequests() when the request is done.
+	 * @return An id for the request, or 0 if the corridor is empty.
+	 */
+	unsigned int requestCorridorRepair(const PathCorridor& corridor, const PathCallback& callback);
+
+	/**
+	 * @brief Moves the start of a corridor to a new position.
+	 * @param corridor A corridor.
+	 * @param position The new position, in view coordinates.
+	 * @return False if the position couldn't be matched with the corridor, in which case a new path needs to be found.
+	 */
+	bool moveCorridor(PathCorridor& corridor, const WFMath::Point<3>& position) const;
+
+	/**
+	 * @brief Looks for shortcuts at the start of a corridor.
+	 * @param corridor A corridor.
+	 */
+	void optimizeCorridor(PathCorridor& corridor) const;
+
+	/**
+	 * @brief Removes any polygons of a corridor which have become invalid, because the tiles they belong to have been rebuilt or removed.
+	 * @param corridor A corridor.
+	 * @return The number of polygons removed.
+	 */
+	size_t trimCorridor(PathCorridor& corridor) const;
+
+	/**
+	 * @brief Gets the waypoints of the straight path through a corridor.
+	 * @param corridor A corridor.
+	 * @param path The waypoints, in view coordinates, will be stored here.
+	 * @return The number of waypoints.
+	 */
+	int getCorridorPath(const PathCorridor& corridor, std::list<WFMath::Point<3>>& path) const;
+
+	/**
+	 * @brief Cancels a path request. The callback won't be called.
+	 * @param requestId The id of a request, as returned by requestPath(). Unknown ids are ignored.
+	 */
+	void cancelPathRequest(unsigned int requestId);
+
+	/**
+	 * @brief Processes pending path requests, for at most the number of search iterations set by the path iteration budget.
+	 *
+	 * Call this regularly (for example once per frame) as long as it returns a non zero value.
+	 * @return The number of path requests remaining.
+	 */
+	size_t processPathRequests();
+
 	/**
 	 * @brief Process the tile at the specified index.
 	 * @param tx X index.
@@ -181,9 +294,11 @@ public:
 	bool avoidObstacles(const WFMath::Point<2>& position, const WFMath::Vector<2>& desiredVelocity, WFMath::Vector<2>& newVelocity) const;
 
 	/**
-	 * @brief Prunes a tile if possible and needed.
+	 * @brief Prunes tiles if possible and needed.
 	 *
-	 * This removes a tile that isn't in the current awareness area, if needed.
+	 * If the memory used by tiles exceeds the budget, a batch of tiles that aren't in the current awareness area are removed.
+	 * The candidates are the least recently used tiles, and of those the ones furthest away from the focus line are removed first.
+	 * Removal continues until the memory use is below the low water mark, or the batch is done.
 	 */
 	void pruneTiles();
 
@@ -196,10 +311,64 @@ public:
 	bool needsPruning() const;
 
 	/**
-	 * @brief Sets the desired tile amount.
-	 * @param amount The new desired tile amount.
+	 * @brief Sets the amount of memory that tiles are allowed to use.
+	 *
+	 * This includes both the compressed tile layers and the built navmesh tiles.
+	 * Tiles inside the awareness area are never removed, so the budget might be exceeded if the area is large.
+	 * @param bytes The budget, in bytes.
 	 */
-	void setDesiredTilesAmount(size_t amount);
+	void setTileMemoryBudget(size_t bytes);
+
+	/**
+	 * @brief Gets the amount of memory currently used by tiles.
+	 * @return The memory used by the compressed tile layers and the navmesh tiles, in bytes.
+	 */
+	size_t getTileMemoryUsage() const;
+
+	/**
+	 * @brief Sets a directory in which built tiles are cached between sessions.
+	 *
+	 * Each tile is stored together with a hash of its height data, the entity areas affecting it and the Recast configuration.
+	 * When a tile is to be built and the hash matches the cached tile, it's loaded from disk instead of being rasterized.
+	 * Tiles are stored per server and world, and per navmesh configuration, so that the same directory can be shared between them.
+	 * @param directory A directory, including a trailing slash. An empty string disables the cache.
+	 */
+	void setTileCacheDirectory(const std::string& directory);
+
+	/**
+	 * @brief Rasterizes and compresses the layers of a tile.
+	 *
+	 * This only operates on the supplied data and context, so it's safe to call from a background thread.
+	 * It doesn't depend on any instance state, which also allows it to be benchmarked separately.
+	 * @param ctx A Recast context. Each thread should use its own context.
+	 * @param data The tile build data. The resulting compressed layers are stored in it.
+	 * @return The number of tile layers that were created.
+	 */
+	static int rasterizeTileLayers(rcContext& ctx, TileBuildData& data);
+
+	/**
+	 * @brief Sets up the Recast config and the height data bounds for building a tile.
+	 *
+	 * This doesn't depend on any instance state, which allows it to be used when benchmarking rasterizeTileLayers().
+	 * @param cfg The Recast config for the whole navmesh.
+	 * @param tx The tile x index.
+	 * @param ty The tile y index.
+	 * @param data The tile build data, which will have its tile index, config and height bounds set.
+	 */
+	static void prepareTileBounds(const rcConfig& cfg, int tx, int ty, TileBuildData& data);
+
+	/**
+	 * @brief Finds a path from the start to the finish, using the supplied query.
+	 *
+	 * This is what findPath() uses, but it doesn't depend on any instance state, which allows it to be benchmarked separately.
+	 * @param navQuery A query, set up for the navmesh.
+	 * @param filter The filter to use for the query.
+	 * @param start A starting position.
+	 * @param end A finish position.
+	 * @param path The waypoints of the path will be stored here.
+	 * @return The number of waypoints in the path, with the same semantics as the return value of findPath().
+	 */
+	static int findPath(const dtNavMeshQuery& navQuery, const dtQueryFilter& filter, const WFMath::Point<3>& start, const WFMath::Point<3>& end, std::list<WFMath::Point<3>>& path);
 
 	/**
 	 * @brief Emitted when a tile is updated.
@@ -223,6 +392,13 @@ public:
 	 */
 	sigc::signal<void> EventTileDirty;
 
+	/**
+	 * @brief Emitted when a bulk rebuild has completed.
+	 * @param size_t The number of tiles built.
+	 * @param float The total time, in seconds, from the start of the bulk rebuild until all tiles were committed.
+	 */
+	sigc::signal<void, size_t, float> EventBulkRebuildCompleted;
+
 protected:
 
 	Eris::View& mView;
@@ -256,14 +432,26 @@ protected:
 	float mAvatarRadius;
 
 	/**
-	 * @brief The desired amount of tiles to keep active.
+	 * @brief Keeps track of the memory used by tiles, and of the order in which they were used.
 	 *
-	 * If the number of unused tiles (i.e. not part of the current awareness) exceed this number
-	 * any controller should prune the tiles.
+	 * Whenever a tile is added to the awareness area, or built, it has it's priority increased.
+	 * If the memory used exceeds the budget any controller should prune the tiles.
 	 * @see pruneTiles()
 	 * @see needsPruning()
 	 */
-	size_t mDesiredTilesAmount;
+	TileMemoryTracker* mTileMemory;
+
+	/**
+	 * @brief The max number of tiles removed by each call to pruneTiles().
+	 */
+	size_t mMaxTilesPerPrune;
+
+	/**
+	 * @brief The focus line of the latest awareness area.
+	 *
+	 * Used when pruning, to keep tiles close to the line around for longer.
+	 */
+	WFMath::Segment<2> mFocusLine;
 
 	/**
 	 * @brief The main Recast context.
@@ -288,7 +476,11 @@ protected:
 	dtNavMesh* mNavMesh;
 	dtNavMeshQuery* mNavQuery;
 	dtQueryFilter* mFilter;
-	dtObstacleAvoidanceQuery* mObstacleAvoidanceQuery;
+
+	/**
+	 * @brief Finds velocities which avoid nearby moving entities.
+	 */
+	ObstacleAvoidanceSampler* mObstacleAvoidanceSampler;
 	dtObstacleAvoidanceParams* mObstacleAvoidanceParams;
 
 	/**
@@ -324,9 +516,10 @@ protected:
 	/**
 	 * @brief The view resolved areas for each entity.
 	 *
-	 * This information is used when determining what tiles to rebuild when entities are moved.
+	 * This information is used when determining what tiles to rebuild when entities are moved, and
+	 * when finding the entities to rasterize for each tile. The grid cells have the same size as the tiles.
 	 */
-	std::map<Eris::Entity*, WFMath::RotBox<2>> mEntityAreas;
+	AreaIndex<Eris::Entity*>* mEntityAreas;
 
 	/**
 	 * @brief Keeps track of all currently observed entities.
@@ -344,20 +537,289 @@ protected:
 	std::list<Eris::Entity*> mMovingEntities;
 
 	/**
-	 * @brief A Most Recently Used list of active tiles.
+	 * @brief A stationary entity which has moved, and is represented by a tile cache obstacle.
+	 */
+	struct DynamicObstacle
+	{
+		/**
+		 * @brief The current area of the entity.
+		 */
+		WFMath::RotBox<2> area;
+
+		/**
+		 * @brief The obstacle in the tile cache, or 0 if it hasn't been added yet.
+		 */
+		dtObstacleRef ref;
+	};
+
+	/**
+	 * @brief Entities without velocity which have been moved after they were first seen.
+	 *
+	 * Instead of rebuilding the tiles each time such an entity is moved it's added as an obstacle to the tile cache,
+	 * which only requires the navmesh of the affected tiles to be regenerated from the already compressed layers.
+	 * Entities too large to be represented by an obstacle are still handled by rebuilding tiles.
+	 */
+	std::unordered_map<Eris::Entity*, DynamicObstacle> mDynamicObstacles;
+
+	/**
+	 * @brief Dynamic obstacles which need to be (re)added to the tile cache.
+	 */
+	std::set<Eris::Entity*> mDirtyObstacles;
+
+	/**
+	 * @brief Obstacles which should be removed from the tile cache, along with their areas.
+	 *
+	 * The tile cache can only handle a limited amount of requests at once, so removals might have to wait.
+	 */
+	std::list<std::pair<dtObstacleRef, WFMath::RotBox<2>>> mObstaclesToRemove;
+
+	/**
+	 * @brief True if obstacle requests have been submitted, and dtTileCache::update() hasn't yet reported that all of them are processed.
+	 */
+	bool mObstacleUpdatesPending;
+
+	/**
+	 * @brief Tiles affected by the obstacle requests currently being processed.
+	 */
+	std::set<std::pair<int, int>> mObstacleAffectedTiles;
+
+	/**
+	 * @brief Task queue used for rasterizing tiles in background threads.
+	 */
+	Tasks::TaskQueue* mTaskQueue;
+
+	/**
+	 * @brief Tiles which currently are being rasterized in a background thread.
+	 *
+	 * A tile which is marked as dirty while being built won't be dispatched again until the current build is done.
+	 */
+	std::set<std::pair<int, int>> mTilesInProgress;
+
+	/**
+	 * @brief Tiles which have been rasterized in the background and are waiting to be committed.
+	 */
+	std::list<TileBuildData*> mBuiltTiles;
+
+	/**
+	 * @brief The max number of tiles which can be rasterized at the same time.
+	 */
+	size_t mMaxTilesInProgress;
+
+	/**
+	 * @brief The max time, in microseconds, spent committing built tiles in each call to rebuildDirtyTile().
+	 */
+	long mCommitBudget;
+
+	/**
+	 * @brief True if a bulk rebuild is in progress.
+	 * @see startBulkRebuild()
+	 */
+	bool mBulkRebuild;
+
+	/**
+	 * @brief The number of tiles dispatched in the current bulk rebuild.
+	 */
+	size_t mBulkRebuildTileCount;
+
+	/**
+	 * @brief When the current bulk rebuild was started.
+	 */
+	std::chrono::steady_clock::time_point mBulkRebuildStart;
+
+	/**
+	 * @brief The number of dirty tiles in the awareness area at which setAwarenessArea() will start a bulk rebuild.
+	 */
+	size_t mBulkRebuildThreshold;
+
+	/**
+	 * @brief The directory in which tiles are cached on disk. Empty if disabled.
+	 */
+	std::string mTileCacheDirectory;
+
+	/**
+	 * @brief Identifies the server and the world; part of the name and header of cached tiles.
+	 */
+	unsigned long long mTileCacheWorldId;
+
+	/**
+	 * @brief A hash of the navmesh configuration; part of the name and header of cached tiles.
+	 */
+	unsigned long long mTileCacheConfigHash;
+
+	/**
+	 * @brief An asynchronous path request.
+	 */
+	struct PathRequest
+	{
+		unsigned int id;
+		WFMath::Point<3> start;
+		WFMath::Point<3> end;
+		PathCallback callback;
+
+		/**
+		 * @brief The polygon to start from, or 0 if the polygon nearest to the start should be used.
+		 */
+		dtPolyRef startRef;
+
+		/**
+		 * @brief True if the sliced query has been initialized for this request.
+		 */
+		bool initialized;
+
+		/**
+		 * @brief The navmesh generation when the sliced query was initialized.
+		 */
+		unsigned int navMeshGeneration;
+
+		float startNearest[3];
+		float endNearest[3];
+	};
+
+	/**
+	 * @brief Navmesh query used for asynchronous path requests.
 	 *
-	 * Whenever a tile is added to the awareness area it has it's priority increased within this list.
-	 * This makes sure that those tiles that are at the back of the list always are the least used ones.
+	 * This is separate from the main query since a sliced query keeps state between calls,
+	 * which would be invalidated by any other path search using the same query.
+	 */
+	dtNavMeshQuery* mSlicedNavQuery;
+
+	/**
+	 * @brief Pending path requests. The first one is the one being processed.
+	 */
+	std::list<PathRequest> mPathRequests;
+
+	/**
+	 * @brief The id of the last path request.
+	 */
+	unsigned int mPathRequestCounter;
+
+	/**
+	 * @brief The max number of search iterations to perform in each call to processPathRequests().
+	 */
+	int mPathIterationBudget;
+
+	/**
+	 * @brief Incremented whenever tiles are added to or removed from the navmesh.
+	 *
+	 * A sliced query fails if a polygon it uses disappears; if the navmesh has changed since the query was started
+	 * it's restarted instead of being reported as a failure.
+	 */
+	unsigned int mNavMeshGeneration;
+
+	/**
+	 * @brief Initializes the sliced query for a path request.
+	 * @param request The request.
+	 * @return 0 if successful, else a negative value as returned by findPath().
 	 */
-	MRUList<std::pair<int, int>>* mActiveTileList;
+	int initPathRequest(PathRequest& request);
 
 	/**
-	 * @brief Rebuild the tile at the specific index.
+	 * @brief Removes the first path request and calls its callback.
+	 * @param result The result.
+	 * @param path The path.
+	 * @param corridor The corridor of the path.
+	 */
+	void finishPathRequest(int result, const std::list<WFMath::Point<3>>& path, const PathCorridor& corridor);
+
+	/**
+	 * @brief Tries to load the compressed layers of a tile from the disk cache.
+	 *
+	 * This is safe to call from a background thread.
+	 * @param data The tile build data. The hash and cache path must be set.
+	 * @return True if a cached tile with a matching hash was found and loaded.
+	 */
+	static bool loadCachedTile(TileBuildData& data);
+
+	/**
+	 * @brief Writes the compressed layers of a tile to the disk cache.
+	 *
+	 * This is safe to call from a background thread.
+	 * @param data The tile build data, with rasterized tiles.
+	 */
+	static void saveCachedTile(const TileBuildData& data);
+
+	/**
+	 * @brief Dispatches a dirty tile to be built in the background.
+	 * @param tileIndex The tile index.
+	 */
+	void dispatchTileBuild(const std::pair<int, int>& tileIndex);
+
+	/**
+	 * @brief Gathers all data needed to rasterize a tile.
+	 *
+	 * This must be called on the main thread.
 	 * @param tx X index.
 	 * @param ty Y index.
-	 * @param entityAreas A list of entities, projected as 2d rotation boxes, which affects the tile.
+	 * @param data The build data to fill.
 	 */
-	void rebuildTile(int tx, int ty, const std::vector<WFMath::RotBox<2>>& entityAreas);
+	void prepareTileBuild(int tx, int ty, TileBuildData& data);
+
+	/**
+	 * @brief Commits a rasterized tile to the tile cache and rebuilds the navmesh for it.
+	 *
+	 * This must be called on the main thread.
+	 * @param data Rasterized tile data. Ownership of the compressed tiles is transferred to the tile cache.
+	 */
+	void commitTile(TileBuildData& data);
+
+	/**
+	 * @brief Recalculates the memory used by the compressed layers and the navmesh tiles at a tile index.
+	 * @param tx The tile x index.
+	 * @param ty The tile y index.
+	 */
+	void updateTileMemory(int tx, int ty);
+
+	/**
+	 * @brief Checks whether a tile is being built, or has been built but not yet committed.
+	 * @param index The tile index.
+	 * @return True if the tile is being built.
+	 */
+	bool isTileBuildPending(const std::pair<int, int>& index) const;
+
+	/**
+	 * @brief Removes all layers at a tile index from both the tile cache and the navmesh.
+	 * @param tx The tile x index.
+	 * @param ty The tile y index.
+	 */
+	void removeTiles(int tx, int ty);
+
+	/**
+	 * @brief Called on the main thread when a tile has been rasterized in the background.
+	 * @param data The build data. Ownership is transferred.
+	 */
+	void tileBuilt(TileBuildData* data);
+
+	/**
+	 * @brief Checks if an entity area is small enough to be represented by a tile cache obstacle.
+	 * @param area An entity area.
+	 * @return True if the area can be used as an obstacle.
+	 */
+	bool canBeObstacle(const WFMath::RotBox<2>& area) const;
+
+	/**
+	 * @brief Marks the dynamic obstacle of the entity as in need of being (re)added to the tile cache.
+	 * @param entity An entity which has a dynamic obstacle.
+	 */
+	void markObstacleAsDirty(Eris::Entity* entity);
+
+	/**
+	 * @brief Removes the dynamic obstacle of the entity, if there is any.
+	 * @param entity An entity.
+	 * @return True if the entity had a dynamic obstacle.
+	 */
+	bool removeDynamicObstacle(Eris::Entity* entity);
+
+	/**
+	 * @brief Registers that an obstacle request covering the supplied area has been submitted to the tile cache.
+	 * @param area The area of the obstacle.
+	 */
+	void obstacleRequestSubmitted(const WFMath::RotBox<2>& area);
+
+	/**
+	 * @brief Submits obstacle changes to the tile cache and updates the navmesh for them.
+	 * @param budget The max time, in microseconds, to spend updating tiles.
+	 */
+	void updateObstacles(long budget);
 
 	/**
 	 * @brief Calculates the 2d rotbox area of the entity and adds it to the supplied map of areas.
@@ -373,17 +835,6 @@ protected:
 	 */
 	void findEntityAreas(const WFMath::AxisBox<2>& extent, std::vector<WFMath::RotBox<2> >& areas);
 
-	/**
-	 * @brief Rasterizes the tile at the specified index.
-	 * @param entityAreas The entity areas that affects the tile.
-	 * @param tx X index.
-	 * @param ty Y index.
-	 * @param tiles Out parameter for the tiles.
-	 * @param maxTiles The maximum number of tile layers to create.
-	 * @return The number of tile layers that were created.
-	 */
-	int rasterizeTileLayers(const std::vector<WFMath::RotBox<2>>& entityAreas, const int tx, const int ty, TileCacheData* tiles, const int maxTiles);
-
 	/**
 	 * @brief Applies the supplied processor on the supplied tiles.
 	 * @param tiles A collection of tile references.
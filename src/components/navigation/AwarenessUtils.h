@@ -46,7 +46,13 @@
 #include "DetourCommon.h"
 #include "DetourTileCache.h"
 #include "DetourTileCacheBuilder.h"
+#include "Recast.h"
+
+#include <wfmath/rotbox.h>
+
 #include <string.h>
+#include <string>
+#include <vector>
 
 namespace Ember
 {
@@ -191,6 +197,79 @@ struct RasterizationContext
 	int ntiles;
 };
 
+/**
+ * @brief Holds everything needed to rasterize a tile, as well as the result.
+ *
+ * An instance is filled in on the main thread, rasterized in a background thread and then committed on the main thread again.
+ * Since the rasterization doesn't touch any shared state the input (such as height data) is copied into the instance beforehand.
+ */
+struct TileBuildData
+{
+	TileBuildData() :
+			tx(0), ty(0), heightsXMin(0), heightsXMax(0), heightsYMin(0), heightsYMax(0), hash(0), cacheWorldId(0), cacheConfigHash(0), ntiles(0)
+	{
+		memset(&cfg, 0, sizeof(rcConfig));
+		memset(tiles, 0, sizeof(TileCacheData) * MAX_LAYERS);
+	}
+
+	~TileBuildData()
+	{
+		for (int i = 0; i < MAX_LAYERS; ++i) {
+			dtFree(tiles[i].data);
+			tiles[i].data = 0;
+		}
+	}
+
+	int tx;
+	int ty;
+
+	/**
+	 * @brief The Recast config, adjusted to the bounds of the tile.
+	 */
+	rcConfig cfg;
+
+	int heightsXMin;
+	int heightsXMax;
+	int heightsYMin;
+	int heightsYMax;
+
+	/**
+	 * @brief Height data with 1 meter interval, covering the tile including its border.
+	 */
+	std::vector<float> heights;
+
+	/**
+	 * @brief Areas of the entities which affect the tile.
+	 */
+	std::vector<WFMath::RotBox<2>> entityAreas;
+
+	/**
+	 * @brief A hash of all input which affects the tile; used for the disk cache.
+	 */
+	unsigned long long hash;
+
+	/**
+	 * @brief Identifies the server and world the tile belongs to; used for the disk cache.
+	 */
+	unsigned long long cacheWorldId;
+
+	/**
+	 * @brief A hash of the navmesh configuration the tile was built with; used for the disk cache.
+	 */
+	unsigned long long cacheConfigHash;
+
+	/**
+	 * @brief Path to the file in which the tile is cached on disk. Empty if there's no disk cache.
+	 */
+	std::string cachePath;
+
+	/**
+	 * @brief The compressed tile layers; the result of the rasterization.
+	 */
+	TileCacheData tiles[MAX_LAYERS];
+	int ntiles;
+};
+
 }
 }
 
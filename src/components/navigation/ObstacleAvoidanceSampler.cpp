@@ -0,0 +1,344 @@
+/*
+ Copyright (C) 2014 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+ This work is based on the dtObstacleAvoidanceQuery class by Mikko Mononen.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "ObstacleAvoidanceSampler.h"
+
+#include "DetourObstacleAvoidance.h"
+#include "DetourCommon.h"
+
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define EMBER_NAVIGATION_SSE 1
+#endif
+
+namespace Ember
+{
+namespace Navigation
+{
+
+namespace
+{
+const float PI = 3.14159265f;
+
+//Velocities below this are considered to not be moving, in the sweep test.
+const float SWEEP_EPS = 0.0001f;
+}
+
+ObstacleAvoidanceSampler::ObstacleAvoidanceSampler(size_t maxCircles) :
+		mMaxCircles(maxCircles)
+{
+	for (auto array : { &mCircleX, &mCircleZ, &mCircleRad, &mCircleVelX, &mCircleVelZ, &mCircleSX, &mCircleSZ, &mCircleDpX, &mCircleDpZ, &mCircleNpX, &mCircleNpZ, &mCircleC }) {
+		array->reserve(maxCircles);
+	}
+}
+
+void ObstacleAvoidanceSampler::reset()
+{
+	mCircleX.clear();
+	mCircleZ.clear();
+	mCircleRad.clear();
+	mCircleVelX.clear();
+	mCircleVelZ.clear();
+}
+
+bool ObstacleAvoidanceSampler::addCircle(const float* pos, float rad, const float* vel)
+{
+	if (mCircleX.size() >= mMaxCircles) {
+		return false;
+	}
+	mCircleX.push_back(pos[0]);
+	mCircleZ.push_back(pos[2]);
+	mCircleRad.push_back(rad);
+	mCircleVelX.push_back(vel[0]);
+	mCircleVelZ.push_back(vel[2]);
+	return true;
+}
+
+size_t ObstacleAvoidanceSampler::getCircleCount() const
+{
+	return mCircleX.size();
+}
+
+void ObstacleAvoidanceSampler::prepare(const float* pos, float rad, const float* dvel)
+{
+	size_t count = mCircleX.size();
+	mCircleSX.resize(count);
+	mCircleSZ.resize(count);
+	mCircleDpX.resize(count);
+	mCircleDpZ.resize(count);
+	mCircleNpX.resize(count);
+	mCircleNpZ.resize(count);
+	mCircleC.resize(count);
+
+	for (size_t i = 0; i < count; ++i) {
+		float sx = mCircleX[i] - pos[0];
+		float sz = mCircleZ[i] - pos[2];
+		mCircleSX[i] = sx;
+		mCircleSZ[i] = sz;
+		float r = rad + mCircleRad[i];
+		mCircleC[i] = sx * sx + sz * sz - r * r;
+
+		//Direction to the obstacle.
+		float length = std::sqrt(sx * sx + sz * sz);
+		float dpx = 0, dpz = 0;
+		if (length > 0.0f) {
+			dpx = sx / length;
+			dpz = sz / length;
+		}
+		mCircleDpX[i] = dpx;
+		mCircleDpZ[i] = dpz;
+
+		//Pick the side to pass the obstacle on from the relative velocity, same as dtObstacleAvoidanceQuery::prepare().
+		float dvx = mCircleVelX[i] - dvel[0];
+		float dvz = mCircleVelZ[i] - dvel[2];
+		float area = dvx * dpz - dpx * dvz;
+		if (area < 0.01f) {
+			mCircleNpX[i] = -dpz;
+			mCircleNpZ[i] = dpx;
+		} else {
+			mCircleNpX[i] = dpz;
+			mCircleNpZ[i] = -dpx;
+		}
+	}
+}
+
+float ObstacleAvoidanceSampler::scoreSample(float candX, float candZ, const float* vel, const float* dvel, float invVmax, float invHorizTime, const dtObstacleAvoidanceParams& params) const
+{
+	float tmin = params.horizTime;
+	float side = 0;
+	size_t count = mCircleX.size();
+
+	for (size_t i = 0; i < count; ++i) {
+		//RVO
+		float vabX = candX * 2 - vel[0] - mCircleVelX[i];
+		float vabZ = candZ * 2 - vel[2] - mCircleVelZ[i];
+
+		side += dtClamp(dtMin((mCircleDpX[i] * vabX + mCircleDpZ[i] * vabZ) * 0.5f + 0.5f, (mCircleNpX[i] * vabX + mCircleNpZ[i] * vabZ) * 2), 0.0f, 1.0f);
+
+		float a = vabX * vabX + vabZ * vabZ;
+		if (a < SWEEP_EPS) {
+			continue;
+		}
+		float b = vabX * mCircleSX[i] + vabZ * mCircleSZ[i];
+		float d = b * b - a * mCircleC[i];
+		if (d < 0.0f) {
+			continue;
+		}
+		float rd = std::sqrt(d);
+		float htmin = (b - rd) / a;
+		float htmax = (b + rd) / a;
+
+		//Avoid more when overlapped.
+		if (htmin < 0.0f && htmax > 0.0f) {
+			htmin = -htmin * 0.5f;
+		}
+		if (htmin >= 0.0f && htmin < tmin) {
+			tmin = htmin;
+		}
+	}
+
+	//Normalize side bias, to prevent it dominating too much.
+	if (count) {
+		side /= count;
+	}
+
+	float dx = candX - dvel[0], dz = candZ - dvel[2];
+	float cx = candX - vel[0], cz = candZ - vel[2];
+	float vpen = params.weightDesVel * (std::sqrt(dx * dx + dz * dz) * invVmax);
+	float vcpen = params.weightCurVel * (std::sqrt(cx * cx + cz * cz) * invVmax);
+	float spen = params.weightSide * side;
+	float tpen = params.weightToi * (1.0f / (0.1f + tmin * invHorizTime));
+	return vpen + vcpen + spen + tpen;
+}
+
+void ObstacleAvoidanceSampler::scoreSamples(const float* candX, const float* candZ, size_t count, const float* vel, const float* dvel, float invVmax, float invHorizTime, const dtObstacleAvoidanceParams& params, float* penalties) const
+{
+#ifdef EMBER_NAVIGATION_SSE
+	const size_t ncircles = mCircleX.size();
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 two = _mm_set1_ps(2.0f);
+	const __m128 eps = _mm_set1_ps(SWEEP_EPS);
+
+	//Four candidate velocities are scored against each obstacle at once.
+	for (size_t j = 0; j < count; j += 4) {
+		const __m128 cx = _mm_loadu_ps(candX + j);
+		const __m128 cz = _mm_loadu_ps(candZ + j);
+		__m128 tmin = _mm_set1_ps(params.horizTime);
+		__m128 side = zero;
+
+		for (size_t i = 0; i < ncircles; ++i) {
+			//RVO
+			const __m128 vabX = _mm_sub_ps(_mm_mul_ps(cx, two), _mm_set1_ps(vel[0] + mCircleVelX[i]));
+			const __m128 vabZ = _mm_sub_ps(_mm_mul_ps(cz, two), _mm_set1_ps(vel[2] + mCircleVelZ[i]));
+
+			const __m128 dpDot = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(mCircleDpX[i]), vabX), _mm_mul_ps(_mm_set1_ps(mCircleDpZ[i]), vabZ));
+			const __m128 npDot = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(mCircleNpX[i]), vabX), _mm_mul_ps(_mm_set1_ps(mCircleNpZ[i]), vabZ));
+			const __m128 sideValue = _mm_min_ps(_mm_add_ps(_mm_mul_ps(dpDot, half), half), _mm_mul_ps(npDot, two));
+			side = _mm_add_ps(side, _mm_min_ps(_mm_max_ps(sideValue, zero), one));
+
+			const __m128 a = _mm_add_ps(_mm_mul_ps(vabX, vabX), _mm_mul_ps(vabZ, vabZ));
+			const __m128 b = _mm_add_ps(_mm_mul_ps(vabX, _mm_set1_ps(mCircleSX[i])), _mm_mul_ps(vabZ, _mm_set1_ps(mCircleSZ[i])));
+			const __m128 d = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(a, _mm_set1_ps(mCircleC[i])));
+			const __m128 hit = _mm_and_ps(_mm_cmpge_ps(a, eps), _mm_cmpge_ps(d, zero));
+			if (_mm_movemask_ps(hit) == 0) {
+				continue;
+			}
+
+			//The clamps keep lanes without a hit finite; their results are masked out below.
+			const __m128 rd = _mm_sqrt_ps(_mm_max_ps(d, zero));
+			const __m128 invA = _mm_div_ps(one, _mm_max_ps(a, eps));
+			__m128 htmin = _mm_mul_ps(_mm_sub_ps(b, rd), invA);
+			const __m128 htmax = _mm_mul_ps(_mm_add_ps(b, rd), invA);
+
+			//Avoid more when overlapped.
+			const __m128 overlapped = _mm_and_ps(_mm_cmplt_ps(htmin, zero), _mm_cmpgt_ps(htmax, zero));
+			htmin = _mm_or_ps(_mm_and_ps(overlapped, _mm_mul_ps(htmin, _mm_set1_ps(-0.5f))), _mm_andnot_ps(overlapped, htmin));
+
+			const __m128 ahead = _mm_and_ps(hit, _mm_cmpge_ps(htmin, zero));
+			tmin = _mm_or_ps(_mm_and_ps(ahead, _mm_min_ps(tmin, htmin)), _mm_andnot_ps(ahead, tmin));
+		}
+
+		//Normalize side bias, to prevent it dominating too much.
+		if (ncircles) {
+			side = _mm_mul_ps(side, _mm_set1_ps(1.0f / ncircles));
+		}
+
+		const __m128 dx = _mm_sub_ps(cx, _mm_set1_ps(dvel[0]));
+		const __m128 dz = _mm_sub_ps(cz, _mm_set1_ps(dvel[2]));
+		const __m128 vx = _mm_sub_ps(cx, _mm_set1_ps(vel[0]));
+		const __m128 vz = _mm_sub_ps(cz, _mm_set1_ps(vel[2]));
+		const __m128 vpen = _mm_mul_ps(_mm_set1_ps(params.weightDesVel * invVmax), _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dz, dz))));
+		const __m128 vcpen = _mm_mul_ps(_mm_set1_ps(params.weightCurVel * invVmax), _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vz, vz))));
+		const __m128 spen = _mm_mul_ps(_mm_set1_ps(params.weightSide), side);
+		const __m128 tpen = _mm_div_ps(_mm_set1_ps(params.weightToi), _mm_add_ps(_mm_set1_ps(0.1f), _mm_mul_ps(tmin, _mm_set1_ps(invHorizTime))));
+
+		_mm_storeu_ps(penalties + j, _mm_add_ps(_mm_add_ps(vpen, vcpen), _mm_add_ps(spen, tpen)));
+	}
+#else
+	for (size_t j = 0; j < count; ++j) {
+		penalties[j] = scoreSample(candX[j], candZ[j], vel, dvel, invVmax, invHorizTime, params);
+	}
+#endif
+}
+
+int ObstacleAvoidanceSampler::sampleVelocityAdaptive(const float* pos, float rad, float vmax, const float* vel, const float* dvel, float* nvel, const dtObstacleAvoidanceParams& params)
+{
+	prepare(pos, rad, dvel);
+
+	const float invHorizTime = 1.0f / params.horizTime;
+	const float invVmax = 1.0f / vmax;
+
+	dtVset(nvel, 0, 0, 0);
+
+	//Build sampling pattern aligned to desired velocity.
+	static const int MAX_PATTERN = DT_MAX_PATTERN_DIVS * DT_MAX_PATTERN_RINGS + 1;
+	float patX[MAX_PATTERN];
+	float patZ[MAX_PATTERN];
+	int npat = 0;
+
+	const int nd = dtClamp((int)params.adaptiveDivs, 1, DT_MAX_PATTERN_DIVS);
+	const int nr = dtClamp((int)params.adaptiveRings, 1, DT_MAX_PATTERN_RINGS);
+	const int depth = (int)params.adaptiveDepth;
+	const float da = (1.0f / nd) * PI * 2;
+	const float dang = std::atan2(dvel[2], dvel[0]);
+
+	//Always add sample at zero
+	patX[npat] = 0;
+	patZ[npat] = 0;
+	npat++;
+
+	for (int j = 0; j < nr; ++j) {
+		const float r = (float)(nr - j) / (float)nr;
+		float a = dang + (j & 1) * 0.5f * da;
+		for (int i = 0; i < nd; ++i) {
+			patX[npat] = std::cos(a) * r;
+			patZ[npat] = std::sin(a) * r;
+			npat++;
+			a += da;
+		}
+	}
+
+	//Candidate arrays are padded to a multiple of four, so that they can be scored in batches.
+	float candX[MAX_PATTERN + 3];
+	float candZ[MAX_PATTERN + 3];
+	float penalties[MAX_PATTERN + 3];
+
+	float cr = vmax * (1.0f - params.velBias);
+	float resX = dvel[0] * params.velBias;
+	float resZ = dvel[2] * params.velBias;
+	int ns = 0;
+
+	for (int k = 0; k < depth; ++k) {
+		size_t ncand = 0;
+		for (int i = 0; i < npat; ++i) {
+			float x = resX + patX[i] * cr;
+			float z = resZ + patZ[i] * cr;
+			if (dtSqr(x) + dtSqr(z) > dtSqr(vmax + 0.001f)) {
+				continue;
+			}
+			candX[ncand] = x;
+			candZ[ncand] = z;
+			ncand++;
+		}
+
+		float bestX = 0, bestZ = 0;
+		if (ncand) {
+			size_t padded = (ncand + 3) & ~size_t(3);
+			for (size_t i = ncand; i < padded; ++i) {
+				candX[i] = candX[0];
+				candZ[i] = candZ[0];
+			}
+			scoreSamples(candX, candZ, padded, vel, dvel, invVmax, invHorizTime, params, penalties);
+
+			float minPenalty = FLT_MAX;
+			for (size_t i = 0; i < ncand; ++i) {
+				if (penalties[i] < minPenalty) {
+					minPenalty = penalties[i];
+					bestX = candX[i];
+					bestZ = candZ[i];
+				}
+			}
+			ns += static_cast<int>(ncand);
+		}
+
+		resX = bestX;
+		resZ = bestZ;
+
+		cr *= 0.5f;
+	}
+
+	nvel[0] = resX;
+	nvel[2] = resZ;
+
+	return ns;
+}
+
+}
+}
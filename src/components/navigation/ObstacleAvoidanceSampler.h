@@ -0,0 +1,125 @@
+/*
+ Copyright (C) 2014 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+ This work is based on the dtObstacleAvoidanceQuery class by Mikko Mononen.
+ */
+
+#ifndef OBSTACLEAVOIDANCESAMPLER_H_
+#define OBSTACLEAVOIDANCESAMPLER_H_
+
+#include <vector>
+#include <cstddef>
+
+struct dtObstacleAvoidanceParams;
+
+namespace Ember
+{
+namespace Navigation
+{
+
+/**
+ * @brief Finds a velocity which avoids moving circular obstacles, by scoring candidate velocities in an adaptive pattern.
+ *
+ * This uses the same sampling and scoring as dtObstacleAvoidanceSampleVelocityAdaptive, but the obstacles are stored
+ * as arrays of components, and the candidate velocities are scored several at a time using SSE when available.
+ * This makes it cheap enough to consider more obstacles each frame.
+ *
+ * Only circle obstacles are supported; the navmesh boundaries are handled by the path corridor.
+ * All positions are in Recast coordinates, with the y axis ignored.
+ */
+class ObstacleAvoidanceSampler
+{
+public:
+
+	/**
+	 * @brief Ctor.
+	 * @param maxCircles The max number of obstacles which can be added.
+	 */
+	explicit ObstacleAvoidanceSampler(size_t maxCircles);
+
+	/**
+	 * @brief Removes all obstacles.
+	 */
+	void reset();
+
+	/**
+	 * @brief Adds an obstacle.
+	 * @param pos The position of the obstacle.
+	 * @param rad The radius of the obstacle.
+	 * @param vel The velocity of the obstacle.
+	 * @return False if the max number of obstacles already have been added.
+	 */
+	bool addCircle(const float* pos, float rad, const float* vel);
+
+	/**
+	 * @brief Gets the number of obstacles.
+	 * @return The number of obstacles.
+	 */
+	size_t getCircleCount() const;
+
+	/**
+	 * @brief Samples velocities in an adaptive pattern aligned to the desired velocity, and picks the one with the lowest penalty.
+	 * @param pos The position of the agent.
+	 * @param rad The radius of the agent.
+	 * @param vmax The max speed of the agent.
+	 * @param vel The current velocity of the agent.
+	 * @param dvel The desired velocity of the agent.
+	 * @param nvel The new velocity is written to this.
+	 * @param params Sampling parameters.
+	 * @return The number of samples scored.
+	 */
+	int sampleVelocityAdaptive(const float* pos, float rad, float vmax, const float* vel, const float* dvel, float* nvel, const dtObstacleAvoidanceParams& params);
+
+private:
+
+	size_t mMaxCircles;
+
+	/**
+	 * @brief The obstacles, stored as separate arrays for each component to allow several samples to be scored at once.
+	 *
+	 * The "S", "Dp" and "Np" arrays are the offset to the obstacle, its direction and the preferred side to pass it on, calculated in prepare().
+	 */
+	std::vector<float> mCircleX, mCircleZ, mCircleRad, mCircleVelX, mCircleVelZ;
+	std::vector<float> mCircleSX, mCircleSZ, mCircleDpX, mCircleDpZ, mCircleNpX, mCircleNpZ;
+
+	/**
+	 * @brief Per obstacle constant part of the sweep test; the squared distance to the obstacle minus the squared combined radius.
+	 */
+	std::vector<float> mCircleC;
+
+	/**
+	 * @brief Calculates the per obstacle values which don't depend on the candidate velocity.
+	 */
+	void prepare(const float* pos, float rad, const float* dvel);
+
+	/**
+	 * @brief Calculates the penalties for a number of candidate velocities.
+	 *
+	 * The candidate arrays must be padded to a multiple of four.
+	 */
+	void scoreSamples(const float* candX, const float* candZ, size_t count, const float* vel, const float* dvel, float invVmax, float invHorizTime, const dtObstacleAvoidanceParams& params, float* penalties) const;
+
+	/**
+	 * @brief Calculates the penalty for a single candidate velocity.
+	 */
+	float scoreSample(float candX, float candZ, const float* vel, const float* dvel, float invVmax, float invHorizTime, const dtObstacleAvoidanceParams& params) const;
+};
+
+}
+}
+
+#endif /* OBSTACLEAVOIDANCESAMPLER_H_ */
@@ -0,0 +1,275 @@
+/*
+ Copyright (C) 2014 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+ This work is based on the dtPathCorridor class by Mikko Mononen.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "PathCorridor.h"
+
+#include "DetourNavMeshQuery.h"
+#include "DetourCommon.h"
+
+#include <algorithm>
+
+namespace Ember
+{
+namespace Navigation
+{
+
+namespace
+{
+
+/**
+ * @brief Merges the polygons visited when moving along the surface into the start of the path.
+ */
+void mergeCorridorStartMoved(std::vector<dtPolyRef>& path, const dtPolyRef* visited, int nvisited)
+{
+	int furthestPath = -1;
+	int furthestVisited = -1;
+
+	// Find furthest common polygon.
+	for (int i = static_cast<int>(path.size()) - 1; i >= 0 && furthestPath == -1; --i) {
+		for (int j = nvisited - 1; j >= 0; --j) {
+			if (path[i] == visited[j]) {
+				furthestPath = i;
+				furthestVisited = j;
+			}
+		}
+	}
+
+	// If no intersection found just keep the current path.
+	if (furthestPath == -1 || furthestVisited == -1) {
+		return;
+	}
+
+	// The new path starts with the visited polygons, from the current one back to the common one, followed by the rest of the path.
+	std::vector<dtPolyRef> newPath;
+	newPath.reserve(nvisited - furthestVisited + path.size() - furthestPath);
+	for (int i = nvisited - 1; i >= furthestVisited; --i) {
+		newPath.push_back(visited[i]);
+	}
+	newPath.insert(newPath.end(), path.begin() + furthestPath + 1, path.end());
+	path.swap(newPath);
+}
+
+/**
+ * @brief Merges a shortcut found by a local search into the start of the path.
+ */
+void mergeCorridorStartShortcut(std::vector<dtPolyRef>& path, const dtPolyRef* visited, int nvisited)
+{
+	int furthestPath = -1;
+	int furthestVisited = -1;
+
+	// Find furthest common polygon.
+	for (int i = static_cast<int>(path.size()) - 1; i >= 0 && furthestPath == -1; --i) {
+		for (int j = nvisited - 1; j >= 0; --j) {
+			if (path[i] == visited[j]) {
+				furthestPath = i;
+				furthestVisited = j;
+			}
+		}
+	}
+
+	// If no intersection found, or the shortcut doesn't skip anything, just keep the current path.
+	if (furthestPath == -1 || furthestVisited <= 0) {
+		return;
+	}
+
+	std::vector<dtPolyRef> newPath(visited, visited + furthestVisited);
+	newPath.insert(newPath.end(), path.begin() + furthestPath, path.end());
+	path.swap(newPath);
+}
+
+}
+
+PathCorridor::PathCorridor() :
+		mReachesTarget(false)
+{
+	dtVset(mPos, 0, 0, 0);
+	dtVset(mTarget, 0, 0, 0);
+}
+
+void PathCorridor::reset(dtPolyRef ref, const float* pos)
+{
+	dtVcopy(mPos, pos);
+	dtVcopy(mTarget, pos);
+	mPath.assign(1, ref);
+	mReachesTarget = true;
+}
+
+void PathCorridor::clear()
+{
+	mPath.clear();
+	mReachesTarget = false;
+}
+
+void PathCorridor::setCorridor(const float* pos, const float* target, const std::vector<dtPolyRef>& polys)
+{
+	dtVcopy(mPos, pos);
+	dtVcopy(mTarget, target);
+	mPath = polys;
+	mReachesTarget = !mPath.empty();
+}
+
+void PathCorridor::appendCorridor(const float* target, const std::vector<dtPolyRef>& polys)
+{
+	dtVcopy(mTarget, target);
+	auto I = polys.begin();
+	if (!mPath.empty() && I != polys.end() && *I == mPath.back()) {
+		++I;
+	}
+	mPath.insert(mPath.end(), I, polys.end());
+	mReachesTarget = !mPath.empty();
+}
+
+bool PathCorridor::movePosition(const float* npos, dtNavMeshQuery* navquery, const dtQueryFilter* filter)
+{
+	if (mPath.empty()) {
+		return false;
+	}
+
+	// Move along navmesh and update new position.
+	static const int MAX_VISITED = 16;
+	float result[3];
+	dtPolyRef visited[MAX_VISITED];
+	int nvisited = 0;
+	dtStatus status = navquery->moveAlongSurface(mPath.front(), mPos, npos, filter, result, visited, &nvisited, MAX_VISITED);
+	if (dtStatusFailed(status)) {
+		return false;
+	}
+
+	mergeCorridorStartMoved(mPath, visited, nvisited);
+
+	// Adjust the position to stay on top of the navmesh.
+	float h = mPos[1];
+	navquery->getPolyHeight(mPath.front(), result, &h);
+	result[1] = h;
+	dtVcopy(mPos, result);
+	return true;
+}
+
+bool PathCorridor::optimizePathTopology(dtNavMeshQuery* navquery, const dtQueryFilter* filter)
+{
+	if (mPath.size() < 3) {
+		return false;
+	}
+
+	static const int MAX_ITER = 32;
+	static const int MAX_RES = 32;
+
+	dtPolyRef res[MAX_RES];
+	int nres = 0;
+	navquery->initSlicedFindPath(mPath.front(), mPath.back(), mPos, mTarget, filter);
+	navquery->updateSlicedFindPath(MAX_ITER, 0);
+	dtStatus status = navquery->finalizeSlicedFindPathPartial(mPath.data(), static_cast<int>(mPath.size()), res, &nres, MAX_RES);
+
+	if (dtStatusSucceed(status) && nres > 0) {
+		size_t oldSize = mPath.size();
+		mergeCorridorStartShortcut(mPath, res, nres);
+		return mPath.size() != oldSize;
+	}
+
+	return false;
+}
+
+bool PathCorridor::fixPathStart(dtPolyRef safeRef, const float* safePos)
+{
+	dtVcopy(mPos, safePos);
+	auto I = std::find(mPath.begin(), mPath.end(), safeRef);
+	if (I == mPath.end()) {
+		return false;
+	}
+	mPath.erase(mPath.begin(), I);
+	return true;
+}
+
+size_t PathCorridor::trimInvalidPath(dtNavMeshQuery* navquery, const dtQueryFilter* filter)
+{
+	for (size_t i = 0; i < mPath.size(); ++i) {
+		if (!navquery->isValidPolyRef(mPath[i], filter)) {
+			size_t removed = mPath.size() - i;
+			mPath.resize(i);
+			mReachesTarget = false;
+			return removed;
+		}
+	}
+	return 0;
+}
+
+int PathCorridor::findStraightPath(dtNavMeshQuery* navquery, float* straightPath, int maxStraightPath) const
+{
+	if (mPath.empty()) {
+		return 0;
+	}
+
+	//If the corridor doesn't reach the target, go as far as the corridor goes.
+	float target[3];
+	if (mReachesTarget) {
+		dtVcopy(target, mTarget);
+	} else if (dtStatusFailed(navquery->closestPointOnPoly(mPath.back(), mTarget, target, nullptr))) {
+		return 0;
+	}
+
+	int count = 0;
+	dtStatus status = navquery->findStraightPath(mPos, target, mPath.data(), static_cast<int>(mPath.size()), straightPath, nullptr, nullptr, &count, maxStraightPath);
+	if (dtStatusFailed(status)) {
+		return 0;
+	}
+	return count;
+}
+
+const float* PathCorridor::getPos() const
+{
+	return mPos;
+}
+
+const float* PathCorridor::getTarget() const
+{
+	return mTarget;
+}
+
+dtPolyRef PathCorridor::getFirstPoly() const
+{
+	return mPath.empty() ? 0 : mPath.front();
+}
+
+dtPolyRef PathCorridor::getLastPoly() const
+{
+	return mPath.empty() ? 0 : mPath.back();
+}
+
+const std::vector<dtPolyRef>& PathCorridor::getPath() const
+{
+	return mPath;
+}
+
+bool PathCorridor::isEmpty() const
+{
+	return mPath.empty();
+}
+
+bool PathCorridor::reachesTarget() const
+{
+	return mReachesTarget;
+}
+
+}
+}
@@ -0,0 +1,167 @@
+/*
+ Copyright (C) 2014 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+ This work is based on the dtPathCorridor class by Mikko Mononen.
+ */
+
+#ifndef PATHCORRIDOR_H_
+#define PATHCORRIDOR_H_
+
+#include <vector>
+#include <cstddef>
+
+class dtNavMeshQuery;
+class dtQueryFilter;
+typedef unsigned int dtPolyRef;
+
+namespace Ember
+{
+namespace Navigation
+{
+
+/**
+ * @brief A path represented as a corridor of navmesh polygons, with a current position at its start and a target at its end.
+ *
+ * Instead of searching for a new path each time the position changes or the navmesh is updated, the corridor is adjusted:
+ * the start is moved along the navmesh as the position changes, the start of the corridor is shortened when possible,
+ * and when polygons become invalid only the invalid part of the corridor needs to be searched for again.
+ *
+ * All positions are in Recast coordinates.
+ */
+class PathCorridor
+{
+public:
+	PathCorridor();
+
+	/**
+	 * @brief Resets the corridor to contain only the supplied polygon.
+	 * @param ref The polygon the position is within.
+	 * @param pos The position.
+	 */
+	void reset(dtPolyRef ref, const float* pos);
+
+	/**
+	 * @brief Clears the corridor.
+	 */
+	void clear();
+
+	/**
+	 * @brief Sets the corridor, which should start with the polygon the current position is within.
+	 * @param pos The current position.
+	 * @param target The target position.
+	 * @param polys The polygons of the corridor.
+	 */
+	void setCorridor(const float* pos, const float* target, const std::vector<dtPolyRef>& polys);
+
+	/**
+	 * @brief Appends polygons to the end of the corridor, and sets a new target.
+	 *
+	 * The polygons are expected to start with the current last polygon of the corridor.
+	 * @param target The target position.
+	 * @param polys The polygons to append.
+	 */
+	void appendCorridor(const float* target, const std::vector<dtPolyRef>& polys);
+
+	/**
+	 * @brief Moves the position along the navmesh, and adjusts the start of the corridor.
+	 * @param npos The new position.
+	 * @param navquery A navmesh query.
+	 * @param filter A query filter.
+	 * @return True if the position could be moved.
+	 */
+	bool movePosition(const float* npos, dtNavMeshQuery* navquery, const dtQueryFilter* filter);
+
+	/**
+	 * @brief Tries to find a shortcut through the start of the corridor, using a small local search.
+	 *
+	 * The corridor is only ever adjusted locally when moving, so over time it might contain detours.
+	 * This should be called now and then.
+	 * @param navquery A navmesh query. Any ongoing sliced query will be interrupted.
+	 * @param filter A query filter.
+	 * @return True if the corridor was changed.
+	 */
+	bool optimizePathTopology(dtNavMeshQuery* navquery, const dtQueryFilter* filter);
+
+	/**
+	 * @brief Makes sure that the corridor starts with the supplied polygon, which the position is within.
+	 *
+	 * If the polygon is part of the corridor all polygons before it are removed.
+	 * @param safeRef A valid polygon, containing the current position.
+	 * @param safePos The current position.
+	 * @return True if the polygon was part of the corridor.
+	 */
+	bool fixPathStart(dtPolyRef safeRef, const float* safePos);
+
+	/**
+	 * @brief Removes all polygons from the first invalid one and onwards.
+	 * @param navquery A navmesh query.
+	 * @param filter A query filter.
+	 * @return The number of polygons removed.
+	 */
+	size_t trimInvalidPath(dtNavMeshQuery* navquery, const dtQueryFilter* filter);
+
+	/**
+	 * @brief Finds the straight path through the corridor, from the position to the target.
+	 * @param navquery A navmesh query.
+	 * @param straightPath Array to hold vertices, as [(x, y, z) * maxStraightPath].
+	 * @param maxStraightPath The max number of vertices.
+	 * @return The number of vertices.
+	 */
+	int findStraightPath(dtNavMeshQuery* navquery, float* straightPath, int maxStraightPath) const;
+
+	const float* getPos() const;
+	const float* getTarget() const;
+
+	/**
+	 * @brief Gets the first polygon in the corridor, i.e. the one the position is within.
+	 * @return A polygon reference, or 0 if the corridor is empty.
+	 */
+	dtPolyRef getFirstPoly() const;
+
+	/**
+	 * @brief Gets the last polygon in the corridor.
+	 * @return A polygon reference, or 0 if the corridor is empty.
+	 */
+	dtPolyRef getLastPoly() const;
+
+	const std::vector<dtPolyRef>& getPath() const;
+
+	bool isEmpty() const;
+
+	/**
+	 * @brief Returns true if the last polygon of the corridor contains the target, i.e. if the corridor is complete.
+	 * @return True if the corridor reaches the target.
+	 */
+	bool reachesTarget() const;
+
+private:
+
+	float mPos[3];
+	float mTarget[3];
+
+	/**
+	 * @brief True if the last polygon of the corridor contains the target.
+	 */
+	bool mReachesTarget;
+
+	std::vector<dtPolyRef> mPath;
+};
+
+}
+}
+
+#endif /* PATHCORRIDOR_H_ */
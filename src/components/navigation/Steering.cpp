@@ -32,19 +32,24 @@
 #include <wfmath/rotbox.h>
 #include <wfmath/segment.h>
 
+#include <algorithm>
+#include <iterator>
+
 namespace Ember
 {
 namespace Navigation
 {
 
 Steering::Steering(Awareness& awareness, Eris::Avatar& avatar) :
-		mAwareness(awareness), mAvatar(avatar), mSteeringEnabled(false), mUpdateNeeded(false), mPadding(16), mSpeed(5), mExpectingServerMovement(false), mLoitering(nullptr)
+		mAwareness(awareness), mAvatar(avatar), mSteeringEnabled(false), mUpdateNeeded(false), mPathRequestId(0), mCorridorCheckNeeded(false), mRepairingCorridor(false), mCorridorUpdateCounter(0), mPadding(16), mSpeed(5), mExpectingServerMovement(false), mLoitering(nullptr)
 {
 	mAwareness.EventTileUpdated.connect(sigc::mem_fun(*this, &Steering::Awareness_TileUpdated));
+	mAwareness.EventTileRemoved.connect(sigc::mem_fun(*this, &Steering::Awareness_TileRemoved));
 }
 
 Steering::~Steering()
 {
+	cancelPathRequest();
 	delete mLoitering;
 }
 
@@ -52,6 +57,8 @@ void Steering::setDestination(const WFMath::Point<3>& viewPosition)
 {
 	mViewDestination = viewPosition;
 	mUpdateNeeded = true;
+	//Any outstanding request is for the previous destination.
+	cancelPathRequest();
 
 	setAwareness();
 }
@@ -94,6 +101,9 @@ void Steering::setSpeed(float speed)
 
 bool Steering::updatePath()
 {
+	cancelPathRequest();
+	//A synchronous path doesn't come with a corridor.
+	mCorridor.clear();
 	mPath.clear();
 
 	int result = mAwareness.findPath(mAvatar.getEntity()->getViewPosition(), mViewDestination, mPath);
@@ -107,6 +117,77 @@ void Steering::requestUpdate()
 	mUpdateNeeded = true;
 }
 
+void Steering::cancelPathRequest()
+{
+	if (mPathRequestId) {
+		mAwareness.cancelPathRequest(mPathRequestId);
+		mPathRequestId = 0;
+	}
+	mRepairingCorridor = false;
+}
+
+void Steering::pathFound(int result, const std::list<WFMath::Point<3>>& path, const PathCorridor& corridor)
+{
+	mPathRequestId = 0;
+	if (mRepairingCorridor) {
+		mRepairingCorridor = false;
+		if (result > 0 && !mCorridor.isEmpty() && corridor.getFirstPoly() == mCorridor.getLastPoly()) {
+			mCorridor.appendCorridor(corridor.getTarget(), corridor.getPath());
+		} else {
+			//The corridor couldn't be repaired; search for a whole new path.
+			mUpdateNeeded = true;
+			return;
+		}
+	} else if (result > 0) {
+		mCorridor = corridor;
+	} else {
+		mCorridor.clear();
+		mPath = path;
+		EventPathUpdated();
+		return;
+	}
+	updateCorridor();
+	EventPathUpdated();
+}
+
+void Steering::updateCorridor()
+{
+	if (mCorridorCheckNeeded && !mPathRequestId) {
+		mCorridorCheckNeeded = false;
+		if (mAwareness.trimCorridor(mCorridor) > 0) {
+			//Only the end of the corridor, from the first invalid polygon, needs to be searched for again.
+			//Until then the remaining corridor is followed.
+			mPathRequestId = mAwareness.requestCorridorRepair(mCorridor, [this](int result, const std::list<WFMath::Point<3>>& path, const PathCorridor& corridor) {this->pathFound(result, path, corridor);});
+			if (mPathRequestId) {
+				mRepairingCorridor = true;
+			} else {
+				mCorridor.clear();
+				mUpdateNeeded = true;
+				return;
+			}
+		}
+	}
+
+	if (!mAwareness.moveCorridor(mCorridor, mAvatar.getEntity()->getViewPosition())) {
+		//We've strayed from the corridor; search for a whole new path.
+		mCorridor.clear();
+		mUpdateNeeded = true;
+		return;
+	}
+	if (++mCorridorUpdateCounter % 16 == 0) {
+		mAwareness.optimizeCorridor(mCorridor);
+	}
+
+	std::list<WFMath::Point<3>> path;
+	mAwareness.getCorridorPath(mCorridor, path);
+	//The first waypoint is always where the avatar is, so only signal if any of the rest of the path has changed.
+	bool changed = path.size() != mPath.size() || (!path.empty() && !std::equal(std::next(path.begin()), path.end(), std::next(mPath.begin())));
+	mPath = std::move(path);
+	if (changed) {
+		EventPathUpdated();
+	}
+}
+
 void Steering::startSteering()
 {
 	mSteeringEnabled = true;
@@ -121,6 +202,8 @@ void Steering::stopSteering()
 	mSteeringEnabled = false;
 	mExpectingServerMovement = false;
 	mLastSentVelocity = WFMath::Vector<2>();
+	cancelPathRequest();
+	mCorridor.clear();
 
 	//When we stopped steering we'll retain an awareness around the avatar. We'll do this by "loitering".
 	delete mLoitering;
@@ -145,8 +228,14 @@ const std::list<WFMath::Point<3>>& Steering::getPath() const
 void Steering::update()
 {
 	if (mSteeringEnabled) {
-		if (mUpdateNeeded) {
-			updatePath();
+		//Only one request is made at a time; if an update is needed while one is outstanding a new one is made once it's done.
+		//Until then the current path is followed.
+		if (mUpdateNeeded && !mPathRequestId) {
+			mUpdateNeeded = false;
+			mPathRequestId = mAwareness.requestPath(mAvatar.getEntity()->getViewPosition(), mViewDestination, [this](int result, const std::list<WFMath::Point<3>>& path, const PathCorridor& corridor) {this->pathFound(result, path, corridor);});
+		}
+		if (!mCorridor.isEmpty()) {
+			updateCorridor();
 		}
 		auto entity = mAvatar.getEntity();
 		if (!mPath.empty()) {
@@ -155,11 +244,14 @@ void Steering::update()
 			const WFMath::Point<2> entityPosition(entity3dPosition.x(), entity3dPosition.y());
 			//First check if we've arrived at our actual destination.
 			if (WFMath::Distance(WFMath::Point<2>(finalDestination.x(), finalDestination.y()), entityPosition) < 0.1f) {
-				//We've arrived at our destination. If we're moving we should stop.
-				if (mLastSentVelocity != WFMath::Vector<2>::ZERO()) {
-					moveInDirection(WFMath::Vector<2>::ZERO());
+				//If a new path is being searched for it might lead elsewhere, so wait for it before deciding that we've arrived.
+				if (!mPathRequestId) {
+					//We've arrived at our destination. If we're moving we should stop.
+					if (mLastSentVelocity != WFMath::Vector<2>::ZERO()) {
+						moveInDirection(WFMath::Vector<2>::ZERO());
+					}
+					stopSteering();
 				}
-				stopSteering();
 			} else {
 				//We should send a move op if we're either not moving, or we've reached a waypoint, or we need to divert a lot.
 
@@ -187,7 +279,10 @@ void Steering::update()
 					velocity = newVelocity;
 					velocity.normalize();
 					velocity *= mSpeed;
-					mUpdateNeeded = true;
+					//No need to search for a new path; the corridor will follow the avatar as it diverts.
+					if (mCorridor.isEmpty()) {
+						mUpdateNeeded = true;
+					}
 				}
 
 				bool shouldSend = false;
@@ -251,7 +346,19 @@ void Steering::moveToPoint(const WFMath::Point<3>& point)
 
 void Steering::Awareness_TileUpdated(int tx, int ty)
 {
-	mUpdateNeeded = true;
+	//Only the parts of the corridor which go through the updated tile need to be searched for again.
+	if (mCorridor.isEmpty()) {
+		mUpdateNeeded = true;
+	} else {
+		mCorridorCheckNeeded = true;
+	}
+}
+
+void Steering::Awareness_TileRemoved(int tx, int ty, int tlayer)
+{
+	if (!mCorridor.isEmpty()) {
+		mCorridorCheckNeeded = true;
+	}
 }
 
 bool Steering::getIsExpectingServerMovement() const
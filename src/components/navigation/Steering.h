@@ -19,6 +19,8 @@
 #ifndef STEERING_H_
 #define STEERING_H_
 
+#include "PathCorridor.h"
+
 #include <wfmath/point.h>
 #include <wfmath/vector.h>
 #include <wfmath/axisbox.h>
@@ -61,7 +63,9 @@ public:
 	void setDestination(const WFMath::Point<3>& viewPosition);
 
 	/**
-	 * @brief Updates the path.
+	 * @brief Updates the path immediately, blocking until the path has been found.
+	 *
+	 * Prefer requestUpdate(), which finds the path asynchronously.
 	 * @return True if a path was found.
 	 */
 	bool updatePath();
@@ -69,8 +73,8 @@ public:
 	/**
 	 * @brief Requests an update of the path.
 	 *
-	 * The actual update will be deferred to when updatePath() is called, which normally happens
-	 * with a call to update()
+	 * The actual update will be deferred to when update() is called, which will make an asynchronous path request.
+	 * The current path is followed until the new one arrives.
 	 */
 	void requestUpdate();
 
@@ -154,6 +158,34 @@ private:
 	 */
 	bool mUpdateNeeded;
 
+	/**
+	 * @brief The id of the current asynchronous path request, or 0 if there's none.
+	 */
+	unsigned int mPathRequestId;
+
+	/**
+	 * @brief The polygon corridor of the current path.
+	 *
+	 * The corridor is adjusted as the avatar moves and as tiles are updated, so that a new path
+	 * only needs to be searched for when the corridor can't be repaired.
+	 */
+	PathCorridor mCorridor;
+
+	/**
+	 * @brief True if the corridor should be checked for invalid polygons, since tiles have changed.
+	 */
+	bool mCorridorCheckNeeded;
+
+	/**
+	 * @brief True if the current path request is for repairing the end of the corridor, rather than for a whole new path.
+	 */
+	bool mRepairingCorridor;
+
+	/**
+	 * @brief Counts calls to updateCorridor(), to look for shortcuts at regular intervals.
+	 */
+	unsigned int mCorridorUpdateCounter;
+
 	/**
 	 * @brief In world units how much padding to expand the awareness area with.
 	 */
@@ -194,6 +226,32 @@ private:
 	 */
 	void setAwareness();
 
+	/**
+	 * @brief Cancels any outstanding asynchronous path request.
+	 */
+	void cancelPathRequest();
+
+	/**
+	 * @brief Called when an asynchronous path request is done.
+	 * @param result The number of waypoints, or a negative value if no path could be found.
+	 * @param path The new path.
+	 * @param corridor The corridor of the new path.
+	 */
+	void pathFound(int result, const std::list<WFMath::Point<3>>& path, const PathCorridor& corridor);
+
+	/**
+	 * @brief Moves the start of the corridor to the avatar, repairs it if tiles have changed, and updates the path from it.
+	 */
+	void updateCorridor();
+
+	/**
+	 * @brief Listen to tiles being removed, since that invalidates any part of the corridor going through them.
+	 * @param tx
+	 * @param ty
+	 * @param tlayer
+	 */
+	void Awareness_TileRemoved(int tx, int ty, int tlayer);
+
 	/**
 	 * @brief Listen to tiles being updated, and request updates.
 	 * @param tx
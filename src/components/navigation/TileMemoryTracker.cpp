@@ -0,0 +1,111 @@
+/*
+ Copyright (C) 2014 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "TileMemoryTracker.h"
+
+namespace Ember
+{
+namespace Navigation
+{
+
+TileMemoryTracker::TileMemoryTracker(size_t budget) :
+		mBudget(budget), mUsage(0)
+{
+}
+
+void TileMemoryTracker::setBudget(size_t bytes)
+{
+	mBudget = bytes;
+}
+
+size_t TileMemoryTracker::getUsage() const
+{
+	return mUsage;
+}
+
+size_t TileMemoryTracker::getLowWaterMark() const
+{
+	return mBudget - (mBudget / 8);
+}
+
+bool TileMemoryTracker::isOverBudget() const
+{
+	return mUsage > mBudget;
+}
+
+size_t TileMemoryTracker::getTileCount() const
+{
+	return mTiles.size();
+}
+
+void TileMemoryTracker::touch(const TileIndex& index)
+{
+	auto result = mTiles.push_front(index);
+	if (!result.second) {
+		mTiles.relocate(mTiles.begin(), result.first);
+	}
+}
+
+void TileMemoryTracker::setTileMemory(const TileIndex& index, size_t bytes)
+{
+	auto I = mTileMemory.find(index);
+	if (I != mTileMemory.end()) {
+		mUsage -= I->second;
+		mTileMemory.erase(I);
+	}
+	if (bytes) {
+		mTileMemory.insert(std::make_pair(index, bytes));
+		mUsage += bytes;
+		touch(index);
+	}
+}
+
+void TileMemoryTracker::removeTile(const TileIndex& index)
+{
+	setTileMemory(index, 0);
+	mTiles.get<1>().erase(index);
+}
+
+void TileMemoryTracker::collectPruneCandidates(size_t maxCandidates, const std::function<bool(const TileIndex&)>& isPinned, std::vector<TileIndex>& candidates)
+{
+	std::vector<TileIndex> emptyTiles;
+	size_t collected = 0;
+	for (auto I = mTiles.rbegin(); I != mTiles.rend() && collected < maxCandidates; ++I) {
+		if (isPinned(*I)) {
+			continue;
+		}
+		if (mTileMemory.find(*I) == mTileMemory.end()) {
+			//The tile was never built, so there's nothing to remove.
+			emptyTiles.push_back(*I);
+			continue;
+		}
+		candidates.push_back(*I);
+		collected++;
+	}
+
+	for (auto& index : emptyTiles) {
+		mTiles.get<1>().erase(index);
+	}
+}
+
+}
+}
@@ -0,0 +1,135 @@
+/*
+ Copyright (C) 2014 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef TILEMEMORYTRACKER_H_
+#define TILEMEMORYTRACKER_H_
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/identity.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+
+#include <functional>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace Ember
+{
+namespace Navigation
+{
+
+/**
+ * @brief Keeps track of the memory used by navmesh tiles, and of how recently each tile was used.
+ *
+ * This is used by the Awareness to decide which tiles to remove when the memory budget is exceeded.
+ * Tiles are kept in a Most Recently Used list; whenever a tile is used, or built, it's moved to the front.
+ * Every tile with memory accounted for is always in the list, so that it always can be pruned.
+ */
+class TileMemoryTracker
+{
+public:
+	typedef std::pair<int, int> TileIndex;
+
+	/**
+	 * @brief Ctor.
+	 * @param budget The amount of memory, in bytes, that tiles are allowed to use.
+	 */
+	explicit TileMemoryTracker(size_t budget);
+
+	/**
+	 * @brief Sets the amount of memory that tiles are allowed to use.
+	 * @param bytes The budget, in bytes.
+	 */
+	void setBudget(size_t bytes);
+
+	/**
+	 * @brief Gets the memory, in bytes, used by all tiles.
+	 */
+	size_t getUsage() const;
+
+	/**
+	 * @brief Gets the memory use at which pruning should stop.
+	 *
+	 * This is a bit below the budget, so that pruning isn't needed again as soon as another tile is built.
+	 */
+	size_t getLowWaterMark() const;
+
+	/**
+	 * @brief Returns true if the memory used exceeds the budget.
+	 */
+	bool isOverBudget() const;
+
+	/**
+	 * @brief Gets the number of tiles in the Most Recently Used list.
+	 */
+	size_t getTileCount() const;
+
+	/**
+	 * @brief Moves a tile to the front of the Most Recently Used list, adding it if needed.
+	 * @param index The tile index.
+	 */
+	void touch(const TileIndex& index);
+
+	/**
+	 * @brief Sets the memory used by a tile.
+	 *
+	 * If any memory is used the tile is also touched, since it might have been dropped from the list while it was being built.
+	 * @param index The tile index.
+	 * @param bytes The memory used by the compressed layers and the navmesh tiles at the index.
+	 */
+	void setTileMemory(const TileIndex& index, size_t bytes);
+
+	/**
+	 * @brief Forgets a tile completely, both its memory and its place in the list.
+	 * @param index The tile index.
+	 */
+	void removeTile(const TileIndex& index);
+
+	/**
+	 * @brief Collects the least recently used tiles which can be pruned.
+	 *
+	 * Pinned tiles are skipped, but kept in the list. Tiles which aren't pinned and don't use any memory are dropped from the list,
+	 * since there's nothing to remove for them.
+	 * @param maxCandidates The max number of candidates to collect.
+	 * @param isPinned Returns true for tiles which mustn't be pruned; for example tiles in the awareness area or tiles being built.
+	 * @param candidates The candidates are added to this, least recently used first.
+	 */
+	void collectPruneCandidates(size_t maxCandidates, const std::function<bool(const TileIndex&)>& isPinned, std::vector<TileIndex>& candidates);
+
+private:
+
+	size_t mBudget;
+
+	size_t mUsage;
+
+	/**
+	 * @brief The memory, in bytes, used by the compressed layers and the navmesh tiles at each tile index.
+	 */
+	std::map<TileIndex, size_t> mTileMemory;
+
+	/**
+	 * @brief The Most Recently Used list; the front is the most recently used tile.
+	 */
+	boost::multi_index::multi_index_container<TileIndex, boost::multi_index::indexed_by<boost::multi_index::sequenced<>, boost::multi_index::hashed_unique<boost::multi_index::identity<TileIndex>>>> mTiles;
+};
+
+}
+}
+
+#endif /* TILEMEMORYTRACKER_H_ */
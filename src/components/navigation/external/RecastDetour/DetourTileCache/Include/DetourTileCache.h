@@ -109,7 +109,9 @@ public:
 	dtStatus queryTiles(const float* bmin, const float* bmax,
 						dtCompressedTileRef* results, int* resultCount, const int maxResults) const;
 	
-	dtStatus update(const float /*dt*/, class dtNavMesh* navmesh);
+	/// Processes pending obstacle requests, and rebuilds at most one tile.
+	///  @param[out]	upToDate	Optional; set to true if there's nothing more to process.
+	dtStatus update(const float /*dt*/, class dtNavMesh* navmesh, bool* upToDate = 0);
 	
 	dtStatus buildNavMeshTilesAt(const int tx, const int ty, class dtNavMesh* navmesh);
 	
@@ -440,7 +440,7 @@ dtStatus dtTileCache::queryTiles(const float* bmin, const float* bmax,
 	return DT_SUCCESS;
 }
 
-dtStatus dtTileCache::update(const float /*dt*/, dtNavMesh* navmesh)
+dtStatus dtTileCache::update(const float /*dt*/, dtNavMesh* navmesh, bool* upToDate)
 {
 	if (m_nupdate == 0)
 	{
@@ -548,10 +548,16 @@ dtStatus dtTileCache::update(const float /*dt*/, dtNavMesh* navmesh)
 			}
 		}
 			
+		if (upToDate)
+			*upToDate = m_nupdate == 0 && m_nreqs == 0;
+
 		if (dtStatusFailed(status))
 			return status;
 	}
 	
+	if (upToDate)
+		*upToDate = m_nupdate == 0 && m_nreqs == 0;
+
 	return DT_SUCCESS;
 }
 
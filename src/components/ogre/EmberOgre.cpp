@@ -55,6 +55,7 @@
 #include "framework/IScriptingProvider.h"
 #include "framework/Time.h"
 #include "framework/TimeFrame.h"
+#include "framework/Profiler.h"
 
 #include "terrain/TerrainLayerDefinitionManager.h"
 
@@ -143,7 +144,7 @@ void assureConfigFile(const std::string& filename, const std::string& originalCo
 EmberOgre::EmberOgre() :
 		mInput(0), mOgreSetup(nullptr), mRoot(0), mSceneManagerOutOfWorld(0), mWindow(0), mScreen(0), mShaderManager(0), mShaderDetailManager(nullptr), mAutomaticGraphicsLevelManager(nullptr), mGeneralCommandMapper(new InputCommandMapper("general")), mSoundManager(0), mGUIManager(0), mModelDefinitionManager(0), mEntityMappingManager(0), mTerrainLayerManager(0), mEntityRecipeManager(0),
 		mLogObserver(nullptr), mMaterialEditor(nullptr), mModelRepresentationManager(nullptr), mSoundResourceProvider(nullptr), mLodDefinitionManager(nullptr), mLodManager(nullptr),
-		mResourceLoader(0), mOgreLogManager(0), mIsInPausedMode(false), mCameraOutOfWorld(0), mWorld(0), mPMInjectorSignaler(0), mConsoleDevTools(nullptr)
+		mResourceLoader(0), mTreeGenerator(nullptr), mOgreLogManager(0), mIsInPausedMode(false), mCameraOutOfWorld(0), mWorld(0), mPMInjectorSignaler(0), mConsoleDevTools(nullptr)
 {
 	Application::getSingleton().EventServicesInitialized.connect(sigc::mem_fun(*this, &EmberOgre::Application_ServicesInitialized));
 }
@@ -189,6 +190,7 @@ EmberOgre::~EmberOgre()
 	delete mShaderDetailManager;
 	delete mShaderManager;
 	delete mScreen;
+	delete mTreeGenerator;
 
 	if (mOgreSetup.get()) {
 		// Deregister the overlay system before deleting it in OgreSetup::shutdown
@@ -213,6 +215,7 @@ EmberOgre::~EmberOgre()
 
 bool EmberOgre::renderOneFrame(const TimeFrame& timeFrame)
 {
+	ProfileZone zone("EmberOgre::renderOneFrame");
 	Log::sCurrentFrame = mRoot->getNextFrameNumber();
 
 	if (mInput->isApplicationVisible()) {
@@ -225,14 +228,23 @@ bool EmberOgre::renderOneFrame(const TimeFrame& timeFrame)
 
 			//We're not using the mRoot->renderOneFrame functionality because we want to do
 			//input processing and UI updates while waiting for queued render calls, before we call swapBuffers().
-			mRoot->_fireFrameStarted();
-			mRoot->_updateAllRenderTargets();
-			mWindow->update(false);
+			{
+				ProfileZone frameStartedZone("Ogre::Root::_fireFrameStarted");
+				mRoot->_fireFrameStarted();
+			}
+			{
+				ProfileZone updateZone("Ogre::Root::_updateAllRenderTargets");
+				mRoot->_updateAllRenderTargets();
+				mWindow->update(false);
+			}
 			//Do input and render the UI at the last moment, to make sure that the UI is responsive.
 			mInput->processInput();
 			mGUIManager->render();
 
-			mWindow->swapBuffers();
+			{
+				ProfileZone swapZone("Ogre::RenderWindow::swapBuffers");
+				mWindow->swapBuffers();
+			}
 			mRoot->_fireFrameEnded();
 
 		} catch (const std::exception& ex) {
@@ -318,10 +330,21 @@ bool EmberOgre::setup(Input& input, MainLoopController& mainLoopController, Eris
 
 	std::string exportDir(configSrv.getHomeDirectory(BaseDirType_DATA) + "user-media/data/");
 	//Create the model definition manager
-	mModelDefinitionManager = new Model::ModelDefinitionManager(exportDir, eventService);
+	mModelDefinitionManager = new Model::ModelDefinitionManager(exportDir, eventService, configSrv.getHomeDirectory(BaseDirType_CACHE));
 
 	mLodDefinitionManager = new Lod::LodDefinitionManager(exportDir);
-	mLodManager = new Lod::LodManager();
+	//Keep generated Lod levels between sessions, since generating them is expensive.
+	std::string lodCacheDir(configSrv.getHomeDirectory(BaseDirType_CACHE) + "lod/");
+	try {
+		oslink::directory osdir(lodCacheDir);
+		if (!osdir.isExisting()) {
+			oslink::directory::mkdir(lodCacheDir.c_str());
+		}
+	} catch (const std::exception& ex) {
+		S_LOG_WARNING("Could not create directory for Lod cache; Lod levels will be generated each session." << ex);
+		lodCacheDir = "";
+	}
+	mLodManager = new Lod::LodManager(lodCacheDir);
 
 	mEntityMappingManager = new Mapping::EmberEntityMappingManager();
 
@@ -357,7 +380,7 @@ bool EmberOgre::setup(Input& input, MainLoopController& mainLoopController, Eris
 	mResourceLoader->loadGui();
 	mResourceLoader->loadGeneral();
 
-	mScreen = new Screen(*mWindow);
+	mScreen = new Screen(*mWindow, eventService);
 
 	//bind general commands
 	mGeneralCommandMapper->readFromConfigSection("key_bindings_general");
@@ -401,7 +424,24 @@ bool EmberOgre::setup(Input& input, MainLoopController& mainLoopController, Eris
 		//	mCollisionManager = new OgreOpcode::CollisionManager(mSceneMgr);
 		//	mCollisionDetectorVisualizer = new OpcodeCollisionDetectorVisualizer();
 
-		Ogre::ResourceGroupManager::getSingleton().initialiseAllResourceGroups();
+		mResourceLoader->initialiseResourceGroups();
+
+		//Only autogenerate trees if we're not using the pregenerated ones. The trees are grown in the background, with placeholders shown until they are ready.
+		if (configSrv.itemExists("tree", "usedynamictrees") && ((bool)configSrv.getValue("tree", "usedynamictrees"))) {
+			std::string treeCacheDir(configSrv.getHomeDirectory(BaseDirType_CACHE) + "trees/");
+			try {
+				oslink::directory osdir(treeCacheDir);
+				if (!osdir.isExisting()) {
+					oslink::directory::mkdir(treeCacheDir.c_str());
+				}
+			} catch (const std::exception& ex) {
+				S_LOG_WARNING("Could not create directory for tree cache; trees will be grown each session." << ex);
+				treeCacheDir = "";
+			}
+			mTreeGenerator = new Environment::Tree(eventService, treeCacheDir);
+			mTreeGenerator->makeMesh("GeneratedTrees/European_Larch", Ogre::TParameters::European_Larch);
+			mTreeGenerator->makeMesh("GeneratedTrees/Fir", Ogre::TParameters::Fir);
+		}
 
 		//out of pure interest we'll print out how many modeldefinitions we've loaded
 		Ogre::ResourceManager::ResourceMapIterator I = Model::ModelDefinitionManager::getSingleton().getResourceIterator();
@@ -412,6 +452,7 @@ bool EmberOgre::setup(Input& input, MainLoopController& mainLoopController, Eris
 		}
 
 		S_LOG_INFO("Finished loading " << count << " modeldefinitions.");
+		Model::ModelDefinitionManager::getSingleton().saveDefinitionCache();
 
 		// Create shader manager
 		mAutomaticGraphicsLevelManager = new AutomaticGraphicsLevelManager(mainLoopController);
@@ -504,14 +545,6 @@ void EmberOgre::preloadMedia(void)
 			S_LOG_FAILURE( "Error when loading texture " << *I << "." << e);
 		}
 	}
-
-	//only autogenerate trees if we're not using the pregenerated ones
-	if (configSrv.itemExists("tree", "usedynamictrees") && ((bool)configSrv.getValue("tree", "usedynamictrees"))) {
-		Environment::Tree tree;
-		tree.makeMesh("GeneratedTrees/European_Larch", Ogre::TParameters::European_Larch);
-		tree.makeMesh("GeneratedTrees/Fir", Ogre::TParameters::Fir);
-	}
-
 }
 
 void EmberOgre::Server_GotView(Eris::View* view)
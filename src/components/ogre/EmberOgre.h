@@ -93,6 +93,11 @@ class ModelDefinitionManager;
 class ModelRepresentationManager;
 }
 
+namespace Environment
+{
+class Tree;
+}
+
 namespace Authoring
 {
 class EntityMoveManager;
@@ -346,6 +351,11 @@ protected:
 	 */
 	OgreResourceLoader* mResourceLoader;
 
+	/**
+	 * @brief Grows procedural trees in the background, if "tree:usedynamictrees" is set.
+	 */
+	Environment::Tree* mTreeGenerator;
+
 	/**
 	 * @brief We hold a reference to our own Ogre log manager, thus making sure that Ogre doesn't create one itself.
 	 *
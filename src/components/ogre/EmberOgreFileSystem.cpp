@@ -244,11 +244,18 @@ int _findclose(long id)
 namespace Ember {
 namespace OgreView {
     //-----------------------------------------------------------------------
-    FileSystemArchive::FileSystemArchive(const String& name, const String& archType )
-        : Archive(name, archType)
+    std::atomic<unsigned int> FileSystemArchive::sListingGeneration(0);
+    //-----------------------------------------------------------------------
+    FileSystemArchive::FileSystemArchive(const String& name, const String& archType, ResourceManifest* manifest)
+        : Archive(name, archType), mManifest(manifest), mListingGeneration(0)
     {
     }
     //-----------------------------------------------------------------------
+    void FileSystemArchive::invalidateListings()
+    {
+        sListingGeneration++;
+    }
+    //-----------------------------------------------------------------------
     bool FileSystemArchive::isCaseSensitive(void) const
     {
         #if OGRE_PLATFORM == OGRE_PLATFORM_WIN32
@@ -361,6 +368,93 @@ namespace OgreView {
         }
     }
     //-----------------------------------------------------------------------
+    bool FileSystemArchive::findFilesInListing(const String& pattern, bool recursive,
+        bool dirs, StringVector* simpleList, FileInfoList* detailList) const
+    {
+        if (dirs || pattern.find_first_of("/\\") != String::npos) {
+            return false;
+        }
+
+        std::shared_ptr<const ResourceManifest::Listing> listing = getListing();
+        bool caseSensitive = isCaseSensitive();
+        for (const ResourceManifest::File& file : listing->files) {
+            if (!recursive && !file.path.empty()) {
+                continue;
+            }
+            if (!StringUtil::match(file.basename, pattern, caseSensitive)) {
+                continue;
+            }
+            if (simpleList)
+            {
+                simpleList->push_back(file.filename);
+            }
+            else if (detailList)
+            {
+                FileInfo fi;
+                fi.archive = this;
+                fi.filename = file.filename;
+                fi.basename = file.basename;
+                fi.path = file.path;
+                fi.compressedSize = file.size;
+                fi.uncompressedSize = file.size;
+                detailList->push_back(fi);
+            }
+        }
+        return true;
+    }
+    //-----------------------------------------------------------------------
+    std::shared_ptr<const ResourceManifest::Listing> FileSystemArchive::getListing() const
+    {
+        std::lock_guard<std::mutex> lock(mListingMutex);
+        const unsigned int generation = sListingGeneration;
+        if (mListing) {
+            if (mListingGeneration == generation) {
+                return mListing;
+            }
+            //Files might have been written or removed at runtime, for example by exporting a model definition.
+            //Only the directories need to be checked for that, which is much cheaper than walking the location again.
+            if (ResourceManifest::isListingCurrent(mName, *mListing)) {
+                mListingGeneration = generation;
+                return mListing;
+            }
+            S_LOG_VERBOSE("Resource location " << mName << " has changed; listing it again.");
+        } else if (mManifest) {
+            mListing = mManifest->find(mName);
+            if (mListing) {
+                mListingGeneration = generation;
+                return mListing;
+            }
+        }
+
+        auto listing = std::make_shared<ResourceManifest::Listing>();
+        FileInfoList files;
+        findFiles("*", true, false, 0, &files);
+        listing->files.reserve(files.size());
+        for (const FileInfo& fi : files) {
+            ResourceManifest::File file;
+            file.filename = fi.filename;
+            file.path = fi.path;
+            file.basename = fi.basename;
+            file.size = fi.uncompressedSize;
+            listing->files.push_back(std::move(file));
+        }
+
+        //Record the directories, so that the manifest can tell if anything has been added or removed.
+        StringVector directories;
+        findFiles("*", true, true, &directories, 0);
+        listing->directories.emplace_back("", ResourceManifest::getModifiedTime(mName));
+        for (const String& directory : directories) {
+            listing->directories.emplace_back(directory, ResourceManifest::getModifiedTime(concatenate_path(mName, directory)));
+        }
+
+        mListing = listing;
+        mListingGeneration = generation;
+        if (mManifest) {
+            mManifest->store(mName, mListing);
+        }
+        return mListing;
+    }
+    //-----------------------------------------------------------------------
     FileSystemArchive::~FileSystemArchive()
     {
         unload();
@@ -409,7 +503,9 @@ namespace OgreView {
 		// directory change requires locking due to saved returns
 		StringVectorPtr ret(OGRE_NEW_T(StringVector, MEMCATEGORY_GENERAL)(), SPFM_DELETE_T);
 
-        findFiles("*", recursive, dirs, ret.getPointer(), 0);
+        if (!findFilesInListing("*", recursive, dirs, ret.getPointer(), 0)) {
+            findFiles("*", recursive, dirs, ret.getPointer(), 0);
+        }
 
         return ret;
     }
@@ -418,7 +514,9 @@ namespace OgreView {
     {
         FileInfoListPtr ret(OGRE_NEW_T(FileInfoList, MEMCATEGORY_GENERAL)(), SPFM_DELETE_T);
 
-        findFiles("*", recursive, dirs, 0, ret.getPointer());
+        if (!findFilesInListing("*", recursive, dirs, 0, ret.getPointer())) {
+            findFiles("*", recursive, dirs, 0, ret.getPointer());
+        }
 
         return ret;
     }
@@ -428,7 +526,9 @@ namespace OgreView {
     {
 		StringVectorPtr ret(OGRE_NEW_T(StringVector, MEMCATEGORY_GENERAL)(), SPFM_DELETE_T);
 
-        findFiles(pattern, recursive, dirs, ret.getPointer(), 0);
+        if (!findFilesInListing(pattern, recursive, dirs, ret.getPointer(), 0)) {
+            findFiles(pattern, recursive, dirs, ret.getPointer(), 0);
+        }
 
         return ret;
 
@@ -439,7 +539,9 @@ namespace OgreView {
     {
 		FileInfoListPtr ret(OGRE_NEW_T(FileInfoList, MEMCATEGORY_GENERAL)(), SPFM_DELETE_T);
 
-        findFiles(pattern, recursive, dirs, 0, ret.getPointer());
+        if (!findFilesInListing(pattern, recursive, dirs, 0, ret.getPointer())) {
+            findFiles(pattern, recursive, dirs, 0, ret.getPointer());
+        }
 
         return ret;
     }
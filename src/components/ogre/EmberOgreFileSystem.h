@@ -35,6 +35,12 @@ Torus Knot Software Ltd.
 #include <OgreArchive.h>
 #include <OgreArchiveFactory.h>
 
+#include "ResourceManifest.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
 namespace Ember {
 namespace OgreView {
 
@@ -43,6 +49,9 @@ namespace OgreView {
         This has been modified from the original Ogre class to:
         1) not visit hidden directories (such as .svn)
         2) not recurse into directories if there's a file named "norecurse" in them
+        3) only walk the directories once, and serve all file listings from memory after that,
+           using the listing from a ResourceManifest if it's still valid; after invalidateListings() has been
+           called the directories are checked once more, and walked again only if any of them have been modified
     */
     class FileSystemArchive : public Ogre::Archive
     {
@@ -60,10 +69,50 @@ namespace OgreView {
         void findFiles(const Ogre::String& pattern, bool recursive, bool dirs,
             Ogre::StringVector* simpleList, Ogre::FileInfoList* detailList) const;
 
+        /**
+         * @brief Finds files matching the pattern in the listing of all files, instead of walking the directories.
+         *
+         * Only patterns without any directory part are supported, which is what Ogre uses when indexing and parsing scripts.
+         * @return False if the query couldn't be handled by the listing, and findFiles() needs to be used instead.
+         */
+        bool findFilesInListing(const Ogre::String& pattern, bool recursive, bool dirs,
+            Ogre::StringVector* simpleList, Ogre::FileInfoList* detailList) const;
+
+        /**
+         * @brief Gets the listing of all files in the archive, walking the directories if there's no valid listing or manifest.
+         */
+        std::shared_ptr<const ResourceManifest::Listing> getListing() const;
+
+        /**
+         * @brief An optional manifest, used for storing listings between sessions.
+         */
+        ResourceManifest* mManifest;
+
+        mutable std::shared_ptr<const ResourceManifest::Listing> mListing;
+
+        /**
+         * @brief The listing generation at which mListing was last known to be current.
+         */
+        mutable unsigned int mListingGeneration;
+
+        /**
+         * @brief Incremented by invalidateListings().
+         */
+        static std::atomic<unsigned int> sListingGeneration;
+
+        mutable std::mutex mListingMutex;
+
     public:
-        FileSystemArchive(const Ogre::String& name, const Ogre::String& archType );
+        FileSystemArchive(const Ogre::String& name, const Ogre::String& archType, ResourceManifest* manifest = nullptr);
         virtual ~FileSystemArchive();
 
+        /**
+         * @brief Makes all archives check whether their listings are still current the next time they are used.
+         *
+         * Call this before resource groups are initialised, and after files have been written to or removed from a resource location.
+         */
+        static void invalidateListings();
+
         /// @copydoc Archive::isCaseSensitive
         bool isCaseSensitive(void) const;
 
@@ -103,6 +152,10 @@ namespace OgreView {
     class FileSystemArchiveFactory : public Ogre::ArchiveFactory
     {
     public:
+        /**
+         * @param manifest An optional manifest of the files in each archive. Ownership isn't transferred.
+         */
+        FileSystemArchiveFactory(ResourceManifest* manifest = nullptr) : mManifest(manifest) {}
         virtual ~FileSystemArchiveFactory() {}
         /// @copydoc FactoryObj::getType
         const Ogre::String& getType(void) const;
@@ -111,11 +164,14 @@ namespace OgreView {
         Ogre::Archive* createInstance(const Ogre::String& name, bool readOnly)
         {
             //FIXME: use the readOnly parameter
-            return new OgreView::FileSystemArchive(name, "EmberFileSystem");
+            return new OgreView::FileSystemArchive(name, "EmberFileSystem", mManifest);
         }
 
         /// @copydoc FactoryObj::destroyInstance
         void destroyInstance( Ogre::Archive* arch) { delete arch; }
+
+    private:
+        ResourceManifest* mManifest;
     };
 
 
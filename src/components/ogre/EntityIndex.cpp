@@ -0,0 +1,246 @@
+/*
+ Copyright (C) 2014 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "EntityIndex.h"
+
+#include "domain/EmberEntity.h"
+
+#include <Eris/View.h>
+
+#include <wfmath/intersect.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace Ember
+{
+namespace OgreView
+{
+
+EntityIndex::EntityIndex(Eris::View& view, float cellSize) :
+		mCellSize(cellSize), mIndexedCount(0)
+{
+	view.EntitySeen.connect(sigc::mem_fun(*this, &EntityIndex::View_EntitySeen));
+	view.EntityCreated.connect(sigc::mem_fun(*this, &EntityIndex::View_EntitySeen));
+
+	EmberEntity* topLevel = static_cast<EmberEntity*>(view.getTopLevel());
+	if (topLevel) {
+		addEntity(*topLevel);
+	}
+}
+
+EntityIndex::~EntityIndex()
+{
+	for (auto& entry : mEntries) {
+		entry.second.moved.disconnect();
+		entry.second.locationChanged.disconnect();
+		entry.second.beingDeleted.disconnect();
+	}
+}
+
+void EntityIndex::query(const WFMath::AxisBox<2>& extent, std::vector<EmberEntity*>& entities) const
+{
+	int minX = cellIndex(extent.lowCorner().x());
+	int maxX = cellIndex(extent.highCorner().x());
+	int minY = cellIndex(extent.lowCorner().y());
+	int maxY = cellIndex(extent.highCorner().y());
+	for (int x = minX; x <= maxX; ++x) {
+		for (int y = minY; y <= maxY; ++y) {
+			auto I = mCells.find(cellKey(x, y));
+			if (I == mCells.end()) {
+				continue;
+			}
+			for (const Entry* entry : I->second) {
+				//An entity spanning many cells should only be reported once; do that in the first cell of the query it's in.
+				if (x != std::max(entry->minX, minX) || y != std::max(entry->minY, minY)) {
+					continue;
+				}
+				if (WFMath::Intersect(extent, entry->bounds, false)) {
+					entities.push_back(entry->entity);
+				}
+			}
+		}
+	}
+}
+
+void EntityIndex::query(const WFMath::Point<2>& center, float radius, std::vector<EmberEntity*>& entities) const
+{
+	WFMath::AxisBox<2> extent(WFMath::Point<2>(center.x() - radius, center.y() - radius), WFMath::Point<2>(center.x() + radius, center.y() + radius));
+	size_t firstFound = entities.size();
+	query(extent, entities);
+
+	//Remove those entities which only are within the corners of the extent.
+	float squaredRadius = radius * radius;
+	auto outside = std::remove_if(entities.begin() + firstFound, entities.end(), [&](EmberEntity* entity) {
+		const WFMath::AxisBox<2>& bounds = mEntries.find(entity)->second.bounds;
+		float dx = std::max(bounds.lowCorner().x() - center.x(), std::max(0.0f, center.x() - bounds.highCorner().x()));
+		float dy = std::max(bounds.lowCorner().y() - center.y(), std::max(0.0f, center.y() - bounds.highCorner().y()));
+		return dx * dx + dy * dy > squaredRadius;
+	});
+	entities.erase(outside, entities.end());
+}
+
+size_t EntityIndex::size() const
+{
+	return mIndexedCount;
+}
+
+int EntityIndex::cellIndex(float coord) const
+{
+	return static_cast<int>(std::floor(coord / mCellSize));
+}
+
+int64_t EntityIndex::cellKey(int x, int y)
+{
+	return (static_cast<int64_t>(x) << 32) | static_cast<uint32_t>(y);
+}
+
+void EntityIndex::addEntity(EmberEntity& entity)
+{
+	auto result = mEntries.insert(std::make_pair(&entity, Entry()));
+	if (result.second) {
+		Entry& entry = result.first->second;
+		entry.entity = &entity;
+		entry.isIndexed = false;
+		entry.moved = entity.Moved.connect(sigc::bind(sigc::mem_fun(*this, &EntityIndex::Entity_Moved), &entity));
+		entry.locationChanged = entity.LocationChanged.connect(sigc::bind(sigc::mem_fun(*this, &EntityIndex::Entity_LocationChanged), &entity));
+		entry.beingDeleted = entity.BeingDeleted.connect(sigc::bind(sigc::mem_fun(*this, &EntityIndex::Entity_BeingDeleted), &entity));
+	}
+	updateBounds(result.first->second);
+
+	for (unsigned int i = 0; i < entity.numContained(); ++i) {
+		addEntity(*static_cast<EmberEntity*>(entity.getContained(i)));
+	}
+}
+
+void EntityIndex::updateEntity(EmberEntity& entity)
+{
+	auto I = mEntries.find(&entity);
+	if (I == mEntries.end()) {
+		return;
+	}
+	updateBounds(I->second);
+
+	//Contained entities are positioned relative to their location, so they have moved too.
+	for (unsigned int i = 0; i < entity.numContained(); ++i) {
+		updateEntity(*static_cast<EmberEntity*>(entity.getContained(i)));
+	}
+}
+
+void EntityIndex::updateBounds(Entry& entry)
+{
+	removeFromCells(entry);
+	if (calculateBounds(*entry.entity, entry.bounds)) {
+		addToCells(entry);
+	}
+}
+
+bool EntityIndex::calculateBounds(EmberEntity& entity, WFMath::AxisBox<2>& bounds) const
+{
+	if (!entity.getLocation()) {
+		return false;
+	}
+	WFMath::Point<3> position = entity.getViewPosition();
+	if (!position.isValid()) {
+		return false;
+	}
+
+	float radius = 0;
+	if (entity.hasBBox() && entity.getBBox().isValid()) {
+		//Use the corner furthest away from the origin, so that the bounds are valid for any orientation.
+		const WFMath::AxisBox<3>& bbox = entity.getBBox();
+		float squaredRadius = 0;
+		for (int i = 0; i < 3; ++i) {
+			float extent = std::max(std::abs(bbox.lowCorner()[i]), std::abs(bbox.highCorner()[i]));
+			squaredRadius += extent * extent;
+		}
+		radius = std::sqrt(squaredRadius);
+	}
+	bounds = WFMath::AxisBox<2>(WFMath::Point<2>(position.x() - radius, position.y() - radius), WFMath::Point<2>(position.x() + radius, position.y() + radius));
+	return true;
+}
+
+void EntityIndex::addToCells(Entry& entry)
+{
+	entry.minX = cellIndex(entry.bounds.lowCorner().x());
+	entry.maxX = cellIndex(entry.bounds.highCorner().x());
+	entry.minY = cellIndex(entry.bounds.lowCorner().y());
+	entry.maxY = cellIndex(entry.bounds.highCorner().y());
+	for (int x = entry.minX; x <= entry.maxX; ++x) {
+		for (int y = entry.minY; y <= entry.maxY; ++y) {
+			mCells[cellKey(x, y)].push_back(&entry);
+		}
+	}
+	entry.isIndexed = true;
+	mIndexedCount++;
+}
+
+void EntityIndex::removeFromCells(Entry& entry)
+{
+	if (!entry.isIndexed) {
+		return;
+	}
+	for (int x = entry.minX; x <= entry.maxX; ++x) {
+		for (int y = entry.minY; y <= entry.maxY; ++y) {
+			auto I = mCells.find(cellKey(x, y));
+			if (I != mCells.end()) {
+				auto& cell = I->second;
+				cell.erase(std::remove(cell.begin(), cell.end(), &entry), cell.end());
+				if (cell.empty()) {
+					mCells.erase(I);
+				}
+			}
+		}
+	}
+	entry.isIndexed = false;
+	mIndexedCount--;
+}
+
+void EntityIndex::View_EntitySeen(Eris::Entity* entity)
+{
+	addEntity(*static_cast<EmberEntity*>(entity));
+}
+
+void EntityIndex::Entity_Moved(EmberEntity* entity)
+{
+	updateEntity(*entity);
+}
+
+void EntityIndex::Entity_LocationChanged(Eris::Entity* oldLocation, EmberEntity* entity)
+{
+	updateEntity(*entity);
+}
+
+void EntityIndex::Entity_BeingDeleted(EmberEntity* entity)
+{
+	auto I = mEntries.find(entity);
+	if (I != mEntries.end()) {
+		removeFromCells(I->second);
+		I->second.moved.disconnect();
+		I->second.locationChanged.disconnect();
+		I->second.beingDeleted.disconnect();
+		mEntries.erase(I);
+	}
+}
+
+}
+}
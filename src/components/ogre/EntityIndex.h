@@ -0,0 +1,191 @@
+/*
+ Copyright (C) 2014 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef EMBEROGRE_ENTITYINDEX_H_
+#define EMBEROGRE_ENTITYINDEX_H_
+
+#include <wfmath/axisbox.h>
+#include <wfmath/point.h>
+
+#include <sigc++/trackable.h>
+#include <sigc++/connection.h>
+
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+namespace Eris
+{
+class View;
+class Entity;
+}
+
+namespace Ember
+{
+class EmberEntity;
+
+namespace OgreView
+{
+
+/**
+ * @brief A hashed grid spatial index of the horizontal bounds of all entities in the world.
+ *
+ * The index keeps itself up to date by listening to the entities being seen, moved, relocated and deleted.
+ * When an entity moves all entities contained in it are moved too, so these are updated as well.
+ *
+ * This allows for finding all entities within an area or close to a point without having to walk the whole entity tree.
+ *
+ * The top level entity, i.e. the world, isn't indexed since it covers everything.
+ */
+class EntityIndex : public virtual sigc::trackable
+{
+public:
+
+	/**
+	 * @brief Ctor.
+	 *
+	 * Any entities already in the view are added to the index.
+	 * @param view The view whose entities should be indexed.
+	 * @param cellSize The size of each grid cell, in world units.
+	 */
+	explicit EntityIndex(Eris::View& view, float cellSize = 32.0f);
+
+	/**
+	 * @brief Dtor.
+	 */
+	~EntityIndex();
+
+	/**
+	 * @brief Finds all entities whose bounds intersect the extent.
+	 * @param extent An extent in world units.
+	 * @param entities The found entities are added to this. An entity is only added once per query.
+	 */
+	void query(const WFMath::AxisBox<2>& extent, std::vector<EmberEntity*>& entities) const;
+
+	/**
+	 * @brief Finds all entities whose bounds are within a radius of a point.
+	 * @param center A point in world units.
+	 * @param radius The radius.
+	 * @param entities The found entities are added to this. An entity is only added once per query.
+	 */
+	void query(const WFMath::Point<2>& center, float radius, std::vector<EmberEntity*>& entities) const;
+
+	/**
+	 * @brief Gets the number of entities which currently are indexed.
+	 * @return The number of indexed entities.
+	 */
+	size_t size() const;
+
+private:
+
+	struct Entry
+	{
+		EmberEntity* entity;
+
+		sigc::connection moved;
+		sigc::connection locationChanged;
+		sigc::connection beingDeleted;
+
+		/**
+		 * @brief True if the entity has a valid position, and thus is registered in the cells.
+		 */
+		bool isIndexed;
+
+		/**
+		 * @brief The horizontal bounds of the entity, in world units.
+		 */
+		WFMath::AxisBox<2> bounds;
+
+		int minX;
+		int maxX;
+		int minY;
+		int maxY;
+	};
+
+	/**
+	 * @brief The size of each cell.
+	 */
+	float mCellSize;
+
+	/**
+	 * @brief All observed entities.
+	 *
+	 * Since elements in an unordered_map never are moved the cells can hold pointers to the entries.
+	 */
+	std::unordered_map<EmberEntity*, Entry> mEntries;
+
+	/**
+	 * @brief The grid cells, with the entries overlapping each cell.
+	 */
+	std::unordered_map<int64_t, std::vector<const Entry*>> mCells;
+
+	/**
+	 * @brief The number of entries registered in the cells.
+	 */
+	size_t mIndexedCount;
+
+	int cellIndex(float coord) const;
+
+	static int64_t cellKey(int x, int y);
+
+	/**
+	 * @brief Starts observing an entity, along with all entities contained in it.
+	 * @param entity An entity.
+	 */
+	void addEntity(EmberEntity& entity);
+
+	/**
+	 * @brief Recalculates the bounds of an entity, and of all entities contained in it.
+	 * @param entity An entity.
+	 */
+	void updateEntity(EmberEntity& entity);
+
+	/**
+	 * @brief Recalculates the bounds of an entry, and registers it in the cells it now overlaps.
+	 * @param entry An entry.
+	 */
+	void updateBounds(Entry& entry);
+
+	/**
+	 * @brief Calculates the horizontal bounds of an entity in world units.
+	 *
+	 * The bounds are made large enough to contain the entity no matter its orientation.
+	 * @param entity An entity.
+	 * @param bounds The bounds will be placed here.
+	 * @return True if the entity has a valid position.
+	 */
+	bool calculateBounds(EmberEntity& entity, WFMath::AxisBox<2>& bounds) const;
+
+	void addToCells(Entry& entry);
+
+	void removeFromCells(Entry& entry);
+
+	void View_EntitySeen(Eris::Entity* entity);
+
+	void Entity_Moved(EmberEntity* entity);
+
+	void Entity_LocationChanged(Eris::Entity* oldLocation, EmberEntity* entity);
+
+	void Entity_BeingDeleted(EmberEntity* entity);
+
+};
+
+}
+}
+
+#endif /* EMBEROGRE_ENTITYINDEX_H_ */
@@ -0,0 +1,174 @@
+/*
+ Copyright (C) 2014 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "FrameCaptureQueue.h"
+
+#include "framework/tasks/TaskQueue.h"
+#include "framework/tasks/ITask.h"
+#include "framework/LoggingInstance.h"
+
+#include <OgreRenderTarget.h>
+#include <OgreImage.h>
+#include <OgrePixelFormat.h>
+
+#include <fstream>
+
+namespace Ember
+{
+namespace OgreView
+{
+
+namespace
+{
+bool hasTgaExtension(const std::string& path)
+{
+	return path.size() >= 4 && path.compare(path.size() - 4, 4, ".tga") == 0;
+}
+}
+
+/**
+ * @brief Encodes and writes a captured buffer in a background thread, and returns it to the pool in the main thread.
+ */
+class FrameCaptureQueue::EncodeTask: public Tasks::ITask
+{
+public:
+	EncodeTask(FrameCaptureQueue& queue, Buffer& buffer, const std::string& path, const CompletionCallback& callback) :
+			mQueue(queue), mBuffer(buffer), mPath(path), mCallback(callback), mSuccess(false)
+	{
+	}
+
+	virtual void executeTaskInBackgroundThread(Tasks::TaskExecutionContext& context)
+	{
+		try {
+			if (mBuffer.isBgr) {
+				mSuccess = FrameCaptureQueue::writeTga(mPath, mBuffer.width, mBuffer.height, mBuffer.pixels.data());
+			} else {
+				Ogre::Image image;
+				image.loadDynamicImage(mBuffer.pixels.data(), mBuffer.width, mBuffer.height, 1, Ogre::PF_BYTE_RGB, false);
+				image.save(mPath);
+				mSuccess = true;
+			}
+		} catch (const std::exception& ex) {
+			S_LOG_FAILURE("Could not write captured frame to '" << mPath << "'." << ex);
+		}
+	}
+
+	virtual void executeTaskInMainThread()
+	{
+		mQueue.releaseBuffer(&mBuffer);
+		if (mCallback) {
+			mCallback(mPath, mSuccess);
+		}
+	}
+
+	virtual std::string getName() const
+	{
+		return "EncodeTask";
+	}
+
+private:
+	FrameCaptureQueue& mQueue;
+	Buffer& mBuffer;
+	const std::string mPath;
+	CompletionCallback mCallback;
+	bool mSuccess;
+};
+
+FrameCaptureQueue::FrameCaptureQueue(Ogre::RenderTarget& renderTarget, Eris::EventService& eventService, size_t bufferCount, unsigned int numberOfThreads) :
+		mRenderTarget(renderTarget), mTaskQueue(new Tasks::TaskQueue(numberOfThreads, eventService)), mDroppedFrameCount(0)
+{
+	for (size_t i = 0; i < bufferCount; ++i) {
+		mBuffers.emplace_back(new Buffer());
+		mFreeBuffers.push_back(mBuffers.back().get());
+	}
+}
+
+FrameCaptureQueue::~FrameCaptureQueue()
+{
+	//Complete all captures in progress before the buffers are destroyed.
+	mTaskQueue.reset();
+}
+
+bool FrameCaptureQueue::capture(const std::string& path, const CompletionCallback& callback)
+{
+	if (mFreeBuffers.empty()) {
+		mDroppedFrameCount++;
+		return false;
+	}
+	Buffer* buffer = mFreeBuffers.back();
+
+	//TGA files store their pixels as BGR, which lets us write them without any conversion.
+	buffer->isBgr = hasTgaExtension(path);
+	buffer->width = mRenderTarget.getWidth();
+	buffer->height = mRenderTarget.getHeight();
+	Ogre::PixelFormat format = buffer->isBgr ? Ogre::PF_BYTE_BGR : Ogre::PF_BYTE_RGB;
+	//Resizing keeps the allocated memory if the buffer already is large enough.
+	buffer->pixels.resize(Ogre::PixelUtil::getMemorySize(buffer->width, buffer->height, 1, format));
+
+	try {
+		mRenderTarget.copyContentsToMemory(Ogre::PixelBox(buffer->width, buffer->height, 1, format, buffer->pixels.data()));
+	} catch (const std::exception& ex) {
+		S_LOG_FAILURE("Could not copy contents of render target." << ex);
+		return false;
+	}
+
+	mFreeBuffers.pop_back();
+	if (!mTaskQueue->enqueueTask(new EncodeTask(*this, *buffer, path, callback))) {
+		mFreeBuffers.push_back(buffer);
+		return false;
+	}
+	return true;
+}
+
+size_t FrameCaptureQueue::getDroppedFrameCount() const
+{
+	return mDroppedFrameCount;
+}
+
+void FrameCaptureQueue::releaseBuffer(Buffer* buffer)
+{
+	mFreeBuffers.push_back(buffer);
+}
+
+bool FrameCaptureQueue::writeTga(const std::string& path, size_t width, size_t height, const unsigned char* pixels)
+{
+	std::ofstream stream(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!stream) {
+		return false;
+	}
+	unsigned char header[18] = { 0 };
+	//Uncompressed true color image.
+	header[2] = 2;
+	header[12] = width & 0xFF;
+	header[13] = (width >> 8) & 0xFF;
+	header[14] = height & 0xFF;
+	header[15] = (height >> 8) & 0xFF;
+	header[16] = 24;
+	//The rows are stored from the top down.
+	header[17] = 0x20;
+	stream.write(reinterpret_cast<const char*>(header), sizeof(header));
+	stream.write(reinterpret_cast<const char*>(pixels), width * height * 3);
+	return stream.good();
+}
+
+}
+}
@@ -0,0 +1,151 @@
+/*
+ Copyright (C) 2014 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef EMBEROGRE_FRAMECAPTUREQUEUE_H_
+#define EMBEROGRE_FRAMECAPTUREQUEUE_H_
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+
+namespace Eris
+{
+class EventService;
+}
+
+namespace Ogre
+{
+class RenderTarget;
+}
+
+namespace Ember
+{
+namespace Tasks
+{
+class TaskQueue;
+}
+namespace OgreView
+{
+
+/**
+ * @brief Captures the contents of a render target and writes them to disk, without stalling the main thread on encoding and file io.
+ *
+ * The contents are copied into one of a fixed number of preallocated buffers, which are then encoded and written to disk in background threads.
+ * Once a buffer has been written it's returned to the pool for reuse. If all buffers are in use when a capture is requested the frame is dropped
+ * instead of waiting for a buffer to become free. This makes it possible to record frames without distorting the frame rate much.
+ *
+ * Files with the extension ".tga" are written as uncompressed images directly; any other extension is encoded through the Ogre image codecs.
+ */
+class FrameCaptureQueue
+{
+public:
+
+	/**
+	 * @brief Called in the main thread when a capture has been written.
+	 *
+	 * The first parameter is the path of the file, the second is true if the file was written successfully.
+	 */
+	typedef std::function<void(const std::string&, bool)> CompletionCallback;
+
+	/**
+	 * @brief Ctor.
+	 * @param renderTarget The render target to capture.
+	 * @param eventService Used for returning buffers in the main thread.
+	 * @param bufferCount The number of buffers, i.e. the max number of captures which can be in progress at once.
+	 * @param numberOfThreads The number of threads used for encoding.
+	 */
+	FrameCaptureQueue(Ogre::RenderTarget& renderTarget, Eris::EventService& eventService, size_t bufferCount = 4, unsigned int numberOfThreads = 2);
+
+	/**
+	 * @brief Dtor.
+	 *
+	 * Any captures in progress are completed before this returns.
+	 */
+	~FrameCaptureQueue();
+
+	/**
+	 * @brief Captures the current contents of the render target and queues them for writing.
+	 * @param path The path of the file to write.
+	 * @param callback An optional callback, called when the file has been written.
+	 * @return False if the frame was dropped because all buffers were in use, or if the contents couldn't be read.
+	 */
+	bool capture(const std::string& path, const CompletionCallback& callback = CompletionCallback());
+
+	/**
+	 * @brief Gets the number of frames dropped since the queue was created.
+	 * @return The number of dropped frames.
+	 */
+	size_t getDroppedFrameCount() const;
+
+	/**
+	 * @brief Writes pixels as an uncompressed 24 bit TGA file.
+	 * @param path The path of the file.
+	 * @param width The width of the image.
+	 * @param height The height of the image.
+	 * @param pixels The pixels, as tightly packed rows of BGR triplets, from the top row down.
+	 * @return True if the file could be written.
+	 */
+	static bool writeTga(const std::string& path, size_t width, size_t height, const unsigned char* pixels);
+
+private:
+
+	/**
+	 * @brief A buffer for captured pixels.
+	 */
+	struct Buffer
+	{
+		std::vector<unsigned char> pixels;
+		size_t width;
+		size_t height;
+		bool isBgr;
+	};
+
+	class EncodeTask;
+
+	Ogre::RenderTarget& mRenderTarget;
+
+	/**
+	 * @brief Encodes and writes the captures in background threads.
+	 */
+	std::unique_ptr<Tasks::TaskQueue> mTaskQueue;
+
+	/**
+	 * @brief All buffers, both free and in use.
+	 */
+	std::vector<std::unique_ptr<Buffer>> mBuffers;
+
+	/**
+	 * @brief Buffers which currently aren't in use.
+	 */
+	std::vector<Buffer*> mFreeBuffers;
+
+	size_t mDroppedFrameCount;
+
+	/**
+	 * @brief Returns a buffer to the pool. Called in the main thread when a capture has been written.
+	 * @param buffer The buffer.
+	 */
+	void releaseBuffer(Buffer* buffer);
+
+};
+
+}
+}
+
+#endif /* EMBEROGRE_FRAMECAPTUREQUEUE_H_ */
@@ -19,6 +19,11 @@
 #ifndef IANIMATED_H_
 #define IANIMATED_H_
 
+namespace Ogre
+{
+class Sphere;
+}
+
 namespace Ember
 {
 namespace OgreView
@@ -49,6 +54,18 @@ public:
 	 * @param timeSlice The time slice to advance the animation with.
 	 */
 	virtual void updateAnimation(float timeSlice) = 0;
+
+	/**
+	 * @brief Gets the world bounds of what's animated.
+	 *
+	 * This is used for updating animations which are far away or out of view less often.
+	 * @param bounds The bounds will be placed here.
+	 * @return True if there were any bounds; if not the animation will be updated each frame.
+	 */
+	virtual bool getAnimationBounds(Ogre::Sphere& bounds) const
+	{
+		return false;
+	}
 };
 
 }
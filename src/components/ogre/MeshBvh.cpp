@@ -0,0 +1,306 @@
+/*
+ Copyright (C) 2014 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "MeshBvh.h"
+
+#include <OgreSubMesh.h>
+#include <OgreHardwareBufferManager.h>
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <map>
+
+namespace Ember
+{
+namespace OgreView
+{
+
+namespace
+{
+//The max number of triangles in each leaf.
+const uint32_t MAX_LEAF_TRIANGLES = 4;
+
+//The max depth of the hierarchy. Since nodes are split at the median the depth is at most 32 for 2^32 triangles, so this is never reached.
+const int MAX_DEPTH = 64;
+
+bool intersectsBox(const Ogre::Vector3& min, const Ogre::Vector3& max, const Ogre::Vector3& origin, const Ogre::Vector3& invDir, Ogre::Real maxDistance)
+{
+	Ogre::Real tmin = 0;
+	Ogre::Real tmax = maxDistance;
+	for (int i = 0; i < 3; ++i) {
+		Ogre::Real t1 = (min[i] - origin[i]) * invDir[i];
+		Ogre::Real t2 = (max[i] - origin[i]) * invDir[i];
+		if (t1 > t2) {
+			std::swap(t1, t2);
+		}
+		tmin = std::max(tmin, t1);
+		tmax = std::min(tmax, t2);
+		if (tmin > tmax) {
+			return false;
+		}
+	}
+	return true;
+}
+
+struct CacheEntry
+{
+	size_t stateCount;
+	std::weak_ptr<const MeshBvh> bvh;
+};
+
+std::map<const Ogre::Mesh*, CacheEntry> sCache;
+}
+
+MeshBvh::MeshBvh(const std::vector<Ogre::Vector3>& vertices, const std::vector<uint32_t>& indices)
+{
+	size_t triangleCount = indices.size() / 3;
+	std::vector<Ogre::Vector3> triangles;
+	std::vector<Ogre::Vector3> centroids;
+	triangles.reserve(triangleCount * 3);
+	centroids.reserve(triangleCount);
+	for (size_t i = 0; i < triangleCount; ++i) {
+		const Ogre::Vector3& a = vertices[indices[i * 3]];
+		const Ogre::Vector3& b = vertices[indices[i * 3 + 1]];
+		const Ogre::Vector3& c = vertices[indices[i * 3 + 2]];
+		triangles.push_back(a);
+		triangles.push_back(b);
+		triangles.push_back(c);
+		centroids.push_back((a + b + c) / 3.0f);
+	}
+
+	if (triangleCount == 0) {
+		return;
+	}
+
+	std::vector<uint32_t> order(triangleCount);
+	for (uint32_t i = 0; i < triangleCount; ++i) {
+		order[i] = i;
+	}
+	mNodes.reserve((triangleCount / MAX_LEAF_TRIANGLES) * 2 + 1);
+	buildNode(order, centroids, triangles, 0, static_cast<uint32_t>(triangleCount));
+
+	//Store the triangles in leaf order, so that each leaf refers to a consecutive range.
+	mTriangles.reserve(triangleCount * 3);
+	for (uint32_t index : order) {
+		mTriangles.push_back(triangles[index * 3]);
+		mTriangles.push_back(triangles[index * 3 + 1]);
+		mTriangles.push_back(triangles[index * 3 + 2]);
+	}
+}
+
+uint32_t MeshBvh::buildNode(std::vector<uint32_t>& order, const std::vector<Ogre::Vector3>& centroids, const std::vector<Ogre::Vector3>& triangles, uint32_t start, uint32_t end)
+{
+	uint32_t nodeIndex = static_cast<uint32_t>(mNodes.size());
+	mNodes.push_back(Node());
+
+	Ogre::Vector3 min(std::numeric_limits<Ogre::Real>::max());
+	Ogre::Vector3 max(-std::numeric_limits<Ogre::Real>::max());
+	Ogre::Vector3 centroidMin = min;
+	Ogre::Vector3 centroidMax = max;
+	for (uint32_t i = start; i < end; ++i) {
+		uint32_t triangle = order[i];
+		for (int j = 0; j < 3; ++j) {
+			min.makeFloor(triangles[triangle * 3 + j]);
+			max.makeCeil(triangles[triangle * 3 + j]);
+		}
+		centroidMin.makeFloor(centroids[triangle]);
+		centroidMax.makeCeil(centroids[triangle]);
+	}
+
+	mNodes[nodeIndex].min = min;
+	mNodes[nodeIndex].max = max;
+	mNodes[nodeIndex].start = start;
+	mNodes[nodeIndex].count = 0;
+	mNodes[nodeIndex].right = 0;
+	mNodes[nodeIndex].axis = 0;
+
+	if (end - start <= MAX_LEAF_TRIANGLES) {
+		mNodes[nodeIndex].count = end - start;
+		return nodeIndex;
+	}
+
+	//Split at the median along the axis where the centroids are most spread out.
+	Ogre::Vector3 extent = centroidMax - centroidMin;
+	int axis = 0;
+	if (extent.y > extent.x) {
+		axis = 1;
+	}
+	if (extent.z > extent[axis]) {
+		axis = 2;
+	}
+	uint32_t mid = start + (end - start) / 2;
+	std::nth_element(order.begin() + start, order.begin() + mid, order.begin() + end, [&](uint32_t lhs, uint32_t rhs) {
+		return centroids[lhs][axis] < centroids[rhs][axis];
+	});
+
+	mNodes[nodeIndex].axis = axis;
+	buildNode(order, centroids, triangles, start, mid);
+	uint32_t right = buildNode(order, centroids, triangles, mid, end);
+	mNodes[nodeIndex].right = right;
+	return nodeIndex;
+}
+
+std::pair<bool, Ogre::Real> MeshBvh::intersects(const Ogre::Ray& ray, bool positiveSide, bool negativeSide) const
+{
+	std::pair<bool, Ogre::Real> result(false, 0);
+	if (mNodes.empty()) {
+		return result;
+	}
+
+	const Ogre::Vector3& origin = ray.getOrigin();
+	const Ogre::Vector3& direction = ray.getDirection();
+	//Division by zero results in infinity, which the slab test handles.
+	Ogre::Vector3 invDir(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+	Ogre::Real closest = std::numeric_limits<Ogre::Real>::max();
+
+	uint32_t stack[MAX_DEPTH * 2];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize) {
+		const Node& node = mNodes[stack[--stackSize]];
+		if (!intersectsBox(node.min, node.max, origin, invDir, closest)) {
+			continue;
+		}
+
+		if (node.count) {
+			const Ogre::Vector3* vertices = &mTriangles[node.start * 3];
+			for (uint32_t i = 0; i < node.count; ++i, vertices += 3) {
+				std::pair<bool, Ogre::Real> hit = Ogre::Math::intersects(ray, vertices[0], vertices[1], vertices[2], positiveSide, negativeSide);
+				if (hit.first && hit.second < closest) {
+					closest = hit.second;
+					result = hit;
+				}
+			}
+		} else {
+			//A depth first traversal never holds more than one node per level, plus one, so this can't overflow (see MAX_DEPTH).
+			assert(stackSize + 2 <= MAX_DEPTH * 2);
+			//Visit the child closest to the ray origin first, so that the other child can be culled by distance.
+			uint32_t left = static_cast<uint32_t>(&node - &mNodes.front()) + 1;
+			if (direction[node.axis] > 0) {
+				stack[stackSize++] = node.right;
+				stack[stackSize++] = left;
+			} else {
+				stack[stackSize++] = left;
+				stack[stackSize++] = node.right;
+			}
+		}
+	}
+	return result;
+}
+
+size_t MeshBvh::getTriangleCount() const
+{
+	return mTriangles.size() / 3;
+}
+
+size_t MeshBvh::getNodeCount() const
+{
+	return mNodes.size();
+}
+
+std::shared_ptr<const MeshBvh> MeshBvh::createFromMesh(const Ogre::Mesh& mesh)
+{
+	std::vector<Ogre::Vector3> vertices;
+	std::vector<uint32_t> indices;
+
+	bool addedShared = false;
+	size_t sharedOffset = 0;
+
+	for (unsigned short i = 0; i < mesh.getNumSubMeshes(); ++i) {
+		Ogre::SubMesh* submesh = mesh.getSubMesh(i);
+		Ogre::VertexData* vertexData = submesh->useSharedVertices ? mesh.sharedVertexData : submesh->vertexData;
+		if (!vertexData || !submesh->indexData || submesh->indexData->indexCount == 0) {
+			continue;
+		}
+
+		size_t offset = vertices.size();
+		//The shared vertices are only added once.
+		if (submesh->useSharedVertices && addedShared) {
+			offset = sharedOffset;
+		} else {
+			if (submesh->useSharedVertices) {
+				addedShared = true;
+				sharedOffset = offset;
+			}
+
+			const Ogre::VertexElement* posElem = vertexData->vertexDeclaration->findElementBySemantic(Ogre::VES_POSITION);
+			Ogre::HardwareVertexBufferSharedPtr vbuf = vertexData->vertexBufferBinding->getBuffer(posElem->getSource());
+			unsigned char* vertex = static_cast<unsigned char*>(vbuf->lock(Ogre::HardwareBuffer::HBL_READ_ONLY));
+			//There's no baseVertexPointerToElement() which takes an Ogre::Real, so use float in case Ogre::Real is a double.
+			float* pReal;
+			vertex += vertexData->vertexStart * vbuf->getVertexSize();
+			for (size_t j = 0; j < vertexData->vertexCount; ++j, vertex += vbuf->getVertexSize()) {
+				posElem->baseVertexPointerToElement(vertex, &pReal);
+				vertices.push_back(Ogre::Vector3(pReal[0], pReal[1], pReal[2]));
+			}
+			vbuf->unlock();
+		}
+
+		Ogre::IndexData* indexData = submesh->indexData;
+		Ogre::HardwareIndexBufferSharedPtr ibuf = indexData->indexBuffer;
+		size_t indexCount = (indexData->indexCount / 3) * 3;
+		if (ibuf->getType() == Ogre::HardwareIndexBuffer::IT_32BIT) {
+			const uint32_t* pLong = static_cast<const uint32_t*>(ibuf->lock(Ogre::HardwareBuffer::HBL_READ_ONLY)) + indexData->indexStart;
+			for (size_t k = 0; k < indexCount; ++k) {
+				indices.push_back(pLong[k] + static_cast<uint32_t>(offset));
+			}
+		} else {
+			const uint16_t* pShort = static_cast<const uint16_t*>(ibuf->lock(Ogre::HardwareBuffer::HBL_READ_ONLY)) + indexData->indexStart;
+			for (size_t k = 0; k < indexCount; ++k) {
+				indices.push_back(static_cast<uint32_t>(pShort[k]) + static_cast<uint32_t>(offset));
+			}
+		}
+		ibuf->unlock();
+	}
+
+	return std::make_shared<const MeshBvh>(vertices, indices);
+}
+
+std::shared_ptr<const MeshBvh> MeshBvh::getForMesh(const Ogre::MeshPtr& mesh)
+{
+	size_t stateCount = mesh->getStateCount();
+	auto I = sCache.find(mesh.get());
+	if (I != sCache.end() && I->second.stateCount == stateCount) {
+		auto bvh = I->second.bvh.lock();
+		if (bvh) {
+			return bvh;
+		}
+	}
+
+	//Remove entries for hierarchies no longer used, so that the cache doesn't grow forever.
+	for (auto J = sCache.begin(); J != sCache.end();) {
+		if (J->second.bvh.expired()) {
+			J = sCache.erase(J);
+		} else {
+			++J;
+		}
+	}
+
+	auto bvh = createFromMesh(*mesh);
+	sCache[mesh.get()] = CacheEntry { stateCount, bvh };
+	return bvh;
+}
+
+}
+}
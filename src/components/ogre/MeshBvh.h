@@ -0,0 +1,128 @@
+/*
+ Copyright (C) 2014 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef EMBEROGRE_MESHBVH_H_
+#define EMBEROGRE_MESHBVH_H_
+
+#include <OgreVector3.h>
+#include <OgreRay.h>
+#include <OgreMesh.h>
+
+#include <vector>
+#include <memory>
+#include <utility>
+#include <cstdint>
+
+namespace Ember
+{
+namespace OgreView
+{
+
+/**
+ * @brief A bounding volume hierarchy over the triangles of a mesh, in model space.
+ *
+ * This allows rays to be tested against meshes without having to test every triangle.
+ * The hierarchy is built once per mesh; use getForMesh() to get an instance shared by all entities using the same mesh.
+ * Rays should be transformed into model space before being tested, instead of transforming the mesh into world space.
+ */
+class MeshBvh
+{
+public:
+
+	/**
+	 * @brief Ctor.
+	 * @param vertices Vertex positions.
+	 * @param indices Vertex indices, three for each triangle.
+	 */
+	MeshBvh(const std::vector<Ogre::Vector3>& vertices, const std::vector<uint32_t>& indices);
+
+	/**
+	 * @brief Finds the closest intersection between a ray and the triangles.
+	 * @param ray A ray, in model space. The direction doesn't need to be normalized.
+	 * @param positiveSide True if triangles facing the ray should be tested.
+	 * @param negativeSide True if triangles facing away from the ray should be tested.
+	 * @return Whether there was an intersection, and if so the distance along the ray, in multiples of the ray direction.
+	 */
+	std::pair<bool, Ogre::Real> intersects(const Ogre::Ray& ray, bool positiveSide = true, bool negativeSide = false) const;
+
+	/**
+	 * @brief Gets the number of triangles.
+	 * @return The number of triangles.
+	 */
+	size_t getTriangleCount() const;
+
+	/**
+	 * @brief Gets the number of nodes in the hierarchy.
+	 * @return The number of nodes.
+	 */
+	size_t getNodeCount() const;
+
+	/**
+	 * @brief Creates a hierarchy from the vertex and index data of a mesh.
+	 *
+	 * This reads from the hardware buffers, so the mesh needs to be loaded and its buffers readable.
+	 * @param mesh A mesh.
+	 * @return A new hierarchy.
+	 */
+	static std::shared_ptr<const MeshBvh> createFromMesh(const Ogre::Mesh& mesh);
+
+	/**
+	 * @brief Gets the hierarchy for a mesh, creating it if there's none.
+	 *
+	 * Hierarchies are shared for as long as anyone holds a reference to them, and are recreated if the mesh is reloaded.
+	 * This must only be called from the main thread.
+	 * @param mesh A mesh.
+	 * @return The hierarchy for the mesh.
+	 */
+	static std::shared_ptr<const MeshBvh> getForMesh(const Ogre::MeshPtr& mesh);
+
+private:
+
+	/**
+	 * @brief A node in the hierarchy.
+	 *
+	 * Leaves have a triangle count larger than zero. For other nodes the left child is the next node, and the right child is at "right".
+	 */
+	struct Node
+	{
+		Ogre::Vector3 min;
+		Ogre::Vector3 max;
+		uint32_t start;
+		uint32_t count;
+		uint32_t right;
+		int axis;
+	};
+
+	std::vector<Node> mNodes;
+
+	/**
+	 * @brief The triangles, as three consecutive vertices each, ordered so that the triangles in each leaf are consecutive.
+	 */
+	std::vector<Ogre::Vector3> mTriangles;
+
+	/**
+	 * @brief Builds a node for a range of triangles, and its children.
+	 * @return The index of the new node.
+	 */
+	uint32_t buildNode(std::vector<uint32_t>& order, const std::vector<Ogre::Vector3>& centroids, const std::vector<Ogre::Vector3>& triangles, uint32_t start, uint32_t end);
+};
+
+}
+}
+
+#endif /* EMBEROGRE_MESHBVH_H_ */
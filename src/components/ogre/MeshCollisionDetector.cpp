@@ -32,6 +32,7 @@
 
 #include "model/Model.h"
 #include "model/SubModel.h"
+#include "MeshBvh.h"
 #include <OgreSceneNode.h>
 #include <OgreRay.h>
 #include <OgreSubMesh.h>
@@ -51,6 +52,8 @@ MeshCollisionDetector::~MeshCollisionDetector()
 
 void MeshCollisionDetector::reload()
 {
+	//The submodels might use other meshes now.
+	mBvhs.clear();
 }
 
 void MeshCollisionDetector::refit()
@@ -65,74 +68,55 @@ bool MeshCollisionDetector::getVisualize() const
 	return false;
 }
 
-void MeshCollisionDetector::testCollision(Ogre::Ray& ray, CollisionResult& result)
+const MeshBvh& MeshCollisionDetector::getBvh(const Ogre::MeshPtr& mesh)
 {
+	auto& entry = mBvhs[mesh.get()];
+	size_t stateCount = mesh->getStateCount();
+	if (!entry.bvh || entry.stateCount != stateCount) {
+		entry.bvh = MeshBvh::getForMesh(mesh);
+		entry.stateCount = stateCount;
+	}
+	return *entry.bvh;
+}
 
+void MeshCollisionDetector::testCollision(Ogre::Ray& ray, CollisionResult& result)
+{
 	// at this point we have raycast to a series of different objects bounding boxes.
 	// we need to test these different objects to see which is the first polygon hit.
-	// there are some minor optimizations (distance based) that mean we wont have to
-	// check all of the objects most of the time, but the worst case scenario is that
-	// we need to test every triangle of every object.
+	// Instead of transforming each mesh into world space, the ray is transformed into the model space of each mesh,
+	// where it's tested against the bounding volume hierarchy of the mesh.
 	Ogre::Real closest_distance = -1.0f;
-	Ogre::Vector3 closest_result = Ogre::Vector3::ZERO;
 	const Model::Model::SubModelSet& submodels = mModel->getSubmodels();
 	for (Model::Model::SubModelSet::const_iterator I = submodels.begin(); I != submodels.end(); ++I)
 	{
 		Ogre::Entity* pentity = (*I)->getEntity();
 		if (pentity->isVisible() && pentity->getParentNode()) {
-			// mesh data to retrieve
-			size_t vertex_count;
-			size_t index_count;
-			Ogre::Vector3 *vertices;
-			unsigned long *indices;
-
-			// get the mesh information
-			getMeshInformation(pentity->getMesh(), vertex_count, vertices, index_count, indices,
-								pentity->getParentNode()->_getDerivedPosition(),
-								pentity->getParentNode()->_getDerivedOrientation(),
-								pentity->getParentNode()->getScale());
-
-			// test for hitting individual triangles on the mesh
-			bool new_closest_found = false;
-			for (int i = 0; i < static_cast<int>(index_count); i += 3)
-			{
-				// check for a hit against this triangle
-				std::pair<bool, Ogre::Real> hit = Ogre::Math::intersects(ray, vertices[indices[i]],
-					vertices[indices[i+1]], vertices[indices[i+2]], true, false);
-
-				// if it was a hit check if its the closest
-				if (hit.first)
-				{
-					if ((closest_distance < 0.0f) ||
-						(hit.second < closest_distance))
-					{
-						// this is the closest so far, save it off
-						closest_distance = hit.second;
-						new_closest_found = true;
-					}
-				}
+			Ogre::Node* node = pentity->getParentNode();
+			const Ogre::Vector3& scale = node->_getDerivedScale();
+			if (scale.x == 0 || scale.y == 0 || scale.z == 0) {
+				continue;
 			}
+			Ogre::Quaternion inverseOrientation = node->_getDerivedOrientation().Inverse();
 
-			// free the verticies and indicies memory
-			delete[] vertices;
-			delete[] indices;
+			// The direction isn't normalized after scaling, so that distances along the ray are the same in both spaces.
+			Ogre::Ray localRay((inverseOrientation * (ray.getOrigin() - node->_getDerivedPosition())) / scale, (inverseOrientation * ray.getDirection()) / scale);
 
-			// if we found a new closest raycast for this object, update the
-			// closest_result before moving on to the next object.
-			if (new_closest_found)
+			// A negative scale mirrors the mesh, which flips the facing of the triangles.
+			bool mirrored = (scale.x * scale.y * scale.z) < 0;
+			std::pair<bool, Ogre::Real> hit = getBvh(pentity->getMesh()).intersects(localRay, !mirrored, mirrored);
+			if (hit.first && ((closest_distance < 0.0f) || (hit.second < closest_distance)))
 			{
-				closest_result = ray.getPoint(closest_distance);
+				closest_distance = hit.second;
 			}
 		}
 	}
 
-
 	// return the result
 	if (closest_distance >= 0.0f)
 	{
 		// raycast success
 		result.collided = true;
-		result.position = closest_result;
+		result.position = ray.getPoint(closest_distance);
 		result.distance = closest_distance;
 	}
 	else
@@ -142,132 +126,5 @@ void MeshCollisionDetector::testCollision(Ogre::Ray& ray, CollisionResult& resul
 	}
 }
 
-
-// Get the mesh information for the given mesh.
-// Code found on this forum link: http://www.ogre3d.org/wiki/index.php/RetrieveVertexData
-void MeshCollisionDetector::getMeshInformation(const Ogre::MeshPtr mesh,
-                                size_t &vertex_count,
-                                Ogre::Vector3* &vertices,
-                                size_t &index_count,
-                                unsigned long* &indices,
-                                const Ogre::Vector3 &position,
-                                const Ogre::Quaternion &orient,
-                                const Ogre::Vector3 &scale)
-{
-	bool added_shared = false;
-	size_t current_offset = 0;
-	size_t shared_offset = 0;
-	size_t next_offset = 0;
-	size_t index_offset = 0;
-
-	vertex_count = index_count = 0;
-
-	// Calculate how many vertices and indices we're going to need
-	for (unsigned short i = 0; i < mesh->getNumSubMeshes(); ++i)
-	{
-		Ogre::SubMesh* submesh = mesh->getSubMesh( i );
-
-		// We only need to add the shared vertices once
-		if(submesh->useSharedVertices)
-		{
-			if( !added_shared )
-			{
-				vertex_count += mesh->sharedVertexData->vertexCount;
-				added_shared = true;
-			}
-		}
-		else
-		{
-			vertex_count += submesh->vertexData->vertexCount;
-		}
-
-		// Add the indices
-		index_count += submesh->indexData->indexCount;
-	}
-
-
-	// Allocate space for the vertices and indices
-	vertices = new Ogre::Vector3[vertex_count];
-	indices = new unsigned long[index_count];
-
-	added_shared = false;
-
-	// Run through the submeshes again, adding the data into the arrays
-	for ( unsigned short i = 0; i < mesh->getNumSubMeshes(); ++i)
-	{
-		Ogre::SubMesh* submesh = mesh->getSubMesh(i);
-
-		Ogre::VertexData* vertex_data = submesh->useSharedVertices ? mesh->sharedVertexData : submesh->vertexData;
-
-		if((!submesh->useSharedVertices)||(submesh->useSharedVertices && !added_shared))
-		{
-			if(submesh->useSharedVertices)
-			{
-				added_shared = true;
-				shared_offset = current_offset;
-			}
-
-			const Ogre::VertexElement* posElem =
-				vertex_data->vertexDeclaration->findElementBySemantic(Ogre::VES_POSITION);
-
-			Ogre::HardwareVertexBufferSharedPtr vbuf =
-				vertex_data->vertexBufferBinding->getBuffer(posElem->getSource());
-
-			unsigned char* vertex =
-				static_cast<unsigned char*>(vbuf->lock(Ogre::HardwareBuffer::HBL_READ_ONLY));
-
-			// There is _no_ baseVertexPointerToElement() which takes an Ogre::Real or a double
-			//  as second argument. So make it float, to avoid trouble when Ogre::Real will
-			//  be comiled/typedefed as double:
-			//      Ogre::Real* pReal;
-			float* pReal;
-
-			for( size_t j = 0; j < vertex_data->vertexCount; ++j, vertex += vbuf->getVertexSize())
-			{
-				posElem->baseVertexPointerToElement(vertex, &pReal);
-
-				Ogre::Vector3 pt(pReal[0], pReal[1], pReal[2]);
-
-				vertices[current_offset + j] = (orient * (pt * scale)) + position;
-			}
-
-			vbuf->unlock();
-			next_offset += vertex_data->vertexCount;
-		}
-
-
-		Ogre::IndexData* index_data = submesh->indexData;
-		size_t numTris = index_data->indexCount / 3;
-		Ogre::HardwareIndexBufferSharedPtr ibuf = index_data->indexBuffer;
-
-		bool use32bitindexes = (ibuf->getType() == Ogre::HardwareIndexBuffer::IT_32BIT);
-
-		unsigned long*  pLong = static_cast<unsigned long*>(ibuf->lock(Ogre::HardwareBuffer::HBL_READ_ONLY));
-		unsigned short* pShort = reinterpret_cast<unsigned short*>(pLong);
-
-
-		size_t offset = (submesh->useSharedVertices)? shared_offset : current_offset;
-
-		if ( use32bitindexes )
-		{
-			for ( size_t k = 0; k < numTris*3; ++k)
-			{
-				indices[index_offset++] = pLong[k] + static_cast<unsigned long>(offset);
-			}
-		}
-		else
-		{
-			for ( size_t k = 0; k < numTris*3; ++k)
-			{
-				indices[index_offset++] = static_cast<unsigned long>(pShort[k]) +
-					static_cast<unsigned long>(offset);
-			}
-		}
-
-		ibuf->unlock();
-		current_offset = next_offset;
-	}
-}
-
 }
 }
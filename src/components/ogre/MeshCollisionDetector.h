@@ -26,11 +26,17 @@
 #include "EmberEntityUserObject.h"
 #include "ICollisionDetector.h"
 
+#include <map>
+#include <memory>
+
 namespace Ember {
 namespace OgreView {
 
+class MeshBvh;
+
 /**
-	Uses a brute force approach to checking for intersection by iterating through all vertices to see which intersects the ray.
+	Checks for intersection with the triangles of the meshes of a model.
+	Each mesh has a bounding volume hierarchy, shared with all other entities using the same mesh, and the ray is transformed into model space before being tested against it.
 	@author Erik Hjortsberg <erik.hjortsberg@gmail.com>
 */
 class MeshCollisionDetector : public ICollisionDetector
@@ -52,14 +58,30 @@ public:
 
 protected:
 	Model::Model* mModel;
-	void getMeshInformation(const Ogre::MeshPtr mesh,
-                                size_t &vertex_count,
-                                Ogre::Vector3* &vertices,
-                                size_t &index_count,
-                                unsigned long* &indices,
-                                const Ogre::Vector3 &position,
-                                const Ogre::Quaternion &orient,
-                                const Ogre::Vector3 &scale);
+
+	struct BvhEntry
+	{
+		/**
+		 * @brief The state count of the mesh when the hierarchy was fetched; used to detect when the mesh has been reloaded.
+		 */
+		size_t stateCount;
+		std::shared_ptr<const MeshBvh> bvh;
+	};
+
+	/**
+	 * @brief The hierarchies of the meshes used by the model.
+	 *
+	 * These are fetched when first needed, and kept here so that they are shared for as long as the model exists.
+	 * If a mesh is reloaded its hierarchy is fetched again.
+	 */
+	std::map<const Ogre::Mesh*, BvhEntry> mBvhs;
+
+	/**
+	 * @brief Gets the hierarchy for a mesh.
+	 * @param mesh A mesh used by the model.
+	 * @return The hierarchy.
+	 */
+	const MeshBvh& getBvh(const Ogre::MeshPtr& mesh);
 };
 
 }
@@ -25,21 +25,48 @@
 #include "IMovable.h"
 #include "IAnimated.h"
 
+#include <OgreCamera.h>
+#include <OgreSphere.h>
+
+#include <algorithm>
+
 
 template<> Ember::OgreView::MotionManager* Ember::Singleton<Ember::OgreView::MotionManager>::ms_Singleton = 0;
 namespace Ember {
 namespace OgreView {
 
 
-MotionManager::MotionManager()
+MotionManager::MotionManager() :
+		mCamera(nullptr), mFullRateSize(0.05f), mMaxUpdateInterval(0.25f), mOffscreenUpdateInterval(1.0f), mMinParallelUpdates(32), mWorkGeneration(0), mBusyWorkers(0), mIsShuttingDown(false), mNextDueIndex(0)
 {
 	mInfo.MovingEntities = mMotionSet.size();
 	mInfo.AnimatedEntities = mAnimatedEntities.size();
+	mInfo.AnimationsUpdated = 0;
+
+	//Leave one core for the main thread, and one for the other background work.
+	unsigned int numberOfWorkers = std::min(3u, std::max(2u, std::thread::hardware_concurrency()) - 2u);
+	for (unsigned int i = 0; i < numberOfWorkers; ++i) {
+		mWorkers.emplace_back(&MotionManager::workerLoop, this);
+	}
 }
 
 
 MotionManager::~MotionManager()
-{}
+{
+	{
+		std::lock_guard<std::mutex> lock(mWorkMutex);
+		mIsShuttingDown = true;
+	}
+	mWorkCondition.notify_all();
+	for (auto& worker : mWorkers) {
+		worker.join();
+	}
+}
+
+void MotionManager::setCamera(const Ogre::Camera* camera)
+{
+	mCamera = camera;
+}
 
 
 void MotionManager::doMotionUpdate(Ogre::Real timeSlice)
@@ -49,10 +76,89 @@ void MotionManager::doMotionUpdate(Ogre::Real timeSlice)
 	}
 }
 
+Ogre::Real MotionManager::calculateUpdateInterval(const IAnimated& animated) const
+{
+	Ogre::Sphere bounds;
+	if (!mCamera || !animated.getAnimationBounds(bounds)) {
+		return 0;
+	}
+
+	if (!mCamera->isVisible(bounds)) {
+		return mOffscreenUpdateInterval;
+	}
+
+	Ogre::Real distance = std::max<Ogre::Real>(mCamera->getDerivedPosition().distance(bounds.getCenter()), 1.0f);
+	Ogre::Real size = bounds.getRadius() / distance;
+	if (size >= mFullRateSize) {
+		return 0;
+	}
+	//Go from about 30 updates per second at the full rate size, down to the min rate for things which are really small on screen.
+	return std::min(mMaxUpdateInterval, (1.0f / 30.0f) * (mFullRateSize / std::max<Ogre::Real>(size, 0.0001f)));
+}
+
 void MotionManager::doAnimationUpdate(Ogre::Real timeSlice)
 {
-	for (AnimatedStore::const_iterator I = mAnimatedEntities.begin(); I != mAnimatedEntities.end(); ++I) {
-		I->second->updateAnimation(timeSlice);
+	mDueAnimations.clear();
+	for (AnimatedStore::iterator I = mAnimatedEntities.begin(); I != mAnimatedEntities.end(); ++I) {
+		AnimatedEntry& entry = I->second;
+		entry.accumulatedTime += timeSlice;
+		if (entry.accumulatedTime >= calculateUpdateInterval(*entry.animated)) {
+			mDueAnimations.emplace_back(entry.animated, entry.accumulatedTime);
+			entry.accumulatedTime = 0;
+		}
+	}
+	mInfo.AnimationsUpdated = mDueAnimations.size();
+
+	mNextDueIndex = 0;
+	if (mWorkers.empty() || mDueAnimations.size() < mMinParallelUpdates) {
+		updateDueAnimations();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mWorkMutex);
+		mBusyWorkers = mWorkers.size();
+		++mWorkGeneration;
+	}
+	mWorkCondition.notify_all();
+	updateDueAnimations();
+
+	std::unique_lock<std::mutex> lock(mWorkMutex);
+	mWorkDoneCondition.wait(lock, [&]() {return mBusyWorkers == 0;});
+}
+
+void MotionManager::updateDueAnimations()
+{
+	size_t index;
+	while ((index = mNextDueIndex++) < mDueAnimations.size()) {
+		try {
+			mDueAnimations[index].first->updateAnimation(mDueAnimations[index].second);
+		} catch (const std::exception& ex) {
+			S_LOG_FAILURE("Error when updating animation." << ex);
+		}
+	}
+}
+
+void MotionManager::workerLoop()
+{
+	size_t generation = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mWorkMutex);
+			mWorkCondition.wait(lock, [&]() {return mIsShuttingDown || mWorkGeneration != generation;});
+			if (mIsShuttingDown) {
+				return;
+			}
+			generation = mWorkGeneration;
+		}
+
+		updateDueAnimations();
+
+		{
+			std::lock_guard<std::mutex> lock(mWorkMutex);
+			mBusyWorkers--;
+		}
+		mWorkDoneCondition.notify_one();
 	}
 }
 
@@ -83,7 +189,12 @@ void MotionManager::removeMovable(IMovable* movable)
 
 void MotionManager::addAnimated(const std::string& id, IAnimated* animated)
 {
-	mAnimatedEntities[id] = animated;
+	AnimatedEntry& entry = mAnimatedEntities[id];
+	//Keep the accumulated time if the animatable already is registered.
+	if (entry.animated != animated) {
+		entry.animated = animated;
+		entry.accumulatedTime = 0;
+	}
 	mInfo.AnimatedEntities = mAnimatedEntities.size();
 }
 
@@ -24,6 +24,11 @@
 
 #include <OgreFrameListener.h>
 #include <unordered_map>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 namespace Ember {
 class EmberEntity;
@@ -36,6 +41,9 @@ class IMovable;
  * @brief Responsible for making sure that movement and animation within the graphical system is managed and synchronized.
  *
  * The main task of the manager is to keep track of all movables and animatables, i.e. implementations of IMovable and IAnimated, and make sure that these are asked to update their movement or animation when needed (usually each frame).
+ *
+ * Animations which are far away or outside of the view of the camera are updated at a lower rate, with the time slices accumulated in between.
+ * When many animations need to be updated in the same frame the updates are spread out over a couple of worker threads.
  */
 class MotionManager : public Ogre::FrameListener, public Singleton<MotionManager> {
 public:
@@ -47,6 +55,11 @@ public:
 	{
 		size_t AnimatedEntities;
 		size_t MovingEntities;
+
+		/**
+		 * @brief The number of animations updated in the last frame.
+		 */
+		size_t AnimationsUpdated;
 	};
 
 	/**
@@ -89,6 +102,12 @@ public:
 	 */
 	void removeAnimated(const std::string& id);
 
+	/**
+	 * @brief Sets the camera used for deciding how often animations need to be updated.
+	 * @param camera A camera, or null if all animations should be updated each frame.
+	 */
+	void setCamera(const Ogre::Camera* camera);
+
 	/**
 	 * @see Ogre::FrameListener::frameStarted
 	 */
@@ -106,10 +125,19 @@ public:
 
 private:
 
+	/**
+	 * @brief An animatable, along with the time which has passed since it last was updated.
+	 */
+	struct AnimatedEntry
+	{
+		IAnimated* animated;
+		Ogre::Real accumulatedTime;
+	};
+
 	/**
 	 * @brief A store of animatables, identified by a string.
 	 */
-	typedef std::unordered_map<std::string , IAnimated*> AnimatedStore;
+	typedef std::unordered_map<std::string , AnimatedEntry> AnimatedStore;
 
 	/**
 	 * @brief A store of movables.
@@ -132,6 +160,70 @@ private:
 	 */
 	AnimatedStore mAnimatedEntities;
 
+	/**
+	 * @brief The camera used for deciding how often animations need to be updated.
+	 */
+	const Ogre::Camera* mCamera;
+
+	/**
+	 * @brief Animations which appear at least this large, measured as radius divided by distance, are updated each frame.
+	 */
+	Ogre::Real mFullRateSize;
+
+	/**
+	 * @brief The max time between updates for animations in view.
+	 */
+	Ogre::Real mMaxUpdateInterval;
+
+	/**
+	 * @brief The time between updates for animations outside of the view.
+	 */
+	Ogre::Real mOffscreenUpdateInterval;
+
+	/**
+	 * @brief Animations due for an update in the current frame, along with the time slice to update them with.
+	 */
+	std::vector<std::pair<IAnimated*, Ogre::Real>> mDueAnimations;
+
+	/**
+	 * @brief The min number of animations due in a frame for the worker threads to be used.
+	 */
+	size_t mMinParallelUpdates;
+
+	/**
+	 * @brief Threads helping the main thread with updating animations.
+	 */
+	std::vector<std::thread> mWorkers;
+
+	std::mutex mWorkMutex;
+
+	/**
+	 * @brief Notifies the workers that there are animations to update, or that they should shut down.
+	 */
+	std::condition_variable mWorkCondition;
+
+	/**
+	 * @brief Notifies the main thread that a worker is done.
+	 */
+	std::condition_variable mWorkDoneCondition;
+
+	/**
+	 * @brief Incremented each time the workers are asked to update animations.
+	 */
+	size_t mWorkGeneration;
+
+	/**
+	 * @brief The number of workers which haven't completed the current updates yet.
+	 */
+	size_t mBusyWorkers;
+
+	bool mIsShuttingDown;
+
+	/**
+	 * @brief The index of the next entry in mDueAnimations to update.
+	 */
+	std::atomic<size_t> mNextDueIndex;
+
 
 	/**
 	 * @brief Will iterate over all registered movables and ask them to update their positions.
@@ -142,6 +234,25 @@ private:
 	 * @brief Will iterate over all registered animatables and update those that are enabled.
 	 */
 	void doAnimationUpdate(Ogre::Real timeSlice);
+
+	/**
+	 * @brief Calculates how much time should pass between updates of an animatable.
+	 * @param animated An animatable.
+	 * @return The time in seconds, where zero means that it should be updated each frame.
+	 */
+	Ogre::Real calculateUpdateInterval(const IAnimated& animated) const;
+
+	/**
+	 * @brief Updates animations from mDueAnimations until there are none left.
+	 *
+	 * This is called from both the main thread and the workers.
+	 */
+	void updateDueAnimations();
+
+	/**
+	 * @brief The main loop of the worker threads.
+	 */
+	void workerLoop();
 };
 
 inline const MotionManager::MotionManagerInfo& MotionManager::getInfo() const
@@ -42,10 +42,12 @@
 #include "services/input/Input.h"
 #include "services/EmberServices.h"
 #include "services/server/ServerService.h"
+#include "services/config/ConfigService.h"
 
 #include "framework/Tokeniser.h"
 #include "framework/LoggingInstance.h"
 #include "framework/MainLoopController.h"
+#include "framework/osdir.h"
 
 #include <Eris/View.h>
 #include <Eris/EventService.h>
@@ -91,13 +93,25 @@ MovementController::MovementController(Avatar& avatar, Camera::MainCamera& camer
 		/*, MovementRotateLeft("+Movement_rotate_left", this, "Rotate left.")
 		 , MovementRotateRight("+Movement_rotate_right", this, "Rotate right.")*/
 		//, MoveCameraTo("movecamerato", this, "Moves the camera to a point.")
-				, mCamera(camera), mMovementCommandMapper("movement", "key_bindings_movement"), mIsRunning(false), mMovementDirection(WFMath::Vector<3>::ZERO()), mDecalObject(0), mDecalNode(0), mControllerInputListener(*this), mAvatar(avatar), mFreeFlyingNode(0), mIsFreeFlying(false), mAwareness(nullptr), mAwarenessVisualizer(nullptr), mSteering(nullptr), mConfigListenerContainer(new ConfigListenerContainer()), mVisualizePath(false), mActiveMarker(new bool)
+				, mCamera(camera), mMovementCommandMapper("movement", "key_bindings_movement"), mIsRunning(false), mMovementDirection(WFMath::Vector<3>::ZERO()), mDecalObject(0), mDecalNode(0), mControllerInputListener(*this), mAvatar(avatar), mFreeFlyingNode(0), mIsFreeFlying(false), mAwareness(nullptr), mAwarenessVisualizer(nullptr), mSteering(nullptr), mConfigListenerContainer(new ConfigListenerContainer()), mVisualizePath(false), mActiveMarker(new bool), mTileRebuildPending(false)
 {
 
 	*mActiveMarker = true;
 
 	try {
 		mAwareness = new Navigation::Awareness(*avatar.getEmberEntity().getView(), heightProvider);
+
+		//Keep built navmesh tiles between sessions, so that unchanged areas don't need to be rasterized again.
+		const std::string navmeshCacheDir = EmberServices::getSingleton().getConfigService().getHomeDirectory(BaseDirType_CACHE) + "navmesh/";
+		try {
+			oslink::directory osdir(navmeshCacheDir);
+			if (!osdir.isExisting()) {
+				oslink::directory::mkdir(navmeshCacheDir.c_str());
+			}
+			mAwareness->setTileCacheDirectory(navmeshCacheDir);
+		} catch (const std::exception& ex) {
+			S_LOG_WARNING("Could not create directory for navmesh cache; navmesh tiles will be built each session." << ex);
+		}
 		mAwarenessVisualizer = new Authoring::AwarenessVisualizer(*mAwareness, *camera.getCamera().getSceneManager());
 		mSteering = new Navigation::Steering(*mAwareness, *avatar.getEmberEntity().getView()->getAvatar());
 		mSteering->EventPathUpdated.connect(sigc::mem_fun(*this, &MovementController::Steering_PathUpdated));
@@ -122,6 +136,7 @@ MovementController::MovementController(Avatar& avatar, Camera::MainCamera& camer
 
 	mConfigListenerContainer->registerConfigListenerWithDefaults("authoring", "visualizerecasttiles", sigc::mem_fun(*this, &MovementController::Config_VisualizeRecastTiles), false);
 	mConfigListenerContainer->registerConfigListenerWithDefaults("authoring", "visualizerecastpath", sigc::mem_fun(*this, &MovementController::Config_VisualizeRecastPath), false);
+	mConfigListenerContainer->registerConfigListenerWithDefaults("navigation", "tilememorybudget", sigc::mem_fun(*this, &MovementController::Config_TileMemoryBudget), 16);
 
 	mMovementCommandMapper.restrictToInputMode(Input::IM_MOVEMENT);
 	avatar.getEmberEntity().Moved.connect(sigc::mem_fun(*this, &MovementController::Entity_Moved));
@@ -172,10 +187,11 @@ MovementController::~MovementController()
 void MovementController::tileRebuild()
 {
 	if (mAwareness) {
-		int dirtyTiles = mAwareness->rebuildDirtyTile();
-		if (dirtyTiles) {
-			auto marker = mActiveMarker;
-			mAvatar.getEmberEntity().getView()->getEventService().runOnMainThread([this, marker] {if (*marker) {this->tileRebuild();}});
+		//Tiles are built in background threads, so instead of spinning until they are done we'll check back next frame.
+		mTileRebuildPending = mAwareness->rebuildDirtyTile() != 0;
+		//Newly built tiles might push the memory use over the budget.
+		if (!mTileRebuildPending && mAwareness->needsPruning()) {
+			schedulePruning();
 		}
 	}
 }
@@ -283,7 +299,12 @@ void MovementController::frameProcessed(const TimeFrame&, unsigned int)
 			mDecalNode->setVisible(false);
 		}
 	}
+	if (mTileRebuildPending) {
+		tileRebuild();
+	}
 	if (mSteering) {
+		//Path requests are processed incrementally, within a budget, to avoid stalling the frame on long paths.
+		mAwareness->processPathRequests();
 		mSteering->update();
 	}
 
@@ -296,6 +317,17 @@ void MovementController::Config_VisualizeRecastTiles(const std::string&, const s
 	}
 }
 
+void MovementController::Config_TileMemoryBudget(const std::string&, const std::string&, varconf::Variable& var)
+{
+	//The budget is specified in megabytes.
+	if (var.is_int() && mAwareness) {
+		mAwareness->setTileMemoryBudget(static_cast<size_t>(std::max(1, (int)var)) * 1024 * 1024);
+		if (mAwareness->needsPruning()) {
+			schedulePruning();
+		}
+	}
+}
+
 void MovementController::Config_VisualizeRecastPath(const std::string&, const std::string&, varconf::Variable& var)
 {
 	if (var.is_bool() && mAwarenessVisualizer) {
@@ -328,8 +360,8 @@ void MovementController::moveToPoint(const Ogre::Vector3& point)
 //
 	if (mSteering) {
 		WFMath::Point<3> atlasPos = Convert::toWF<WFMath::Point<3>>(point);
+		//Setting the destination will make the steering request a new path asynchronously.
 		mSteering->setDestination(atlasPos);
-		mSteering->updatePath();
 		mSteering->startSteering();
 
 		if (mAwareness->needsPruning()) {
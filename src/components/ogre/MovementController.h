@@ -202,6 +202,8 @@ protected:
 
 	void Config_VisualizeRecastPath(const std::string&, const std::string&, varconf::Variable& var);
 
+	void Config_TileMemoryBudget(const std::string&, const std::string&, varconf::Variable& var);
+
 	void tileRebuild();
 
 	void stopSteering();
@@ -265,6 +267,13 @@ protected:
 	 * @brief An active marker used for cancelling EventService handlers.
 	 */
 	std::shared_ptr<bool> mActiveMarker;
+
+	/**
+	 * @brief True if there are navmesh tiles being built or waiting to be committed.
+	 *
+	 * While this is true the awareness is processed once every frame.
+	 */
+	bool mTileRebuildPending;
 };
 
 
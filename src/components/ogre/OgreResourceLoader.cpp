@@ -34,6 +34,7 @@
 #include "sound/XMLSoundDefParser.h"
 
 #include "EmberOgreFileSystem.h"
+#include "ResourceManifest.h"
 
 #include "framework/osdir.h"
 #include "framework/TimedLog.h"
@@ -49,13 +50,19 @@ namespace OgreView
 OgreResourceLoader::OgreResourceLoader() :
 		UnloadUnusedResources("unloadunusedresources", this, "Unloads any unused resources."), mLoadRecursive(false)
 {
-	mFileSystemArchiveFactory = new FileSystemArchiveFactory();
+	mResourceManifest = new ResourceManifest(EmberServices::getSingleton().getConfigService().getHomeDirectory(BaseDirType_CACHE) + "resourcemanifest.cache");
+	mFileSystemArchiveFactory = new FileSystemArchiveFactory(mResourceManifest);
 	Ogre::ArchiveManager::getSingleton().addArchiveFactory(mFileSystemArchiveFactory);
+
+	//The sky is only needed once the world is entered, and the sound definitions once sounds are played.
+	mDeferredResourceGroups.insert("Caelum");
+	mDeferredResourceGroups.insert("SoundDefinitions");
 }
 
 OgreResourceLoader::~OgreResourceLoader()
 {
 	delete mFileSystemArchiveFactory;
+	delete mResourceManifest;
 }
 
 void OgreResourceLoader::initialize()
@@ -196,6 +203,32 @@ void OgreResourceLoader::preloadMedia()
 }
 
 
+void OgreResourceLoader::initialiseResourceGroups()
+{
+	TimedLog l("Initialise resource groups.");
+	Ogre::ResourceGroupManager& resourceGroupManager(Ogre::ResourceGroupManager::getSingleton());
+
+	//Check each location for changes once during this pass, rather than on each query.
+	FileSystemArchive::invalidateListings();
+	Ogre::StringVector resourceGroups = resourceGroupManager.getResourceGroups();
+	for (auto& group : resourceGroups) {
+		if (mDeferredResourceGroups.find(group) == mDeferredResourceGroups.end() && !resourceGroupManager.isResourceGroupInitialised(group)) {
+			resourceGroupManager.initialiseResourceGroup(group);
+		}
+	}
+	mResourceManifest->save();
+}
+
+void OgreResourceLoader::ensureResourceGroupInitialised(const std::string& group)
+{
+	Ogre::ResourceGroupManager& resourceGroupManager(Ogre::ResourceGroupManager::getSingleton());
+	if (resourceGroupManager.resourceGroupExists(group) && !resourceGroupManager.isResourceGroupInitialised(group)) {
+		S_LOG_VERBOSE("Initialising deferred resource group " << group << ".");
+		FileSystemArchive::invalidateListings();
+		resourceGroupManager.initialiseResourceGroup(group);
+	}
+}
+
 bool OgreResourceLoader::isExistingDir(const std::string& path) const
 {
 	bool exists = false;
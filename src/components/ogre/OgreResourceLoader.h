@@ -28,10 +28,12 @@
 #include "framework/ConsoleObject.h"
 #include <OgreConfigFile.h>
 #include <map>
+#include <set>
 namespace Ember {
 namespace OgreView {
 
 class FileSystemArchiveFactory;
+class ResourceManifest;
 
 /**
 @author Erik Hjortsberg
@@ -42,6 +44,12 @@ class FileSystemArchiveFactory;
 The main role of this class is to define and load the resources into the Ogre resource system.
 
 If a directory contains a file named "norecurse" (it can be empty) Ember won't recurse further into it
+
+The files in each resource location are recorded in a ResourceManifest, which is kept between sessions so that
+the media directories don't need to be walked at startup unless they have changed.
+
+Some resource groups are only needed once certain parts of the world are created. These are not initialized at
+startup; instead they are initialized through ensureResourceGroupInitialised() when first needed.
 */
 class OgreResourceLoader : public ConsoleObject {
 public:
@@ -57,6 +65,21 @@ public:
 
 	void preloadMedia();
 
+	/**
+	 * @brief Initializes all resource groups, except those which are deferred until first needed.
+	 *
+	 * This parses all scripts in the groups. Once done, the resource manifest is saved.
+	 */
+	void initialiseResourceGroups();
+
+	/**
+	 * @brief Makes sure that a resource group is initialized, i.e. that all scripts in it have been parsed.
+	 *
+	 * Call this before accessing resources in any of the deferred groups.
+	 * @param group The name of the resource group.
+	 */
+	static void ensureResourceGroupInitialised(const std::string& group);
+
 	/**
 	 * @brief Tells Ogre to unload all unused resources, thus freeing up memory.
 	 * @note Calling this might stall the engine a little.
@@ -85,6 +108,16 @@ protected:
 
 	FileSystemArchiveFactory* mFileSystemArchiveFactory;
 
+	/**
+	 * @brief Keeps the listings of all resource locations between sessions.
+	 */
+	ResourceManifest* mResourceManifest;
+
+	/**
+	 * @brief Resource groups which aren't initialized at startup, but when first needed.
+	 */
+	std::set<std::string> mDeferredResourceGroups;
+
 
 	bool addUserMedia(const std::string& path, const std::string& type, const std::string& section, bool recursive);
 	bool addSharedMedia(const std::string& path, const std::string& type, const std::string& section, bool recursive);
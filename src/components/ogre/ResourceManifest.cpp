@@ -0,0 +1,266 @@
+/*
+ Copyright (C) 2014 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "ResourceManifest.h"
+
+#include "framework/LoggingInstance.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+namespace Ember
+{
+namespace OgreView
+{
+
+namespace
+{
+const char MANIFEST_MAGIC[4] = { 'E', 'R', 'M', 'F' };
+const uint32_t MANIFEST_VERSION = 1;
+
+void writeString(std::ostream& stream, const std::string& value)
+{
+	uint32_t size = static_cast<uint32_t>(value.size());
+	stream.write(reinterpret_cast<const char*>(&size), sizeof(size));
+	stream.write(value.data(), size);
+}
+
+bool readString(std::istream& stream, std::string& value)
+{
+	uint32_t size = 0;
+	stream.read(reinterpret_cast<char*>(&size), sizeof(size));
+	//Guard against corrupt files.
+	if (!stream || size > 0x100000) {
+		return false;
+	}
+	value.resize(size);
+	if (size) {
+		stream.read(&value[0], size);
+	}
+	return static_cast<bool>(stream);
+}
+}
+
+ResourceManifest::ResourceManifest(const std::string& path) :
+		mPath(path), mIsDirty(false)
+{
+	load();
+}
+
+ResourceManifest::~ResourceManifest()
+{
+	save();
+}
+
+long long ResourceManifest::getModifiedTime(const std::string& path)
+{
+	struct stat tagStat;
+	if (stat(path.c_str(), &tagStat) != 0) {
+		return -1;
+	}
+	return tagStat.st_mtime;
+}
+
+bool ResourceManifest::isListingCurrent(const std::string& location, const Listing& listing)
+{
+	//Adding or removing a file or directory changes the modification time of the directory it's in.
+	for (auto& directory : listing.directories) {
+		std::string path = directory.first.empty() ? location : location + "/" + directory.first;
+		if (getModifiedTime(path) != directory.second) {
+			return false;
+		}
+	}
+	return true;
+}
+
+std::shared_ptr<const ResourceManifest::Listing> ResourceManifest::find(const std::string& location)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto I = mEntries.find(location);
+	if (I == mEntries.end()) {
+		return std::shared_ptr<const Listing>();
+	}
+	Entry& entry = I->second;
+	if (!entry.isValidated) {
+		if (!isListingCurrent(location, *entry.listing)) {
+			S_LOG_VERBOSE("Resource location " << location << " has changed since the manifest was written.");
+			mEntries.erase(I);
+			mIsDirty = true;
+			return std::shared_ptr<const Listing>();
+		}
+		entry.isValidated = true;
+	}
+	entry.isUsed = true;
+	return entry.listing;
+}
+
+void ResourceManifest::store(const std::string& location, std::shared_ptr<const Listing> listing)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	Entry& entry = mEntries[location];
+	entry.listing = listing;
+	entry.isValidated = true;
+	entry.isUsed = true;
+	mIsDirty = true;
+}
+
+void ResourceManifest::load()
+{
+	std::ifstream stream(mPath.c_str(), std::ios::binary);
+	if (!stream) {
+		return;
+	}
+
+	char magic[4];
+	uint32_t version = 0;
+	uint32_t locationCount = 0;
+	stream.read(magic, 4);
+	stream.read(reinterpret_cast<char*>(&version), sizeof(version));
+	stream.read(reinterpret_cast<char*>(&locationCount), sizeof(locationCount));
+	if (!stream || memcmp(magic, MANIFEST_MAGIC, 4) != 0 || version != MANIFEST_VERSION) {
+		S_LOG_INFO("Resource manifest is out of date; all resource locations will be scanned.");
+		return;
+	}
+
+	std::unordered_map<std::string, Entry> entries;
+	for (uint32_t i = 0; i < locationCount; ++i) {
+		std::string location;
+		auto listing = std::make_shared<Listing>();
+		uint32_t directoryCount = 0;
+		uint32_t fileCount = 0;
+		if (!readString(stream, location)) {
+			break;
+		}
+		stream.read(reinterpret_cast<char*>(&directoryCount), sizeof(directoryCount));
+		for (uint32_t j = 0; j < directoryCount && stream; ++j) {
+			std::string directory;
+			int64_t modifiedTime = 0;
+			if (readString(stream, directory)) {
+				stream.read(reinterpret_cast<char*>(&modifiedTime), sizeof(modifiedTime));
+				listing->directories.emplace_back(std::move(directory), modifiedTime);
+			}
+		}
+		stream.read(reinterpret_cast<char*>(&fileCount), sizeof(fileCount));
+		for (uint32_t j = 0; j < fileCount && stream; ++j) {
+			File file;
+			uint64_t size = 0;
+			if (readString(stream, file.filename)) {
+				stream.read(reinterpret_cast<char*>(&size), sizeof(size));
+				file.size = static_cast<size_t>(size);
+				size_t slash = file.filename.rfind('/');
+				if (slash == std::string::npos) {
+					file.basename = file.filename;
+				} else {
+					file.path = file.filename.substr(0, slash + 1);
+					file.basename = file.filename.substr(slash + 1);
+				}
+				listing->files.push_back(std::move(file));
+			}
+		}
+		if (!stream) {
+			break;
+		}
+		Entry& entry = entries[location];
+		entry.listing = listing;
+		entry.isValidated = false;
+		entry.isUsed = false;
+	}
+	if (!stream) {
+		S_LOG_WARNING("Resource manifest is corrupt; all resource locations will be scanned.");
+		return;
+	}
+	mEntries = std::move(entries);
+	S_LOG_VERBOSE("Read resource manifest with " << mEntries.size() << " locations.");
+}
+
+void ResourceManifest::save()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (mPath.empty()) {
+		return;
+	}
+
+	//Remove locations which no longer are used.
+	for (auto I = mEntries.begin(); I != mEntries.end();) {
+		if (!I->second.isUsed) {
+			I = mEntries.erase(I);
+			mIsDirty = true;
+		} else {
+			++I;
+		}
+	}
+	if (!mIsDirty) {
+		return;
+	}
+
+	//Write to a temporary file first, so that an interrupted write never leaves a corrupt manifest.
+	std::string tempPath = mPath + ".tmp";
+	{
+		std::ofstream stream(tempPath.c_str(), std::ios::binary | std::ios::trunc);
+		if (!stream) {
+			S_LOG_WARNING("Could not write resource manifest to " << tempPath << ".");
+			return;
+		}
+		uint32_t locationCount = static_cast<uint32_t>(mEntries.size());
+		stream.write(MANIFEST_MAGIC, 4);
+		stream.write(reinterpret_cast<const char*>(&MANIFEST_VERSION), sizeof(MANIFEST_VERSION));
+		stream.write(reinterpret_cast<const char*>(&locationCount), sizeof(locationCount));
+		for (auto& entry : mEntries) {
+			const Listing& listing = *entry.second.listing;
+			writeString(stream, entry.first);
+			uint32_t directoryCount = static_cast<uint32_t>(listing.directories.size());
+			stream.write(reinterpret_cast<const char*>(&directoryCount), sizeof(directoryCount));
+			for (auto& directory : listing.directories) {
+				int64_t modifiedTime = directory.second;
+				writeString(stream, directory.first);
+				stream.write(reinterpret_cast<const char*>(&modifiedTime), sizeof(modifiedTime));
+			}
+			uint32_t fileCount = static_cast<uint32_t>(listing.files.size());
+			stream.write(reinterpret_cast<const char*>(&fileCount), sizeof(fileCount));
+			for (auto& file : listing.files) {
+				uint64_t size = file.size;
+				writeString(stream, file.filename);
+				stream.write(reinterpret_cast<const char*>(&size), sizeof(size));
+			}
+		}
+		if (!stream) {
+			stream.close();
+			std::remove(tempPath.c_str());
+			S_LOG_WARNING("Could not write resource manifest to " << tempPath << ".");
+			return;
+		}
+	}
+	std::remove(mPath.c_str());
+	if (std::rename(tempPath.c_str(), mPath.c_str()) != 0) {
+		std::remove(tempPath.c_str());
+		return;
+	}
+	mIsDirty = false;
+}
+
+}
+}
@@ -0,0 +1,169 @@
+/*
+ Copyright (C) 2014 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef EMBEROGRE_RESOURCEMANIFEST_H_
+#define EMBEROGRE_RESOURCEMANIFEST_H_
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace Ember
+{
+namespace OgreView
+{
+
+/**
+ * @brief A manifest of all files in each resource location, kept on disk between sessions.
+ *
+ * Walking all media directories at startup is slow on a large media tree, since each file needs to be visited and stat'ed.
+ * This is made worse by Ogre listing each location once for each script pattern when resource groups are initialized.
+ * With a manifest only the directories of a location need to be checked. If none of them have been modified, no files
+ * can have been added or removed, and the stored listing is used.
+ */
+class ResourceManifest
+{
+public:
+
+	/**
+	 * @brief A file within a location.
+	 */
+	struct File
+	{
+		/**
+		 * @brief The path of the file, relative to the location.
+		 */
+		std::string filename;
+
+		/**
+		 * @brief The directory part of the file name, including a trailing slash.
+		 */
+		std::string path;
+
+		/**
+		 * @brief The name of the file, without any directory.
+		 */
+		std::string basename;
+
+		size_t size;
+	};
+
+	/**
+	 * @brief The contents of a location.
+	 */
+	struct Listing
+	{
+		/**
+		 * @brief All files, in the order they were found when walking the location.
+		 */
+		std::vector<File> files;
+
+		/**
+		 * @brief All directories walked, relative to the location, along with their modification times.
+		 *
+		 * The location itself is included as an empty string.
+		 */
+		std::vector<std::pair<std::string, long long>> directories;
+	};
+
+	/**
+	 * @brief Ctor.
+	 *
+	 * Any existing manifest at the path is read.
+	 * @param path The path of the manifest file.
+	 */
+	explicit ResourceManifest(const std::string& path);
+
+	/**
+	 * @brief Dtor.
+	 *
+	 * Saves the manifest if it has changed.
+	 */
+	~ResourceManifest();
+
+	/**
+	 * @brief Gets the listing of a location, if it's still valid.
+	 * @param location The absolute path of the location.
+	 * @return A listing, or null if there's no valid listing.
+	 */
+	std::shared_ptr<const Listing> find(const std::string& location);
+
+	/**
+	 * @brief Stores the listing of a location.
+	 * @param location The absolute path of the location.
+	 * @param listing The listing.
+	 */
+	void store(const std::string& location, std::shared_ptr<const Listing> listing);
+
+	/**
+	 * @brief Writes the manifest to disk, if it has changed since it was read.
+	 */
+	void save();
+
+	/**
+	 * @brief Gets the modification time of a directory.
+	 * @param path The path of the directory.
+	 * @return The modification time, or -1 if the directory doesn't exist.
+	 */
+	static long long getModifiedTime(const std::string& path);
+
+	/**
+	 * @brief Checks that no files or directories have been added to or removed from a location since it was listed.
+	 * @param location The absolute path of the location.
+	 * @param listing The listing.
+	 * @return True if none of the directories in the listing have been modified.
+	 */
+	static bool isListingCurrent(const std::string& location, const Listing& listing);
+
+private:
+
+	struct Entry
+	{
+		std::shared_ptr<const Listing> listing;
+
+		/**
+		 * @brief True if the directories have been checked during this session.
+		 */
+		bool isValidated;
+
+		/**
+		 * @brief True if the location has been used during this session. Only used locations are saved.
+		 */
+		bool isUsed;
+	};
+
+	std::string mPath;
+
+	std::unordered_map<std::string, Entry> mEntries;
+
+	bool mIsDirty;
+
+	/**
+	 * @brief Archives can be accessed from background threads.
+	 */
+	std::mutex mMutex;
+
+	void load();
+};
+
+}
+}
+
+#endif /* EMBEROGRE_RESOURCEMANIFEST_H_ */
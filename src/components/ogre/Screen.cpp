@@ -22,6 +22,7 @@
 
 #include "Screen.h"
 #include "camera/Recorder.h"
+#include "FrameCaptureQueue.h"
 
 #include "services/EmberServices.h"
 #include "services/config/ConfigService.h"
@@ -42,14 +43,15 @@ namespace Ember
 namespace OgreView
 {
 
-Screen::Screen(Ogre::RenderWindow& window) :
-		ToggleRendermode("toggle_rendermode", this, "Toggle between wireframe and solid render modes."), Screenshot("screenshot", this, "Take a screenshot and write to disk."), Record("+record", this, "Record to disk."), mWindow(window), mRecorder(new Camera::Recorder()), mPolygonMode(Ogre::PM_SOLID)
+Screen::Screen(Ogre::RenderWindow& window, Eris::EventService& eventService) :
+		ToggleRendermode("toggle_rendermode", this, "Toggle between wireframe and solid render modes."), Screenshot("screenshot", this, "Take a screenshot and write to disk."), Record("+record", this, "Record to disk. Use '+record raw' to write uncompressed frames."), mWindow(window), mCaptureQueue(new FrameCaptureQueue(window, eventService)), mRecorder(new Camera::Recorder(*mCaptureQueue)), mPolygonMode(Ogre::PM_SOLID)
 {
 }
 
 Screen::~Screen()
 {
 	delete mRecorder;
+	delete mCaptureQueue;
 }
 
 void Screen::runCommand(const std::string &command, const std::string &args)
@@ -60,7 +62,7 @@ void Screen::runCommand(const std::string &command, const std::string &args)
 	} else if (ToggleRendermode == command) {
 		toggleRenderMode();
 	} else if (Record == command) {
-		mRecorder->startRecording();
+		mRecorder->startRecording(args == "raw");
 	} else if (Record.getInverseCommand() == command) {
 		mRecorder->stopRecording();
 	}
@@ -142,11 +144,17 @@ const std::string Screen::_takeScreenshot()
 		throw Exception("Error when saving screenshot.");
 	}
 
-	try {
-		// take screenshot
-		mWindow.writeContentsToFile(dir + filename.str());
-	} catch (const std::exception& ex) {
-		S_LOG_FAILURE("Could not write screenshot to disc." << ex);
+	// take screenshot
+	bool queued = mCaptureQueue->capture(dir + filename.str(), [](const std::string& path, bool success) {
+		if (success) {
+			S_LOG_INFO("Screenshot saved at: " << path);
+			ConsoleBackend::getSingletonPtr()->pushMessage("Wrote image: " + path, "info");
+		} else {
+			ConsoleBackend::getSingletonPtr()->pushMessage("Error when saving screenshot.", "error");
+		}
+	});
+	if (!queued) {
+		S_LOG_FAILURE("Could not capture screenshot.");
 		throw Exception("Error when saving screenshot.");
 	}
 	return dir + filename.str();
@@ -155,9 +163,7 @@ const std::string Screen::_takeScreenshot()
 void Screen::takeScreenshot()
 {
 	try {
-		const std::string& result = _takeScreenshot();
-		S_LOG_INFO("Screenshot saved at: " << result);
-		ConsoleBackend::getSingletonPtr()->pushMessage("Wrote image: " + result, "info");
+		_takeScreenshot();
 	} catch (const std::exception& ex) {
 		ConsoleBackend::getSingletonPtr()->pushMessage(std::string("Error when saving screenshot: ") + ex.what(), "error");
 	} catch (...) {
@@ -28,6 +28,11 @@
 
 #include <sigc++/trackable.h>
 
+namespace Eris
+{
+class EventService;
+}
+
 namespace Ember
 {
 namespace OgreView
@@ -36,6 +41,7 @@ namespace Camera
 {
 class Recorder;
 }
+class FrameCaptureQueue;
 
 /**
  * @author Erik Ogenvik
@@ -48,8 +54,9 @@ public:
 	/**
 	 * @brief Ctor.
 	 * @param window The main render window.
+	 * @param eventService Used for completing screen shots in the main thread.
 	 */
-	Screen(Ogre::RenderWindow& window);
+	Screen(Ogre::RenderWindow& window, Eris::EventService& eventService);
 
 	/**
 	 * @brief Dtor.
@@ -65,6 +72,8 @@ public:
 
 	/**
 	 * @brief Takes a screen shot and writes it to disk.
+	 *
+	 * The screen shot is written in a background thread, and a message is shown in the console once it's done.
 	 */
 	void takeScreenshot();
 
@@ -87,6 +96,11 @@ protected:
 	 */
 	Ogre::RenderWindow& mWindow;
 
+	/**
+	 * @brief Writes screen shots and recorded frames to disk in background threads.
+	 */
+	FrameCaptureQueue* mCaptureQueue;
+
 	/**
 	 * @brief A recorder which can record frames to disk.
 	 */
@@ -103,7 +117,7 @@ protected:
 	Ogre::RenderTarget::FrameStats mFrameStats;
 
 	/**
-	 * @brief Takes and saves a screenshot to disk.
+	 * @brief Takes a screenshot and queues it for saving to disk.
 	 * @return The file name of the new screenshot.
 	 */
 	const std::string _takeScreenshot();
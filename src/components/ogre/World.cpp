@@ -22,6 +22,7 @@
 #include "MovementController.h"
 #include "EmberEntityFactory.h"
 #include "MotionManager.h"
+#include "EntityIndex.h"
 #include "authoring/EntityMoveManager.h"
 #include "Scene.h"
 #include "EntityWorldPickListener.h"
@@ -43,6 +44,9 @@
 #include "terrain/ITerrainAdapter.h"
 
 #include "camera/MainCamera.h"
+
+#include "model/ModelDefinitionManager.h"
+#include "model/ModelBackgroundLoaderQueue.h"
 #include "camera/ThirdPersonCameraMount.h"
 
 #include "environment/Foliage.h"
@@ -69,6 +73,8 @@
 #include <OgreViewport.h>
 #include <OgreRoot.h>
 
+#include <algorithm>
+
 #include <sigc++/bind.h>
 
 namespace Ember
@@ -83,7 +89,7 @@ World::World(Eris::View& view, Ogre::RenderWindow& renderWindow, Ember::OgreView
 		mTerrainManager(new Terrain::TerrainManager(mScene->createTerrainAdapter(), *mScene, shaderManager, view.getEventService())),
 		mMainCamera(new Camera::MainCamera(mScene->getSceneManager(), mRenderWindow, input, mScene->getMainCamera(), *mTerrainManager->getTerrainAdapter())),
 		mMoveManager(new Authoring::EntityMoveManager(*this)), mEmberEntityFactory(new EmberEntityFactory(view, *mScene, entityMappingManager)),
-		mMotionManager(new MotionManager()), mAvatarCameraMotionHandler(0), mAvatarCameraWarper(nullptr),
+		mMotionManager(new MotionManager()), mEntityIndex(new EntityIndex(view)), mAvatarCameraMotionHandler(0), mAvatarCameraWarper(nullptr),
 		mEntityWorldPickListener(0), mAuthoringManager(new Authoring::AuthoringManager(*this)),
 		mAuthoringMoverConnector(new Authoring::AuthoringMoverConnector(*mAuthoringManager, *mMoveManager)),
 		mTerrainEntityManager(0), mLodLevelManager(new Lod::LodLevelManager(graphicalChangeAdapter, mScene->getMainCamera())),
@@ -98,7 +104,7 @@ World::World(Eris::View& view, Ogre::RenderWindow& renderWindow, Ember::OgreView
 
 	signals.EventTerrainManagerCreated.emit(*mTerrainManager);
 
-	mEnvironment = new Environment::Environment(mScene->getSceneManager(), *mTerrainManager, new Environment::CaelumEnvironment(&mScene->getSceneManager(), &renderWindow, mScene->getMainCamera(), *mCalendar), new Environment::SimpleEnvironment(&mScene->getSceneManager(), &renderWindow, mScene->getMainCamera()));
+	mEnvironment = new Environment::Environment(mScene->getSceneManager(), *mTerrainManager, view.getEventService(), new Environment::CaelumEnvironment(&mScene->getSceneManager(), &renderWindow, mScene->getMainCamera(), *mCalendar), new Environment::SimpleEnvironment(&mScene->getSceneManager(), &renderWindow, mScene->getMainCamera()));
 
 	mScene->addRenderingTechnique("forest", new ForestRenderingTechnique(*mEnvironment->getForest()));
 	mTerrainManager->getHandler().setLightning(mEnvironment);
@@ -107,6 +113,7 @@ World::World(Eris::View& view, Ogre::RenderWindow& renderWindow, Ember::OgreView
 	mViewport->setBackgroundColour(Ogre::ColourValue(0, 0, 0));
 	mScene->getMainCamera().setAspectRatio(Ogre::Real(mViewport->getActualWidth()) / Ogre::Real(mViewport->getActualHeight()));
 
+	mMotionManager->setCamera(&mScene->getMainCamera());
 	signals.EventMotionManagerCreated.emit(*mMotionManager);
 	Ogre::Root::getSingleton().addFrameListener(mMotionManager);
 
@@ -122,10 +129,14 @@ World::World(Eris::View& view, Ogre::RenderWindow& renderWindow, Ember::OgreView
 	mConfigListenerContainer->registerConfigListener("graphics", "foliage", sigc::bind<-1>(sigc::mem_fun(*this, &World::Config_Foliage), sigc::ref(graphicalChangeAdapter)));
 
 	mRenderDistanceManager = new RenderDistanceManager(graphicalChangeAdapter, *(mEnvironment->getFog()), mScene->getMainCamera());
+
+	//Load the models closest to the camera first.
+	Model::ModelDefinitionManager::getSingleton().getBackgroundLoaderQueue().setCamera(&mScene->getMainCamera());
 }
 
 World::~World()
 {
+	Model::ModelDefinitionManager::getSingleton().getBackgroundLoaderQueue().setCamera(nullptr);
 	mAfterTerrainUpdateConnection.disconnect();
 
 	delete mFoliageInitializer;
@@ -152,6 +163,8 @@ World::~World()
 	delete mMotionManager;
 	mSignals.EventMotionManagerDestroyed();
 
+	delete mEntityIndex;
+
 	delete mRenderDistanceManager;
 
 	ISceneRenderingTechnique* technique = mScene->removeRenderingTechnique("forest");
@@ -200,6 +213,12 @@ MotionManager& World::getMotionManager() const
 	return *mMotionManager;
 }
 
+EntityIndex& World::getEntityIndex() const
+{
+	assert(mEntityIndex);
+	return *mEntityIndex;
+}
+
 Camera::MainCamera& World::getMainCamera() const
 {
 	assert(mMainCamera);
@@ -273,16 +292,19 @@ void World::terrainManager_AfterTerrainUpdate(const std::vector<WFMath::AxisBox<
 {
 	EmberEntity* emberEntity = static_cast<EmberEntity*>(mView.getTopLevel());
 	if (emberEntity) {
-		updateEntityPosition(emberEntity, areas);
-	}
-}
+		emberEntity->adjustPosition();
 
-void World::updateEntityPosition(EmberEntity* entity, const std::vector<WFMath::AxisBox<2>>& areas)
-{
-	entity->adjustPosition();
-	for (unsigned int i = 0; i < entity->numContained(); ++i) {
-		EmberEntity* containedEntity = static_cast<EmberEntity*>(entity->getContained(i));
-		updateEntityPosition(containedEntity, areas);
+		//Only the entities within the changed areas need to be adjusted.
+		std::vector<EmberEntity*> entities;
+		for (auto& area : areas) {
+			mEntityIndex->query(area, entities);
+		}
+		//An entity can be within more than one area.
+		std::sort(entities.begin(), entities.end());
+		entities.erase(std::unique(entities.begin(), entities.end()), entities.end());
+		for (EmberEntity* entity : entities) {
+			entity->adjustPosition();
+		}
 	}
 }
 
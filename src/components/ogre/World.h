@@ -98,6 +98,7 @@ class Avatar;
 class MovementController;
 class EmberEntityFactory;
 class MotionManager;
+class EntityIndex;
 class Scene;
 class EmberOgreSignals;
 class ICameraMotionHandler;
@@ -174,6 +175,14 @@ public:
 	 */
 	MotionManager& getMotionManager() const;
 
+	/**
+	 * @brief Gets the spatial index of all entities in the world.
+	 *
+	 * Use this instead of walking the entity tree when looking for entities within an area.
+	 * @return The entity index.
+	 */
+	EntityIndex& getEntityIndex() const;
+
 	/**
 	 * @brief Gets the entity factory which is responsible for creating all new entities in the world.
 	 *
@@ -333,6 +342,11 @@ protected:
 	 */
 	MotionManager* mMotionManager;
 
+	/**
+	 * @brief Spatial index of all entities in the world.
+	 */
+	EntityIndex* mEntityIndex;
+
 	/**
 	 * @brief The main motion handler for the avatar camera.
 	 */
@@ -436,13 +450,6 @@ protected:
 	 */
 	void avatarEntity_BeingDeleted();
 
-	/**
-	 * @brief Updates the position of the entity, and all it's children, as long as it's within the changed areas.
-	 * @param entity The entity to update.
-	 * @param areas The areas which have been updated.
-	 */
-	void updateEntityPosition(EmberEntity* entity, const std::vector<WFMath::AxisBox<2>>& areas);
-
 	/**
 	 * @brief Listen to changes the "graphics:foliage" config element, and create or destroy the foliage accordingly.
 	 * @param section
@@ -17,10 +17,11 @@
  */
 
 #include "Recorder.h"
-#include "components/ogre/EmberOgre.h"
+#include "components/ogre/FrameCaptureQueue.h"
 #include "services/EmberServices.h"
 #include "services/config/ConfigService.h"
 #include "framework/osdir.h"
+#include "framework/LoggingInstance.h"
 #include <OgreRoot.h>
 #include <OgreRenderWindow.h>
 
@@ -31,17 +32,23 @@ namespace OgreView
 namespace Camera
 {
 
-Recorder::Recorder(): mSequence(0), mAccruedTime(0.0f), mFramesPerSecond(20.0f)
+Recorder::Recorder(FrameCaptureQueue& captureQueue): mCaptureQueue(captureQueue), mSequence(0), mAccruedTime(0.0f), mFramesPerSecond(20.0f), mExtension(".png"), mInitialDroppedFrameCount(0)
 {
 }
 
-void Recorder::startRecording()
+void Recorder::startRecording(bool uncompressed)
 {
+	mExtension = uncompressed ? ".tga" : ".png";
+	mInitialDroppedFrameCount = mCaptureQueue.getDroppedFrameCount();
 	Ogre::Root::getSingleton().addFrameListener(this);
 }
 void Recorder::stopRecording()
 {
 	Ogre::Root::getSingleton().removeFrameListener(this);
+	size_t droppedFrames = mCaptureQueue.getDroppedFrameCount() - mInitialDroppedFrameCount;
+	if (droppedFrames) {
+		S_LOG_WARNING("Dropped " << droppedFrames << " frames while recording, since they couldn't be written fast enough.");
+	}
 }
 
 bool Recorder::frameStarted(const Ogre::FrameEvent& event)
@@ -50,7 +57,7 @@ bool Recorder::frameStarted(const Ogre::FrameEvent& event)
 	if (mAccruedTime >= (1.0f / mFramesPerSecond)) {
 		mAccruedTime = 0.0f;
 		std::stringstream filename;
-		filename << "screenshot_" << mSequence++ << ".tga";
+		filename << "screenshot_" << mSequence++ << mExtension;
 		const std::string dir = EmberServices::getSingleton().getConfigService().getHomeDirectory(BaseDirType_DATA) + "recordings/";
 		try {
 			//make sure the directory exists
@@ -65,14 +72,8 @@ bool Recorder::frameStarted(const Ogre::FrameEvent& event)
 			stopRecording();
 			return true;
 		}
-		try {
-			// take screenshot
-			EmberOgre::getSingleton().getRenderWindow()->writeContentsToFile(dir + filename.str());
-		} catch (const std::exception& ex) {
-			S_LOG_FAILURE("Could not write screenshot to disc." << ex);
-			stopRecording();
-			return true;
-		}
+		//The frame is written in a background thread; if there's no room for it in the queue it's dropped.
+		mCaptureQueue.capture(dir + filename.str());
 	}
 	return true;
 }
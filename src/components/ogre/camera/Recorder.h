@@ -19,28 +19,52 @@
 #ifndef RECORDER_H_
 #define RECORDER_H_
 #include <OgreFrameListener.h>
+#include <string>
 
 namespace Ember
 {
 namespace OgreView
 {
+class FrameCaptureQueue;
+
 namespace Camera
 {
 
+/**
+ * @brief Records frames to disk at a fixed rate.
+ *
+ * The frames are written through a FrameCaptureQueue, which means that frames are dropped rather than stalling the rendering if the encoding can't keep up.
+ */
 class Recorder : public Ogre::FrameListener
 {
 public:
- 	Recorder();
-	void startRecording();
+	/**
+	 * @brief Ctor.
+	 * @param captureQueue The queue used for writing frames.
+	 */
+ 	Recorder(FrameCaptureQueue& captureQueue);
+
+	/**
+	 * @brief Starts recording.
+	 * @param uncompressed If true frames are written as uncompressed TGA files, which is faster but takes more space. If false PNG files are written.
+	 */
+	void startRecording(bool uncompressed = false);
 	void stopRecording();
 	/**
 	 * Methods from Ogre::FrameListener
 	 */
 	bool frameStarted(const Ogre::FrameEvent& event);
 private:
+	FrameCaptureQueue& mCaptureQueue;
 	int mSequence;
 	float mAccruedTime;
 	float mFramesPerSecond;
+	std::string mExtension;
+
+	/**
+	 * @brief The number of dropped frames when the recording started.
+	 */
+	size_t mInitialDroppedFrameCount;
 };
 }
 }
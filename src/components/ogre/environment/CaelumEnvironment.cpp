@@ -33,6 +33,7 @@
 //#include "HydraxWater.h"
 #include "framework/Tokeniser.h"
 #include "framework/Time.h"
+#include "components/ogre/OgreResourceLoader.h"
 //#include "Caelum/include/CaelumSystem.h"
 #include <Eris/Calendar.h>
 
@@ -131,6 +132,9 @@ void CaelumEnvironment::setupCaelum(::Ogre::SceneManager *sceneMgr, ::Ogre::Rend
 
 	Ogre::Root* root = Ogre::Root::getSingletonPtr();
 
+	//The Caelum resources aren't parsed at startup.
+	OgreResourceLoader::ensureResourceGroupInitialised("Caelum");
+
 	mCaelumSystem = new Caelum::CaelumSystem(root, sceneMgr, Caelum::CaelumSystem::CAELUM_COMPONENTS_NONE);
 
 	try {
@@ -56,22 +56,26 @@ EmberEntityLoader::EmberEntityLoader(::Forests::PagedGeometry &geom, unsigned in
 EmberEntityLoader::~EmberEntityLoader()
 {
 	//When shutting down, make sure to delete all connections.
-#if EMBERENTITYLOADER_USEBATCH
 	for (EntityStore::iterator I = mEntities.begin(); I != mEntities.end(); ++I) {
-		for (EntityColumn::iterator J = I->second.begin(); J != I->second.end(); ++J) {
-			for (EntityMap::iterator K = J->second.begin(); K != J->second.end(); ++K)
-			{
-				K->second.movedConnection.disconnect();
-				K->second.visibilityChangedConnection.disconnect();
-			}
+		for (EntityMap::iterator J = I->second.begin(); J != I->second.end(); ++J) {
+			J->second.movedConnection.disconnect();
+			J->second.visibilityChangedConnection.disconnect();
 		}
 	}
-#else
-	for (EntityMap::iterator I = mEntities.begin(); I != mEntities.end(); ++I) {
-		I->second.movedConnection.disconnect();
-		I->second.visibilityChangedConnection.disconnect();
+}
+
+EmberEntityLoader::CellKey EmberEntityLoader::getCell(const Ogre::Vector3& position) const
+{
+	if (position.isNaN()) {
+		return CellKey(std::numeric_limits<int>::min(), std::numeric_limits<int>::min());
 	}
-#endif
+	return CellKey(static_cast<int>(Ogre::Math::Floor(position.x / mBatchSize)), static_cast<int>(Ogre::Math::Floor(position.z / mBatchSize)));
+}
+
+void EmberEntityLoader::markPageDirty(const Ogre::Vector3& position)
+{
+	const Ogre::Real pageSize = mGeom.getPageSize();
+	mDirtyPages.insert(CellKey(static_cast<int>(Ogre::Math::Floor(position.x / pageSize)), static_cast<int>(Ogre::Math::Floor(position.z / pageSize))));
 }
 
 void EmberEntityLoader::addEmberEntity(Model::ModelRepresentation* modelRepresentation)
@@ -95,20 +99,14 @@ void EmberEntityLoader::addEmberEntity(Model::ModelRepresentation* modelRepresen
 		position = Convert::toOgre(viewPosition);
 	}
 	instance.lastPosition = position;
-#if EMBERENTITYLOADER_USEBATCH
-	const int batchX = Ogre::Math::Floor(position.x / mBatchSize);
-	const int batchY = Ogre::Math::Floor(position.y / mBatchSize);
-	mEntityLookup[entity] = std::pair<int, int>(batchX, batchY);
-
-	EntityMap& entities(mEntities[batchX][batchY]);
-#else
-	EntityMap& entities(mEntities);
-#endif
-	entities[entity.getId()] = instance;
+
+	const CellKey cell = getCell(position);
+	mEntityLookup[entity.getId()] = cell;
+	mEntities[cell][entity.getId()] = instance;
 
 	if (isValidPos) {
 		//Rebuild geometry if necessary
-		mGeom.reloadGeometryPage(position);
+		markPageDirty(position);
 	}
 
 }
@@ -119,100 +117,71 @@ void EmberEntityLoader::removeEmberEntity(EmberEntity* entity)
 		S_LOG_WARNING("Tried to remove a null ref entity from the paged geometry.");
 		return;
 	}
-#if EMBERENTITYLOADER_USEBATCH
-	EntityLookup::iterator I = mEntityLookup.find(entity);
+	mMovedEntities.erase(entity);
+
+	EntityLookup::iterator I = mEntityLookup.find(entity->getId());
 	if (I != mEntityLookup.end()) {
-		EntityStore::iterator J = mEntities.find(I->second.first);
+		EntityStore::iterator J = mEntities.find(I->second);
 		if (J != mEntities.end()) {
-			EntityColumn& column(J->second);
-			EntityColumn::iterator K = column.find(I->second.second);
-			if (K != column.end()) {
-				EntityMap& entityMap(K->second);
-				EntityMap::iterator L = entityMap.find(entity->getId());
-				if (L != entityMap.end()) {
-					L->second.movedConnection.disconnect();
-					L->second.beingDeletedConnection.disconnect();
-					entityMap.erase(L);
-					mEntityLookup.erase(I);
+			EntityMap& entityMap(J->second);
+			EntityMap::iterator K = entityMap.find(entity->getId());
+			if (K != entityMap.end()) {
+				ModelRepresentationInstance& instance(K->second);
+				Model::ModelRepresentation* modelRepresentation(instance.modelRepresentation);
+				instance.movedConnection.disconnect();
+				instance.visibilityChangedConnection.disconnect();
+				//Reset the rendering distance to the one set by the model def.
+				modelRepresentation->getModel().setRenderingDistance(modelRepresentation->getModel().getDefinition()->getRenderingDistance());
+				if (!instance.lastPosition.isNaN()) {
+					markPageDirty(instance.lastPosition);
+				}
+				entityMap.erase(K);
+				if (entityMap.empty()) {
+					mEntities.erase(J);
 				}
 			}
 		}
-	}
-#else
-	EntityMap::iterator I = mEntities.find(entity->getId());
-	if (I != mEntities.end()) {
-		ModelRepresentationInstance& instance(I->second);
-		Model::ModelRepresentation* modelRepresentation(instance.modelRepresentation);
-		instance.movedConnection.disconnect();
-		instance.visibilityChangedConnection.disconnect();
-		//Reset the rendering distance to the one set by the model def.
-		modelRepresentation->getModel().setRenderingDistance(modelRepresentation->getModel().getDefinition()->getRenderingDistance());
-		mEntities.erase(I);
+		mEntityLookup.erase(I);
 	}
 
-#endif
-
 	WFMath::Point<3> pos = entity->getViewPosition();
 	if (pos.isValid()) {
 		//Rebuild geometry if necessary.
-		mGeom.reloadGeometryPage(Convert::toOgre(pos));
+		markPageDirty(Convert::toOgre(pos));
 	}
 }
 
-EmberEntityLoader::EntityMap* EmberEntityLoader::getStoreForEntity(EmberEntity* entity)
-{
-#if EMBERENTITYLOADER_USEBATCH
-	EntityLookup::iterator I = mEntityLookup.find(entity);
-	if (I != mEntityLookup.end()) {
-		EntityStore::iterator J = mEntities.find(I->second.first);
-		if (J != mEntities.end()) {
-			EntityColumn& column(J->second);
-			EntityColumn::iterator K = column.find(I->second.second);
-			if (K != column.end()) {
-				EntityMap& entityMap(K->second);
-				return &entityMap;
-			}
-		}
-	}
-	return 0;
-#else
-	return &mEntities;
-#endif
-}
-
 void EmberEntityLoader::loadPage(::Forests::PageInfo & page)
 {
 	static Ogre::ColourValue colour(1, 1, 1, 1);
 
-#if EMBERENTITYLOADER_USEBATCH
-	const int batchX = static_cast<int>(Ogre::Math::Floor(page.bounds.left/ mBatchSize));
-	const int batchY = static_cast<int>(Ogre::Math::Floor(page.bounds.top / mBatchSize));
-	EntityMap& entities(mEntities[batchX][batchY]);
-#else
-	EntityMap& entities(mEntities);
-#endif
+	//Only look at the cells which overlap the page.
+	const int cellX1 = static_cast<int>(Ogre::Math::Floor(page.bounds.left / mBatchSize));
+	const int cellX2 = static_cast<int>(Ogre::Math::Floor(page.bounds.right / mBatchSize));
+	const int cellZ1 = static_cast<int>(Ogre::Math::Floor(page.bounds.top / mBatchSize));
+	const int cellZ2 = static_cast<int>(Ogre::Math::Floor(page.bounds.bottom / mBatchSize));
+
+	for (int cellX = cellX1; cellX <= cellX2; ++cellX) {
+		for (int cellZ = cellZ1; cellZ <= cellZ2; ++cellZ) {
+			EntityStore::iterator cellI = mEntities.find(CellKey(cellX, cellZ));
+			if (cellI == mEntities.end()) {
+				continue;
+			}
+			EntityMap& entities(cellI->second);
 
-	for (EntityMap::iterator I = entities.begin(); I != entities.end(); ++I) {
-		ModelRepresentationInstance& instance(I->second);
-		Model::ModelRepresentation* modelRepresentation(instance.modelRepresentation);
-		EmberEntity& emberEntity = modelRepresentation->getEntity();
-		if (emberEntity.isVisible()) {
-			WFMath::Point<3> viewPos = emberEntity.getViewPosition();
-			if (viewPos.isValid()) {
-				Ogre::Vector3 pos(Convert::toOgre(viewPos));
-				Model::Model& model(modelRepresentation->getModel());
-				Ogre::Node* node = model.getParentNode();
-				if (node) {
-					const Ogre::Vector3& pos = node->_getDerivedPosition();
-					if (pos.x > page.bounds.left && pos.x < page.bounds.right && pos.z > page.bounds.top && pos.z < page.bounds.bottom) {
-						for (Model::Model::SubModelSet::const_iterator J = model.getSubmodels().begin(); J != model.getSubmodels().end(); ++J) {
-							// 				if (!(*J)->getEntity()->getParentSceneNode()) {
-							// 					model->getParentSceneNode()->attachObject((*J)->getEntity());
-							// 				}
-							//  				if ((*J)->getEntity()->isVisible()) {
-							addEntity((*J)->getEntity(), pos, node->_getDerivedOrientation(), modelRepresentation->getScale(), colour);
-							// 					(*J)->getEntity()->setVisible(false);
-							//  				}
+			for (EntityMap::iterator I = entities.begin(); I != entities.end(); ++I) {
+				ModelRepresentationInstance& instance(I->second);
+				Model::ModelRepresentation* modelRepresentation(instance.modelRepresentation);
+				EmberEntity& emberEntity = modelRepresentation->getEntity();
+				if (emberEntity.isVisible()) {
+					Model::Model& model(modelRepresentation->getModel());
+					Ogre::Node* node = model.getParentNode();
+					if (node) {
+						const Ogre::Vector3& pos = node->_getDerivedPosition();
+						if (pos.x > page.bounds.left && pos.x < page.bounds.right && pos.z > page.bounds.top && pos.z < page.bounds.bottom) {
+							for (Model::Model::SubModelSet::const_iterator J = model.getSubmodels().begin(); J != model.getSubmodels().end(); ++J) {
+								addEntity((*J)->getEntity(), pos, node->_getDerivedOrientation(), modelRepresentation->getScale(), colour);
+							}
 						}
 					}
 				}
@@ -221,31 +190,73 @@ void EmberEntityLoader::loadPage(::Forests::PageInfo & page)
 	}
 }
 
-void EmberEntityLoader::EmberEntity_Moved(EmberEntity* entity)
+void EmberEntityLoader::frameUpdate()
 {
-	EntityMap* entityMap(getStoreForEntity(entity));
-	if (entityMap) {
-		EntityMap::iterator I = entityMap->find(entity->getId());
-		if (I != entityMap->end()) {
-			ModelRepresentationInstance& instance(I->second);
-			if (!instance.lastPosition.isNaN()) {
-				mGeom.reloadGeometryPage(instance.lastPosition);
-			}
-			WFMath::Point<3> viewPos = entity->getViewPosition();
-			if (viewPos.isValid()) {
-				mGeom.reloadGeometryPage(Convert::toOgre(viewPos));
-				instance.lastPosition = Convert::toOgre(viewPos);
-			}
+	for (std::unordered_set<EmberEntity*>::const_iterator I = mMovedEntities.begin(); I != mMovedEntities.end(); ++I) {
+		updateEntityCell(**I);
+	}
+	mMovedEntities.clear();
+
+	//Every affected page is only reloaded once, no matter how many entities on it that have changed.
+	const Ogre::Real pageSize = mGeom.getPageSize();
+	for (std::set<CellKey>::const_iterator I = mDirtyPages.begin(); I != mDirtyPages.end(); ++I) {
+		mGeom.reloadGeometryPage(Ogre::Vector3((I->first + 0.5f) * pageSize, 0, (I->second + 0.5f) * pageSize));
+	}
+	mDirtyPages.clear();
+}
+
+void EmberEntityLoader::updateEntityCell(EmberEntity& entity)
+{
+	EntityLookup::iterator I = mEntityLookup.find(entity.getId());
+	if (I == mEntityLookup.end()) {
+		return;
+	}
+	EntityStore::iterator J = mEntities.find(I->second);
+	if (J == mEntities.end()) {
+		return;
+	}
+	EntityMap::iterator K = J->second.find(entity.getId());
+	if (K == J->second.end()) {
+		return;
+	}
+
+	ModelRepresentationInstance& instance(K->second);
+	if (!instance.lastPosition.isNaN()) {
+		markPageDirty(instance.lastPosition);
+	}
+	WFMath::Point<3> viewPos = entity.getViewPosition();
+	if (!viewPos.isValid()) {
+		return;
+	}
+	const Ogre::Vector3 position = Convert::toOgre(viewPos);
+	markPageDirty(position);
+	instance.lastPosition = position;
+
+	const CellKey cell = getCell(position);
+	if (cell != I->second) {
+		//Copy the instance before erasing it, since inserting into the new cell can invalidate iterators into the store.
+		ModelRepresentationInstance movedInstance(instance);
+		J->second.erase(K);
+		if (J->second.empty()) {
+			mEntities.erase(J);
 		}
+		mEntities[cell][entity.getId()] = movedInstance;
+		I->second = cell;
 	}
 }
 
+void EmberEntityLoader::EmberEntity_Moved(EmberEntity* entity)
+{
+	//The move is applied in the next frameUpdate(), so that an entity moved many times in one frame is only processed once.
+	mMovedEntities.insert(entity);
+}
+
 void EmberEntityLoader::EmberEntity_VisibilityChanged(bool, EmberEntity* entity)
 {
 	WFMath::Point<3> viewPos = entity->getViewPosition();
 	if (viewPos.isValid()) {
 		//When the visibility changes, we only need to reload the page the entity is on.
-		mGeom.reloadGeometryPage(Convert::toOgre(viewPos));
+		markPageDirty(Convert::toOgre(viewPos));
 	}
 }
 
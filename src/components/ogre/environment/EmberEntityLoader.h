@@ -26,10 +26,8 @@
 #include "pagedgeometry/include/PagedGeometry.h"
 #include <sigc++/connection.h>
 #include <unordered_map>
-
-//If set to 1 batches will be used.
-//This will speed up the process of getting trees, but will add overhead to adding or removing.
-#define EMBERENTITYLOADER_USEBATCH 0
+#include <unordered_set>
+#include <set>
 
 namespace Ember {
 class EmberEntity;
@@ -83,20 +81,38 @@ struct ModelRepresentationInstance
 
 	Use addEmberEntity to add entities, and removeEmberEntity to remove them.
 
-	The storage of entities can either use a straight up map, or use batches, where each batch corresponds to a page in the paged geometry. The latter is more efficient when generating the pages needed by the paged geometry engine, but requires more memory and is less effective when adding or removing entities. The batching can be turned on and off through the EMBERENTITYLOADER_USEBATCH define.
+	The entities are stored in a flat hashed grid, where each cell is of the size of a batch. When a page is loaded only the cells overlapping the page are looked at.
+
+	Changes to entities (additions, removals, movements and visibility changes) aren't applied to the paged geometry directly. Instead the affected pages are collected and reloaded once in frameUpdate(). This means that if a lot of entities are moved at once (such as when importing or authoring a world) every page is only reloaded once per frame.
 */
 class EmberEntityLoader : public ::Forests::PageLoader
 {
 public:
 	typedef std::unordered_map<std::string, ModelRepresentationInstance> EntityMap;
-	typedef std::map<int, EntityMap> EntityColumn;
-	typedef std::map<int, EntityColumn> EntityStore;
-	typedef std::unordered_map<Model::ModelRepresentation*, std::pair<int, int>> EntityLookup;
+
+	/**
+	 * @brief Identifies a cell in the grid, as x and z indices.
+	 */
+	typedef std::pair<int, int> CellKey;
+
+	/**
+	 * @brief Hashes a CellKey, for use in the grid.
+	 */
+	struct CellKeyHash
+	{
+		size_t operator()(const CellKey& key) const
+		{
+			return std::hash<long long>()((static_cast<long long>(key.first) << 32) ^ static_cast<unsigned int>(key.second));
+		}
+	};
+
+	typedef std::unordered_map<CellKey, EntityMap, CellKeyHash> EntityStore;
+	typedef std::unordered_map<std::string, CellKey> EntityLookup;
 
     /**
      * @brief Ctor.
      * @param geom The geometry for which this class will provide entity loading.
-     * @param batchSize The size of each batch. Only relevant if batching is used.
+     * @param batchSize The size of each grid cell, in world units.
      */
     EmberEntityLoader(::Forests::PagedGeometry &geom, unsigned int batchSize);
 
@@ -124,23 +140,31 @@ public:
 	 */
 	virtual void loadPage(::Forests::PageInfo &page);
 
+	/**
+	 * @brief Applies all entity changes since the last frame, reloading each affected page once.
+	 */
+	virtual void frameUpdate();
+
 protected:
-#if EMBERENTITYLOADER_USEBATCH
 	/**
-	@brief The batched store in which the EntityInstance instances are stored.
+	@brief The grid in which the EntityInstance instances are stored.
 	*/
 	EntityStore mEntities;
 
 	/**
-	@brief A lookup map, used for looking up which column and segment any EntityInstance is stored. Use this in combination with mEntities to access the EntityMap where a specific entity can be found.
+	@brief A lookup map, used for looking up in which cell any entity is stored.
 	*/
 	EntityLookup mEntityLookup;
-#else
+
 	/**
-	@brief The main store where we keep our EntityInstance instances.
+	@brief Entities which have moved since the last frame.
 	*/
-	EntityMap mEntities;
-#endif
+	std::unordered_set<EmberEntity*> mMovedEntities;
+
+	/**
+	@brief Pages, as indices in the paged geometry, which need to be reloaded in the next frame.
+	*/
+	std::set<CellKey> mDirtyPages;
 
 	/**
 	@brief The main paged geometry instance which will handle all rendering.
@@ -148,7 +172,7 @@ protected:
 	::Forests::PagedGeometry &mGeom;
 
 	/**
-	@brief The size, in world units, for each batch. Only relevant if batching is used.
+	@brief The size, in world units, of each grid cell.
 	*/
 	unsigned int mBatchSize;
 
@@ -167,12 +191,24 @@ protected:
 	void EmberEntity_VisibilityChanged(bool visible, EmberEntity* entity);
 
 	/**
-	 * @brief Utility method for getting the EntityMap a certain entity belongs to.
-	 * Since we support batching, getting the EntityMap where an entity is located can require some further lookups if batching is enabled. This method should be used by any other method that needs to do such a lookup.
-	 * @param entity The which we should lookup.
-	 * @return A pointer to the EntityMap where the entity is stored, or null if no entity map can be found.
+	 * @brief Gets the grid cell for a position.
+	 * Invalid positions are all placed in a cell which is never loaded.
+	 * @param position The position, in Ogre space.
+	 * @return The cell.
+	 */
+	CellKey getCell(const Ogre::Vector3& position) const;
+
+	/**
+	 * @brief Marks the page at the position as needing a reload.
+	 * @param position The position, in Ogre space.
+	 */
+	void markPageDirty(const Ogre::Vector3& position);
+
+	/**
+	 * @brief Moves the stored instance of the entity to the cell matching its current position, marking the pages at the previous and new position for reloading.
+	 * @param entity The entity which has been moved.
 	 */
-	EntityMap* getStoreForEntity(EmberEntity * entity);
+	void updateEntityCell(EmberEntity& entity);
 };
 
 }
@@ -42,8 +42,8 @@ namespace OgreView
 namespace Environment
 {
 
-Environment::Environment(Ogre::SceneManager& sceneMgr, Terrain::TerrainManager& terrainManager, IEnvironmentProvider* provider, IEnvironmentProvider* fallbackProvider) :
-		SetTime("set_time", this, "Sets the time. parameters: <hour> <minute>"), SetFogDensity("set_fogdensity", this, "Sets the fog density."), SetAmbientLight("setambientlight", this, "Set the ambient light of the world: <red> <green> <blue>"), mProvider(provider), mFallbackProvider(fallbackProvider), mEnabledFirmamentProvider(0), mForest(new Forest(terrainManager))
+Environment::Environment(Ogre::SceneManager& sceneMgr, Terrain::TerrainManager& terrainManager, Eris::EventService& eventService, IEnvironmentProvider* provider, IEnvironmentProvider* fallbackProvider) :
+		SetTime("set_time", this, "Sets the time. parameters: <hour> <minute>"), SetFogDensity("set_fogdensity", this, "Sets the fog density."), SetAmbientLight("setambientlight", this, "Set the ambient light of the world: <red> <green> <blue>"), mProvider(provider), mFallbackProvider(fallbackProvider), mEnabledFirmamentProvider(0), mForest(new Forest(terrainManager, eventService))
 {
 	//Set some default ambient light
 	sceneMgr.setAmbientLight(Ogre::ColourValue(0.6, 0.6, 0.6));
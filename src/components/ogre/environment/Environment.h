@@ -30,6 +30,11 @@
 #include <sigc++/signal.h>
 #include <sigc++/trackable.h>
 
+namespace Eris
+{
+class EventService;
+}
+
 namespace Ember
 {
 class EmberEntity;
@@ -67,10 +72,11 @@ public:
 	 * @brief Ctor.
 	 * @param sceneMgr The main scene manager.
 	 * @param terrainManager The main terrain manager.
+	 * @param eventService Used for running background tasks.
 	 * @param provider Main environment provider.
 	 * @param fallbackProvider A fallback provider which is used if the main provider for some reason fails to create the environment (if for instance the hardware doesn't support it).
 	 */
-	Environment(Ogre::SceneManager& sceneMgr, Terrain::TerrainManager& terrainManager, IEnvironmentProvider* provider, IEnvironmentProvider* fallbackProvider = 0);
+	Environment(Ogre::SceneManager& sceneMgr, Terrain::TerrainManager& terrainManager, Eris::EventService& eventService, IEnvironmentProvider* provider, IEnvironmentProvider* fallbackProvider = 0);
 
 	~Environment();
 
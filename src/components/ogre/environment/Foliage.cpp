@@ -36,10 +36,14 @@
 #include "framework/Tokeniser.h"
 #include "services/config/ConfigService.h"
 
+#include "pagedgeometry/include/PagedGeometry.h"
+
 #include <OgreRoot.h>
 
 #include <wfmath/point.h>
 
+#include <algorithm>
+
 template<> Ember::OgreView::Environment::Foliage* Ember::Singleton<Ember::OgreView::Environment::Foliage>::ms_Singleton = 0;
 using namespace Ember::OgreView::Terrain;
 
@@ -115,26 +119,34 @@ void Foliage::reloadAtPosition(const WFMath::Point<2>& worldPosition)
 	}
 }
 
-bool Foliage::frameStarted(const Ogre::FrameEvent&)
+bool Foliage::frameStarted(const Ogre::FrameEvent& evt)
 {
+	//The page load budget is shared with other paged geometry, so only count what's loaded while updating the foliage.
+	const ::Forests::PageLoadBudget::Stats statsBefore = ::Forests::PageLoadBudget::getCurrentFrameStats();
+	unsigned long start = mTimer.getMicroseconds();
 	for (FoliageStore::iterator I = mFoliages.begin(); I != mFoliages.end(); ++I) {
 		(*I)->frameStarted();
 	}
+	float foliageTime = (mTimer.getMicroseconds() - start) / 1000.0f;
+	const ::Forests::PageLoadBudget::Stats& statsAfter = ::Forests::PageLoadBudget::getCurrentFrameStats();
+	float loadTime = statsAfter.loadTime - statsBefore.loadTime;
+	bool pagesPending = statsAfter.pendingPages > statsBefore.pendingPages;
+	EventFrameProcessed(std::max(0.0f, foliageTime - loadTime), evt.timeSinceLastFrame, pagesPending);
 
 	return true;
 }
 
-void Foliage::setDensity(float newDensity)
+void Foliage::setDensity(float newDensity, bool reload)
 {
 	for (FoliageStore::iterator I = mFoliages.begin(); I != mFoliages.end(); ++I) {
-		(*I)->setDensity(newDensity);
+		(*I)->setDensity(newDensity, reload);
 	}
 }
 
-void Foliage::setFarDistance(float newFarDistance)
+void Foliage::setFarDistance(float newFarDistance, bool reload)
 {
 	for (FoliageStore::iterator I = mFoliages.begin(); I != mFoliages.end(); ++I) {
-		(*I)->setFarDistance(newFarDistance);
+		(*I)->setFarDistance(newFarDistance, reload);
 	}
 }
 
@@ -28,6 +28,9 @@
 #include "framework/ConsoleObject.h"
 
 #include <OgreFrameListener.h>
+#include <OgreTimer.h>
+
+#include <sigc++/signal.h>
 
 namespace WFMath
 {
@@ -83,15 +86,26 @@ public:
 	 * @brief Sets the density of all foliage in a factor of default density.
 	 * eg. passing 0.1 will make all foliage density = (the default defined layer density) * 0.1;
 	 * @param newDensity the new density percentage in float, where 1 implies normal or full density and 0 implies no density or no foliage. 
+	 * @param reload If true all foliage is reloaded; otherwise the new density is only used by pages loaded from now on.
 	 */
-	void setDensity(float newDensity);
+	void setDensity(float newDensity, bool reload = true);
 	
 	/**
 	 * @brief Sets the max far distance of all foliage in a factor of default distance.
 	 * eg. passing 0.1 will make the furthest distance foliage appears at = default far distance * 0.1;
 	 * @param newFarDistance the new far distance percentage, where 1 implies normal or max far distance and 0 implies minimum far distance;
+	 * @param reload If true all foliage is reloaded; otherwise only pages which come into range are loaded. This must only be false if the distance isn't increased past the default far distance.
+	 */
+	void setFarDistance(float newFarDistance, bool reload = true);
+
+	/**
+	 * @brief Emitted each frame after all foliage has been updated.
+	 *
+	 * The first argument is the time in milliseconds spent updating the foliage this frame, not counting the time spent loading pages (which is limited by the page load budget).
+	 * The second argument is the time in seconds since the last frame.
+	 * The third argument is true if there are foliage pages waiting to be loaded, in which case the foliage isn't yet in a steady state.
 	 */
-	void setFarDistance(float newFarDistance);
+	sigc::signal<void, float, float, bool> EventFrameProcessed;
 
 
 protected:
@@ -100,6 +114,11 @@ protected:
 
 	FoliageStore mFoliages;
 
+	/**
+	 * @brief Used for measuring the time spent updating the foliage each frame.
+	 */
+	Ogre::Timer mTimer;
+
 
 	void createGrassMesh();
 	
@@ -103,18 +103,20 @@ public:
 	 * This affects the overall density of the foliage by a factor.
 	 * eg. passing 0.1 will make the foliage density = (the default defined layer density) * 0.1;
 	 * @param newDensity the new density factor in float, where 1 implies normal or full density and 0 implies no density.
+	 * @param reload If true all pages are reloaded; otherwise the new density is only used by pages loaded from now on.
 	 * @note Should be overriden in the deriving foliage layer to provide ability to set the far distance. 
 	 */
-	virtual void setDensity(float) { }
+	virtual void setDensity(float, bool) { }
 	
 	/**
 	 * @brief Sets the far distance factor of the foliage.
 	 * This affects the far distance of the foliage by a factor.
 	 * eg. passing 0.1 will make the furthest distance foliage appears at = default far distance * 0.1;
 	 * @param factor the new far distance factor, where 1 implies normal or max far distance and 0 implies minimum far distance;
+	 * @param reload If true all pages are reloaded; otherwise only pages which come into range are loaded. This must only be false if the distance isn't increased past the default far distance.
 	 * @note Should be overriden in the deriving foliage layer to provide ability to set the far distance. 
 	 */
-	virtual void setFarDistance(float) { };
+	virtual void setFarDistance(float, bool) { };
 
 protected:
 
@@ -24,6 +24,7 @@
 
 #include "services/config/ConfigListenerContainer.h"
 
+#include <algorithm>
 #include <cmath>
 
 namespace Ember
@@ -34,7 +35,7 @@ namespace Environment
 {
 
 FoliageDetailManager::FoliageDetailManager(Foliage& foliage, GraphicalChangeAdapter& graphicalChangeAdapter) :
-		mFoliage(foliage), mThresholdLevel(2.0f), mDefaultDensityStep(0.3f), mUpdatedDensity(1.0f), mDefaultDistanceStep(0.3f), mFarDistance(1.0f), mMaxFarDistance(2.0f), mMinFarDistance(0.3f), mGraphicalChangeAdapter(graphicalChangeAdapter), mConfigListenerContainer(new ConfigListenerContainer())
+		mFoliage(foliage), mThresholdLevel(2.0f), mDefaultDensityStep(0.3f), mUpdatedDensity(1.0f), mDefaultDistanceStep(0.3f), mFarDistance(1.0f), mMaxFarDistance(2.0f), mMinFarDistance(0.3f), mFrameBudget(0.0f), mSmoothedFrameTime(0.0f), mGovernorFactor(1.0f), mAppliedGovernorFactor(1.0f), mMinGovernorFactor(0.2f), mTimeSinceGovernorChange(0.0f), mGraphicalChangeAdapter(graphicalChangeAdapter), mConfigListenerContainer(new ConfigListenerContainer())
 {
 }
 
@@ -42,6 +43,7 @@ FoliageDetailManager::~FoliageDetailManager()
 {
 	delete mConfigListenerContainer;
 	mChangeRequiredConnection.disconnect();
+	mFrameProcessedConnection.disconnect();
 }
 
 void FoliageDetailManager::initialize()
@@ -49,6 +51,8 @@ void FoliageDetailManager::initialize()
 	mChangeRequiredConnection = mGraphicalChangeAdapter.EventChangeRequired.connect(sigc::mem_fun(*this, &FoliageDetailManager::changeLevel));
 	mConfigListenerContainer->registerConfigListener("graphics", "foliagedensity", sigc::mem_fun(*this, &FoliageDetailManager::Config_FoliageDensity));
 	mConfigListenerContainer->registerConfigListener("graphics", "foliagefardistance", sigc::mem_fun(*this, &FoliageDetailManager::Config_FoliageFarDistance));
+	mFrameProcessedConnection = mFoliage.EventFrameProcessed.connect(sigc::mem_fun(*this, &FoliageDetailManager::Foliage_FrameProcessed));
+	mConfigListenerContainer->registerConfigListener("graphics", "foliageframebudget", sigc::mem_fun(*this, &FoliageDetailManager::Config_FoliageFrameBudget));
 }
 
 bool FoliageDetailManager::changeLevel(float level)
@@ -73,11 +77,11 @@ bool FoliageDetailManager::stepDownFoliageDensity(float step)
 {
 	if (mUpdatedDensity > step) { //step down only if existing density is greater than step
 		mUpdatedDensity -= step;
-		mFoliage.setDensity(mUpdatedDensity);
+		applyDensity();
 		return true;
 	} else if (mUpdatedDensity < step && mUpdatedDensity > 0.0f) { //if there is still some positive density left which is smaller than step, set it to 0
 		mUpdatedDensity = 0.0f;
-		mFoliage.setDensity(mUpdatedDensity);
+		applyDensity();
 		return true;
 	} else { //step down not possible
 		return false;
@@ -88,11 +92,11 @@ bool FoliageDetailManager::stepUpFoliageDensity(float step)
 {
 	if (mUpdatedDensity + step <= 1.0f) { //step up only if the step doesn't cause density to go over default density
 		mUpdatedDensity += step;
-		mFoliage.setDensity(mUpdatedDensity);
+		applyDensity();
 		return true;
 	} else if (mUpdatedDensity < 1.0f) { //if the density is still below default density but a default step causes it to go over default density
 		mUpdatedDensity = 1.0f;
-		mFoliage.setDensity(mUpdatedDensity);
+		applyDensity();
 		return true;
 	} else {
 		return false; //step up not possible
@@ -103,11 +107,11 @@ bool FoliageDetailManager::stepDownFoliageDistance(float step)
 {
 	if (mFarDistance > step) { //step down only if existing far distance is greater than step
 		mFarDistance -= step;
-		mFoliage.setFarDistance(mFarDistance);
+		applyDistance();
 		return true;
 	} else if (mFarDistance < step && mFarDistance > mMinFarDistance) { //if there is still some positive far distance left which is smaller than step, set it to minimum far distance.
 		mFarDistance = mMinFarDistance;
-		mFoliage.setFarDistance(mFarDistance);
+		applyDistance();
 		return true;
 	} else { //step down not possible
 		return false;
@@ -118,11 +122,11 @@ bool FoliageDetailManager::stepUpFoliageDistance(float step)
 {
 	if (mFarDistance + step <= mMaxFarDistance) { //step up only if the step doesn't cause distance to go over max distance.
 		mFarDistance += step;
-		mFoliage.setFarDistance(mFarDistance);
+		applyDistance();
 		return true;
 	} else if (mFarDistance < mMaxFarDistance) { //if the far distance is still below max distance but a default step causes it to go over max distance.
 		mFarDistance = mMaxFarDistance;
-		mFoliage.setFarDistance(mFarDistance);
+		applyDistance();
 		return true;
 	} else {
 		return false; //step up not possible
@@ -138,7 +142,7 @@ bool FoliageDetailManager::setFoliageDistance(float distance)
 	} else {
 		mFarDistance = distance;
 	}
-	mFoliage.setFarDistance(mFarDistance);
+	applyDistance();
 	
 	unpause();
 	return true;
@@ -155,7 +159,7 @@ bool FoliageDetailManager::setFoliageDensity(float density)
 	} else {
 		mUpdatedDensity = density;
 	}
-	mFoliage.setDensity(mUpdatedDensity);
+	applyDensity();
 	
 	unpause();
 
@@ -178,14 +182,76 @@ void FoliageDetailManager::Config_FoliageFarDistance(const std::string&, const s
 	}
 }
 
+void FoliageDetailManager::Config_FoliageFrameBudget(const std::string&, const std::string&, varconf::Variable& variable)
+{
+	if (variable.is_double()) {
+		mFrameBudget = std::max(0.0f, static_cast<float>(static_cast<double>(variable)));
+		if (mFrameBudget == 0.0f && mAppliedGovernorFactor != 1.0f) {
+			//The governor has been disabled; restore the foliage to the unscaled values.
+			mGovernorFactor = 1.0f;
+			mAppliedGovernorFactor = 1.0f;
+			applyDensity(false);
+			applyDistance(false);
+		}
+	}
+}
+
+void FoliageDetailManager::Foliage_FrameProcessed(float foliageTime, float timeSinceLastFrame, bool pagesPending)
+{
+	if (mFrameBudget <= 0.0f) {
+		return;
+	}
+
+	//While pages are being loaded the foliage isn't in a steady state, and the measurements wouldn't reflect the current settings.
+	if (pagesPending) {
+		return;
+	}
+
+	//Smooth the measurements so that single spikes, such as when a batch of pages is loaded, don't cause any changes.
+	mSmoothedFrameTime += (foliageTime - mSmoothedFrameTime) * 0.1f;
+	mTimeSinceGovernorChange += timeSinceLastFrame;
+
+	//Scale down quickly when over budget, but only scale up slowly when well below it. In between nothing is changed, to avoid oscillation.
+	if (mSmoothedFrameTime > mFrameBudget) {
+		float overshoot = std::min(mSmoothedFrameTime / mFrameBudget - 1.0f, 1.0f);
+		mGovernorFactor = std::max(mMinGovernorFactor, mGovernorFactor - (0.1f + 0.4f * overshoot) * timeSinceLastFrame);
+	} else if (mSmoothedFrameTime < mFrameBudget * 0.6f) {
+		mGovernorFactor = std::min(1.0f, mGovernorFactor + 0.05f * timeSinceLastFrame);
+	}
+
+	//Changes only reach the foliage as pages are loaded, so only apply changes which are large enough (or which reach the limits), and not too often.
+	if (mGovernorFactor != mAppliedGovernorFactor && mTimeSinceGovernorChange > 2.0f) {
+		if (std::abs(mGovernorFactor - mAppliedGovernorFactor) >= 0.05f || mGovernorFactor == 1.0f || mGovernorFactor == mMinGovernorFactor) {
+			mAppliedGovernorFactor = mGovernorFactor;
+			mTimeSinceGovernorChange = 0.0f;
+			//Don't reload all foliage, which would be a visible jump; new pages get the new density, and the detail levels shrink or grow right away.
+			applyDensity(false);
+			applyDistance(false);
+		}
+	}
+}
+
+void FoliageDetailManager::applyDensity(bool reload)
+{
+	mFoliage.setDensity(mUpdatedDensity * mAppliedGovernorFactor, reload);
+}
+
+void FoliageDetailManager::applyDistance(bool reload)
+{
+	//The cost of foliage grows with the square of the distance, so the distance is scaled down less than the density.
+	mFoliage.setFarDistance(mFarDistance * (0.5f + 0.5f * mAppliedGovernorFactor), reload);
+}
+
 void FoliageDetailManager::pause()
 {
 	mChangeRequiredConnection.block();
+	mFrameProcessedConnection.block();
 }
 
 void FoliageDetailManager::unpause()
 {
 	mChangeRequiredConnection.unblock();
+	mFrameProcessedConnection.unblock();
 }
 
 }
@@ -41,6 +41,12 @@ class Foliage;
 /**
  * @brief This class manages the detail level of foliage by responding to the changeRequired signal from IGraphicalManager.
  * Acts as a sub-component of the automatic handling of graphics system.
+ *
+ * In addition it acts as a governor, which measures the time spent updating the foliage each frame and keeps it within a configurable budget ("graphics:foliageframebudget").
+ * Time spent loading pages isn't counted, since that's limited separately by the page load budget, and nothing is measured while pages are waiting to be loaded.
+ * The governor continuously scales the density and far distance of the foliage, on top of the values set through the config or the graphical change adapter.
+ * Its changes don't reload the foliage: the density is used by pages as they're loaded, and the ranges of the detail levels change right away.
+ * Changes are only applied when the measured time is well outside of the budget and at most once every couple of seconds.
  */
 class FoliageDetailManager
 {
@@ -138,6 +144,31 @@ protected:
 	 */
 	void Config_FoliageFarDistance(const std::string& section, const std::string& key, varconf::Variable& variable);
 
+	/**
+	 * @brief Connected to the config service to listen for the foliage frame time budget.
+	 */
+	void Config_FoliageFrameBudget(const std::string& section, const std::string& key, varconf::Variable& variable);
+
+	/**
+	 * @brief Called each frame after the foliage has been updated; adjusts the governor factor.
+	 * @param foliageTime The time in milliseconds spent updating the foliage this frame, not counting page loads.
+	 * @param timeSinceLastFrame The time in seconds since the last frame.
+	 * @param pagesPending True if there are foliage pages waiting to be loaded.
+	 */
+	void Foliage_FrameProcessed(float foliageTime, float timeSinceLastFrame, bool pagesPending);
+
+	/**
+	 * @brief Applies the current density, scaled by the governor factor, to the foliage.
+	 * @param reload If true all foliage is reloaded.
+	 */
+	void applyDensity(bool reload = true);
+
+	/**
+	 * @brief Applies the current far distance, scaled by the governor factor, to the foliage.
+	 * @param reload If true all foliage is reloaded.
+	 */
+	void applyDistance(bool reload = true);
+
 	/**
 	 * @brief The main foliage instance.
 	 */
@@ -178,6 +209,41 @@ protected:
 	 */
 	float mMinFarDistance;
 
+	/**
+	 * The time in milliseconds which the foliage is allowed to use each frame. A value of 0 disables the governor.
+	 */
+	float mFrameBudget;
+
+	/**
+	 * The exponentially smoothed time in milliseconds spent updating the foliage each frame.
+	 */
+	float mSmoothedFrameTime;
+
+	/**
+	 * The factor, between mMinGovernorFactor and 1, by which the governor currently wants to scale density and far distance.
+	 */
+	float mGovernorFactor;
+
+	/**
+	 * The governor factor which was last applied to the foliage.
+	 */
+	float mAppliedGovernorFactor;
+
+	/**
+	 * The lowest factor the governor will scale the foliage down to.
+	 */
+	float mMinGovernorFactor;
+
+	/**
+	 * Seconds elapsed since the governor last applied a change.
+	 */
+	float mTimeSinceGovernorChange;
+
+	/**
+	 * Connection to the Foliage::EventFrameProcessed signal, used by the governor.
+	 */
+	sigc::connection mFrameProcessedConnection;
+
 	/**
 	 * Holds the reference to the connection to the changeRequired signal. Used to disconnect the signal on destruction of this class or to pause the functioning of this component.
 	 */
@@ -29,6 +29,9 @@
 #include "ExclusiveImposterPage.h"
 
 #include "framework/LoggingInstance.h"
+#include "framework/osdir.h"
+#include "framework/tasks/TaskQueue.h"
+#include "services/EmberServices.h"
 #include "services/config/ConfigService.h"
 #include "pagedgeometry/include/PagedGeometry.h"
 #include "pagedgeometry/include/TreeLoader3D.h"
@@ -36,6 +39,7 @@
 #include "pagedgeometry/include/DummyPage.h"
 #include "pagedgeometry/include/PassiveEntityPage.h"
 #include "pagedgeometry/include/BatchedGeometry.h"
+#include "pagedgeometry/include/ImpostorPage.h"
 
 #include "../Convert.h"
 #include "../Scene.h"
@@ -56,11 +60,12 @@ namespace OgreView
 namespace Environment
 {
 
-Forest::Forest(Terrain::TerrainManager& terrainManager) :
-	mTerrainManager(terrainManager), mTrees(0), mTreeLoader(0), mEntityLoader(0), mMaxRange(500)
+Forest::Forest(Terrain::TerrainManager& terrainManager, Eris::EventService& eventService) :
+	mTerrainManager(terrainManager), mTrees(0), mTreeLoader(0), mEntityLoader(0), mImpostorCacheQueue(new Tasks::TaskQueue(1, eventService)), mMaxRange(500)
 {
 	Ogre::Root::getSingleton().addFrameListener(this);
 	mTerrainManager.getHandler().EventWorldSizeChanged.connect(sigc::mem_fun(*this, &Forest::worldSizeChanged));
+	registerConfigListenerWithDefaults("graphics", "pageloadbudget", sigc::mem_fun(*this, &Forest::Config_PageLoadBudget), 4.0);
 }
 
 Forest::~Forest()
@@ -68,6 +73,8 @@ Forest::~Forest()
 	delete mEntityLoader;
 	delete mTreeLoader;
 	delete mTrees;
+	//The queue is destroyed after this, which will finish all pending writes.
+	Forests::ImpostorPage::setImpostorCacheDirectory("", nullptr);
 	Ogre::Root::getSingleton().removeFrameListener(this);
 }
 
@@ -80,6 +87,18 @@ void Forest::initialize()
 	mTrees->setPageSize(64); //Set the size of each page of geometry
 
 	mTrees->setInfinite();
+
+	//Keep rendered impostors between sessions, so that they don't need to be rendered again each time.
+	const std::string impostorCacheDir = EmberServices::getSingleton().getConfigService().getHomeDirectory(BaseDirType_CACHE) + "impostors/";
+	try {
+		oslink::directory osdir(impostorCacheDir);
+		if (!osdir.isExisting()) {
+			oslink::directory::mkdir(impostorCacheDir.c_str());
+		}
+		Forests::ImpostorPage::setImpostorCacheDirectory(impostorCacheDir, mImpostorCacheQueue.get());
+	} catch (const std::exception& ex) {
+		S_LOG_WARNING("Could not create directory for impostor cache; impostors will be rendered each session." << ex);
+	}
 	// 	mTrees->addDetailLevel<Forests::BatchPage>(150, 50);		//Use batches up to 150 units away, and fade for 30 more units
 	//  mTrees->addDetailLevel<Forests::DummyPage>(100, 0);		//Use batches up to 150 units away, and fade for 30 more units
 	mTrees->addDetailLevel<Forests::PassiveEntityPage> (150, 0); //Use standard entities up to 150 units away, and don't fade since the PassiveEntityPage doesn't support this (yet)
@@ -145,6 +164,15 @@ void Forest::worldSizeChanged()
 	}
 }
 
+void Forest::Config_PageLoadBudget(const std::string&, const std::string&, varconf::Variable& variable)
+{
+	if (variable.is_double()) {
+		//The budget is shared by all paged geometry, i.e. both the forest and the foliage.
+		double milliseconds = static_cast<double>(variable);
+		Forests::PageLoadBudget::setBudget(milliseconds > 0 ? static_cast<unsigned long>(milliseconds * 1000) : 0);
+	}
+}
+
 
 }
 
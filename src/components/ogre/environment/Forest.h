@@ -23,9 +23,12 @@
 #ifndef EMBEROGRE_ENVIRONMENTFOREST_H
 #define EMBEROGRE_ENVIRONMENTFOREST_H
 
+#include "services/config/ConfigListenerContainer.h"
+
 #include <OgreMath.h>
 #include <OgreFrameListener.h>
 #include <sigc++/trackable.h>
+#include <memory>
 
 namespace Forests {
 class PagedGeometry;
@@ -37,8 +40,15 @@ namespace Ogre
 	class Entity;
 	class Vector3;
 }
+namespace Eris {
+class EventService;
+}
+
 namespace Ember {
 class EmberEntity;
+namespace Tasks {
+class TaskQueue;
+}
 namespace OgreView {
 
 namespace Terrain
@@ -57,10 +67,10 @@ class EmberEntityLoader;
 /**
 	@author Erik Hjortsberg <erik.hjortsberg@gmail.com>
 */
-class Forest : public Ogre::FrameListener, public virtual sigc::trackable
+class Forest : public Ogre::FrameListener, public ConfigListenerContainer, public virtual sigc::trackable
 {
 public:
-    Forest(Terrain::TerrainManager& terrainManager);
+    Forest(Terrain::TerrainManager& terrainManager, Eris::EventService& eventService);
 
     virtual ~Forest();
 
@@ -81,6 +91,11 @@ protected:
 	Forests::TreeLoader3D *mTreeLoader;
 	EmberEntityLoader* mEntityLoader;
 
+	/**
+	 * @brief Encodes and writes rendered impostors to the impostor cache.
+	 */
+	std::unique_ptr<Tasks::TaskQueue> mImpostorCacheQueue;
+
 	/**
 	 * @brief The max range for entities to be rendered in the forest.
 	 */
@@ -91,6 +106,11 @@ protected:
 	 */
 	void worldSizeChanged();
 
+	/**
+	 * @brief Connected to the config service to listen for the per-frame page load budget of all paged geometry.
+	 */
+	void Config_PageLoadBudget(const std::string& section, const std::string& key, varconf::Variable& variable);
+
 };
 
 }
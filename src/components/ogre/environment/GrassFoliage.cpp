@@ -178,13 +178,15 @@ void GrassFoliage::frameStarted()
 	}
 }
 
-void GrassFoliage::setDensity(float newGrassDensity)
+void GrassFoliage::setDensity(float newGrassDensity, bool reload)
 {
 	mGrassLoader->setDensityFactor(newGrassDensity);
-	mPagedGeometry->reloadGeometry();
+	if (reload) {
+		mPagedGeometry->reloadGeometry();
+	}
 }
 
-void GrassFoliage::setFarDistance(float factor)
+void GrassFoliage::setFarDistance(float factor, bool reload)
 {
 	std::list<Forests::GeometryPageManager*> detailLevels = mPagedGeometry->getDetailLevels();
 
@@ -195,7 +197,9 @@ void GrassFoliage::setFarDistance(float factor)
 		(*I)->setTransition(factor * J->transition);
 		++J;
 	}
-	mPagedGeometry->reloadGeometry();
+	if (reload) {
+		mPagedGeometry->reloadGeometry();
+	}
 }
 
 }
@@ -57,8 +57,8 @@ public:
 	
 	virtual void initialize();
 	virtual void frameStarted();
-	virtual void setDensity(float newGrassDensity);
-	virtual void setFarDistance(float factor);
+	virtual void setDensity(float newGrassDensity, bool reload);
+	virtual void setFarDistance(float factor, bool reload);
 
 protected:
 	
@@ -93,13 +93,15 @@ void ShrubberyFoliage::frameStarted()
 	}
 }
 
-void ShrubberyFoliage::setDensity(float newGrassDensity)
+void ShrubberyFoliage::setDensity(float newGrassDensity, bool reload)
 {
 	mLoader->setDensityFactor(newGrassDensity);
-	mPagedGeometry->reloadGeometry();
+	if (reload) {
+		mPagedGeometry->reloadGeometry();
+	}
 }
 
-void ShrubberyFoliage::setFarDistance(float factor)
+void ShrubberyFoliage::setFarDistance(float factor, bool reload)
 {
 	std::list<Forests::GeometryPageManager*> detailLevels = mPagedGeometry->getDetailLevels();
 
@@ -110,7 +112,9 @@ void ShrubberyFoliage::setFarDistance(float factor)
 		(*I)->setTransition(factor * J->transition);
 		++J;
 	}
-	mPagedGeometry->reloadGeometry();
+	if (reload) {
+		mPagedGeometry->reloadGeometry();
+	}
 }
 
 }
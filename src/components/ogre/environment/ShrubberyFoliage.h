@@ -58,9 +58,9 @@ public:
 	
 	virtual void initialize();
 	
-	virtual void setDensity(float newGrassDensity);
+	virtual void setDensity(float newGrassDensity, bool reload);
 	
-	virtual void setFarDistance(float factor);
+	virtual void setFarDistance(float factor, bool reload);
 
 protected:
 	FoliageLoader* mLoader;
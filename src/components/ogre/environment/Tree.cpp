@@ -30,67 +30,347 @@
 #include "../OgreIncludes.h"
 #include "Tree.h"
 
+#include "framework/tasks/TaskQueue.h"
+#include "framework/tasks/ITask.h"
+#include "framework/LoggingInstance.h"
+
+#include <OgreMeshManager.h>
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
 namespace Ember {
 namespace OgreView {
 
 namespace Environment {
 
-using namespace Ogre;
+namespace
+{
+const char CACHE_MAGIC[4] = { 'E', 'T', 'R', 'E' };
+
+/**
+ * @brief Increase this whenever the tree generator changes, so that trees grown by earlier versions aren't used.
+ */
+const uint32_t CACHE_VERSION = 2;
+
+const std::string RESOURCE_GROUP("General");
+const std::string BARK_MATERIAL("BarkTextMat");
+const std::string LEAF_MATERIAL("LeafTextMat");
+const std::string COORD_FRAME_MATERIAL("CoordFrameMat");
+
+//All trees are grown with a fixed seed, so that they always look the same and can be cached.
+const unsigned char TREE_SEASON = 0;
+const int TREE_SEED = 0;
+
+/**
+ * @brief Guards against corrupt cache files.
+ */
+const uint32_t MAX_CACHE_ELEMENTS = 0x1000000;
+
+template <typename T>
+void writeArray(std::ostream& stream, const std::vector<T>& values)
+{
+	uint32_t size = static_cast<uint32_t>(values.size());
+	stream.write(reinterpret_cast<const char*>(&size), sizeof(size));
+	if (size) {
+		stream.write(reinterpret_cast<const char*>(&values[0]), size * sizeof(T));
+	}
+}
+
+template <typename T>
+bool readArray(std::istream& stream, std::vector<T>& values)
+{
+	uint32_t size = 0;
+	stream.read(reinterpret_cast<char*>(&size), sizeof(size));
+	if (!stream || size > MAX_CACHE_ELEMENTS) {
+		return false;
+	}
+	values.resize(size);
+	if (size) {
+		stream.read(reinterpret_cast<char*>(&values[0]), size * sizeof(T));
+	}
+	return static_cast<bool>(stream);
+}
+
+void writeIndexes(std::ostream& stream, const std::vector<unsigned long>& indexes)
+{
+	//unsigned long differs in size between platforms, so the indexes are stored as 32 bit values.
+	writeArray(stream, std::vector<uint32_t>(indexes.begin(), indexes.end()));
+}
+
+bool readIndexes(std::istream& stream, std::vector<unsigned long>& indexes, size_t vertexCount)
+{
+	std::vector<uint32_t> values;
+	if (!readArray(stream, values)) {
+		return false;
+	}
+	for (uint32_t value : values) {
+		if (value >= vertexCount) {
+			return false;
+		}
+	}
+	indexes.assign(values.begin(), values.end());
+	return true;
+}
+}
 
-Tree::Tree()
+/**
+ * @brief Reads a tree from the cache, or grows it, in a background thread.
+ */
+class Tree::GrowTask: public Tasks::ITask
 {
-/*        Material *pBarkMat = (Material*)MaterialManager::getSingleton().create( "BarkTextMat" );
-        pBarkMat->getTechnique(0)->getPass(0)->createTextureUnitState( "tree_bark.jpg" );
-	Material *pLeafMat = (Material*)MaterialManager::getSingleton().create( "LeafTextMat" );
+public:
+	GrowTask(Tree& tree, const std::string& meshName, Ogre::TParameters::TreeType type, const std::string& cachePath) :
+			mTree(tree), mMeshName(meshName), mType(type), mCachePath(cachePath)
+	{
+	}
+
+	virtual void executeTaskInBackgroundThread(Tasks::TaskExecutionContext& context)
+	{
+		std::shared_ptr<Ogre::TGeometry> geometry(new Ogre::TGeometry());
+		if (Tree::readCache(mCachePath, *geometry)) {
+			mGeometry = geometry;
+			return;
+		}
+		try {
+			Ogre::TParameters parameters(2);
+			parameters.Set(mType);
+			Ogre::Tree tree(mMeshName, &parameters, TREE_SEASON, TREE_SEED);
+			tree.Grow();
+			tree.CreateGeometry(*geometry);
+			mGeometry = geometry;
+		} catch (const std::exception& ex) {
+			S_LOG_FAILURE("Could not grow tree '" << mMeshName << "'." << ex);
+			return;
+		}
+		Tree::writeCache(mCachePath, *geometry);
+	}
+
+	virtual void executeTaskInMainThread()
+	{
+		mTree.treeGrown(mMeshName, mGeometry);
+	}
+
+	virtual std::string getName() const
+	{
+		return "GrowTask";
+	}
 
-	pLeafMat->getTechnique(0)->getPass(0)->createTextureUnitState( "tree_leaves_pack1.tga" );
-	pLeafMat->getTechnique(0)->getPass(0)->setSceneBlending(SBT_TRANSPARENT_ALPHA);
-	pLeafMat->getTechnique(0)->getPass(0)->setCullingMode(Ogre::CULL_NONE);
-	pLeafMat->getTechnique(0)->getPass(0)->setManualCullingMode(Ogre::MANUAL_CULL_NONE);
-        pLeafMat->getTechnique(0)->getPass(0)->setLightingEnabled(true);
-        pLeafMat->getTechnique(0)->getPass(0)->setDiffuse(0.9f, 1.0f, 0.9f, 1.0f);   // alpha not working with DX9 !!!!!!!
-        pLeafMat->getTechnique(0)->getPass(0)->setAmbient(0.5f, 0.6f, 0.5f);
+private:
+	Tree& mTree;
+	const std::string mMeshName;
+	const Ogre::TParameters::TreeType mType;
+	const std::string mCachePath;
+	std::shared_ptr<const Ogre::TGeometry> mGeometry;
+};
 
-        Material *pCoordFrameMat = (Material*)MaterialManager::getSingleton().create( "CoordFrameMat" );
-        pCoordFrameMat->getTechnique(0)->getPass(0)->setSceneBlending(SBT_TRANSPARENT_ALPHA);
-        pCoordFrameMat->getTechnique(0)->getPass(0)->setLightingEnabled(false);*/
+Tree::Tree(Eris::EventService& eventService, const std::string& cacheDirectory) :
+		mTaskQueue(new Tasks::TaskQueue(1, eventService)), mCacheDirectory(cacheDirectory)
+{
 }
 
 
 Tree::~Tree()
 {
+	//Make sure that no tasks refer to this instance before the meshes are removed.
+	mTaskQueue.reset();
+	for (auto& entry : mMeshes) {
+		Ogre::MeshManager::getSingleton().remove(entry.first);
+	}
 }
 
 
-void Tree::makeMesh(Ogre::String meshName, Ogre::TParameters::TreeType type)
+void Tree::makeMesh(const std::string& meshName, Ogre::TParameters::TreeType type)
 {
-        //pCoordFrameMat->getTechnique(0)->getPass(0)->setShadingMode();
+	if (mMeshes.count(meshName)) {
+		return;
+	}
+	TreeMesh& treeMesh = mMeshes[meshName];
+	treeMesh.placeholder = createPlaceholder(type);
+	Ogre::MeshManager::getSingleton().createManual(meshName, RESOURCE_GROUP, this);
 
+	if (!mTaskQueue->enqueueTask(new GrowTask(*this, meshName, type, getCachePath(type, TREE_SEASON, TREE_SEED)))) {
+		S_LOG_WARNING("Could not queue growing of tree '" << meshName << "'; the placeholder will be used.");
+	}
+}
 
-        // Attach the entity to the root of the scene
+void Tree::loadResource(Ogre::Resource* resource)
+{
+	Ogre::Mesh* mesh = static_cast<Ogre::Mesh*>(resource);
+	auto I = mMeshes.find(mesh->getName());
+	if (I == mMeshes.end()) {
+		return;
+	}
+	if (I->second.geometry) {
+		Ogre::Tree::FillMesh(mesh, *I->second.geometry, BARK_MATERIAL, LEAF_MATERIAL, COORD_FRAME_MATERIAL);
+	} else {
+		Ogre::Tree::FillMesh(mesh, *I->second.placeholder, BARK_MATERIAL, LEAF_MATERIAL, COORD_FRAME_MATERIAL);
+	}
+}
 
+void Tree::treeGrown(const std::string& meshName, std::shared_ptr<const Ogre::TGeometry> geometry)
+{
+	auto I = mMeshes.find(meshName);
+	if (I == mMeshes.end()) {
+		return;
+	}
+	if (!geometry) {
+		S_LOG_WARNING("Tree '" << meshName << "' could not be grown; the placeholder will be used.");
+		return;
+	}
+	I->second.geometry = geometry;
+	I->second.placeholder.reset();
+	S_LOG_VERBOSE("Tree '" << meshName << "' is ready, with " << geometry->mColors.size() << " vertices.");
 
-//        uchar u8Levels = 2;
-//	TParameters* pParams = new TParameters(u8Levels);
-//	pParams->Set( type );
-//
-//	uchar u8Season = 0;
-//	int iSeed = 0;
-//
-//	Ogre::Tree* pTree = new Ogre::Tree("TreeTest", pParams, u8Season, iSeed);
-//	pTree->Grow();
-//	MeshPtr pTreeMesh = pTree->CreateMesh(meshName);
-//	pTreeMesh->getSubMesh(0)->setMaterialName("BarkTextMat");
-//        if (pTree->GetParameters()->GetLeaves() > 0)
-//        {
-//	  		pTreeMesh->getSubMesh(1)->setMaterialName("LeafTextMat");
-//          if (pTree->GetParameters()->GetTreeType() == TParameters::Simple)
-//            pTreeMesh->getSubMesh(2)->setMaterialName("CoordFrameMat");
-//        }
-//        else if (pTree->GetParameters()->GetTreeType() == TParameters::Simple)
-//          pTreeMesh->getSubMesh(1)->setMaterialName("CoordFrameMat");
+	//Entities notice that the mesh has been reloaded and recreate their sub entities.
+	Ogre::MeshPtr mesh = Ogre::MeshManager::getSingleton().getByName(meshName, RESOURCE_GROUP);
+	if (!mesh.isNull() && mesh->isLoaded()) {
+		mesh->reload();
+	}
+}
+
+std::string Tree::getCachePath(Ogre::TParameters::TreeType type, unsigned char season, int seed) const
+{
+	if (mCacheDirectory.empty()) {
+		return "";
+	}
+
+	//FNV-1a hash of the parameters.
+	uint64_t hash = 14695981039346656037ULL;
+	auto hashValue = [&hash](uint32_t value) {
+		for (int i = 0; i < 4; ++i) {
+			hash ^= (value >> (i * 8)) & 0xFF;
+			hash *= 1099511628211ULL;
+		}
+	};
+	hashValue(CACHE_VERSION);
+	hashValue(static_cast<uint32_t>(type));
+	hashValue(season);
+	hashValue(static_cast<uint32_t>(seed));
+
+	std::stringstream ss;
+	ss << mCacheDirectory << "tree-" << std::hex << std::setw(16) << std::setfill('0') << hash << ".cache";
+	return ss.str();
+}
+
+std::shared_ptr<Ogre::TGeometry> Tree::createPlaceholder(Ogre::TParameters::TreeType type)
+{
+	Ogre::TParameters parameters(2);
+	parameters.Set(type);
+	float height = parameters.GetScale() * parameters.GetnLength(0);
+	if (!std::isfinite(height) || height <= 0) {
+		height = 5.0f;
+	}
+	float width = height * 0.3f;
+	float radius = std::max(0.1f, height * 0.02f);
+
+	//A simple six sided trunk, tapering towards the top.
+	const int sides = 6;
+	std::shared_ptr<Ogre::TGeometry> geometry(new Ogre::TGeometry());
+	for (int ring = 0; ring < 2; ++ring) {
+		float ringRadius = ring ? radius * 0.3f : radius;
+		for (int i = 0; i < sides; ++i) {
+			float angle = Ogre::Math::TWO_PI * i / sides;
+			float x = std::cos(angle);
+			float z = std::sin(angle);
+			float vertex[8] = { x * ringRadius, ring * height, z * ringRadius, x, 0, z, static_cast<float>(i) / sides, static_cast<float>(ring) };
+			geometry->mVertices.insert(geometry->mVertices.end(), vertex, vertex + 8);
+			geometry->mColors.push_back(0xFFFFFFFF);
+		}
+	}
+	for (int i = 0; i < sides; ++i) {
+		unsigned long current = i;
+		unsigned long next = (i + 1) % sides;
+		unsigned long indexes[6] = { current, next + sides, next, current, current + sides, next + sides };
+		geometry->mStemIndexes.insert(geometry->mStemIndexes.end(), indexes, indexes + 6);
+	}
+
+	//Use the bounds of a grown tree, so that the placeholder is culled and sorted as the real tree would be.
+	geometry->mBounds = Ogre::AxisAlignedBox(-width, 0, -width, width, height, width);
+	geometry->mfBoundingRadius = geometry->mBounds.getHalfSize().length();
+	return geometry;
+}
 
+bool Tree::readCache(const std::string& path, Ogre::TGeometry& geometry)
+{
+	if (path.empty()) {
+		return false;
+	}
+	std::ifstream stream(path.c_str(), std::ios::binary);
+	if (!stream) {
+		return false;
+	}
+
+	char magic[4];
+	uint32_t version = 0;
+	uint32_t realSize = 0;
+	stream.read(magic, 4);
+	stream.read(reinterpret_cast<char*>(&version), sizeof(version));
+	stream.read(reinterpret_cast<char*>(&realSize), sizeof(realSize));
+	if (!stream || memcmp(magic, CACHE_MAGIC, 4) != 0 || version != CACHE_VERSION || realSize != sizeof(Ogre::Real)) {
+		return false;
+	}
+
+	Ogre::Real bounds[7];
+	stream.read(reinterpret_cast<char*>(bounds), sizeof(bounds));
+	if (!readArray(stream, geometry.mVertices) || !readArray(stream, geometry.mColors) || geometry.mVertices.size() != geometry.mColors.size() * 8) {
+		S_LOG_WARNING("Tree cache file '" << path << "' is corrupt.");
+		return false;
+	}
+	size_t vertexCount = geometry.mColors.size();
+	if (!readIndexes(stream, geometry.mStemIndexes, vertexCount) || !readIndexes(stream, geometry.mLeavesIndexes, vertexCount) || !readIndexes(stream, geometry.mCoordFrameIndexes, vertexCount)) {
+		S_LOG_WARNING("Tree cache file '" << path << "' is corrupt.");
+		return false;
+	}
+	geometry.mBounds = Ogre::AxisAlignedBox(bounds[0], bounds[1], bounds[2], bounds[3], bounds[4], bounds[5]);
+	geometry.mfBoundingRadius = bounds[6];
+	return true;
+}
+
+void Tree::writeCache(const std::string& path, const Ogre::TGeometry& geometry)
+{
+	if (path.empty()) {
+		return;
+	}
 
+	//Write to a temporary file first, so that an interrupted write never leaves a corrupt cache file.
+	std::string tempPath = path + ".tmp";
+	{
+		std::ofstream stream(tempPath.c_str(), std::ios::binary | std::ios::trunc);
+		if (!stream) {
+			S_LOG_WARNING("Could not write tree cache file to " << tempPath << ".");
+			return;
+		}
+		uint32_t realSize = sizeof(Ogre::Real);
+		const Ogre::Vector3& minimum = geometry.mBounds.getMinimum();
+		const Ogre::Vector3& maximum = geometry.mBounds.getMaximum();
+		Ogre::Real bounds[7] = { minimum.x, minimum.y, minimum.z, maximum.x, maximum.y, maximum.z, geometry.mfBoundingRadius };
+		stream.write(CACHE_MAGIC, 4);
+		stream.write(reinterpret_cast<const char*>(&CACHE_VERSION), sizeof(CACHE_VERSION));
+		stream.write(reinterpret_cast<const char*>(&realSize), sizeof(realSize));
+		stream.write(reinterpret_cast<const char*>(bounds), sizeof(bounds));
+		writeArray(stream, geometry.mVertices);
+		writeArray(stream, geometry.mColors);
+		writeIndexes(stream, geometry.mStemIndexes);
+		writeIndexes(stream, geometry.mLeavesIndexes);
+		writeIndexes(stream, geometry.mCoordFrameIndexes);
+		if (!stream) {
+			stream.close();
+			std::remove(tempPath.c_str());
+			S_LOG_WARNING("Could not write tree cache file to " << tempPath << ".");
+			return;
+		}
+	}
+	std::remove(path.c_str());
+	if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+		std::remove(tempPath.c_str());
+	}
 }
 
 }
@@ -23,23 +23,142 @@
 #ifndef TREE_H
 #define TREE_H
 
-/**
-@author Erik Hjortsberg
-*/
+#include "meshtree/TParameters.h"
+
+#include <OgreResource.h>
+
+#include <map>
+#include <memory>
+#include <string>
+
+namespace Eris
+{
+class EventService;
+}
+
+namespace Ogre
+{
+struct TGeometry;
+}
+
 namespace Ember {
+namespace Tasks
+{
+class TaskQueue;
+}
 namespace OgreView {
 
 namespace Environment {
 
-class TreeType;
-class Tree{
+/**
+ * @brief Generates tree meshes procedurally, in background threads.
+ *
+ * Growing a tree recurses through thousands of stems and leaves, which takes far too long to do in the main thread.
+ * Each mesh is instead created right away as a manual mesh, for which this instance acts as loader. Until the tree has
+ * been grown the mesh is filled with a simple placeholder of the same size. Once the geometry is ready the mesh is
+ * reloaded, which makes any entities using it pick up the real tree.
+ *
+ * Grown trees are written to the cache directory, keyed by the parameters used when growing them, so that they only
+ * need to be grown once.
+ *
+ * @author Erik Hjortsberg
+ */
+class Tree : public Ogre::ManualResourceLoader
+{
 public:
-    Tree();
 
-    ~Tree();
-	
-	void makeMesh(Ogre::String meshName, Ogre::TParameters::TreeType type);
+	/**
+	 * @brief Ctor.
+	 * @param eventService Used for handing over grown trees to the main thread.
+	 * @param cacheDirectory The directory in which grown trees are cached.
+	 */
+	Tree(Eris::EventService& eventService, const std::string& cacheDirectory);
+
+	/**
+	 * @brief Dtor.
+	 *
+	 * Waits for any trees being grown, and removes all meshes created by this instance.
+	 */
+	virtual ~Tree();
+
+	/**
+	 * @brief Creates a mesh with a tree, which is grown in the background.
+	 *
+	 * The mesh can be used right away; it will contain a placeholder until the tree is ready.
+	 * @param meshName The name of the mesh.
+	 * @param type The type of tree.
+	 */
+	void makeMesh(const std::string& meshName, Ogre::TParameters::TreeType type);
+
+	/**
+	 * @brief Fills a mesh created by makeMesh with either the grown tree or the placeholder.
+	 * @param resource The mesh.
+	 */
+	virtual void loadResource(Ogre::Resource* resource);
+
+private:
+
+	class GrowTask;
+
+	/**
+	 * @brief A mesh created by this instance.
+	 */
+	struct TreeMesh
+	{
+		/**
+		 * @brief The grown tree, or null if it's not ready yet.
+		 */
+		std::shared_ptr<const Ogre::TGeometry> geometry;
+
+		/**
+		 * @brief Shown until the tree is ready.
+		 */
+		std::shared_ptr<const Ogre::TGeometry> placeholder;
+	};
+
+	std::unique_ptr<Tasks::TaskQueue> mTaskQueue;
+
+	const std::string mCacheDirectory;
+
+	std::map<std::string, TreeMesh> mMeshes;
+
+	/**
+	 * @brief Called in the main thread when a tree has been grown, or read from the cache.
+	 * @param meshName The name of the mesh.
+	 * @param geometry The geometry of the tree, or null if it couldn't be grown.
+	 */
+	void treeGrown(const std::string& meshName, std::shared_ptr<const Ogre::TGeometry> geometry);
+
+	/**
+	 * @brief Gets the path of the cache file for a tree.
+	 * @param type The type of tree.
+	 * @param season The season.
+	 * @param seed The seed of the random generator.
+	 * @return A path within the cache directory.
+	 */
+	std::string getCachePath(Ogre::TParameters::TreeType type, unsigned char season, int seed) const;
+
+	/**
+	 * @brief Creates a placeholder the size of a grown tree of the supplied type.
+	 * @param type The type of tree.
+	 * @return A placeholder geometry.
+	 */
+	static std::shared_ptr<Ogre::TGeometry> createPlaceholder(Ogre::TParameters::TreeType type);
+
+	/**
+	 * @brief Reads a grown tree from the cache.
+	 * @param path The path of the cache file.
+	 * @param geometry The geometry to fill.
+	 * @return True if the file existed and was valid.
+	 */
+	static bool readCache(const std::string& path, Ogre::TGeometry& geometry);
 
+	/**
+	 * @brief Writes a grown tree to the cache.
+	 * @param path The path of the cache file.
+	 * @param geometry The geometry of the tree.
+	 */
+	static void writeCache(const std::string& path, const Ogre::TGeometry& geometry);
 };
 
 }
@@ -24,13 +24,14 @@ namespace Ogre {
 
 Tree::Tree(const String& name, TParameters *pParameters, uchar u8Season,  int iSeed)
 {
+  // Each tree has a generator of its own, since trees are grown in background threads
   if (iSeed == -1)
   {
-    srand(time(0));  
+    mRandom.seed(static_cast<std::minstd_rand::result_type>(time(0)));
   }
   else
   {
-    srand(iSeed);
+    mRandom.seed(static_cast<std::minstd_rand::result_type>(iSeed));
   }
     
   mpParameters = pParameters->Clone();
@@ -83,10 +84,10 @@ Real Tree::GetRandomValue(const Real fUpperBound)
   }
   else
   {
-    if (rand()%2 == 1)
+    if (mRandom()%2 == 1)
       iSign = -1;
     
-    return  iSign*(rand()%iPrecision) * fUpperBound / iPrecision;
+    return  iSign*static_cast<int>(mRandom()%iPrecision) * fUpperBound / iPrecision;
   }
 }
 
@@ -94,142 +95,148 @@ Real Tree::GetRandomValue(const Real fUpperBound)
 
 Ogre::MeshPtr Tree::CreateMesh(const String &name) 
 { 
+   TGeometry geometry;
+   CreateGeometry(geometry);
+
 	//HACK: implement ManualResourceLoader
    Ogre::MeshPtr pMesh = MeshManager::getSingleton().createManual(name,"trees"); 
-   SubMesh *pStemsSub, *pLeavesSub, *pCoordFrameSub;
-
-   // Set up vertex data 
-   // Use a single shared buffer 
-   pMesh->sharedVertexData = new VertexData(); 
-   VertexData* vertexData = pMesh->sharedVertexData; 
-   // Set up Vertex Declaration 
-   VertexDeclaration* vertexDecl = vertexData->vertexDeclaration; 
-   size_t currOffset = 0; 
-   // We always need positions 
-   vertexDecl->addElement(POSITION_BINDING, currOffset, VET_FLOAT3, VES_POSITION); 
-   currOffset += VertexElement::getTypeSize(VET_FLOAT3); 
-
-   // normals 
-   vertexDecl->addElement(POSITION_BINDING, currOffset, VET_FLOAT3, VES_NORMAL); 
-   currOffset += VertexElement::getTypeSize(VET_FLOAT3); 
-
-   // 2D texture coords 
-   vertexDecl->addElement(POSITION_BINDING, currOffset, VET_FLOAT2, VES_TEXTURE_COORDINATES, 0); 
-   currOffset += VertexElement::getTypeSize(VET_FLOAT2); 
+   FillMesh(pMesh.get(), geometry, StringUtil::BLANK, StringUtil::BLANK, StringUtil::BLANK);
 
-   // vertex color
-   vertexDecl->addElement(COLOUR_BINDING, currOffset, VET_COLOUR, VES_DIFFUSE);
-   currOffset += VertexElement::getTypeSize(VET_COLOUR); 
-
-   vertexData->vertexCount = miTotalVertices; 
-
-   // Allocate vertex buffer 
-   HardwareVertexBufferSharedPtr vbuf = 
-      HardwareBufferManager::getSingleton(). 
-      createVertexBuffer(vertexDecl->getVertexSize(POSITION_BINDING), vertexData->vertexCount, 
-      HardwareBuffer::HBU_STATIC_WRITE_ONLY, false); 
+   return pMesh;
+}
 
-   // Set up the binding (one source only) 
-   VertexBufferBinding* binding = vertexData->vertexBufferBinding; 
-   binding->setBinding(POSITION_BINDING, vbuf); 
+//---------------------------------------------------------------------------
 
+void Tree::CreateGeometry(TGeometry &rGeometry)
+{
    // Generate vertex data recurcively
-   // Lock the whole buffer 
-   Real* pVertexArray = static_cast<Real*>( vbuf->lock(HardwareBuffer::HBL_DISCARD) ); 
-
-   HardwareVertexBufferSharedPtr vcolbuf =
-          HardwareBufferManager::getSingleton().
-          createVertexBuffer(vertexDecl->getVertexSize(COLOUR_BINDING), vertexData->vertexCount, 
-          HardwareBuffer::HBU_STATIC_WRITE_ONLY, false); 
-        // bind position and diffuses
-        binding->setBinding(COLOUR_BINDING, vcolbuf);
-
-   RGBA* pVertexColorArray = static_cast<RGBA*>( vcolbuf->lock(HardwareBuffer::HBL_DISCARD) );
-   
+   rGeometry.mVertices.resize(8 * miTotalVertices);
+   rGeometry.mColors.resize(miTotalVertices);
+   Real* pVertexArray = miTotalVertices ? &rGeometry.mVertices[0] : 0;
+   RGBA* pVertexColorArray = miTotalVertices ? &rGeometry.mColors[0] : 0;
+
    mpTrunk->AddMeshVertices(&pVertexArray, &pVertexColorArray);
    if (miTotalLeaves > 0)
      mpTrunk->AddLeavesVertices(&pVertexArray, &pVertexColorArray, 0);
    if (this->mpParameters->mTreeType == TParameters::Simple)
      mpTrunk->AddCoordFrameVertices(&pVertexArray, &pVertexColorArray);
 
-   // Unlock 
-   vbuf->unlock(); 
-   vcolbuf->unlock(); 
-   
    // Generate face list for the trunk and the stems
-   pStemsSub = pMesh->createSubMesh(); 
-   pStemsSub->useSharedVertices = true; 
-
-   pStemsSub->indexData->indexCount = 3 * miTotalFaces; 
-   pStemsSub->indexData->indexBuffer = HardwareBufferManager::getSingleton(). 
-         createIndexBuffer( HardwareIndexBuffer::IT_32BIT /*HardwareIndexBuffer::IT_16BIT */ , 
-         pStemsSub->indexData->indexCount, HardwareBuffer::HBU_STATIC_WRITE_ONLY, false); 
-
- //  int v1, v2, v3; 
-   HardwareIndexBufferSharedPtr ibuf = pStemsSub->indexData->indexBuffer; 
-   // Lock the whole buffer 
-   // unsigned short* pFaceIndexes = static_cast<unsigned short*> ( ibuf->lock(HardwareBuffer::HBL_DISCARD) );
-   unsigned long* pFaceIndexes = static_cast<unsigned long*> ( ibuf->lock(HardwareBuffer::HBL_DISCARD) ); 
-
    unsigned long u32VertexIndexOffset = 0;
-   mpTrunk->AddMeshFaces(&pFaceIndexes, &u32VertexIndexOffset);
-   
-   // Unlock 
-   ibuf->unlock(); 
-   
+   unsigned long* pFaceIndexes;
+   rGeometry.mStemIndexes.resize(3 * miTotalFaces);
+   if (miTotalFaces > 0)
+   {
+     pFaceIndexes = &rGeometry.mStemIndexes[0];
+     mpTrunk->AddMeshFaces(&pFaceIndexes, &u32VertexIndexOffset);
+   }
+
    // Generate face list for the leaves
-   if (miTotalLeaves > 0)
+   rGeometry.mLeavesIndexes.clear();
+   if (miTotalLeaves > 0 && miTotalLeavesFaces > 0)
    {
-		pLeavesSub = pMesh->createSubMesh(); 
-		pLeavesSub->useSharedVertices = true; 
+     rGeometry.mLeavesIndexes.resize(3 * miTotalLeavesFaces);
+     pFaceIndexes = &rGeometry.mLeavesIndexes[0];
+     mpTrunk->AddLeavesMeshFaces(&pFaceIndexes, &u32VertexIndexOffset);
+   }
 
-		pLeavesSub->indexData->indexCount = 3 * miTotalLeavesFaces; 
-		pLeavesSub->indexData->indexBuffer = HardwareBufferManager::getSingleton(). 
-				createIndexBuffer(HardwareIndexBuffer::IT_32BIT /*HardwareIndexBuffer::IT_16BIT*/, 
-				pLeavesSub->indexData->indexCount, HardwareBuffer::HBU_STATIC_WRITE_ONLY, false); 
+   // Generate face list for the coordinate frame display
+   rGeometry.mCoordFrameIndexes.clear();
+   if (this->mpParameters->mTreeType == TParameters::Simple && miTotalCoordFrames > 0)
+   {
+     rGeometry.mCoordFrameIndexes.resize(3 * 9 * miTotalCoordFrames);   // 9 faces per coord frames
+     pFaceIndexes = &rGeometry.mCoordFrameIndexes[0];
+     mpTrunk->AddCoordFrameMeshFaces(&pFaceIndexes, &u32VertexIndexOffset);
+   }
 
-		//  int v1, v2, v3; 
-		ibuf = pLeavesSub->indexData->indexBuffer; 
-		// Lock the whole buffer 
-		// pFaceIndexes = static_cast<unsigned short*>( ibuf->lock(HardwareBuffer::HBL_DISCARD) ); 
-		pFaceIndexes = static_cast<unsigned long*>( ibuf->lock(HardwareBuffer::HBL_DISCARD) ); 
+   // TODO: Improve AAB + SphereRadius !!!!!!!!!!!
+   Vector3 vb1, vb2;
+   vb1 = Vector3(-mfMaxX, 0, -mfMaxZ) ;
+   vb2 = Vector3(mfMaxX, mfMaxY, mfMaxZ) ;
+   rGeometry.mBounds = AxisAlignedBox(vb1, vb2);
+   rGeometry.mfBoundingRadius = Math::Sqrt((vb2-vb1).Vector3::dotProduct(vb2-vb1))/2.0;
+}
 
-		mpTrunk->AddLeavesMeshFaces(&pFaceIndexes, &u32VertexIndexOffset);
+//---------------------------------------------------------------------------
 
-		// Unlock 
-		ibuf->unlock(); 
-   }
+static void AddSubMesh(Mesh *pMesh, const std::vector<unsigned long> &rIndexes, const String &material)
+{
+   if (rIndexes.empty())
+     return;
+
+   SubMesh *pSub = pMesh->createSubMesh(); 
+   pSub->useSharedVertices = true; 
+   if (!material.empty())
+     pSub->setMaterialName(material);
+
+   pSub->indexData->indexCount = rIndexes.size(); 
+   pSub->indexData->indexBuffer = HardwareBufferManager::getSingleton(). 
+         createIndexBuffer(HardwareIndexBuffer::IT_32BIT, 
+         pSub->indexData->indexCount, HardwareBuffer::HBU_STATIC_WRITE_ONLY, false); 
+
+   // unsigned long is 64 bits wide on some platforms, so the indexes are narrowed one by one
+   HardwareIndexBufferSharedPtr ibuf = pSub->indexData->indexBuffer; 
+   uint32* pFaceIndexes = static_cast<uint32*>( ibuf->lock(HardwareBuffer::HBL_DISCARD) ); 
+   for (size_t i = 0; i < rIndexes.size(); i++)
+     pFaceIndexes[i] = static_cast<uint32>(rIndexes[i]);
+   ibuf->unlock(); 
+}
 
+//---------------------------------------------------------------------------
 
-   // Generate face list for the coordinate frame display
-   if (this->mpParameters->mTreeType == TParameters::Simple)
-   {
-     	pCoordFrameSub = pMesh->createSubMesh(); 
-		pCoordFrameSub->useSharedVertices = true; 
+void Tree::FillMesh(Mesh *pMesh, const TGeometry &rGeometry, const String &stemMaterial, const String &leavesMaterial, const String &coordFrameMaterial)
+{
+   // Set up vertex data 
+   // Use a single shared buffer 
+   pMesh->sharedVertexData = new VertexData(); 
+   VertexData* vertexData = pMesh->sharedVertexData; 
+   // Set up Vertex Declaration 
+   VertexDeclaration* vertexDecl = vertexData->vertexDeclaration; 
+   size_t currOffset = 0; 
+   // We always need positions 
+   vertexDecl->addElement(POSITION_BINDING, currOffset, VET_FLOAT3, VES_POSITION); 
+   currOffset += VertexElement::getTypeSize(VET_FLOAT3); 
 
-		pCoordFrameSub->indexData->indexCount = 3 * 9 * miTotalCoordFrames;   // 9 faces per coord frames
-		pCoordFrameSub->indexData->indexBuffer = HardwareBufferManager::getSingleton(). 
-				createIndexBuffer(HardwareIndexBuffer::IT_32BIT /*HardwareIndexBuffer::IT_16BIT*/, 
-				pCoordFrameSub->indexData->indexCount, HardwareBuffer::HBU_STATIC_WRITE_ONLY, false); 
+   // normals 
+   vertexDecl->addElement(POSITION_BINDING, currOffset, VET_FLOAT3, VES_NORMAL); 
+   currOffset += VertexElement::getTypeSize(VET_FLOAT3); 
 
-		ibuf = pCoordFrameSub->indexData->indexBuffer; 
-		// Lock the whole buffer 
-		pFaceIndexes = static_cast<unsigned long*>( ibuf->lock(HardwareBuffer::HBL_DISCARD) ); 
+   // 2D texture coords 
+   vertexDecl->addElement(POSITION_BINDING, currOffset, VET_FLOAT2, VES_TEXTURE_COORDINATES, 0); 
+   currOffset += VertexElement::getTypeSize(VET_FLOAT2); 
+
+   // vertex color, which is kept in a buffer of its own
+   vertexDecl->addElement(COLOUR_BINDING, 0, VET_COLOUR, VES_DIFFUSE);
 
-		mpTrunk->AddCoordFrameMeshFaces(&pFaceIndexes, &u32VertexIndexOffset);
+   vertexData->vertexCount = rGeometry.mColors.size(); 
 
-		// Unlock 
-		ibuf->unlock(); 
+   if (vertexData->vertexCount > 0)
+   {
+     // Allocate vertex buffer 
+     HardwareVertexBufferSharedPtr vbuf = 
+        HardwareBufferManager::getSingleton(). 
+        createVertexBuffer(vertexDecl->getVertexSize(POSITION_BINDING), vertexData->vertexCount, 
+        HardwareBuffer::HBU_STATIC_WRITE_ONLY, false); 
+     vbuf->writeData(0, vbuf->getSizeInBytes(), &rGeometry.mVertices[0], true);
+
+     HardwareVertexBufferSharedPtr vcolbuf =
+        HardwareBufferManager::getSingleton().
+        createVertexBuffer(vertexDecl->getVertexSize(COLOUR_BINDING), vertexData->vertexCount, 
+        HardwareBuffer::HBU_STATIC_WRITE_ONLY, false); 
+     vcolbuf->writeData(0, vcolbuf->getSizeInBytes(), &rGeometry.mColors[0], true);
+
+     // bind position and diffuses
+     VertexBufferBinding* binding = vertexData->vertexBufferBinding; 
+     binding->setBinding(POSITION_BINDING, vbuf); 
+     binding->setBinding(COLOUR_BINDING, vcolbuf);
    }
 
-   // TODO: Improve AAB + SphereRadius !!!!!!!!!!!
-   Vector3 vb1, vb2;
-   vb1 = Vector3(-mfMaxX, 0, -mfMaxZ) ;
-   vb2 = Vector3(mfMaxX, mfMaxY, mfMaxZ) ;
-   pMesh->_setBounds(AxisAlignedBox(vb1, vb2)); 
-   pMesh->_setBoundingSphereRadius(Math::Sqrt((vb2-vb1).Vector3::dotProduct(vb2-vb1))/2.0); 
+   AddSubMesh(pMesh, rGeometry.mStemIndexes, stemMaterial);
+   AddSubMesh(pMesh, rGeometry.mLeavesIndexes, leavesMaterial);
+   AddSubMesh(pMesh, rGeometry.mCoordFrameIndexes, coordFrameMaterial);
 
-   return pMesh;
+   pMesh->_setBounds(rGeometry.mBounds); 
+   pMesh->_setBoundingSphereRadius(rGeometry.mfBoundingRadius); 
 }
 //---------------------------------------------------------------------------
 
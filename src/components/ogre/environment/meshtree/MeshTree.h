@@ -6,6 +6,8 @@
 #include "TStem.h"
 #include "TParameters.h"
 
+#include <random>
+
 #define FLARE_RESOLUTION 10
 
 /*
@@ -30,6 +32,21 @@ namespace Ogre {
 
 //---------------------------------------------------------------------------
 
+// The geometry of a grown tree, held in ordinary memory so that it can be
+// created outside of the render thread and stored on disk.
+struct TGeometry
+{
+  std::vector<Real> mVertices;              // Position, normal and texture coordinates; 8 values per vertex
+  std::vector<RGBA> mColors;                // One per vertex
+  std::vector<unsigned long> mStemIndexes;
+  std::vector<unsigned long> mLeavesIndexes;
+  std::vector<unsigned long> mCoordFrameIndexes;
+  AxisAlignedBox mBounds;
+  Real mfBoundingRadius;
+};
+
+//---------------------------------------------------------------------------
+
 class Tree
 {
   friend class TStem;
@@ -45,6 +62,7 @@ class Tree
     Real mfMaxY;             // occurring in the tree
     Real mfMaxZ;
     uchar mu8Season;
+    std::minstd_rand mRandom;
 
   protected:
 
@@ -63,6 +81,8 @@ class Tree
     void Grow(void);
     Real GetRandomValue(const Real fUpperBound);
     Ogre::MeshPtr CreateMesh(const String &name); 
+    void CreateGeometry(TGeometry &rGeometry);
+    static void FillMesh(Mesh *pMesh, const TGeometry &rGeometry, const String &stemMaterial, const String &leavesMaterial, const String &coordFrameMaterial);
     inline TParameters* GetParameters(void){return mpParameters;};
     inline Real GetScale(void){return mfScale;};
 };
@@ -46,6 +46,12 @@ Permission is granted to anyone to use this software for any purpose, including
 //is desired)
 //#define IMPOSTOR_FILE_SAVE
 
+namespace Ember {
+namespace Tasks {
+class TaskQueue;
+}
+}
+
 namespace Forests {
 
 class ImpostorBatch;
@@ -182,7 +188,27 @@ public:
 	\warning This is NOT a real-time operation - it may take a few seconds to complete.
 	*/
 	static void regenerateAll();
-	
+
+	/**
+	\brief Sets the directory in which rendered impostor textures are cached between sessions.
+	\param directory The directory, including a trailing separator. An empty string disables the cache.
+	\param writeQueue The queue in which the images are encoded and written. This must outlive all
+	impostor pages, or be unset (together with the directory) before it's destroyed.
+
+	When a cache directory is set every rendered impostor atlas is written to it, keyed by
+	the contents of the mesh file, the materials, the impostor resolution, the background color
+	and the pivot. Subsequent requests for the same combination (in the same or a later session)
+	will be loaded from disk instead of being rendered again.
+
+	\note This has no effect if IMPOSTOR_FILE_SAVE is defined, since the textures are then
+	already stored in the temp directory of the PagedGeometry instance.
+	*/
+	static void setImpostorCacheDirectory(const Ogre::String& directory, Ember::Tasks::TaskQueue* writeQueue) { impostorCacheDirectory = directory; impostorCacheQueue = writeQueue; }
+
+	/**
+	\brief Gets the directory in which rendered impostor textures are cached.
+	*/
+	static const Ogre::String& getImpostorCacheDirectory() { return impostorCacheDirectory; }
 
 	inline void setBlendMode(ImpostorBlendMode blendMode) { this->blendMode = blendMode; }
 	inline ImpostorBlendMode getBlendMode() { return blendMode; }
@@ -195,6 +221,8 @@ protected:
 	static int impostorResolution;
 	static Ogre::ColourValue impostorBackgroundColor;
 	static Ogre::BillboardOrigin impostorPivot;
+	static Ogre::String impostorCacheDirectory;
+	static Ember::Tasks::TaskQueue* impostorCacheQueue;
 	
 	static Ogre::uint32 selfInstances;
 	static Ogre::uint32 updateInstanceID;
@@ -278,7 +306,7 @@ public:
 	
 	
 	/**
-	 *    At load time the texture will be rerendered.
+	 *    At load time the texture will be loaded from the impostor cache, or rerendered if it isn't cached.
 	 * @param resource 
 	 */
 	virtual void loadResource (Ogre::Resource *resource);
@@ -308,7 +336,11 @@ public:
 	*/
 	static void removeTexture(ImpostorTexture* Texture);
 
-	void regenerate();
+	/** Renders the impostor texture again.
+	\param force If false the texture is loaded from the impostor cache if possible.
+	*/
+	void regenerate(bool force = true);
+	void reload() { regenerate(false); }
 	static void regenerateAll();
 
 	~ImpostorTexture();
@@ -319,6 +351,10 @@ protected:
 	void renderTextures(bool force);	// Renders the impostor texture grid
 	void updateMaterials();				// Updates the materials to use the latest rendered impostor texture grid
 
+	Ogre::String getCacheFileName();					// Gets the path of the cached image, or an empty string if caching is disabled
+	bool loadFromCache(Ogre::TexturePtr renderTexture);	// Copies the cached image into the texture, if it exists
+	void writeToCache(Ogre::TexturePtr renderTexture);	// Reads back the texture and writes it to the cache in a background thread
+
 	Ogre::String removeInvalidCharacters(Ogre::String s);
 
 	static std::map<Ogre::String, ImpostorTexture *> selfList;
@@ -331,6 +367,8 @@ protected:
 	Ogre::TexturePtr texture;
 
 	Ogre::ResourceHandle sourceMesh;
+	Ogre::String meshContentHash;	// Hash of the mesh file, calculated when the cache is first used; empty if the mesh has no file
+	bool meshContentHashCalculated;
 	Ogre::AxisAlignedBox boundingBox;
 	float entityDiameter, entityRadius;
 	Ogre::Vector3 entityCenter;
@@ -1336,6 +1336,94 @@ private:
 
 
 
+//-------------------------------------------------------------------------------------
+/**
+\brief A per-frame time budget for loading geometry pages, shared by all PagedGeometry instances.
+
+Whenever the camera crosses a page boundary a lot of pages can come into range at the
+same time, especially when several PagedGeometry instances (grass, shrubbery, trees)
+are active. Instead of loading all of them in the same frame each GeometryPageManager
+asks this class whether there's any time left in the current frame before loading a page.
+Pages which don't fit in the budget are loaded in later frames, closest and most
+visible ones first.
+
+At least one page is always loaded each frame, so loading will progress even if single
+pages take longer than the budget.
+
+The statistics of the last completed frame can be retrieved through getLastFrameStats().
+*/
+class PageLoadBudget
+{
+public:
+	/**
+	\brief Statistics about page loading during a single frame.
+	*/
+	struct Stats
+	{
+		Stats() : pendingPages(0), loadedPages(0), deferredPages(0), loadTime(0), maxPageLoadTime(0) {}
+
+		/** \brief The number of pages waiting to be loaded, in all page managers. */
+		unsigned int pendingPages;
+		/** \brief The number of pages loaded. */
+		unsigned int loadedPages;
+		/** \brief The number of pages which were in range but were postponed because the budget was used up. */
+		unsigned int deferredPages;
+		/** \brief The total time spent loading pages, in milliseconds. */
+		float loadTime;
+		/** \brief The time spent loading the slowest page, in milliseconds. */
+		float maxPageLoadTime;
+	};
+
+	/**
+	\brief Sets the time budget for loading pages each frame.
+	\param microseconds The budget in microseconds. A value of 0 disables the budget.
+	*/
+	static void setBudget(unsigned long microseconds) { budget = microseconds; }
+
+	/**
+	\brief Gets the time budget for loading pages each frame, in microseconds.
+	*/
+	static unsigned long getBudget() { return budget; }
+
+	/**
+	\brief Gets the statistics for the last completed frame.
+	*/
+	static const Stats& getLastFrameStats() { return lastFrameStats; }
+
+	/**
+	\brief Gets the statistics for the current frame so far.
+	*/
+	static const Stats& getCurrentFrameStats() { _checkFrame(); return currentFrameStats; }
+
+	/** \brief Internal function - DO NOT USE */
+	static bool _canLoad();
+
+	/** \brief Internal function - DO NOT USE */
+	static void _registerLoad(unsigned long microseconds);
+
+	/** \brief Internal function - DO NOT USE */
+	static void _registerDeferred();
+
+	/** \brief Internal function - DO NOT USE */
+	static void _registerPending(unsigned int pages);
+
+	/** \brief Internal function - DO NOT USE */
+	static unsigned long _getMicroseconds();
+
+private:
+	//Rolls the statistics over if a new frame has started
+	static void _checkFrame();
+
+	static unsigned long budget;
+	static unsigned long frameLoadTime;		//Microseconds spent loading pages in the current frame
+	static unsigned long currentFrame;
+	static Stats currentFrameStats;
+	static Stats lastFrameStats;
+	static Ogre::Timer timer;
+};
+
+
+
 //-------------------------------------------------------------------------------------
 /**
 \brief Manages the rendering of geometry for a detail level type.
@@ -1541,6 +1629,8 @@ private:
 
 	//Utility functions for loading/unloading geometry pages (see source for detailed descriptions)
 	void _loadPage(GeometryPage *page);
+	void _loadPageTimed(GeometryPage *page);
+	Ogre::Real _getLoadPriority(const GeometryPage *page, const Ogre::Vector3 &camPos, const Ogre::Vector3 &camDir) const;
 	void _unloadPage(GeometryPage *page);
 	void _unloadPageDelayed(GeometryPage *page);
 
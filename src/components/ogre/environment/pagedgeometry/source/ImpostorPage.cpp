@@ -24,6 +24,18 @@ Permission is granted to anyone to use this software for any purpose, including
 #include <OgreEntity.h>
 #include <OgreSubEntity.h>
 #include <OgreHardwarePixelBuffer.h>
+#include <OgreImage.h>
+#include <OgreDataStream.h>
+#include <OgreResourceGroupManager.h>
+
+#include "framework/tasks/TaskQueue.h"
+#include "framework/tasks/ITask.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <vector>
 using namespace Ogre;
 
 namespace Forests {
@@ -35,6 +47,8 @@ uint32 ImpostorPage::selfInstances = 0;
 int ImpostorPage::impostorResolution = 128;
 ColourValue ImpostorPage::impostorBackgroundColor = ColourValue(0.0f, 0.3f, 0.0f, 0.0f);
 BillboardOrigin ImpostorPage::impostorPivot = BBO_CENTER;
+String ImpostorPage::impostorCacheDirectory;
+Ember::Tasks::TaskQueue* ImpostorPage::impostorCacheQueue = nullptr;
 
 
 void ImpostorPage::init(PagedGeometry *geom, const Ogre::Any &data)
@@ -321,7 +335,7 @@ ImpostorTextureResourceLoader::ImpostorTextureResourceLoader(ImpostorTexture& im
 void ImpostorTextureResourceLoader::loadResource (Ogre::Resource *resource)
 {
 	if (resource->getLoadingState() == Ogre::Resource::LOADSTATE_UNLOADED) {
-		texture.regenerate();
+		texture.reload();
 	}
 }
 
@@ -334,7 +348,7 @@ unsigned long ImpostorTexture::GUID = 0;
 //Do not use this constructor yourself - instead, call getTexture()
 //to get/create an ImpostorTexture for an Entity.
 ImpostorTexture::ImpostorTexture(ImpostorPage *group, Entity *entity)
-: loader(nullptr)
+: meshContentHash(), meshContentHashCalculated(false), loader(nullptr)
 {
 	//Store scene manager and entity
 	ImpostorTexture::sceneMgr = group->sceneMgr;
@@ -430,7 +444,7 @@ ImpostorTexture::~ImpostorTexture()
 	selfList.erase(entityKey);
 }
 
-void ImpostorTexture::regenerate()
+void ImpostorTexture::regenerate(bool force)
 {
 	assert(!texture.isNull());
 	String texName(texture->getName());
@@ -438,7 +452,7 @@ void ImpostorTexture::regenerate()
 	if (TextureManager::getSingletonPtr())
 		TextureManager::getSingleton().remove(texName);
 
-	renderTextures(true);
+	renderTextures(force);
 	updateMaterials();
 }
 
@@ -471,6 +485,14 @@ void ImpostorTexture::renderTextures(bool force)
 				TEX_TYPE_2D, textureSize * IMPOSTOR_YAW_ANGLES, textureSize * IMPOSTOR_PITCH_ANGLES, 0, PF_A8R8G8B8, TU_RENDERTARGET, loader.get());
 	}
 	renderTexture->setNumMipmaps(MIP_UNLIMITED);
+
+#ifndef IMPOSTOR_FILE_SAVE
+	//Use an earlier render from the impostor cache if there is one; no need to set up the scene then
+	if (!force && loadFromCache(renderTexture)) {
+		texture = renderTexture;
+		return;
+	}
+#endif
 	
 	//Set up render target
 	renderTarget = renderTexture->getBuffer()->getRenderTarget(); 
@@ -621,6 +643,7 @@ void ImpostorTexture::renderTextures(bool force)
 		texture = TextureManager::getSingleton().load(fileNamePNG, "BinFolder", TEX_TYPE_2D, MIP_UNLIMITED);
 #else
 		texture = renderTexture;
+		writeToCache(renderTexture);
 #endif
 	}
 	
@@ -664,6 +687,158 @@ void ImpostorTexture::renderTextures(bool force)
 #endif
 }
 
+namespace {
+
+//64 bit FNV-1a
+void hashBytes(uint64& hash, const void* data, size_t length)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < length; ++i) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+}
+
+//Hashes the file the mesh was loaded from, so that changes to the mesh invalidate its cached impostors
+String calculateMeshContentHash(const Mesh& mesh)
+{
+	//Manually created meshes have no file, and their contents can change at any time
+	if (mesh.isManuallyLoaded())
+		return "";
+	try {
+		DataStreamPtr stream = ResourceGroupManager::getSingleton().openResource(mesh.getName(), mesh.getGroup(), true, const_cast<Mesh*>(&mesh));
+		if (stream.isNull())
+			return "";
+		uint64 hash = 14695981039346656037ULL;
+		char buffer[65536];
+		while (!stream->eof()) {
+			size_t read = stream->read(buffer, sizeof(buffer));
+			if (read == 0)
+				break;
+			hashBytes(hash, buffer, read);
+		}
+		StringUtil::StrStreamType ss;
+		ss << std::hex << hash << "-" << stream->size();
+		return ss.str();
+	} catch (const Ogre::Exception&) {
+		return "";
+	}
+}
+
+//Encodes a read back impostor atlas and writes it to the cache
+class CacheWriteTask : public Ember::Tasks::ITask
+{
+public:
+	CacheWriteTask(std::shared_ptr<Image> image, const String& fileName)
+	: image(image), fileName(fileName)
+	{
+	}
+
+	virtual void executeTaskInBackgroundThread(Ember::Tasks::TaskExecutionContext& context)
+	{
+		try {
+			//Write to a temporary file first, so that an interrupted write never leaves a truncated image in the cache
+			DataStreamPtr encoded = image->encode("png");
+			const String tempFileName = fileName + ".tmp";
+			std::ofstream file(tempFileName.c_str(), std::ios::out | std::ios::binary);
+			if (!file.is_open())
+				return;
+			std::vector<char> bytes(encoded->size());
+			encoded->read(&bytes[0], bytes.size());
+			file.write(&bytes[0], bytes.size());
+			file.close();
+			std::remove(fileName.c_str());
+			std::rename(tempFileName.c_str(), fileName.c_str());
+		} catch (...) {
+			//Failing to write the cache isn't fatal; the impostor will just be rendered again next time
+		}
+	}
+
+	virtual std::string getName() const
+	{
+		return "ImpostorCacheWriteTask";
+	}
+
+private:
+	std::shared_ptr<Image> image;
+	const String fileName;
+};
+
+}
+
+String ImpostorTexture::getCacheFileName()
+{
+	if (ImpostorPage::impostorCacheDirectory.empty())
+		return "";
+
+	if (!meshContentHashCalculated) {
+		meshContentHash = calculateMeshContentHash(*entity->getMesh());
+		meshContentHashCalculated = true;
+	}
+
+	//Without a file there's nothing to tell if the mesh has changed, so such impostors are never cached
+	if (meshContentHash.empty())
+		return "";
+
+	//Everything which affects the rendered image needs to be part of the key
+	StringUtil::StrStreamType keyStream;
+	keyStream << entityKey << "-" << meshContentHash << "-" << ImpostorPage::impostorResolution << "-" << ImpostorPage::impostorPivot << "-" << ImpostorPage::impostorBackgroundColor;
+	const String key = keyStream.str();
+
+	uint64 hash = 14695981039346656037ULL;
+	hashBytes(hash, key.data(), key.size());
+
+	StringUtil::StrStreamType fileName;
+	fileName << ImpostorPage::impostorCacheDirectory << "Impostor." << std::hex << std::setw(16) << std::setfill('0') << hash << '.' << std::dec << ImpostorPage::impostorResolution << ".png";
+	return fileName.str();
+}
+
+bool ImpostorTexture::loadFromCache(TexturePtr renderTexture)
+{
+	const String fileName = getCacheFileName();
+	if (fileName.empty())
+		return false;
+
+	std::ifstream* file = OGRE_NEW_T(std::ifstream, MEMCATEGORY_GENERAL)(fileName.c_str(), std::ios::in | std::ios::binary);
+	if (!file->is_open()) {
+		OGRE_DELETE_T(file, basic_ifstream, MEMCATEGORY_GENERAL);
+		return false;
+	}
+	DataStreamPtr stream(OGRE_NEW FileStreamDataStream(fileName, file));
+
+	try {
+		Image image;
+		image.load(stream, "png");
+		if (image.getWidth() != renderTexture->getWidth() || image.getHeight() != renderTexture->getHeight())
+			return false;
+		renderTexture->getBuffer()->blitFromMemory(image.getPixelBox());
+	} catch (const Ogre::Exception&) {
+		//A corrupt or unreadable cache file is treated as a miss; it will be overwritten by the new render
+		return false;
+	}
+	return true;
+}
+
+void ImpostorTexture::writeToCache(TexturePtr renderTexture)
+{
+	if (!ImpostorPage::impostorCacheQueue)
+		return;
+	const String fileName = getCacheFileName();
+	if (fileName.empty())
+		return;
+
+	//The GPU readback has to happen here in the main thread, but encoding and disk I/O can be done in the background
+	HardwarePixelBufferSharedPtr buffer = renderTexture->getBuffer();
+	const size_t width = buffer->getWidth();
+	const size_t height = buffer->getHeight();
+	uchar* data = OGRE_ALLOC_T(uchar, PixelUtil::getMemorySize(width, height, 1, PF_A8R8G8B8), MEMCATEGORY_GENERAL);
+	std::shared_ptr<Image> image(new Image());
+	image->loadDynamicImage(data, width, height, 1, PF_A8R8G8B8, true);
+	buffer->blitToMemory(image->getPixelBox());
+
+	ImpostorPage::impostorCacheQueue->enqueueTask(new CacheWriteTask(image, fileName));
+}
+
 String ImpostorTexture::removeInvalidCharacters(String s)
 {
 	StringUtil::StrStreamType s2;
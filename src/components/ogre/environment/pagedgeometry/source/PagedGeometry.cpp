@@ -19,6 +19,9 @@ Permission is granted to anyone to use this software for any purpose, including
 #include <OgreTimer.h>
 #include <OgreCamera.h>
 #include <OgreVector3.h>
+
+#include <algorithm>
+#include <vector>
 using namespace Ogre;
 using namespace std;
 
@@ -403,6 +406,61 @@ Ogre::RenderQueueGroupID PagedGeometry::getRenderQueue() const
 
 //-------------------------------------------------------------------------------------
 
+unsigned long PageLoadBudget::budget = 0;
+unsigned long PageLoadBudget::frameLoadTime = 0;
+unsigned long PageLoadBudget::currentFrame = 0;
+PageLoadBudget::Stats PageLoadBudget::currentFrameStats;
+PageLoadBudget::Stats PageLoadBudget::lastFrameStats;
+Ogre::Timer PageLoadBudget::timer;
+
+void PageLoadBudget::_checkFrame()
+{
+	const unsigned long frame = Root::getSingleton().getNextFrameNumber();
+	if (frame != currentFrame){
+		lastFrameStats = currentFrameStats;
+		currentFrameStats = Stats();
+		frameLoadTime = 0;
+		currentFrame = frame;
+	}
+}
+
+bool PageLoadBudget::_canLoad()
+{
+	_checkFrame();
+	//Always allow at least one page per frame, so that loading progresses even with very slow pages
+	return budget == 0 || currentFrameStats.loadedPages == 0 || frameLoadTime < budget;
+}
+
+void PageLoadBudget::_registerLoad(unsigned long microseconds)
+{
+	_checkFrame();
+	frameLoadTime += microseconds;
+	++currentFrameStats.loadedPages;
+	const float milliseconds = microseconds / 1000.0f;
+	currentFrameStats.loadTime += milliseconds;
+	if (milliseconds > currentFrameStats.maxPageLoadTime)
+		currentFrameStats.maxPageLoadTime = milliseconds;
+}
+
+void PageLoadBudget::_registerDeferred()
+{
+	_checkFrame();
+	++currentFrameStats.deferredPages;
+}
+
+void PageLoadBudget::_registerPending(unsigned int pages)
+{
+	_checkFrame();
+	currentFrameStats.pendingPages += pages;
+}
+
+unsigned long PageLoadBudget::_getMicroseconds()
+{
+	return timer.getMicroseconds();
+}
+
+//-------------------------------------------------------------------------------------
+
 GeometryPageManager::GeometryPageManager(PagedGeometry *mainGeom)
 : mainGeom(mainGeom)
 	, cacheTimer(0) // Reset the cache timer
@@ -481,7 +539,10 @@ void GeometryPageManager::update(unsigned long deltaTime, Vector3 &camPos, Vecto
 	}
 	//Now, in that general area, find what pages are within the cacheDist radius
 	//Pages within the cacheDist radius will be added to the pending block list
-	//to be loaded later, and pages within farDist will be loaded immediately.
+	//to be loaded later, and pages within farDist will be loaded immediately
+	//(as long as the per-frame page load budget allows it).
+	const Vector3 camDir = mainGeom->_convertToLocal(mainGeom->getCamera()->getDerivedDirection());
+	std::vector<std::pair<Real, GeometryPage *> > immediateList;
 	for (int x = x1; x <= x2; ++x){
 		for (int z = z1; z <= z2; ++z){
 			GeometryPage *blk = _getGridPage(x, z);
@@ -496,15 +557,8 @@ void GeometryPageManager::update(unsigned long deltaTime, Vector3 &camPos, Vecto
 				if (blk->_loaded == false){
 					//Test if the block's distance is between nearDist and farDist
 					if (distSq >= nearDistSq && distSq < farTransDistSq){
-						//If so, load the geometry immediately
-						_loadPage(blk);
-						loadedList.insert(blk);
-
-						//And remove it from the pending list if necessary
-						if (blk->_pending){
-							pendingList.erase(blk);
-							blk->_pending = false;
-						}
+						//If so, the geometry should be loaded immediately
+						immediateList.push_back(std::make_pair(_getLoadPriority(blk, camPos, camDir), blk));
 					} else {
 						//Otherwise, add it to the pending geometry list (if not already)
 						//Pages in then pending list will be loaded later (see below)
@@ -523,6 +577,29 @@ void GeometryPageManager::update(unsigned long deltaTime, Vector3 &camPos, Vecto
 			}
 		}
 	}
+
+	//Load the pages closest to, and in front of, the camera first. Whatever doesn't fit in
+	//this frame's budget is put in the pending list and will be tried again next frame.
+	std::sort(immediateList.begin(), immediateList.end());
+	for (std::vector<std::pair<Real, GeometryPage *> >::const_iterator I = immediateList.begin(); I != immediateList.end(); ++I){
+		GeometryPage *blk = I->second;
+		if (PageLoadBudget::_canLoad()){
+			_loadPageTimed(blk);
+			loadedList.insert(blk);
+
+			//And remove it from the pending list if necessary
+			if (blk->_pending){
+				pendingList.erase(blk);
+				blk->_pending = false;
+			}
+		} else {
+			PageLoadBudget::_registerDeferred();
+			if (!blk->_pending){
+				pendingList.insert(blk);
+				blk->_pending = true;
+			}
+		}
+	}
 	
 	
 	//Calculate cache speeds based on camera speed. This is important to keep the cache
@@ -548,37 +625,50 @@ void GeometryPageManager::update(unsigned long deltaTime, Vector3 &camPos, Vecto
 
 	//Now load a single geometry page periodically, based on the cacheInterval
 	cacheTimer += deltaTime;
-	if (cacheTimer >= cacheInterval && enableCache){
-		//Find a block to be loaded from the pending list
+	if (cacheTimer >= cacheInterval && enableCache && PageLoadBudget::_canLoad()){
+		//Find the block with the highest priority in the pending list, dropping those
+		//which have gone out of the cache radius
+		GeometryPage *bestBlk = NULL;
+		Real bestPriority = 0;
 		i1 = pendingList.begin();
 		i2 = pendingList.end();
 		while (i1 != i2)
 		{
 			GeometryPage *blk = *i1;
 			
-			//Remove it from the pending list
-			i1 = pendingList.erase(i1);
-			blk->_pending = false;
-			
-			//If it's within the geometry cache radius, load it and break out of the loop
 			Real dx = camPos.x - blk->_centerPoint.x;
 			Real dz = camPos.z - blk->_centerPoint.z;
 			Real distSq = dx * dx + dz * dz;
-			if (distSq <= cacheDistSq){
-				_loadPage(blk);
-				loadedList.insert(blk);
+			if (distSq > cacheDistSq){
+				i1 = pendingList.erase(i1);
+				blk->_pending = false;
+				continue;
+			}
 
-				enableCache = false;
-				break;
+			Real priority = _getLoadPriority(blk, camPos, camDir);
+			if (bestBlk == NULL || priority < bestPriority){
+				bestBlk = blk;
+				bestPriority = priority;
 			}
+			++i1;
+		}
+
+		if (bestBlk){
+			pendingList.erase(bestBlk);
+			bestBlk->_pending = false;
 
-			//Otherwise this will keep looping until an unloaded page is found
+			_loadPageTimed(bestBlk);
+			loadedList.insert(bestBlk);
+
+			enableCache = false;
 		}
 			
 		//Reset the cache timer
 		cacheTimer = 0;
 	}
 
+	PageLoadBudget::_registerPending(pendingList.size());
+
 
 	//-- Update existing geometry and impostors --
 
@@ -847,6 +937,28 @@ void GeometryPageManager::resetPreloadedGeometry()
 }
 
 
+//Loads the given page through _loadPage() and accounts the time spent against the per-frame page load budget
+void GeometryPageManager::_loadPageTimed(GeometryPage *page)
+{
+	const unsigned long start = PageLoadBudget::_getMicroseconds();
+	_loadPage(page);
+	PageLoadBudget::_registerLoad(PageLoadBudget::_getMicroseconds() - start);
+}
+
+//Gets the load priority of a page; pages with lower values should be loaded first.
+//Pages behind the camera are deprioritized, except the ones right next to the camera.
+Real GeometryPageManager::_getLoadPriority(const GeometryPage *page, const Vector3 &camPos, const Vector3 &camDir) const
+{
+	Real dx = page->_centerPoint.x - camPos.x;
+	Real dz = page->_centerPoint.z - camPos.z;
+	Real distSq = dx * dx + dz * dz;
+
+	Real pageSizeSq = mainGeom->getPageSize() * mainGeom->getPageSize();
+	if (distSq > pageSizeSq && (dx * camDir.x + dz * camDir.z) < 0)
+		distSq *= 4;
+	return distSq;
+}
+
 //Loads the given page of geometry immediately
 //Note: _loadPage() does add the page to loadedList, so that will have to be done manually
 void GeometryPageManager::_loadPage(GeometryPage *page)
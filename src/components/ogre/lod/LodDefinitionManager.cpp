@@ -23,6 +23,8 @@
 #include "LodDefinitionManager.h"
 #include "LodManager.h"
 
+#include "components/ogre/EmberOgreFileSystem.h"
+
 template<>
 Ember::OgreView::Lod::LodDefinitionManager * Ember::Singleton<Ember::OgreView::Lod::LodDefinitionManager>::ms_Singleton = 0;
 
@@ -93,7 +95,10 @@ void LodDefinitionManager::parseScript(Ogre::DataStreamPtr& stream, const Ogre::
 void LodDefinitionManager::exportScript(std::string meshName, LodDefinitionPtr definition)
 {
 	std::string lodName = LodManager::getSingleton().convertMeshNameToLodName(meshName);
-	mLodDefinitionSerializer.exportScript(definition, lodName);
+	if (mLodDefinitionSerializer.exportScript(definition, lodName)) {
+		//The exported script needs to be picked up by the listing of its resource location.
+		FileSystemArchive::invalidateListings();
+	}
 }
 
 }
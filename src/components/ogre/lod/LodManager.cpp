@@ -24,10 +24,26 @@
 #include "LodDefinition.h"
 #include "LodDefinitionManager.h"
 #include "ScaledPixelCountLodStrategy.h"
+#include "PMInjectorSignaler.h"
+
+#include "framework/LoggingInstance.h"
 
 #include <OgreQueuedProgressiveMeshGenerator.h>
 #include <OgrePixelCountLodStrategy.h>
 #include <OgreDistanceLodStrategy.h>
+#include <OgreLodStrategyManager.h>
+#include <OgreSubMesh.h>
+#include <OgreHardwareBufferManager.h>
+
+#include <sigc++/functors/mem_fun.h>
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+#include <cstdint>
 
 template<>
 Ember::OgreView::Lod::LodManager * Ember::Singleton<Ember::OgreView::Lod::LodManager>::ms_Singleton = 0;
@@ -39,13 +55,61 @@ namespace OgreView
 namespace Lod
 {
 
-LodManager::LodManager()
+namespace
 {
+const char LOD_CACHE_MAGIC[4] = { 'E', 'L', 'O', 'D' };
+const uint32_t LOD_CACHE_VERSION = 1;
+
+void hashBytes(unsigned long long& hash, const void* data, size_t size)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
 }
 
-LodManager::~LodManager()
+void writeString(std::ostream& stream, const std::string& value)
+{
+	uint32_t size = static_cast<uint32_t>(value.size());
+	stream.write(reinterpret_cast<const char*>(&size), sizeof(size));
+	stream.write(value.data(), size);
+}
+
+bool readString(std::istream& stream, std::string& value)
+{
+	uint32_t size = 0;
+	stream.read(reinterpret_cast<char*>(&size), sizeof(size));
+	//Guard against corrupt files.
+	if (!stream || size > 65536) {
+		return false;
+	}
+	value.resize(size);
+	if (size) {
+		stream.read(&value[0], size);
+	}
+	return static_cast<bool>(stream);
+}
+
+/**
+ * @brief The index data of one Lod level of a submesh.
+ */
+struct CachedFaceList
 {
+	bool use32BitIndices;
+	uint32_t indexCount;
+	std::vector<char> indices;
+};
+}
 
+LodManager::LodManager(const std::string& cacheDirectory) :
+	mCacheDirectory(cacheDirectory)
+{
+}
+
+LodManager::~LodManager()
+{
+	mLodInjectedConnection.disconnect();
 }
 
 void LodManager::loadLod(Ogre::MeshPtr mesh)
@@ -60,16 +124,14 @@ void LodManager::loadLod(Ogre::MeshPtr mesh)
 	} catch (const Ogre::FileNotFoundException& ex) {
 		// Exception is thrown if a mesh hasn't got a loddef.
 		// By default, use the automatic mesh lod management system.
-		Ogre::QueuedProgressiveMeshGenerator pm;
-		pm.generateAutoconfiguredLodLevels(mesh);
+		generateAutoconfiguredLod(mesh);
 	}
 }
 
 void LodManager::loadLod(Ogre::MeshPtr mesh, const LodDefinition& def)
 {
 	if (def.getUseAutomaticLod()) {
-		Ogre::QueuedProgressiveMeshGenerator pm;
-		pm.generateAutoconfiguredLodLevels(mesh);
+		generateAutoconfiguredLod(mesh);
 	} else if (def.getLodDistanceCount() == 0) {
 		mesh->removeLodLevels();
 		return;
@@ -94,12 +156,7 @@ void LodManager::loadLod(Ogre::MeshPtr mesh, const LodDefinition& def)
 			} else {
 				loadAutomaticLodImpl(data.rbegin(), data.rend(), lodConfig);
 			}
-			// Uncomment the ProgressiveMesh of your choice.
-			// NOTE: OgreProgressiveMeshExt doesn't support collapse cost based reduction.
-			// OgreProgressiveMeshExt pm;
-			// ProgressiveMeshGenerator pm;
-			Ogre::QueuedProgressiveMeshGenerator pm;
-			pm.generateLodLevels(lodConfig);
+			generateLod(lodConfig);
 		} else {
 			// User created Lod
 
@@ -132,6 +189,279 @@ std::string LodManager::convertMeshNameToLodName(std::string meshName)
 	return meshName;
 }
 
+void LodManager::generateAutoconfiguredLod(Ogre::MeshPtr mesh)
+{
+	//Get the automatic configuration up front, so that it's cached in the same way as any other configuration.
+	Ogre::LodConfig lodConfig;
+	Ogre::QueuedProgressiveMeshGenerator pm;
+	pm.getAutoconfig(mesh, lodConfig);
+	generateLod(lodConfig);
+}
+
+std::string LodManager::calculateSettingsKey(const Ogre::LodConfig& lodConfig)
+{
+	std::stringstream ss;
+	ss << lodConfig.strategy->getName();
+	for (auto& level : lodConfig.levels) {
+		ss << ";" << level.distance << ":" << level.reductionMethod << ":" << level.reductionValue;
+	}
+	return ss.str();
+}
+
+void LodManager::generateLod(Ogre::LodConfig& lodConfig)
+{
+	if (useCache(lodConfig.mesh, calculateSettingsKey(lodConfig))) {
+		return;
+	}
+	// Uncomment the ProgressiveMesh of your choice.
+	// NOTE: OgreProgressiveMeshExt doesn't support collapse cost based reduction.
+	// OgreProgressiveMeshExt pm;
+	// ProgressiveMeshGenerator pm;
+	Ogre::QueuedProgressiveMeshGenerator pm;
+	pm.generateLodLevels(lodConfig);
+}
+
+bool LodManager::useCache(Ogre::MeshPtr mesh, const std::string& settingsKey)
+{
+	if (mCacheDirectory.empty()) {
+		return false;
+	}
+	std::string contentHash = calculateContentHash(*mesh);
+	if (contentHash.empty()) {
+		return false;
+	}
+
+	CacheEntry entry;
+	entry.meshName = mesh->getName();
+	entry.settingsKey = settingsKey;
+	entry.key = entry.meshName + "\n" + contentHash + "\n" + settingsKey;
+
+	//Use one file per mesh, so that stale entries are overwritten instead of accumulating.
+	std::string fileName = entry.meshName;
+	for (char& character : fileName) {
+		if (!isalnum(static_cast<unsigned char>(character)) && character != '.' && character != '-' && character != '_') {
+			character = '_';
+		}
+	}
+	entry.path = mCacheDirectory + fileName + ".lodcache";
+
+	if (loadCachedLod(*mesh, entry)) {
+		S_LOG_VERBOSE("Loaded Lod levels for mesh '" << entry.meshName << "' from the cache.");
+		return true;
+	}
+
+	//The levels are generated in a background thread, and written to the cache once injected into the mesh.
+	if (!mLodInjectedConnection.connected() && PMInjectorSignaler::hasInstance()) {
+		mLodInjectedConnection = PMInjectorSignaler::getSingleton().LodInjected.connect(sigc::mem_fun(*this, &LodManager::PMInjector_LodInjected));
+	}
+	//If Lod levels already are being generated for the mesh with other settings, only the latest ones are cached.
+	mPendingCacheEntries[mesh.get()] = entry;
+	return false;
+}
+
+std::string LodManager::calculateContentHash(const Ogre::Mesh& mesh) const
+{
+	try {
+		Ogre::DataStreamPtr stream = Ogre::ResourceGroupManager::getSingleton().openResource(mesh.getName(), mesh.getGroup(), true, const_cast<Ogre::Mesh*>(&mesh));
+		if (stream.isNull()) {
+			return "";
+		}
+		unsigned long long hash = 14695981039346656037ULL;
+		char buffer[65536];
+		while (!stream->eof()) {
+			size_t read = stream->read(buffer, sizeof(buffer));
+			if (read == 0) {
+				break;
+			}
+			hashBytes(hash, buffer, read);
+		}
+		std::stringstream ss;
+		ss << std::hex << hash << "-" << stream->size();
+		return ss.str();
+	} catch (const Ogre::Exception&) {
+		//Manually created meshes have no file.
+		return "";
+	}
+}
+
+bool LodManager::loadCachedLod(Ogre::Mesh& mesh, const CacheEntry& entry)
+{
+	std::ifstream stream(entry.path.c_str(), std::ios::binary);
+	if (!stream) {
+		return false;
+	}
+
+	char magic[4];
+	uint32_t version = 0;
+	stream.read(magic, 4);
+	stream.read(reinterpret_cast<char*>(&version), sizeof(version));
+	std::string key;
+	if (!stream || memcmp(magic, LOD_CACHE_MAGIC, 4) != 0 || version != LOD_CACHE_VERSION || !readString(stream, key) || key != entry.key) {
+		return false;
+	}
+
+	std::string strategyName;
+	uint16_t numLevels = 0;
+	uint16_t numSubMeshes = 0;
+	if (!readString(stream, strategyName)) {
+		return false;
+	}
+	stream.read(reinterpret_cast<char*>(&numLevels), sizeof(numLevels));
+	stream.read(reinterpret_cast<char*>(&numSubMeshes), sizeof(numSubMeshes));
+	if (!stream || numLevels < 2 || numSubMeshes != mesh.getNumSubMeshes()) {
+		return false;
+	}
+	Ogre::LodStrategy* strategy = Ogre::LodStrategyManager::getSingleton().getStrategy(strategyName);
+	if (!strategy) {
+		return false;
+	}
+
+	std::vector<Ogre::Real> userValues(numLevels - 1);
+	for (auto& userValue : userValues) {
+		float value;
+		stream.read(reinterpret_cast<char*>(&value), sizeof(value));
+		userValue = value;
+	}
+
+	//Read everything before touching the mesh, so that a truncated file leaves the mesh untouched.
+	std::vector<CachedFaceList> faceLists(numSubMeshes * (numLevels - 1));
+	for (auto& faceList : faceLists) {
+		uint32_t use32BitIndices = 0;
+		stream.read(reinterpret_cast<char*>(&use32BitIndices), sizeof(use32BitIndices));
+		stream.read(reinterpret_cast<char*>(&faceList.indexCount), sizeof(faceList.indexCount));
+		if (!stream || faceList.indexCount > 0x10000000) {
+			return false;
+		}
+		faceList.use32BitIndices = use32BitIndices != 0;
+		faceList.indices.resize(faceList.indexCount * (faceList.use32BitIndices ? 4 : 2));
+		if (!faceList.indices.empty()) {
+			stream.read(faceList.indices.data(), faceList.indices.size());
+		}
+	}
+	if (!stream) {
+		return false;
+	}
+
+	try {
+		mesh.removeLodLevels();
+		mesh.setLodStrategy(strategy);
+		mesh._setLodInfo(numLevels);
+		for (uint16_t level = 1; level < numLevels; ++level) {
+			Ogre::MeshLodUsage usage;
+			usage.userValue = userValues[level - 1];
+			usage.value = strategy->transformUserValue(usage.userValue);
+			usage.edgeData = 0;
+			usage.manualMesh.setNull();
+			mesh._setLodUsage(level, usage);
+		}
+
+		for (uint16_t submesh = 0; submesh < numSubMeshes; ++submesh) {
+			for (uint16_t level = 1; level < numLevels; ++level) {
+				const CachedFaceList& faceList = faceLists[submesh * (numLevels - 1) + level - 1];
+				Ogre::IndexData* indexData = OGRE_NEW Ogre::IndexData();
+				indexData->indexStart = 0;
+				indexData->indexCount = faceList.indexCount;
+				if (faceList.indexCount) {
+					indexData->indexBuffer = Ogre::HardwareBufferManager::getSingleton().createIndexBuffer(faceList.use32BitIndices ? Ogre::HardwareIndexBuffer::IT_32BIT : Ogre::HardwareIndexBuffer::IT_16BIT, faceList.indexCount, mesh.getIndexBufferUsage(), mesh.isIndexBufferShadowed());
+					indexData->indexBuffer->writeData(0, faceList.indices.size(), faceList.indices.data(), true);
+				}
+				mesh._setSubMeshLodFaceList(submesh, level, indexData);
+			}
+		}
+	} catch (const Ogre::Exception& ex) {
+		S_LOG_WARNING("Could not load cached Lod levels for mesh '" << entry.meshName << "'." << ex);
+		mesh.removeLodLevels();
+		return false;
+	}
+	return true;
+}
+
+void LodManager::saveCachedLod(const Ogre::Mesh& mesh, const CacheEntry& entry)
+{
+	uint16_t numLevels = mesh.getNumLodLevels();
+	//Manual Lod levels refer to other meshes, which the cache can't represent.
+	if (numLevels < 2 || mesh.hasManualLodLevel()) {
+		return;
+	}
+	uint16_t numSubMeshes = mesh.getNumSubMeshes();
+
+	std::stringstream data;
+	try {
+		for (uint16_t submeshIndex = 0; submeshIndex < numSubMeshes; ++submeshIndex) {
+			const Ogre::SubMesh* submesh = mesh.getSubMesh(submeshIndex);
+			if (submesh->mLodFaceList.size() != static_cast<size_t>(numLevels - 1)) {
+				return;
+			}
+			for (const Ogre::IndexData* indexData : submesh->mLodFaceList) {
+				uint32_t indexCount = static_cast<uint32_t>(indexData->indexCount);
+				uint32_t use32BitIndices = 0;
+				if (indexCount && !indexData->indexBuffer.isNull()) {
+					use32BitIndices = indexData->indexBuffer->getType() == Ogre::HardwareIndexBuffer::IT_32BIT ? 1 : 0;
+				} else {
+					indexCount = 0;
+				}
+				data.write(reinterpret_cast<const char*>(&use32BitIndices), sizeof(use32BitIndices));
+				data.write(reinterpret_cast<const char*>(&indexCount), sizeof(indexCount));
+				if (indexCount) {
+					size_t indexSize = indexData->indexBuffer->getIndexSize();
+					const char* indices = static_cast<const char*>(indexData->indexBuffer->lock(indexData->indexStart * indexSize, indexCount * indexSize, Ogre::HardwareBuffer::HBL_READ_ONLY));
+					data.write(indices, indexCount * indexSize);
+					indexData->indexBuffer->unlock();
+				}
+			}
+		}
+	} catch (const Ogre::Exception& ex) {
+		S_LOG_WARNING("Could not read Lod levels of mesh '" << entry.meshName << "' for caching." << ex);
+		return;
+	}
+
+	//Write to a temporary file first, so that an interrupted write never leaves a corrupt cache entry.
+	std::string tempPath = entry.path + ".tmp";
+	{
+		std::ofstream stream(tempPath.c_str(), std::ios::binary | std::ios::trunc);
+		if (!stream) {
+			return;
+		}
+		stream.write(LOD_CACHE_MAGIC, 4);
+		stream.write(reinterpret_cast<const char*>(&LOD_CACHE_VERSION), sizeof(LOD_CACHE_VERSION));
+		writeString(stream, entry.key);
+		writeString(stream, mesh.getLodStrategy()->getName());
+		stream.write(reinterpret_cast<const char*>(&numLevels), sizeof(numLevels));
+		stream.write(reinterpret_cast<const char*>(&numSubMeshes), sizeof(numSubMeshes));
+		for (uint16_t level = 1; level < numLevels; ++level) {
+			float userValue = static_cast<float>(mesh.getLodLevel(level).userValue);
+			stream.write(reinterpret_cast<const char*>(&userValue), sizeof(userValue));
+		}
+		stream << data.rdbuf();
+		if (!stream) {
+			stream.close();
+			std::remove(tempPath.c_str());
+			return;
+		}
+	}
+	std::remove(entry.path.c_str());
+	if (std::rename(tempPath.c_str(), entry.path.c_str()) != 0) {
+		std::remove(tempPath.c_str());
+	}
+}
+
+void LodManager::PMInjector_LodInjected(Ogre::LodConfig* lodConfig)
+{
+	auto I = mPendingCacheEntries.find(lodConfig->mesh.get());
+	if (I != mPendingCacheEntries.end()) {
+		//The mesh might have been destroyed and another one created at the same address.
+		if (I->second.meshName != lodConfig->mesh->getName()) {
+			mPendingCacheEntries.erase(I);
+			return;
+		}
+		//These might be the levels of an earlier request with other settings, in which case the entry is kept for the latest request.
+		if (I->second.settingsKey == calculateSettingsKey(*lodConfig)) {
+			saveCachedLod(*lodConfig->mesh, I->second);
+			mPendingCacheEntries.erase(I);
+		}
+	}
+}
+
 template<typename T>
 void LodManager::loadAutomaticLodImpl(T it, T itEnd, Ogre::LodConfig& lodConfig)
 {
@@ -28,7 +28,10 @@
 #include "components/ogre/EmberOgrePrerequisites.h"
 #include "framework/Singleton.h"
 
+#include <sigc++/connection.h>
+
 #include <string>
+#include <map>
 
 namespace Ember
 {
@@ -47,8 +50,10 @@ public:
 
 	/**
 	 * @brief Ctor.
+	 * @param cacheDirectory A directory, including a trailing slash, in which generated Lod levels are cached between sessions.
+	 * An empty string disables the cache.
 	 */
-	LodManager();
+	LodManager(const std::string& cacheDirectory = "");
 
 	/**
 	 * @brief Dtor.
@@ -74,6 +79,84 @@ public:
 
 private:
 
+	/**
+	 * @brief Identifies the cached Lod levels for a mesh.
+	 */
+	struct CacheEntry
+	{
+		/**
+		 * @brief The name of the mesh.
+		 */
+		std::string meshName;
+
+		/**
+		 * @brief The path of the cache file.
+		 */
+		std::string path;
+
+		/**
+		 * @brief A description of the Lod settings the levels are generated with.
+		 */
+		std::string settingsKey;
+
+		/**
+		 * @brief A key made up of the mesh name, a hash of the mesh file and the Lod settings.
+		 *
+		 * The cached data is only used if the stored key matches.
+		 */
+		std::string key;
+	};
+
+	/**
+	 * @brief The directory in which generated Lod levels are cached.
+	 */
+	std::string mCacheDirectory;
+
+	/**
+	 * @brief Meshes for which Lod levels are being generated, and which should be cached when done.
+	 */
+	std::map<const Ogre::Mesh*, CacheEntry> mPendingCacheEntries;
+
+	sigc::connection mLodInjectedConnection;
+
+	/**
+	 * @brief Generates Lod levels with the automatic configuration, or loads them from the cache.
+	 */
+	void generateAutoconfiguredLod(Ogre::MeshPtr mesh);
+
+	/**
+	 * @brief Generates Lod levels for the configuration, or loads them from the cache.
+	 */
+	void generateLod(Ogre::LodConfig& lodConfig);
+
+	/**
+	 * @brief Describes the Lod settings of a configuration, for use as part of the cache key.
+	 */
+	static std::string calculateSettingsKey(const Ogre::LodConfig& lodConfig);
+
+	/**
+	 * @brief Loads cached Lod levels, or else prepares for the generated levels to be cached.
+	 * @param mesh The mesh.
+	 * @param settingsKey A description of the Lod settings.
+	 * @return True if the Lod levels were loaded from the cache.
+	 */
+	bool useCache(Ogre::MeshPtr mesh, const std::string& settingsKey);
+
+	/**
+	 * @brief Calculates a hash of the file the mesh was loaded from.
+	 * @return A hash as a hex string, or an empty string if the mesh wasn't loaded from a file.
+	 */
+	std::string calculateContentHash(const Ogre::Mesh& mesh) const;
+
+	bool loadCachedLod(Ogre::Mesh& mesh, const CacheEntry& entry);
+
+	void saveCachedLod(const Ogre::Mesh& mesh, const CacheEntry& entry);
+
+	/**
+	 * @brief Called when generated Lod levels have been added to a mesh.
+	 */
+	void PMInjector_LodInjected(Ogre::LodConfig* lodConfig);
+
 	template<typename T>
 	void loadUserLodImpl(T it, T itEnd, Ogre::Mesh* mesh);
 	template<typename T>
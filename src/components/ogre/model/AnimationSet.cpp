@@ -34,6 +34,33 @@ namespace OgreView
 namespace Model
 {
 
+namespace
+{
+//Blend weights below this don't make any visible difference.
+const Ogre::Real NEGLIGIBLE_WEIGHT = 0.001f;
+
+/**
+ * @brief Checks if a part wouldn't make any visible difference if enabled.
+ * @param part An animation part.
+ * @return True if the weight of the part, or of all of its bone groups, is negligible.
+ */
+bool isNegligible(const AnimationPart& part)
+{
+	if (part.state->getWeight() < NEGLIGIBLE_WEIGHT) {
+		return true;
+	}
+	if (part.boneGroupRefs.empty()) {
+		return false;
+	}
+	for (const BoneGroupRef& boneGroupRef : part.boneGroupRefs) {
+		if (boneGroupRef.weight >= NEGLIGIBLE_WEIGHT) {
+			return false;
+		}
+	}
+	return true;
+}
+}
+
 AnimationSet::AnimationSet() :
 		mAccumulatedTime(0), mCurrentAnimationSetIndex(0), mSpeed(1.0)
 {
@@ -41,7 +68,8 @@ AnimationSet::AnimationSet() :
 
 void AnimationSet::addTime(Ogre::Real timeSlice)
 {
-	static bool discardThis;
+	//Not static, since animations can be updated from multiple threads.
+	bool discardThis;
 	addTime(timeSlice, discardThis);
 }
 
@@ -147,10 +175,12 @@ void Animation::setEnabled(bool enabled)
 		//we'll get an assert error if we try to enable an animation with zero length
 		Ogre::AnimationState* state = I->state;
 		if (state->getLength() != 0) {
-			if (state->getEnabled() != enabled) {
-				state->setEnabled(enabled);
+			//Parts which won't make any visible difference are kept disabled, so that they aren't blended into the skeleton.
+			bool partEnabled = enabled && !isNegligible(*I);
+			if (state->getEnabled() != partEnabled) {
+				state->setEnabled(partEnabled);
 				state->destroyBlendMask();
-				if (enabled) {
+				if (partEnabled) {
 					const std::vector<BoneGroupRef>& boneGroupRefs = I->boneGroupRefs;
 					for (std::vector<BoneGroupRef>::const_iterator J = boneGroupRefs.begin(); J != boneGroupRefs.end(); ++J) {
 						const BoneGroupRef& boneGroupRef = *J;
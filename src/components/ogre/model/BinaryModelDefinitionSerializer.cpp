@@ -0,0 +1,483 @@
+/*
+ Copyright (C) 2014 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "BinaryModelDefinitionSerializer.h"
+#include "ModelDefinition.h"
+
+#include <cstring>
+#include <cstdint>
+
+namespace Ember
+{
+namespace OgreView
+{
+namespace Model
+{
+
+const unsigned int BinaryModelDefinitionSerializer::VERSION = 1;
+
+namespace
+{
+
+/**
+ * @brief Appends values to a buffer.
+ */
+class Writer
+{
+public:
+	explicit Writer(std::string& buffer) :
+			mBuffer(buffer)
+	{
+	}
+
+	template<typename T>
+	void write(T value)
+	{
+		mBuffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	void writeBool(bool value)
+	{
+		write<uint8_t>(value ? 1 : 0);
+	}
+
+	void writeCount(size_t count)
+	{
+		write<uint32_t>(static_cast<uint32_t>(count));
+	}
+
+	void writeString(const std::string& value)
+	{
+		writeCount(value.size());
+		mBuffer.append(value);
+	}
+
+	void writeVector(const Ogre::Vector3& value)
+	{
+		write<float>(value.x);
+		write<float>(value.y);
+		write<float>(value.z);
+	}
+
+	void writeQuaternion(const Ogre::Quaternion& value)
+	{
+		write<float>(value.w);
+		write<float>(value.x);
+		write<float>(value.y);
+		write<float>(value.z);
+	}
+
+	void writeColour(const Ogre::ColourValue& value)
+	{
+		write<float>(value.r);
+		write<float>(value.g);
+		write<float>(value.b);
+		write<float>(value.a);
+	}
+
+private:
+	std::string& mBuffer;
+};
+
+/**
+ * @brief Reads values from a buffer.
+ *
+ * Reading past the end of the buffer sets the failed flag and returns zeroed values, so that callers only need to check for failure once at the end.
+ */
+class Reader
+{
+public:
+	explicit Reader(const std::string& buffer) :
+			mBuffer(buffer), mPosition(0), mFailed(false)
+	{
+	}
+
+	template<typename T>
+	T read()
+	{
+		T value = T();
+		if (mFailed || mPosition + sizeof(T) > mBuffer.size()) {
+			mFailed = true;
+			return value;
+		}
+		memcpy(&value, mBuffer.data() + mPosition, sizeof(T));
+		mPosition += sizeof(T);
+		return value;
+	}
+
+	bool readBool()
+	{
+		return read<uint8_t>() != 0;
+	}
+
+	/**
+	 * @brief Reads the number of elements in a collection.
+	 *
+	 * Since each element takes at least one byte, counts larger than the remaining data means that the data is corrupt.
+	 */
+	size_t readCount()
+	{
+		uint32_t count = read<uint32_t>();
+		if (count > mBuffer.size() - mPosition) {
+			mFailed = true;
+			return 0;
+		}
+		return count;
+	}
+
+	std::string readString()
+	{
+		size_t size = readCount();
+		if (mFailed) {
+			return "";
+		}
+		std::string value(mBuffer, mPosition, size);
+		mPosition += size;
+		return value;
+	}
+
+	Ogre::Vector3 readVector()
+	{
+		float x = read<float>();
+		float y = read<float>();
+		float z = read<float>();
+		return Ogre::Vector3(x, y, z);
+	}
+
+	Ogre::Quaternion readQuaternion()
+	{
+		float w = read<float>();
+		float x = read<float>();
+		float y = read<float>();
+		float z = read<float>();
+		return Ogre::Quaternion(w, x, y, z);
+	}
+
+	Ogre::ColourValue readColour()
+	{
+		float r = read<float>();
+		float g = read<float>();
+		float b = read<float>();
+		float a = read<float>();
+		return Ogre::ColourValue(r, g, b, a);
+	}
+
+	bool isValid() const
+	{
+		return !mFailed && mPosition == mBuffer.size();
+	}
+
+	bool hasFailed() const
+	{
+		return mFailed;
+	}
+
+private:
+	const std::string& mBuffer;
+	size_t mPosition;
+	bool mFailed;
+};
+
+}
+
+std::string BinaryModelDefinitionSerializer::serialize(const ModelDefinition& modelDef) const
+{
+	std::string buffer;
+	Writer writer(buffer);
+
+	writer.write<float>(modelDef.mScale);
+	writer.writeBool(modelDef.mShowContained);
+	writer.write<int32_t>(modelDef.mUseScaleOf);
+	writer.write<float>(modelDef.mRenderingDistance);
+	writer.writeString(modelDef.mIconPath);
+	writer.writeVector(modelDef.mTranslate);
+	writer.writeQuaternion(modelDef.mRotation);
+	writer.writeVector(modelDef.mContentOffset);
+
+	writer.writeCount(modelDef.mSubModels.size());
+	for (const SubModelDefinition* subModelDef : modelDef.mSubModels) {
+		writer.writeString(subModelDef->getMeshName());
+		writer.writeCount(subModelDef->getPartDefinitions().size());
+		for (const PartDefinition* partDef : subModelDef->getPartDefinitions()) {
+			writer.writeString(partDef->getName());
+			writer.writeBool(partDef->getShow());
+			writer.writeString(partDef->getGroup());
+			writer.writeCount(partDef->getSubEntityDefinitions().size());
+			for (const SubEntityDefinition* subEntityDef : partDef->getSubEntityDefinitions()) {
+				//Sub entities are referred to either by name or, if there's no name, by index.
+				writer.writeString(subEntityDef->getSubEntityName());
+				writer.write<uint32_t>(subEntityDef->getSubEntityIndex());
+				writer.writeString(subEntityDef->getMaterialName());
+			}
+		}
+	}
+
+	writer.writeCount(modelDef.mActions.size());
+	for (const ActionDefinition* actionDef : modelDef.mActions) {
+		writer.writeString(actionDef->getName());
+		writer.write<float>(actionDef->getAnimationSpeed());
+		writer.writeCount(actionDef->getAnimationDefinitions().size());
+		for (const AnimationDefinition* animDef : actionDef->getAnimationDefinitions()) {
+			writer.write<int32_t>(animDef->getIterations());
+			writer.writeCount(animDef->getAnimationPartDefinitions().size());
+			for (const AnimationPartDefinition* animPartDef : animDef->getAnimationPartDefinitions()) {
+				writer.writeString(animPartDef->Name);
+				writer.writeCount(animPartDef->BoneGroupRefs.size());
+				for (const BoneGroupRefDefinition& boneGroupRef : animPartDef->BoneGroupRefs) {
+					writer.writeString(boneGroupRef.Name);
+					writer.write<float>(boneGroupRef.Weight);
+				}
+			}
+		}
+		writer.writeCount(actionDef->getSoundDefinitions().size());
+		for (const SoundDefinition* soundDef : actionDef->getSoundDefinitions()) {
+			writer.writeString(soundDef->groupName);
+			writer.write<uint32_t>(soundDef->playOrder);
+		}
+		writer.writeCount(actionDef->getActivationDefinitions().size());
+		for (const ActivationDefinition* activationDef : actionDef->getActivationDefinitions()) {
+			writer.write<int32_t>(activationDef->type);
+			writer.writeString(activationDef->trigger);
+		}
+	}
+
+	writer.writeCount(modelDef.mAttachPoints.size());
+	for (const AttachPointDefinition& attachPointDef : modelDef.mAttachPoints) {
+		writer.writeString(attachPointDef.Name);
+		writer.writeString(attachPointDef.BoneName);
+		writer.writeString(attachPointDef.Pose);
+		writer.writeQuaternion(attachPointDef.Rotation);
+		writer.writeVector(attachPointDef.Translation);
+	}
+
+	writer.writeCount(modelDef.mParticleSystems.size());
+	for (const ModelDefinition::ParticleSystemDefinition& particleSystemDef : modelDef.mParticleSystems) {
+		writer.writeString(particleSystemDef.Script);
+		writer.writeVector(particleSystemDef.Direction);
+		writer.writeCount(particleSystemDef.Bindings.size());
+		for (const ModelDefinition::BindingDefinition& binding : particleSystemDef.Bindings) {
+			writer.writeString(binding.EmitterVar);
+			writer.writeString(binding.AtlasAttribute);
+		}
+	}
+
+	writer.writeCount(modelDef.mViews.size());
+	for (const ViewDefinitionStore::value_type& entry : modelDef.mViews) {
+		writer.writeString(entry.second->Name);
+		writer.writeQuaternion(entry.second->Rotation);
+		writer.write<float>(entry.second->Distance);
+	}
+
+	writer.writeBool(modelDef.mRenderingDef != nullptr);
+	if (modelDef.mRenderingDef) {
+		writer.writeString(modelDef.mRenderingDef->getScheme());
+		writer.writeCount(modelDef.mRenderingDef->getParameters().size());
+		for (const StringParamStore::value_type& entry : modelDef.mRenderingDef->getParameters()) {
+			writer.writeString(entry.first);
+			writer.writeString(entry.second);
+		}
+	}
+
+	writer.writeCount(modelDef.mLights.size());
+	for (const ModelDefinition::LightDefinition& lightDef : modelDef.mLights) {
+		writer.write<int32_t>(lightDef.type);
+		writer.writeColour(lightDef.diffuseColour);
+		writer.writeColour(lightDef.specularColour);
+		writer.write<float>(lightDef.range);
+		writer.write<float>(lightDef.constant);
+		writer.write<float>(lightDef.linear);
+		writer.write<float>(lightDef.quadratic);
+		writer.writeVector(lightDef.position);
+	}
+
+	writer.writeCount(modelDef.mBoneGroups.size());
+	for (const BoneGroupDefinitionStore::value_type& entry : modelDef.mBoneGroups) {
+		writer.writeString(entry.second->Name);
+		writer.writeCount(entry.second->Bones.size());
+		for (size_t bone : entry.second->Bones) {
+			writer.write<uint32_t>(static_cast<uint32_t>(bone));
+		}
+	}
+
+	writer.writeCount(modelDef.mPoseDefinitions.size());
+	for (const PoseDefinitionStore::value_type& entry : modelDef.mPoseDefinitions) {
+		writer.writeString(entry.first);
+		writer.writeQuaternion(entry.second.Rotate);
+		writer.writeVector(entry.second.Translate);
+		writer.writeBool(entry.second.IgnoreEntityData);
+	}
+
+	return buffer;
+}
+
+bool BinaryModelDefinitionSerializer::deserialize(ModelDefinition& modelDef, const std::string& data) const
+{
+	Reader reader(data);
+
+	modelDef.mScale = reader.read<float>();
+	modelDef.mShowContained = reader.readBool();
+	modelDef.mUseScaleOf = static_cast<ModelDefinition::UseScaleOf>(reader.read<int32_t>());
+	modelDef.mRenderingDistance = reader.read<float>();
+	modelDef.mIconPath = reader.readString();
+	modelDef.mTranslate = reader.readVector();
+	modelDef.mRotation = reader.readQuaternion();
+	modelDef.mContentOffset = reader.readVector();
+
+	size_t subModelCount = reader.readCount();
+	for (size_t i = 0; i < subModelCount && !reader.hasFailed(); ++i) {
+		SubModelDefinition* subModelDef = modelDef.createSubModelDefinition(reader.readString());
+		size_t partCount = reader.readCount();
+		for (size_t j = 0; j < partCount && !reader.hasFailed(); ++j) {
+			PartDefinition* partDef = subModelDef->createPartDefinition(reader.readString());
+			partDef->setShow(reader.readBool());
+			partDef->setGroup(reader.readString());
+			size_t subEntityCount = reader.readCount();
+			for (size_t k = 0; k < subEntityCount && !reader.hasFailed(); ++k) {
+				std::string subEntityName = reader.readString();
+				unsigned int subEntityIndex = reader.read<uint32_t>();
+				SubEntityDefinition* subEntityDef;
+				if (subEntityName.empty()) {
+					subEntityDef = partDef->createSubEntityDefinition(subEntityIndex);
+				} else {
+					subEntityDef = partDef->createSubEntityDefinition(subEntityName);
+				}
+				subEntityDef->setMaterialName(reader.readString());
+			}
+		}
+	}
+
+	size_t actionCount = reader.readCount();
+	for (size_t i = 0; i < actionCount && !reader.hasFailed(); ++i) {
+		ActionDefinition* actionDef = modelDef.createActionDefinition(reader.readString());
+		actionDef->setAnimationSpeed(reader.read<float>());
+		size_t animationCount = reader.readCount();
+		for (size_t j = 0; j < animationCount && !reader.hasFailed(); ++j) {
+			AnimationDefinition* animDef = actionDef->createAnimationDefinition(reader.read<int32_t>());
+			size_t animationPartCount = reader.readCount();
+			for (size_t k = 0; k < animationPartCount && !reader.hasFailed(); ++k) {
+				AnimationPartDefinition* animPartDef = animDef->createAnimationPartDefinition(reader.readString());
+				size_t boneGroupRefCount = reader.readCount();
+				for (size_t l = 0; l < boneGroupRefCount && !reader.hasFailed(); ++l) {
+					BoneGroupRefDefinition boneGroupRef;
+					boneGroupRef.Name = reader.readString();
+					boneGroupRef.Weight = reader.read<float>();
+					animPartDef->BoneGroupRefs.push_back(boneGroupRef);
+				}
+			}
+		}
+		size_t soundCount = reader.readCount();
+		for (size_t j = 0; j < soundCount && !reader.hasFailed(); ++j) {
+			std::string groupName = reader.readString();
+			unsigned int playOrder = reader.read<uint32_t>();
+			actionDef->createSoundDefinition(groupName, playOrder);
+		}
+		size_t activationCount = reader.readCount();
+		for (size_t j = 0; j < activationCount && !reader.hasFailed(); ++j) {
+			ActivationDefinition::Type type = static_cast<ActivationDefinition::Type>(reader.read<int32_t>());
+			std::string trigger = reader.readString();
+			actionDef->createActivationDefinition(type, trigger);
+		}
+	}
+
+	size_t attachPointCount = reader.readCount();
+	for (size_t i = 0; i < attachPointCount && !reader.hasFailed(); ++i) {
+		AttachPointDefinition attachPointDef;
+		attachPointDef.Name = reader.readString();
+		attachPointDef.BoneName = reader.readString();
+		attachPointDef.Pose = reader.readString();
+		attachPointDef.Rotation = reader.readQuaternion();
+		attachPointDef.Translation = reader.readVector();
+		modelDef.mAttachPoints.push_back(attachPointDef);
+	}
+
+	size_t particleSystemCount = reader.readCount();
+	for (size_t i = 0; i < particleSystemCount && !reader.hasFailed(); ++i) {
+		ModelDefinition::ParticleSystemDefinition particleSystemDef;
+		particleSystemDef.Script = reader.readString();
+		particleSystemDef.Direction = reader.readVector();
+		size_t bindingCount = reader.readCount();
+		for (size_t j = 0; j < bindingCount && !reader.hasFailed(); ++j) {
+			ModelDefinition::BindingDefinition binding;
+			binding.EmitterVar = reader.readString();
+			binding.AtlasAttribute = reader.readString();
+			particleSystemDef.Bindings.push_back(binding);
+		}
+		modelDef.mParticleSystems.push_back(particleSystemDef);
+	}
+
+	size_t viewCount = reader.readCount();
+	for (size_t i = 0; i < viewCount && !reader.hasFailed(); ++i) {
+		ViewDefinition* viewDef = modelDef.createViewDefinition(reader.readString());
+		viewDef->Rotation = reader.readQuaternion();
+		viewDef->Distance = reader.read<float>();
+	}
+
+	if (reader.readBool()) {
+		modelDef.mRenderingDef = new RenderingDefinition();
+		modelDef.mRenderingDef->setScheme(reader.readString());
+		size_t paramCount = reader.readCount();
+		for (size_t i = 0; i < paramCount && !reader.hasFailed(); ++i) {
+			std::string key = reader.readString();
+			std::string value = reader.readString();
+			modelDef.mRenderingDef->mParams.insert(StringParamStore::value_type(key, value));
+		}
+	}
+
+	size_t lightCount = reader.readCount();
+	for (size_t i = 0; i < lightCount && !reader.hasFailed(); ++i) {
+		ModelDefinition::LightDefinition lightDef;
+		lightDef.type = static_cast<Ogre::Light::LightTypes>(reader.read<int32_t>());
+		lightDef.diffuseColour = reader.readColour();
+		lightDef.specularColour = reader.readColour();
+		lightDef.range = reader.read<float>();
+		lightDef.constant = reader.read<float>();
+		lightDef.linear = reader.read<float>();
+		lightDef.quadratic = reader.read<float>();
+		lightDef.position = reader.readVector();
+		modelDef.mLights.push_back(lightDef);
+	}
+
+	size_t boneGroupCount = reader.readCount();
+	for (size_t i = 0; i < boneGroupCount && !reader.hasFailed(); ++i) {
+		BoneGroupDefinition* boneGroupDef = modelDef.createBoneGroupDefinition(reader.readString());
+		size_t boneCount = reader.readCount();
+		for (size_t j = 0; j < boneCount && !reader.hasFailed(); ++j) {
+			boneGroupDef->Bones.push_back(reader.read<uint32_t>());
+		}
+	}
+
+	size_t poseCount = reader.readCount();
+	for (size_t i = 0; i < poseCount && !reader.hasFailed(); ++i) {
+		std::string name = reader.readString();
+		PoseDefinition poseDef;
+		poseDef.Rotate = reader.readQuaternion();
+		poseDef.Translate = reader.readVector();
+		poseDef.IgnoreEntityData = reader.readBool();
+		modelDef.mPoseDefinitions.insert(std::make_pair(name, poseDef));
+	}
+
+	return reader.isValid();
+}
+
+}
+}
+}
@@ -0,0 +1,68 @@
+/*
+ Copyright (C) 2014 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef BINARYMODELDEFINITIONSERIALIZER_H_
+#define BINARYMODELDEFINITIONSERIALIZER_H_
+
+#include <string>
+
+namespace Ember
+{
+namespace OgreView
+{
+namespace Model
+{
+
+class ModelDefinition;
+
+/**
+ * @brief Serializes model definitions to and from a compact binary form.
+ *
+ * This is used for caching definitions between sessions, so that the xml scripts don't need to be parsed at startup.
+ * The binary form is only meant to be read by the same version of Ember which wrote it; it's not meant for authoring.
+ */
+class BinaryModelDefinitionSerializer
+{
+public:
+
+	/**
+	 * @brief The version of the binary format. Increase this whenever the format changes.
+	 */
+	static const unsigned int VERSION;
+
+	/**
+	 * @brief Serializes a definition.
+	 * @param modelDef The definition.
+	 * @return The serialized data.
+	 */
+	std::string serialize(const ModelDefinition& modelDef) const;
+
+	/**
+	 * @brief Populates an empty definition from serialized data.
+	 * @param modelDef An empty definition.
+	 * @param data Serialized data.
+	 * @return True if the data could be read.
+	 */
+	bool deserialize(ModelDefinition& modelDef, const std::string& data) const;
+};
+
+}
+}
+}
+
+#endif /* BINARYMODELDEFINITIONSERIALIZER_H_ */
@@ -114,7 +114,7 @@ void Model::reload()
 	Reloaded.emit();
 }
 
-bool Model::create(const std::string& modelType, Eris::EventService& eventService)
+bool Model::create(const std::string& modelType, ModelBackgroundLoaderQueue& loaderQueue)
 {
 	if (!mDefinition.isNull() && mDefinition->isValid()) {
 		S_LOG_WARNING("Trying to call create('" + modelType + "') on a Model instance that already have been created as a '" + mDefinition->getName() + "'.");
@@ -135,7 +135,7 @@ bool Model::create(const std::string& modelType, Eris::EventService& eventServic
 	} else {
 #if OGRE_THREAD_SUPPORT
 		if (!mBackgroundLoader) {
-			mBackgroundLoader = std::make_shared<ModelBackgroundLoader>(this, eventService);
+			mBackgroundLoader = std::make_shared<ModelBackgroundLoader>(this, loaderQueue);
 		}
 #endif
 		mDefinition->addModelInstance(this);
@@ -1056,7 +1056,7 @@ const Model::AttachPointWrapperStore* Model::getAttachedPoints() const
 
 Ogre::String ModelFactory::FACTORY_TYPE_NAME = "Model";
 //-----------------------------------------------------------------------
-ModelFactory::ModelFactory(Eris::EventService& eventService) : mEventService(eventService)
+ModelFactory::ModelFactory(ModelBackgroundLoaderQueue& loaderQueue) : mLoaderQueue(loaderQueue)
 {
 
 }
@@ -1074,7 +1074,7 @@ Ogre::MovableObject* ModelFactory::createInstanceImpl(const Ogre::String& name,
 		auto ni = params->find("modeldefinition");
 		if (ni != params->end()) {
 			Model* model = new Model(name);
-			model->create(ni->second, mEventService);
+			model->create(ni->second, mLoaderQueue);
 			return model;
 		}
 
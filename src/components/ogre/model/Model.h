@@ -30,11 +30,6 @@
 #include <memory>
 #include <unordered_map>
 
-namespace Eris
-{
-class EventService;
-}
-
 namespace Ember
 {
 namespace OgreView
@@ -54,6 +49,7 @@ class ParticleSystem;
 class Action;
 class ModelPart;
 class ModelBackgroundLoader;
+class ModelBackgroundLoaderQueue;
 
 struct LightInfo
 {
@@ -331,9 +327,10 @@ protected:
 	 * Try to create the needed meshes from the specified modeldef.
 	 * Returns true if successful, else false.
 	 * @param modelType
+	 * @param loaderQueue The queue through which background loading is scheduled.
 	 * @return
 	 */
-	bool create(const std::string& modelType, Eris::EventService& eventService); // create model of specific type
+	bool create(const std::string& modelType, ModelBackgroundLoaderQueue& loaderQueue); // create model of specific type
 
 	bool createActualModel();
 
@@ -455,10 +452,10 @@ inline const Model::SubModelSet& Model::getSubmodels() const
 class ModelFactory: public Ogre::MovableObjectFactory
 {
 protected:
-	Eris::EventService& mEventService;
+	ModelBackgroundLoaderQueue& mLoaderQueue;
 	Ogre::MovableObject* createInstanceImpl(const Ogre::String& name, const Ogre::NameValuePairList* params);
 public:
-	ModelFactory(Eris::EventService& eventService);
+	ModelFactory(ModelBackgroundLoaderQueue& loaderQueue);
 	virtual ~ModelFactory()
 	{
 	}
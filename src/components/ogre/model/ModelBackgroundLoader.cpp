@@ -25,6 +25,7 @@
 #endif
 
 #include "ModelBackgroundLoader.h"
+#include "ModelBackgroundLoaderQueue.h"
 #include "Model.h"
 #include "framework/TimeFrame.h"
 #include "framework/LoggingInstance.h"
@@ -41,8 +42,6 @@
 #include <OgrePass.h>
 #include <OgreTextureUnitState.h>
 
-#include <Eris/EventService.h>
-
 namespace Ember
 {
 namespace OgreView
@@ -61,8 +60,8 @@ void ModelBackgroundLoaderListener::operationCompleted(Ogre::BackgroundProcessTi
 	mLoader.operationCompleted(ticket, result, this);
 }
 
-ModelBackgroundLoader::ModelBackgroundLoader(Model* model, Eris::EventService& eventService) :
-		mModel(model), mEventService(eventService), mState(LS_UNINITIALIZED), mListener(*this), mSubModelLoadingIndex(0)
+ModelBackgroundLoader::ModelBackgroundLoader(Model* model, ModelBackgroundLoaderQueue& queue) :
+		mModel(model), mQueue(queue), mIsScheduled(false), mIsActive(false), mState(LS_UNINITIALIZED), mListener(*this), mSubModelLoadingIndex(0)
 {
 }
 
@@ -71,26 +70,42 @@ ModelBackgroundLoader::~ModelBackgroundLoader()
 	for (auto& ticket : mTickets) {
 		Ogre::ResourceBackgroundQueue::getSingleton().abortRequest(ticket);
 	}
+	deactivate();
 }
 
 bool ModelBackgroundLoader::poll()
 {
-	bool result = performLoading();
-	if (result) {
+	if (mState == LS_DONE) {
 		return true;
-	} else {
-		if (areAllTicketsProcessed()) {
-			auto self = this->shared_from_this();
-			mEventService.runOnMainThread([this, self]() {
-				if (this->mModel) {
-					bool result = this->poll();
-					if (result) {
-						this->reloadModel();
-					}
-				}
-			});
-		}
-		return false;
+	}
+	if (areAllTicketsProcessed()) {
+		mQueue.schedule(shared_from_this());
+	}
+	return false;
+}
+
+void ModelBackgroundLoader::performStep()
+{
+	if (!mModel) {
+		return;
+	}
+	if (mState == LS_UNINITIALIZED && !mIsActive) {
+		mIsActive = true;
+		mQueue.loaderStarted();
+	}
+	if (performLoading()) {
+		deactivate();
+		reloadModel();
+	} else if (areAllTicketsProcessed()) {
+		mQueue.schedule(shared_from_this());
+	}
+}
+
+void ModelBackgroundLoader::deactivate()
+{
+	if (mIsActive) {
+		mIsActive = false;
+		mQueue.loaderFinished();
 	}
 }
 
@@ -298,16 +313,8 @@ void ModelBackgroundLoader::operationCompleted(Ogre::BackgroundProcessTicket tic
 	auto I = mTickets.find(ticket);
 	if (I != mTickets.end()) {
 		mTickets.erase(I);
-		if (mTickets.empty()) {
-			auto self = this->shared_from_this();
-			mEventService.runOnMainThread([this, self]() {
-				if (this->mModel) {
-					bool result = this->poll();
-					if (result) {
-						this->reloadModel();
-					}
-				}
-			});
+		if (mTickets.empty() && mModel) {
+			mQueue.schedule(shared_from_this());
 		}
 	}
 }
@@ -334,6 +341,7 @@ void ModelBackgroundLoader::detachFromModel()
 		Ogre::ResourceBackgroundQueue::getSingleton().abortRequest(ticket);
 	}
 	mTickets.clear();
+	deactivate();
 }
 
 void ModelBackgroundLoader::addTicket(Ogre::BackgroundProcessTicket ticket)
@@ -29,11 +29,6 @@
 
 #include <memory>
 
-namespace Eris
-{
-class EventService;
-}
-
 namespace Ember
 {
 class TimeFrame;
@@ -45,6 +40,7 @@ namespace Model
 
 class Model;
 class ModelBackgroundLoader;
+class ModelBackgroundLoaderQueue;
 
 /**
  * @brief A background loading listener attached to an instance ModelBackgroundLoader.
@@ -91,13 +87,15 @@ private:
 
 /**
  @brief Responsible for loading the resources needed by a Model.
- If thread support is enabled it will be used. You must then call poll() each frame to see if the background thread has finished loading.
+ If thread support is enabled it will be used.
+ The work performed in the main thread is scheduled through a ModelBackgroundLoaderQueue, which makes sure that models close to the camera are loaded first.
 
  @author Erik Hjortsberg <erik.hjortsberg@gmail.com>
  */
 class ModelBackgroundLoader : public std::enable_shared_from_this<ModelBackgroundLoader>
 {
 	friend class ModelBackgroundLoaderListener;
+	friend class ModelBackgroundLoaderQueue;
 public:
 	/**
 	 * @brief The different loading states of the Model.
@@ -155,8 +153,9 @@ public:
 	/**
 	 * @brief Ctor.
 	 * @param model The model which will be loaded.
+	 * @param queue The queue through which loading is scheduled.
 	 */
-	ModelBackgroundLoader(Model* model, Eris::EventService& eventService);
+	ModelBackgroundLoader(Model* model, ModelBackgroundLoaderQueue& queue);
 
 	/**
 	 * @brief Dtor.
@@ -164,12 +163,13 @@ public:
 	virtual ~ModelBackgroundLoader();
 
 	/**
-	 * @brief Starts the polling loop.
+	 * @brief Starts the loading, unless it's already complete.
 	 *
 	 * If the model isn't yet loaded, we're in either of two states.
 	 * We're either waiting for background loading tickets to complete. In this case nothing will be done. @see operationCompleted
 	 * Or we don't have any background tickets currently, but bailed out early in the loading process in order to allow for interleaving with the event loop.
-	 * In the latter case a new call to "poll" will be posted to the event loop.
+	 * In the latter case the loader will be scheduled with the queue, which will continue the loading when it's this loader's turn.
+	 * Once loading is complete the model will be reloaded.
 	 *
 	 * The result of this is that this method only should be called externally once.
 	 *
@@ -203,9 +203,19 @@ protected:
 	Model* mModel;
 
 	/**
-	 * @brief Handles event interleaving.
+	 * @brief Decides when the loader gets to perform work in the main thread.
+	 */
+	ModelBackgroundLoaderQueue& mQueue;
+
+	/**
+	 * @brief True if the loader is waiting in the queue.
+	 */
+	bool mIsScheduled;
+
+	/**
+	 * @brief True if loading has started but not yet completed.
 	 */
-	Eris::EventService& mEventService;
+	bool mIsActive;
 
 	/**
 	 * @brief The background loading tickets held by this instance.
@@ -277,6 +287,18 @@ protected:
 	 */
 	bool performLoading();
 
+	/**
+	 * @brief Performs loading in the main thread; called by the queue when it's this loader's turn.
+	 *
+	 * If loading isn't complete and there are no background tickets left to wait for, the loader is scheduled again.
+	 */
+	void performStep();
+
+	/**
+	 * @brief Notifies the queue that the loader no longer is active, if it was.
+	 */
+	void deactivate();
+
 };
 
 }
@@ -0,0 +1,190 @@
+/*
+ Copyright (C) 2014 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "ModelBackgroundLoaderQueue.h"
+#include "ModelBackgroundLoader.h"
+#include "Model.h"
+
+#include "framework/Time.h"
+
+#include <OgreCamera.h>
+#include <OgreSceneNode.h>
+#include <OgreSphere.h>
+
+#include <Eris/EventService.h>
+
+#include <limits>
+#include <algorithm>
+
+namespace Ember
+{
+namespace OgreView
+{
+namespace Model
+{
+
+ModelBackgroundLoaderQueue::ModelBackgroundLoaderQueue(Eris::EventService& eventService) :
+		mEventService(eventService), mCamera(nullptr), mMaxActiveLoaders(8), mActiveLoaderCount(0), mTimeSliceMilliseconds(2), mIsProcessingScheduled(false), mSelfReference(std::make_shared<ModelBackgroundLoaderQueue*>(this))
+{
+}
+
+ModelBackgroundLoaderQueue::~ModelBackgroundLoaderQueue()
+{
+	//Make sure that no processing is posted while the loaders are released.
+	mSelfReference.reset();
+	for (auto& loader : mLoaders) {
+		loader->mIsScheduled = false;
+	}
+	mLoaders.clear();
+}
+
+void ModelBackgroundLoaderQueue::setCamera(const Ogre::Camera* camera)
+{
+	mCamera = camera;
+}
+
+void ModelBackgroundLoaderQueue::setMaxActiveLoaders(size_t maxActiveLoaders)
+{
+	mMaxActiveLoaders = std::max<size_t>(1, maxActiveLoaders);
+	scheduleProcessing();
+}
+
+float ModelBackgroundLoaderQueue::calculatePriority(const Model& model) const
+{
+	const Ogre::Node* node = model.getParentNode();
+	if (!mCamera || !node || model._getManager() != mCamera->getSceneManager()) {
+		return std::numeric_limits<float>::max();
+	}
+
+	const Ogre::Vector3& position = node->_getDerivedPosition();
+	const Ogre::Vector3& scale = node->_getDerivedScale();
+	//The bounds aren't known until the meshes are loaded, so assume one meter for models not yet loaded.
+	Ogre::Real radius = std::max<Ogre::Real>(model.getBoundingRadius(), 1.0f) * std::max(scale.x, std::max(scale.y, scale.z));
+	Ogre::Real distance = std::max<Ogre::Real>(mCamera->getDerivedPosition().distance(position), 1.0f);
+
+	//The size on screen is roughly proportional to the radius divided by the distance.
+	float priority = radius / distance;
+	//Prefetch models out of view, but only after those in view.
+	if (!mCamera->isVisible(Ogre::Sphere(position, radius))) {
+		priority *= 0.01f;
+	}
+	return priority;
+}
+
+void ModelBackgroundLoaderQueue::schedule(std::shared_ptr<ModelBackgroundLoader> loader)
+{
+	if (!loader->mIsScheduled) {
+		loader->mIsScheduled = true;
+		mLoaders.push_back(loader);
+		scheduleProcessing();
+	}
+}
+
+void ModelBackgroundLoaderQueue::loaderStarted()
+{
+	mActiveLoaderCount++;
+}
+
+void ModelBackgroundLoaderQueue::loaderFinished()
+{
+	if (mActiveLoaderCount) {
+		mActiveLoaderCount--;
+	}
+	//There might be loaders waiting for a free slot.
+	if (!mLoaders.empty()) {
+		scheduleProcessing();
+	}
+}
+
+void ModelBackgroundLoaderQueue::scheduleProcessing()
+{
+	if (mIsProcessingScheduled || !mSelfReference) {
+		return;
+	}
+	mIsProcessingScheduled = true;
+	std::weak_ptr<ModelBackgroundLoaderQueue*> selfReference(mSelfReference);
+	mEventService.runOnMainThread([selfReference]() {
+		auto self = selfReference.lock();
+		if (self) {
+			(*self)->process();
+		}
+	});
+}
+
+void ModelBackgroundLoaderQueue::process()
+{
+	mIsProcessingScheduled = false;
+
+	long long endTime = Time::currentTimeMillis() + mTimeSliceMilliseconds;
+	do {
+		std::shared_ptr<ModelBackgroundLoader> loader = takeNext();
+		if (!loader) {
+			//Either the queue is empty, or the loaders left need to wait for active loaders to finish.
+			return;
+		}
+		loader->performStep();
+	} while (Time::currentTimeMillis() < endTime);
+
+	if (!mLoaders.empty()) {
+		scheduleProcessing();
+	}
+}
+
+std::shared_ptr<ModelBackgroundLoader> ModelBackgroundLoaderQueue::takeNext()
+{
+	//Loaders whose models have been destroyed have nothing left to do.
+	for (auto I = mLoaders.begin(); I != mLoaders.end();) {
+		if (!(*I)->mModel) {
+			(*I)->mIsScheduled = false;
+			I = mLoaders.erase(I);
+		} else {
+			++I;
+		}
+	}
+
+	bool canStart = mActiveLoaderCount < mMaxActiveLoaders;
+	size_t best = mLoaders.size();
+	float bestPriority = -1.0f;
+	for (size_t i = 0; i < mLoaders.size(); ++i) {
+		ModelBackgroundLoader& loader = *mLoaders[i];
+		if (loader.getState() != ModelBackgroundLoader::LS_UNINITIALIZED || canStart) {
+			float priority = calculatePriority(*loader.mModel);
+			//Prefer the earliest scheduled loader for equal priorities.
+			if (priority > bestPriority) {
+				bestPriority = priority;
+				best = i;
+			}
+		}
+	}
+
+	if (best == mLoaders.size()) {
+		return std::shared_ptr<ModelBackgroundLoader>();
+	}
+	std::shared_ptr<ModelBackgroundLoader> loader = mLoaders[best];
+	mLoaders.erase(mLoaders.begin() + best);
+	loader->mIsScheduled = false;
+	return loader;
+}
+
+}
+}
+}
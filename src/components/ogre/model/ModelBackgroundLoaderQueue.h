@@ -0,0 +1,169 @@
+/*
+ Copyright (C) 2014 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef EMBEROGRE_MODELBACKGROUNDLOADERQUEUE_H_
+#define EMBEROGRE_MODELBACKGROUNDLOADERQUEUE_H_
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+namespace Eris
+{
+class EventService;
+}
+
+namespace Ogre
+{
+class Camera;
+}
+
+namespace Ember
+{
+namespace OgreView
+{
+namespace Model
+{
+
+class Model;
+class ModelBackgroundLoader;
+
+/**
+ * @brief Decides in which order model background loaders get to perform their work in the main thread.
+ *
+ * Each time a loader has work to do in the main thread it's scheduled with the queue. The queue will then
+ * process the loaders with the highest priority first, where the priority is based on how large the model
+ * will appear on screen, as seen from the camera. Priorities are recalculated each time a loader is picked,
+ * so that they follow the camera as it moves.
+ *
+ * Only a limited number of loaders are allowed to be active at once. This makes sure that when many models are
+ * created at the same time, such as when entering a busy area, the background loading threads aren't swamped with
+ * requests for models far away before the ones close by get their turn.
+ *
+ * Models outside of the view are still loaded, but after those in view, so that they are ready once they come into view.
+ */
+class ModelBackgroundLoaderQueue
+{
+	friend class ModelBackgroundLoader;
+public:
+
+	/**
+	 * @brief Ctor.
+	 * @param eventService Used for performing work in the main thread.
+	 */
+	explicit ModelBackgroundLoaderQueue(Eris::EventService& eventService);
+
+	/**
+	 * @brief Dtor.
+	 */
+	~ModelBackgroundLoaderQueue();
+
+	/**
+	 * @brief Sets the camera used for prioritizing.
+	 * @param camera A camera, or null if models should be loaded in the order they are scheduled.
+	 */
+	void setCamera(const Ogre::Camera* camera);
+
+	/**
+	 * @brief Sets the max number of loaders which are allowed to be active at once.
+	 * @param maxActiveLoaders The max number of active loaders.
+	 */
+	void setMaxActiveLoaders(size_t maxActiveLoaders);
+
+	/**
+	 * @brief Calculates the loading priority of a model.
+	 *
+	 * Models not shown in the world, such as previews in the gui, get the highest priority since they are explicitly requested by the user.
+	 * @param model A model.
+	 * @return A priority, where a higher value means that the model should be loaded sooner.
+	 */
+	float calculatePriority(const Model& model) const;
+
+private:
+
+	Eris::EventService& mEventService;
+
+	const Ogre::Camera* mCamera;
+
+	/**
+	 * @brief Loaders waiting to perform work in the main thread.
+	 */
+	std::vector<std::shared_ptr<ModelBackgroundLoader>> mLoaders;
+
+	size_t mMaxActiveLoaders;
+
+	/**
+	 * @brief The number of loaders which have started but not yet completed loading.
+	 */
+	size_t mActiveLoaderCount;
+
+	/**
+	 * @brief The max time spent on loading each time the queue is processed.
+	 */
+	long long mTimeSliceMilliseconds;
+
+	/**
+	 * @brief True if processing of the queue has been posted to the main thread.
+	 */
+	bool mIsProcessingScheduled;
+
+	/**
+	 * @brief Used to detect if the queue has been destroyed when posted processing is run.
+	 */
+	std::shared_ptr<ModelBackgroundLoaderQueue*> mSelfReference;
+
+	/**
+	 * @brief Schedules a loader for performing work in the main thread.
+	 *
+	 * Scheduling a loader which already is scheduled does nothing.
+	 * @param loader A loader.
+	 */
+	void schedule(std::shared_ptr<ModelBackgroundLoader> loader);
+
+	/**
+	 * @brief Called by loaders when they start loading.
+	 */
+	void loaderStarted();
+
+	/**
+	 * @brief Called by started loaders when they have completed loading, or are detached from their models.
+	 */
+	void loaderFinished();
+
+	/**
+	 * @brief Posts processing of the queue to the main thread, unless it already has been posted.
+	 */
+	void scheduleProcessing();
+
+	/**
+	 * @brief Lets the loaders with the highest priority perform work, until the time slice is used up.
+	 */
+	void process();
+
+	/**
+	 * @brief Removes the loader with the highest priority which is allowed to run from the queue.
+	 * @return A loader, or null if there's none which is allowed to run.
+	 */
+	std::shared_ptr<ModelBackgroundLoader> takeNext();
+};
+
+}
+}
+}
+
+#endif /* EMBEROGRE_MODELBACKGROUNDLOADERQUEUE_H_ */
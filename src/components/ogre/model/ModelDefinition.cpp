@@ -30,6 +30,8 @@
 #include "Model.h"
 #include "SubModel.h"
 #include "SubModelPart.h"
+#include "BinaryModelDefinitionSerializer.h"
+#include "ModelDefinitionManager.h"
 
 namespace Ember
 {
@@ -69,6 +71,23 @@ ModelDefinition::~ModelDefinition()
 
 void ModelDefinition::loadImpl(void)
 {
+	if (!mSerializedData.empty()) {
+		BinaryModelDefinitionSerializer serializer;
+		if (serializer.deserialize(*this, mSerializedData)) {
+			setValid(true);
+		} else {
+			S_LOG_FAILURE("Could not read cached data for model definition '" << getName() << "'. The script '" << getOrigin() << "' will be parsed again next time.");
+			if (ModelDefinitionManager::hasInstance()) {
+				ModelDefinitionManager::getSingleton().invalidateCachedScript(getGroup(), getOrigin());
+			}
+		}
+		std::string().swap(mSerializedData);
+	}
+}
+
+void ModelDefinition::setSerializedData(const std::string& data)
+{
+	mSerializedData = data;
 }
 
 void ModelDefinition::addModelInstance(Model* model)
@@ -188,6 +207,39 @@ const RenderingDefinition* ModelDefinition::getRenderingDefinition() const
 	return mRenderingDef;
 }
 
+RenderingDefinition* ModelDefinition::createRenderingDefinition(const std::string& scheme)
+{
+	delete mRenderingDef;
+	mRenderingDef = new RenderingDefinition();
+	mRenderingDef->setScheme(scheme);
+	return mRenderingDef;
+}
+
+const ModelDefinition::ParticleSystemSet& ModelDefinition::getParticleSystemDefinitions() const
+{
+	return mParticleSystems;
+}
+
+void ModelDefinition::addParticleSystemDefinition(const ParticleSystemDefinition& definition)
+{
+	mParticleSystems.push_back(definition);
+}
+
+const ModelDefinition::LightSet& ModelDefinition::getLightDefinitions() const
+{
+	return mLights;
+}
+
+void ModelDefinition::addLightDefinition(const LightDefinition& definition)
+{
+	mLights.push_back(definition);
+}
+
+void ModelDefinition::setIconPath(const std::string& iconPath)
+{
+	mIconPath = iconPath;
+}
+
 void ModelDefinition::reloadAllInstances()
 {
 	for (ModelInstanceStore::iterator I = mModelInstances.begin(); I != mModelInstances.end(); ++I) {
@@ -544,6 +596,10 @@ const StringParamStore& RenderingDefinition::getParameters() const
 {
 	return mParams;
 }
+void RenderingDefinition::setParameter(const std::string& key, const std::string& value)
+{
+	mParams[key] = value;
+}
 
 }
 }
@@ -83,6 +83,7 @@ typedef std::map<std::string, BoneGroupDefinition*> BoneGroupDefinitionStore;
 class RenderingDefinition
 {
 	friend class XMLModelDefinitionSerializer;
+	friend class BinaryModelDefinitionSerializer;
 public:
 
 	/**
@@ -102,6 +103,13 @@ public:
 	 */
 	const StringParamStore& getParameters() const;
 
+	/**
+	 * Sets a parameter for the rendering scheme.
+	 * @param key The name of the parameter.
+	 * @param value The value of the parameter.
+	 */
+	void setParameter(const std::string& key, const std::string& value);
+
 private:
 	StringParamStore mParams;
 	std::string mScheme;
@@ -457,6 +465,7 @@ class ModelDefinition: public Ogre::Resource
 {
 
 	friend class XMLModelDefinitionSerializer;
+	friend class BinaryModelDefinitionSerializer;
 	friend class Model;
 
 public:
@@ -501,6 +510,14 @@ public:
 	bool isValid(void) const;
 	void setValid(bool valid);
 
+	/**
+	 * @brief Sets serialized data from which the definition will be populated when it's loaded.
+	 *
+	 * This is used for definitions read from the definition cache, so that they aren't deserialized until they're needed.
+	 * @param data Data written by BinaryModelDefinitionSerializer.
+	 */
+	void setSerializedData(const std::string& data);
+
 	//Ogre resource virtual functions
 	void loadImpl(void);
 
@@ -693,8 +710,9 @@ public:
 
 	void removePoseDefinition(const std::string& name);
 
-private:
-
+	/**
+	 * @brief A binding between an entity attribute and a parameter of a particle system.
+	 */
 	struct BindingDefinition
 	{
 		std::string EmitterVar;
@@ -734,6 +752,9 @@ private:
 
 	typedef std::vector<ParticleSystemDefinition> ParticleSystemSet;
 
+	/**
+	 * @brief A definition of a light attached to the model.
+	 */
 	struct LightDefinition
 	{
 		Ogre::Light::LightTypes type;
@@ -744,6 +765,45 @@ private:
 
 	typedef std::vector<LightDefinition> LightSet;
 
+	/**
+	 * @brief Gets all particle systems.
+	 * @return All particle systems.
+	 */
+	const ParticleSystemSet& getParticleSystemDefinitions() const;
+
+	/**
+	 * @brief Adds a particle system.
+	 * @param definition The definition of the particle system.
+	 */
+	void addParticleSystemDefinition(const ParticleSystemDefinition& definition);
+
+	/**
+	 * @brief Gets all lights.
+	 * @return All lights.
+	 */
+	const LightSet& getLightDefinitions() const;
+
+	/**
+	 * @brief Adds a light.
+	 * @param definition The definition of the light.
+	 */
+	void addLightDefinition(const LightDefinition& definition);
+
+	/**
+	 * @brief Sets a path to an icon resource.
+	 * @param iconPath A path to an image which can be used as an icon for the model.
+	 */
+	void setIconPath(const std::string& iconPath);
+
+	/**
+	 * @brief Creates a rendering scheme definition, replacing any existing one.
+	 * @param scheme The scheme.
+	 * @return A pointer to the new definition.
+	 */
+	RenderingDefinition* createRenderingDefinition(const std::string& scheme);
+
+private:
+
 	/**
 	 * @brief Adds a model instance to the internal store of instances. This method should be called from the class Model when a new Model is created.
 	 * @param
@@ -808,6 +868,11 @@ private:
 
 	RenderingDefinition* mRenderingDef;
 
+	/**
+	 * @brief Serialized data which hasn't yet been deserialized.
+	 */
+	std::string mSerializedData;
+
 };
 
 typedef Ogre::SharedPtr<ModelDefinition> ModelDefinitionPtr;
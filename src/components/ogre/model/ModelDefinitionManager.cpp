@@ -29,9 +29,12 @@
 #include "ModelDefinitionManager.h"
 #include "ModelDefinition.h"
 #include "Model.h"
-#include "ModelBackgroundLoader.h"
+#include "ModelBackgroundLoaderQueue.h"
 
 #include "XMLModelDefinitionSerializer.h"
+#include "BinaryModelDefinitionSerializer.h"
+
+#include "components/ogre/EmberOgreFileSystem.h"
 
 #include "framework/TimeFrame.h"
 #include "framework/TimedLog.h"
@@ -41,6 +44,11 @@
 #include <OgreRoot.h>
 #include <OgreSceneManagerEnumerator.h>
 
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
 
 template<> Ember::OgreView::Model::ModelDefinitionManager* Ember::Singleton<Ember::OgreView::Model::ModelDefinitionManager>::ms_Singleton = 0;
 namespace Ember
@@ -49,8 +57,36 @@ namespace OgreView
 {
 namespace Model {
 
-ModelDefinitionManager::ModelDefinitionManager(const std::string& exportDirectory, Eris::EventService& eventService)
-: ShowModels("showmodels", this, "Show or hide models."), mShowModels(true), mModelFactory(0), mExportDirectory(exportDirectory)
+namespace
+{
+const char DEFINITION_CACHE_MAGIC[4] = { 'E', 'M', 'D', 'C' };
+const uint32_t DEFINITION_CACHE_VERSION = 1;
+
+void writeString(std::ostream& stream, const std::string& value)
+{
+	uint32_t size = static_cast<uint32_t>(value.size());
+	stream.write(reinterpret_cast<const char*>(&size), sizeof(size));
+	stream.write(value.data(), size);
+}
+
+bool readString(std::istream& stream, std::string& value)
+{
+	uint32_t size = 0;
+	stream.read(reinterpret_cast<char*>(&size), sizeof(size));
+	//Guard against corrupt files.
+	if (!stream || size > 0x1000000) {
+		return false;
+	}
+	value.resize(size);
+	if (size) {
+		stream.read(&value[0], size);
+	}
+	return static_cast<bool>(stream);
+}
+}
+
+ModelDefinitionManager::ModelDefinitionManager(const std::string& exportDirectory, Eris::EventService& eventService, const std::string& cacheDirectory)
+: ShowModels("showmodels", this, "Show or hide models."), mShowModels(true), mModelFactory(0), mBackgroundLoaderQueue(new ModelBackgroundLoaderQueue(eventService)), mExportDirectory(exportDirectory), mDefinitionCacheDirty(false)
 {
 	mLoadOrder = 300.0f;
 	mResourceType = "ModelDefinition";
@@ -63,15 +99,20 @@ ModelDefinitionManager::ModelDefinitionManager(const std::string& exportDirector
 
 
 	//register factories
-	mModelFactory = new ModelFactory(eventService);
+	mModelFactory = new ModelFactory(*mBackgroundLoaderQueue);
 	Ogre::Root::getSingleton().addMovableObjectFactory(mModelFactory);
 
+	if (!cacheDirectory.empty()) {
+		mDefinitionCachePath = cacheDirectory + "modeldefinitions.cache";
+		loadDefinitionCache();
+	}
 }
 
 
 
 ModelDefinitionManager::~ModelDefinitionManager()
 {
+	saveDefinitionCache();
 	Ogre::ResourceGroupManager::getSingleton()._unregisterResourceManager(mResourceType);
 	Ogre::ResourceGroupManager::getSingleton()._unregisterScriptLoader(this);
 	//we need to make sure that all Models are destroyed before Ogre begins destroying other movable objects (such as Entities)
@@ -85,6 +126,7 @@ ModelDefinitionManager::~ModelDefinitionManager()
 		Ogre::Root::getSingleton().removeMovableObjectFactory(mModelFactory);
 		delete mModelFactory;
 	}
+	delete mBackgroundLoaderQueue;
 
 }
 
@@ -129,8 +171,173 @@ Ogre::ResourcePtr ModelDefinitionManager::createResource(const Ogre::String& nam
 
 void ModelDefinitionManager::parseScript (Ogre::DataStreamPtr &stream, const Ogre::String &groupName)
 {
-    XMLModelDefinitionSerializer serializer;
-	serializer.parseScript(*this, stream, groupName);
+	XMLModelDefinitionSerializer serializer;
+	if (mDefinitionCachePath.empty()) {
+		serializer.parseScript(*this, stream, groupName);
+		return;
+	}
+
+	std::string key = groupName + "/" + stream->getName();
+	long long modifiedTime = 0;
+	try {
+		modifiedTime = Ogre::ResourceGroupManager::getSingleton().resourceModifiedTime(groupName, stream->getName());
+	} catch (const Ogre::Exception&) {
+	}
+	//Scripts with the same name in different locations of the same group can't be told apart, so they are never cached.
+	if (modifiedTime == 0 || !mHandledScripts.insert(key).second) {
+		serializer.parseScript(*this, stream, groupName);
+		return;
+	}
+	unsigned long long size = stream->size();
+
+	auto I = mCachedScripts.find(key);
+	if (I != mCachedScripts.end() && I->second.modifiedTime == modifiedTime && I->second.size == size) {
+		for (auto& entry : I->second.definitions) {
+			try {
+				ModelDefinitionPtr modelDef = create(entry.first, groupName);
+				if (!modelDef.isNull()) {
+					modelDef->_notifyOrigin(stream->getName());
+					modelDef->setSerializedData(entry.second);
+				}
+			} catch (const Ogre::Exception& ex) {
+				S_LOG_FAILURE("Error when creating cached model '" << entry.first << "'." << ex);
+			}
+		}
+		return;
+	}
+
+	std::vector<ModelDefinitionPtr> definitions;
+	mDefinitionCacheDirty = true;
+	if (serializer.parseScript(*this, stream, groupName, &definitions)) {
+		BinaryModelDefinitionSerializer binarySerializer;
+		CachedScript& cachedScript = mCachedScripts[key];
+		cachedScript.modifiedTime = modifiedTime;
+		cachedScript.size = size;
+		cachedScript.definitions.clear();
+		for (auto& modelDef : definitions) {
+			cachedScript.definitions.emplace_back(modelDef->getName(), binarySerializer.serialize(*modelDef));
+		}
+	} else {
+		//Definitions which weren't created, for example because they are overridden by other scripts, can't be cached.
+		mCachedScripts.erase(key);
+	}
+}
+
+void ModelDefinitionManager::invalidateCachedScript(const std::string& groupName, const std::string& scriptName)
+{
+	if (mCachedScripts.erase(groupName + "/" + scriptName)) {
+		mDefinitionCacheDirty = true;
+	}
+}
+
+void ModelDefinitionManager::loadDefinitionCache()
+{
+	std::ifstream stream(mDefinitionCachePath.c_str(), std::ios::binary);
+	if (!stream) {
+		return;
+	}
+
+	char magic[4];
+	uint32_t version = 0;
+	uint32_t serializerVersion = 0;
+	uint32_t scriptCount = 0;
+	stream.read(magic, 4);
+	stream.read(reinterpret_cast<char*>(&version), sizeof(version));
+	stream.read(reinterpret_cast<char*>(&serializerVersion), sizeof(serializerVersion));
+	stream.read(reinterpret_cast<char*>(&scriptCount), sizeof(scriptCount));
+	if (!stream || memcmp(magic, DEFINITION_CACHE_MAGIC, 4) != 0 || version != DEFINITION_CACHE_VERSION || serializerVersion != BinaryModelDefinitionSerializer::VERSION) {
+		S_LOG_INFO("Model definition cache is out of date; all model definitions will be parsed.");
+		return;
+	}
+
+	std::unordered_map<std::string, CachedScript> cachedScripts;
+	for (uint32_t i = 0; i < scriptCount; ++i) {
+		std::string key;
+		CachedScript cachedScript;
+		uint32_t definitionCount = 0;
+		if (!readString(stream, key)) {
+			break;
+		}
+		stream.read(reinterpret_cast<char*>(&cachedScript.modifiedTime), sizeof(cachedScript.modifiedTime));
+		stream.read(reinterpret_cast<char*>(&cachedScript.size), sizeof(cachedScript.size));
+		stream.read(reinterpret_cast<char*>(&definitionCount), sizeof(definitionCount));
+		for (uint32_t j = 0; j < definitionCount && stream; ++j) {
+			std::string name;
+			std::string data;
+			if (readString(stream, name) && readString(stream, data)) {
+				cachedScript.definitions.emplace_back(std::move(name), std::move(data));
+			}
+		}
+		if (!stream) {
+			break;
+		}
+		cachedScripts.insert(std::make_pair(key, std::move(cachedScript)));
+	}
+	if (!stream) {
+		S_LOG_WARNING("Model definition cache is corrupt; all model definitions will be parsed.");
+		return;
+	}
+	mCachedScripts = std::move(cachedScripts);
+	S_LOG_VERBOSE("Read " << mCachedScripts.size() << " cached model definition scripts.");
+}
+
+void ModelDefinitionManager::saveDefinitionCache()
+{
+	if (mDefinitionCachePath.empty()) {
+		return;
+	}
+
+	//Remove scripts which no longer exist.
+	for (auto I = mCachedScripts.begin(); I != mCachedScripts.end();) {
+		if (mHandledScripts.find(I->first) == mHandledScripts.end()) {
+			I = mCachedScripts.erase(I);
+			mDefinitionCacheDirty = true;
+		} else {
+			++I;
+		}
+	}
+	if (!mDefinitionCacheDirty) {
+		return;
+	}
+
+	//Write to a temporary file first, so that an interrupted write never leaves a corrupt cache.
+	std::string tempPath = mDefinitionCachePath + ".tmp";
+	{
+		std::ofstream stream(tempPath.c_str(), std::ios::binary | std::ios::trunc);
+		if (!stream) {
+			S_LOG_WARNING("Could not write model definition cache to " << tempPath << ".");
+			return;
+		}
+		uint32_t serializerVersion = BinaryModelDefinitionSerializer::VERSION;
+		uint32_t scriptCount = static_cast<uint32_t>(mCachedScripts.size());
+		stream.write(DEFINITION_CACHE_MAGIC, 4);
+		stream.write(reinterpret_cast<const char*>(&DEFINITION_CACHE_VERSION), sizeof(DEFINITION_CACHE_VERSION));
+		stream.write(reinterpret_cast<const char*>(&serializerVersion), sizeof(serializerVersion));
+		stream.write(reinterpret_cast<const char*>(&scriptCount), sizeof(scriptCount));
+		for (auto& entry : mCachedScripts) {
+			writeString(stream, entry.first);
+			uint32_t definitionCount = static_cast<uint32_t>(entry.second.definitions.size());
+			stream.write(reinterpret_cast<const char*>(&entry.second.modifiedTime), sizeof(entry.second.modifiedTime));
+			stream.write(reinterpret_cast<const char*>(&entry.second.size), sizeof(entry.second.size));
+			stream.write(reinterpret_cast<const char*>(&definitionCount), sizeof(definitionCount));
+			for (auto& definition : entry.second.definitions) {
+				writeString(stream, definition.first);
+				writeString(stream, definition.second);
+			}
+		}
+		if (!stream) {
+			stream.close();
+			std::remove(tempPath.c_str());
+			S_LOG_WARNING("Could not write model definition cache to " << tempPath << ".");
+			return;
+		}
+	}
+	std::remove(mDefinitionCachePath.c_str());
+	if (std::rename(tempPath.c_str(), mDefinitionCachePath.c_str()) != 0) {
+		std::remove(tempPath.c_str());
+		return;
+	}
+	mDefinitionCacheDirty = false;
 }
 
 std::string ModelDefinitionManager::exportScript(ModelDefinitionPtr definition)
@@ -138,6 +345,8 @@ std::string ModelDefinitionManager::exportScript(ModelDefinitionPtr definition)
 	XMLModelDefinitionSerializer serializer;
 	bool success = serializer.exportScript(definition, mExportDirectory, definition->getName() + ".modeldef");
 	if (success) {
+		//The export directory is usually a resource location, so the new file needs to be picked up by its listing.
+		FileSystemArchive::invalidateListings();
 		return mExportDirectory + definition->getName() + ".modeldef";
 	} else {
 		return "";
@@ -158,7 +367,16 @@ const std::vector<std::string> ModelDefinitionManager::getAllMeshes() const
 
 ModelDefinitionPtr ModelDefinitionManager::getByName(const Ogre::String& name, const Ogre::String& groupName)
 {
-    return getResourceByName(name, groupName).staticCast<ModelDefinition>();
+	ModelDefinitionPtr modelDef = getResourceByName(name, groupName).staticCast<ModelDefinition>();
+	if (!modelDef.isNull()) {
+		modelDef->load();
+	}
+	return modelDef;
+}
+
+ModelBackgroundLoaderQueue& ModelDefinitionManager::getBackgroundLoaderQueue()
+{
+	return *mBackgroundLoaderQueue;
 }
 
 bool ModelDefinitionManager::getShowModels() const
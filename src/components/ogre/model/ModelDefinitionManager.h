@@ -32,6 +32,11 @@
 
 #include <OgreResourceManager.h>
 
+#include <unordered_map>
+#include <set>
+#include <vector>
+#include <utility>
+
 namespace Eris {
 class EventService;
 }
@@ -42,7 +47,7 @@ namespace OgreView {
 namespace Model {
 
 class ModelFactory;
-class ModelBackgroundLoader;
+class ModelBackgroundLoaderQueue;
 
 
 /**
@@ -60,8 +65,9 @@ public:
 	 * @brief Ctor.
 	 *
 	 * @param exportDirectory The path to the export directory, where exported models will be stored.
+	 * @param cacheDirectory The path to a directory in which parsed definitions are cached between sessions. An empty string disables the cache.
 	 */
-	ModelDefinitionManager(const std::string& exportDirectory, Eris::EventService& eventService);
+	ModelDefinitionManager(const std::string& exportDirectory, Eris::EventService& eventService, const std::string& cacheDirectory = "");
 
 	/**
 	 * @brief Dtor.
@@ -99,10 +105,29 @@ public:
 
 	/**
 	 * @brief Parses the submitted script and creates ModelDefinition instances.
+	 *
+	 * If the script hasn't changed since it was cached the definitions are instead created from the cache,
+	 * and won't be populated until they are loaded.
 	 * @param stream The stream containing the script definition.
 	 * @param groupName
 	 */
 	virtual void parseScript(Ogre::DataStreamPtr& stream, const Ogre::String& groupName);
+
+	/**
+	 * @brief Writes the definition cache to disk, if anything has changed.
+	 *
+	 * This should be called once all resource groups have been initialized, since scripts not parsed since startup are removed from the cache.
+	 */
+	void saveDefinitionCache();
+
+	/**
+	 * @brief Removes a script from the definition cache, so that it's parsed again the next time it's handled.
+	 *
+	 * This is called when cached data can't be read.
+	 * @param groupName The resource group of the script.
+	 * @param scriptName The name of the script.
+	 */
+	void invalidateCachedScript(const std::string& groupName, const std::string& scriptName);
 	
 	/**
 	 * @brief Exports a modeldefinition to a file.
@@ -113,7 +138,7 @@ public:
 	std::string exportScript(ModelDefinitionPtr definition);
 
 
-	/// Get a ModelDefinition by name
+	/// Get a ModelDefinition by name. The definition is loaded if it isn't already, to make sure that definitions read from the cache are populated.
 	/// @see ResourceManager::getResourceByName
 	ModelDefinitionPtr getByName(const Ogre::String& name, const Ogre::String& groupName = Ogre::ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME);
 	
@@ -137,6 +162,12 @@ public:
 	 */
 	void setShowModels(bool show);
 	
+	/**
+	 * @brief Gets the queue through which model background loading is scheduled.
+	 * @return The loader queue.
+	 */
+	ModelBackgroundLoaderQueue& getBackgroundLoaderQueue();
+
 	/**
 	 *    Reimplements the ConsoleObject::runCommand method
 	 * @param command
@@ -153,10 +184,6 @@ public:
 
 protected:
 
-	/**
-	 * @brief A store of background loaders.
-	 */
-	typedef std::list<ModelBackgroundLoader*> BackgroundLoaderStore;
 	Ogre::Resource* createImpl(const Ogre::String& name, Ogre::ResourceHandle handle, 
         const Ogre::String& group, bool isManual, Ogre::ManualResourceLoader* loader, 
         const Ogre::NameValuePairList* createParams);
@@ -172,15 +199,61 @@ protected:
 	ModelFactory* mModelFactory;
 	
 	/**
-	 * @brief The collection of background loaders which will be polled each time pollBackgroundLoaders() are called.
+	 * @brief Schedules the background loading of all models.
 	 */
-	BackgroundLoaderStore mBackgroundLoaders;
+	ModelBackgroundLoaderQueue* mBackgroundLoaderQueue;
 
 	/**
 	 * @brief The path to the export directory.
 	 */
 	const std::string mExportDirectory;
 
+	/**
+	 * @brief The cached definitions of a script.
+	 */
+	struct CachedScript
+	{
+		/**
+		 * @brief The modification time of the script when it was parsed.
+		 */
+		long long modifiedTime;
+
+		/**
+		 * @brief The size of the script when it was parsed.
+		 */
+		unsigned long long size;
+
+		/**
+		 * @brief The names of the definitions in the script, along with their serialized data.
+		 */
+		std::vector<std::pair<std::string, std::string>> definitions;
+	};
+
+	/**
+	 * @brief The path to the definition cache file. Empty if there's no cache.
+	 */
+	std::string mDefinitionCachePath;
+
+	/**
+	 * @brief Cached scripts, keyed by resource group and file name.
+	 */
+	std::unordered_map<std::string, CachedScript> mCachedScripts;
+
+	/**
+	 * @brief The keys of all scripts handled since startup.
+	 */
+	std::set<std::string> mHandledScripts;
+
+	/**
+	 * @brief True if the cache on disk needs to be rewritten.
+	 */
+	bool mDefinitionCacheDirty;
+
+	/**
+	 * @brief Reads the definition cache from disk.
+	 */
+	void loadDefinitionCache();
+
 
 };
 
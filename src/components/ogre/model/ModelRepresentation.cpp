@@ -431,6 +431,15 @@ void ModelRepresentation::updateAnimation(float timeSlice)
 	}
 }
 
+bool ModelRepresentation::getAnimationBounds(Ogre::Sphere& bounds) const
+{
+	if (!mModel.getParentNode()) {
+		return false;
+	}
+	bounds = mModel.getWorldBoundingSphere(true);
+	return true;
+}
+
 void ModelRepresentation::resetAnimations()
 {
 	if (mCurrentMovementAction) {
@@ -179,6 +179,13 @@ public:
 	 */
 	void updateAnimation(float timeSlice);
 
+	/**
+	 * @brief Gets the world bounds of the model, as long as it's attached to a node.
+	 * @param bounds The bounds will be placed here.
+	 * @return True if the model is attached to a node.
+	 */
+	virtual bool getAnimationBounds(Ogre::Sphere& bounds) const;
+
 	/**
 	 * @brief Accesses the world bounding box of the model.
 	 * @param derive Whether to derive from attached objects too.
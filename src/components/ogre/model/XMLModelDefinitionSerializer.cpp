@@ -64,14 +64,16 @@ void XMLModelDefinitionSerializer::importModelDefinition(Ogre::DataStreamPtr&, M
 {
 }
 
-void XMLModelDefinitionSerializer::parseScript(ModelDefinitionManager& modelDefManager, Ogre::DataStreamPtr& stream, const Ogre::String& groupName)
+bool XMLModelDefinitionSerializer::parseScript(ModelDefinitionManager& modelDefManager, Ogre::DataStreamPtr& stream, const Ogre::String& groupName, std::vector<ModelDefinitionPtr>* definitions)
 {
 	TiXmlDocument xmlDoc;
 	XMLHelper xmlHelper;
 	if (!xmlHelper.Load(xmlDoc, stream)) {
-		return;
+		return false;
 	}
 
+	bool complete = true;
+
 	TiXmlElement* rootElem = xmlDoc.RootElement();
 	if (rootElem) {
 
@@ -91,15 +93,21 @@ void XMLModelDefinitionSerializer::parseScript(ModelDefinitionManager& modelDefM
 				if (!modelDef.isNull()) {
 					readModel(modelDef, smElem);
 					modelDef->setValid(true);
+					if (definitions) {
+						definitions->push_back(modelDef);
+					}
+				} else {
+					complete = false;
 				}
 			} catch (const Ogre::Exception& ex) {
 				S_LOG_FAILURE("Error when parsing model '" << name << "'." << ex);
+				complete = false;
 			}
 
 			//modelDef->_notifyOrigin(context.filename);
 		}
 	}
-
+	return complete;
 }
 
 void XMLModelDefinitionSerializer::readModel(ModelDefinitionPtr modelDef, TiXmlElement* modelNode)
@@ -44,7 +44,16 @@ public :
 	virtual ~XMLModelDefinitionSerializer();
 
 	void importModelDefinition(Ogre::DataStreamPtr& stream, ModelDefinition* pmModelDef);
-	void parseScript(ModelDefinitionManager& modelDefManager, Ogre::DataStreamPtr& stream, const Ogre::String& groupName);
+
+	/**
+	 * @brief Parses a script and creates model definitions.
+	 * @param modelDefManager The manager in which the definitions are created.
+	 * @param stream The script.
+	 * @param groupName The resource group.
+	 * @param definitions If not null, the created definitions are added to this.
+	 * @return True if all definitions in the script were created.
+	 */
+	bool parseScript(ModelDefinitionManager& modelDefManager, Ogre::DataStreamPtr& stream, const Ogre::String& groupName, std::vector<ModelDefinitionPtr>* definitions = nullptr);
 	
 	/**
 	 * @brief Exports the model definition to a file.
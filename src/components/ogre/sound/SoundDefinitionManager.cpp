@@ -27,6 +27,7 @@
 #include "SoundDefinitionManager.h"
 #include "XMLSoundDefParser.h"
 #include "SoundGroupDefinition.h"
+#include "components/ogre/OgreResourceLoader.h"
 
 template<> Ember::OgreView::SoundDefinitionManager* Ember::Singleton<Ember::OgreView::SoundDefinitionManager>::ms_Singleton = 0;
 
@@ -67,6 +68,8 @@ Ogre::Resource* SoundDefinitionManager::createImpl(const Ogre::String& name, Ogr
 
 SoundGroupDefinition* SoundDefinitionManager::getSoundGroupDefinition(const std::string& name)
 {
+	//The sound definitions aren't parsed at startup.
+	OgreResourceLoader::ensureResourceGroupInitialised("SoundDefinitions");
 	auto it(mSoundGroupDefinitions.find(name));
 	if (it != mSoundGroupDefinitions.end())
 	{
@@ -78,10 +81,10 @@ SoundGroupDefinition* SoundDefinitionManager::getSoundGroupDefinition(const std:
 
 SoundGroupDefinition* SoundDefinitionManager::createSoundGroupDefinition(const std::string& name)
 {
-	SoundGroupDefinition* newModel = getSoundGroupDefinition(name);
-	if (!newModel)
+	//Look up the definition directly, since this is called while the sound definitions are being parsed.
+	if (mSoundGroupDefinitions.find(name) == mSoundGroupDefinitions.end())
 	{
-		newModel = new SoundGroupDefinition();
+		SoundGroupDefinition* newModel = new SoundGroupDefinition();
 		#ifdef THREAD_SAFE
 		pthread_mutex_lock(&mGroupModelsMutex);
 		#endif
@@ -67,6 +67,9 @@ function Performance.framestarted(timeSinceLastFrame)
 			statString = statString .. "\nAnimated: " .. motionInfo.AnimatedEntities
 			statString = statString .. "\nMoving: " .. motionInfo.MovingEntities
 		end
+		local pageStats = Forests.PageLoadBudget:getLastFrameStats()
+		statString = statString .. "\nPending pages: " .. pageStats.pendingPages
+		statString = statString .. "\nPage loads: " .. pageStats.loadedPages .. string.format(" (%.1f ms, max %.1f ms)", pageStats.loadTime, pageStats.maxPageLoadTime)
 		--ss << "Time in eris: " << getAverageErisTime() * 100 << "% \n"
 		
         -- NOTE: commented out because currently, it does not work and breaks the widget
@@ -0,0 +1,250 @@
+/*
+ Copyright (C) 2014 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "Profiler.h"
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <memory>
+#include <unordered_set>
+#include <sstream>
+
+namespace Ember
+{
+
+namespace
+{
+const std::chrono::steady_clock::time_point sEpoch = std::chrono::steady_clock::now();
+
+struct Zone
+{
+	const char* name;
+	int64_t start;
+	int64_t duration;
+};
+
+void writeJsonString(std::ostream& stream, const char* value)
+{
+	stream << '"';
+	for (const char* c = value; *c; ++c) {
+		switch (*c) {
+		case '"':
+			stream << "\\\"";
+			break;
+		case '\\':
+			stream << "\\\\";
+			break;
+		case '\n':
+			stream << "\\n";
+			break;
+		case '\t':
+			stream << "\\t";
+			break;
+		default:
+			if (static_cast<unsigned char>(*c) < 0x20) {
+				stream << ' ';
+			} else {
+				stream << *c;
+			}
+		}
+	}
+	stream << '"';
+}
+
+/**
+ * @brief The zones recorded by one thread.
+ *
+ * The buffer is owned both by the thread and by the registry, so that zones recorded by threads which have exited can still be exported.
+ */
+struct ThreadBuffer
+{
+	/**
+	 * @brief Only contended when exporting.
+	 */
+	std::mutex mutex;
+	std::string name;
+	unsigned int id;
+
+	/**
+	 * @brief Grows up to ZonesPerThread, after which it's used as a ring.
+	 */
+	std::vector<Zone> zones;
+
+	/**
+	 * @brief The total number of zones recorded, including those overwritten.
+	 */
+	size_t recordedCount;
+};
+
+/**
+ * @brief Keeps track of all thread buffers, and of all interned names.
+ *
+ * This is accessed through a function so that it's available even to threads started during static initialization.
+ */
+struct Registry
+{
+	std::mutex mutex;
+	std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+	std::unordered_set<std::string> names;
+
+	/**
+	 * @brief The id of the next thread buffer. Ids aren't reused, since buffers can be removed.
+	 */
+	unsigned int nextId = 1;
+};
+
+Registry& getRegistry()
+{
+	static Registry registry;
+	return registry;
+}
+
+thread_local std::shared_ptr<ThreadBuffer> tThreadBuffer;
+
+/**
+ * @brief Gets the buffer of the calling thread, creating it if needed.
+ * @return The buffer of the calling thread.
+ */
+ThreadBuffer& getThreadBuffer()
+{
+	if (!tThreadBuffer) {
+		Registry& registry = getRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		tThreadBuffer = std::make_shared<ThreadBuffer>();
+		tThreadBuffer->id = registry.nextId++;
+		tThreadBuffer->recordedCount = 0;
+		std::stringstream ss;
+		ss << "Thread " << tThreadBuffer->id;
+		tThreadBuffer->name = ss.str();
+		registry.buffers.push_back(tThreadBuffer);
+	}
+	return *tThreadBuffer;
+}
+}
+
+std::atomic<bool> Profiler::sEnabled(false);
+
+void Profiler::setEnabled(bool enabled)
+{
+	sEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Profiler::clear()
+{
+	Registry& registry = getRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	for (auto I = registry.buffers.begin(); I != registry.buffers.end();) {
+		auto& buffer = *I;
+		//If the registry holds the only reference the thread has exited, and the buffer will never be used again.
+		if (buffer.use_count() == 1) {
+			I = registry.buffers.erase(I);
+			continue;
+		}
+		std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+		//Release the memory too, since a full buffer is quite large.
+		std::vector<Zone>().swap(buffer->zones);
+		buffer->recordedCount = 0;
+		++I;
+	}
+}
+
+void Profiler::setThreadName(const std::string& name)
+{
+	ThreadBuffer& buffer = getThreadBuffer();
+	std::lock_guard<std::mutex> lock(buffer.mutex);
+	buffer.name = name;
+}
+
+const char* Profiler::internName(const std::string& name)
+{
+	Registry& registry = getRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	//Elements of an unordered_set are never moved, so the pointer stays valid.
+	return registry.names.insert(name).first->c_str();
+}
+
+int64_t Profiler::now()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - sEpoch).count();
+}
+
+void Profiler::record(const char* name, int64_t start, int64_t end)
+{
+	ThreadBuffer& buffer = getThreadBuffer();
+	Zone zone = { name, start, end - start };
+	std::lock_guard<std::mutex> lock(buffer.mutex);
+	if (buffer.zones.size() < ZonesPerThread) {
+		buffer.zones.push_back(zone);
+	} else {
+		buffer.zones[buffer.recordedCount % ZonesPerThread] = zone;
+	}
+	buffer.recordedCount++;
+}
+
+size_t Profiler::writeChromeTrace(std::ostream& stream)
+{
+	std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+	{
+		Registry& registry = getRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		buffers = registry.buffers;
+	}
+
+	size_t zoneCount = 0;
+	bool isFirst = true;
+	stream << "{\"traceEvents\":[";
+	for (auto& buffer : buffers) {
+		//Copy the zones so that the thread isn't blocked while they are written.
+		std::vector<Zone> zones;
+		std::string name;
+		size_t oldest;
+		{
+			std::lock_guard<std::mutex> lock(buffer->mutex);
+			zones = buffer->zones;
+			name = buffer->name;
+			oldest = buffer->recordedCount % ZonesPerThread;
+		}
+		if (zones.size() < ZonesPerThread) {
+			oldest = 0;
+		}
+
+		if (!isFirst) {
+			stream << ",";
+		}
+		isFirst = false;
+		stream << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id << ",\"args\":{\"name\":";
+		writeJsonString(stream, name.c_str());
+		stream << "}}";
+
+		for (size_t i = 0; i < zones.size(); ++i) {
+			const Zone& zone = zones[(oldest + i) % zones.size()];
+			stream << ",\n{\"name\":";
+			writeJsonString(stream, zone.name);
+			stream << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id << ",\"ts\":" << zone.start << ",\"dur\":" << zone.duration << "}";
+		}
+		zoneCount += zones.size();
+	}
+	stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+	return zoneCount;
+}
+}
@@ -0,0 +1,180 @@
+/*
+ Copyright (C) 2014 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <string>
+#include <ostream>
+#include <atomic>
+#include <cstdint>
+
+namespace Ember
+{
+
+/**
+ * @brief Records timed zones from all threads, for inspection as a timeline.
+ *
+ * Each thread records into a ring buffer of its own, so that recording never contends with other threads.
+ * When a buffer is full the oldest zones are overwritten, which means that the recording always covers
+ * the last few seconds before it's exported. That's usually what's wanted when looking into a stutter.
+ *
+ * The recording can be written as Chrome trace JSON, which can be viewed in "chrome://tracing" or similar tools.
+ *
+ * Zones are recorded through instances of ProfileZone. When the profiler isn't enabled a zone costs no more than
+ * a check of an atomic flag.
+ */
+class Profiler
+{
+public:
+
+	/**
+	 * @brief The max number of zones kept for each thread.
+	 */
+	static const size_t ZonesPerThread = 65536;
+
+	/**
+	 * @brief Checks whether zones should be recorded.
+	 * @return True if the profiler is enabled.
+	 */
+	static bool isEnabled()
+	{
+		return sEnabled.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Enables or disables recording.
+	 *
+	 * Zones already recorded are kept when the profiler is disabled.
+	 * @param enabled True if zones should be recorded.
+	 */
+	static void setEnabled(bool enabled);
+
+	/**
+	 * @brief Removes all recorded zones, and frees the memory used for them.
+	 *
+	 * The buffers of threads which have exited are removed altogether.
+	 */
+	static void clear();
+
+	/**
+	 * @brief Sets the name of the calling thread, as shown in the exported trace.
+	 * @param name The name of the thread.
+	 */
+	static void setThreadName(const std::string& name);
+
+	/**
+	 * @brief Gets a name which is kept for as long as the application runs.
+	 *
+	 * Zones only keep a pointer to their names, so names which aren't string literals must be interned.
+	 * @param name A name.
+	 * @return A pointer to a copy of the name, which will never be freed.
+	 */
+	static const char* internName(const std::string& name);
+
+	/**
+	 * @brief Gets the current time.
+	 * @return Microseconds since the application started.
+	 */
+	static int64_t now();
+
+	/**
+	 * @brief Records a zone for the calling thread.
+	 * @param name The name of the zone. This must be valid for as long as the application runs.
+	 * @param start The start of the zone, as returned by now().
+	 * @param end The end of the zone, as returned by now().
+	 */
+	static void record(const char* name, int64_t start, int64_t end);
+
+	/**
+	 * @brief Writes all recorded zones as Chrome trace JSON.
+	 * @param stream The stream to write to.
+	 * @return The number of zones written.
+	 */
+	static size_t writeChromeTrace(std::ostream& stream);
+
+private:
+
+	static std::atomic<bool> sEnabled;
+};
+
+/**
+ * @brief Records the time from creation to destruction as a zone in the profiler.
+ *
+ * Create an instance at the start of a scope which should be timed:
+ * @code
+ * ProfileZone zone("World::update");
+ * @endcode
+ *
+ * If the name needs to be built at runtime, use the default constructor and only call start() if
+ * Profiler::isEnabled() returns true, so that no name is built when the profiler isn't enabled.
+ */
+class ProfileZone
+{
+public:
+
+	/**
+	 * @brief Ctor. Starts the zone if the profiler is enabled.
+	 * @param name The name of the zone. This should be a string literal; otherwise see Profiler::internName().
+	 */
+	explicit ProfileZone(const char* name) :
+			mName(Profiler::isEnabled() ? name : nullptr), mStart(mName ? Profiler::now() : 0)
+	{
+	}
+
+	/**
+	 * @brief Ctor. The zone isn't started until start() is called.
+	 */
+	ProfileZone() :
+			mName(nullptr), mStart(0)
+	{
+	}
+
+	/**
+	 * @brief Dtor. Records the zone if it was started.
+	 */
+	~ProfileZone()
+	{
+		if (mName) {
+			Profiler::record(mName, mStart, Profiler::now());
+		}
+	}
+
+	/**
+	 * @brief Starts the zone if the profiler is enabled.
+	 * @param name The name of the zone.
+	 */
+	void start(const std::string& name)
+	{
+		if (Profiler::isEnabled()) {
+			mName = Profiler::internName(name);
+			mStart = Profiler::now();
+		}
+	}
+
+private:
+	ProfileZone(const ProfileZone&) = delete;
+	ProfileZone& operator=(const ProfileZone&) = delete;
+
+	const char* mName;
+	int64_t mStart;
+};
+
+}
+
+#endif /* PROFILER_H_ */
@@ -21,6 +21,7 @@
 #include "TaskExecutionContext.h"
 #include "TaskUnit.h"
 #include "framework/LoggingInstance.h"
+#include "framework/Profiler.h"
 
 #include <thread>
 
@@ -42,6 +43,7 @@ TaskExecutor::~TaskExecutor()
 
 void TaskExecutor::run()
 {
+	Profiler::setThreadName("TaskExecutor");
 	while (mActive) {
 		TaskUnit* taskUnit = mTaskQueue.fetchNextTask();
 		//If the queue returns a null pointer, it means that the queue is being shut down, and this executor is expected to exit its main processing loop.
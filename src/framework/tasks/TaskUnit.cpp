@@ -21,6 +21,7 @@
 #include "ITaskExecutionListener.h"
 
 #include "framework/Exception.h"
+#include "framework/Profiler.h"
 
 //#define LOG_TASKS
 
@@ -66,6 +67,11 @@ void TaskUnit::executeInBackgroundThread(TaskExecutionContext& context)
 #ifdef LOG_TASKS
 	TimedLog timedLog(mTask->getName() + ": background");
 #endif
+	//Only build the name when profiling, since getName() creates a new string.
+	ProfileZone zone;
+	if (Profiler::isEnabled()) {
+		zone.start(mTask->getName());
+	}
 
 	try {
 		if (mListener) {
@@ -93,6 +99,10 @@ void TaskUnit::executeInMainThread()
 #ifdef LOG_TASKS
 	TimedLog timedLog(mTask->getName() + ": foreground");
 #endif
+	ProfileZone zone;
+	if (Profiler::isEnabled()) {
+		zone.start(mTask->getName());
+	}
 
 	//First execute all subtasks
 	for (SubtasksStore::const_iterator I = mSubtasks.begin(); I != mSubtasks.end(); ++I) {
@@ -42,6 +42,7 @@
 #include "framework/ConsoleBackend.h"
 #include "framework/ShutdownException.h"
 #include "framework/TimeFrame.h"
+#include "framework/Profiler.h"
 #include "framework/FileResourceProvider.h"
 #include "framework/osdir.h"
 
@@ -165,7 +166,7 @@ public:
 template<> Application *Singleton<Application>::ms_Singleton = 0;
 
 Application::Application(const std::string prefix, const std::string homeDir, const ConfigMap& configSettings) :
-		mSession(new Eris::Session()), mOgreView(0), mShouldQuit(false), mPollEris(true), mMainLoopController(mShouldQuit, mPollEris), mPrefix(prefix), mHomeDir(homeDir), mLogObserver(0), mServices(0), mWorldView(0), mConfigSettings(configSettings), mConsoleBackend(new ConsoleBackend()), Quit("quit", this, "Quit Ember."), ToggleErisPolling("toggle_erispolling", this, "Switch server polling on and off."), mScriptingResourceProvider(0)
+		mSession(new Eris::Session()), mOgreView(0), mShouldQuit(false), mPollEris(true), mMainLoopController(mShouldQuit, mPollEris), mPrefix(prefix), mHomeDir(homeDir), mLogObserver(0), mServices(0), mWorldView(0), mConfigSettings(configSettings), mConsoleBackend(new ConsoleBackend()), Quit("quit", this, "Quit Ember."), ToggleErisPolling("toggle_erispolling", this, "Switch server polling on and off."), StartProfiler("+profiler", this, "Start recording profiler zones."), StopProfiler("-profiler", this, "Stop recording profiler zones."), ExportProfile("profiler_export", this, "Write recorded profiler zones as a Chrome trace file. Optionally takes the path of the file."), mScriptingResourceProvider(0)
 
 {
 
@@ -221,9 +222,11 @@ void Application::mainLoop()
 	DesiredFpsListener desiredFpsListener;
 	Eris::EventService& eventService = mSession->getEventService();
 	Input& input(Input::getSingleton());
+	Profiler::setThreadName("Main");
 
 	do {
 		try {
+			ProfileZone frameZone("Application::mainLoop");
 			Log::sCurrentFrameStartMilliseconds = microsec_clock::local_time();
 
 			unsigned int frameActionMask = 0;
@@ -238,6 +241,7 @@ void Application::mainLoop()
 			}
 
 			if (mWorldView) {
+				ProfileZone viewZone("Eris::View::update");
 				mWorldView->update();
 			}
 
@@ -245,7 +249,10 @@ void Application::mainLoop()
 			frameActionMask |= MainLoopController::FA_SOUND;
 
 			//Keep on running IO and handlers until we need to render again
-			eventService.processEvents(timeFrame.getRemainingTime(), mShouldQuit);
+			{
+				ProfileZone eventsZone("Eris::EventService::processEvents");
+				eventService.processEvents(timeFrame.getRemainingTime(), mShouldQuit);
+			}
 
 			mMainLoopController.EventFrameProcessed(timeFrame, frameActionMask);
 
@@ -496,6 +503,27 @@ void Application::runCommand(const std::string& command, const std::string& args
 		mShouldQuit = true;
 	} else if (ToggleErisPolling == command) {
 		mPollEris = !mPollEris;
+	} else if (StartProfiler == command) {
+		Profiler::clear();
+		Profiler::setEnabled(true);
+		ConsoleBackend::getSingleton().pushMessage("Profiler started.", "info");
+	} else if (StopProfiler == command) {
+		Profiler::setEnabled(false);
+		ConsoleBackend::getSingleton().pushMessage("Profiler stopped.", "info");
+	} else if (ExportProfile == command) {
+		std::string path(args);
+		if (path.empty()) {
+			path = mServices->getConfigService().getHomeDirectory(BaseDirType_DATA) + "profile.json";
+		}
+		std::ofstream stream(path.c_str(), std::ios::out | std::ios::trunc);
+		size_t zoneCount = Profiler::writeChromeTrace(stream);
+		if (stream.good()) {
+			S_LOG_INFO("Wrote " << zoneCount << " profiler zones to '" << path << "'.");
+			ConsoleBackend::getSingleton().pushMessage("Wrote profile to '" + path + "'.", "info");
+		} else {
+			S_LOG_FAILURE("Could not write profile to '" << path << "'.");
+			ConsoleBackend::getSingleton().pushMessage("Could not write profile to '" + path + "'.", "error");
+		}
 	}
 }
 
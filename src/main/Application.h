@@ -257,6 +257,21 @@ private:
 	 */
 	const ConsoleCommandWrapper ToggleErisPolling;
 
+	/**
+	 * @brief Starts recording profiler zones.
+	 */
+	const ConsoleCommandWrapper StartProfiler;
+
+	/**
+	 * @brief Stops recording profiler zones.
+	 */
+	const ConsoleCommandWrapper StopProfiler;
+
+	/**
+	 * @brief Writes the recorded profiler zones as a Chrome trace file, to the path given as argument or to "profile.json" in the home directory.
+	 */
+	const ConsoleCommandWrapper ExportProfile;
+
 	/**
 	 * @brief Provides resources to the scripting system.
 	 */
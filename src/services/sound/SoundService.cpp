@@ -26,6 +26,7 @@
 #include "services/EmberServices.h"
 #include "services/config/ConfigService.h"
 #include "framework/LoggingInstance.h"
+#include "framework/Profiler.h"
 
 #include "SoundSample.h"
 #include "SoundInstance.h"
@@ -201,6 +202,7 @@ void SoundService::updateListenerPosition(const WFMath::Point<3>& pos, const WFM
 
 void SoundService::cycle()
 {
+	ProfileZone zone("SoundService::cycle");
 	for (SoundInstanceStore::iterator I = mInstances.begin(); I != mInstances.end(); ) {
 		//We do the iteration this way to allow for instances to be removed inside the iteration.
 		//A typical example would be a sound instance that has played to its completion and thus should be destroyed. The signal for this is emitted as a result of calling SoundInstance::update().
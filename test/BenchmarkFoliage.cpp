@@ -0,0 +1,294 @@
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/BriefTestProgressListener.h>
+#include <cppunit/TestResult.h>
+
+#include "components/ogre/terrain/Types.h"
+#include "components/ogre/terrain/Segment.h"
+#include "components/ogre/terrain/SegmentManager.h"
+#include "components/ogre/terrain/PlantAreaQuery.h"
+#include "components/ogre/terrain/PlantAreaQueryResult.h"
+#include "components/ogre/terrain/PlantInstance.h"
+#include "components/ogre/terrain/PlantQueryTask.h"
+#include "components/ogre/terrain/TerrainLayerDefinition.h"
+#include "components/ogre/terrain/foliage/Vegetation.h"
+#include "components/ogre/terrain/foliage/PlantPopulator.h"
+
+#include "framework/tasks/TaskQueue.h"
+
+#include "BenchmarkStats.h"
+
+#include <Eris/EventService.h>
+
+#include <Mercator/Terrain.h>
+#include <Mercator/Segment.h>
+#include <Mercator/FillShader.h>
+#include <Mercator/ThresholdShader.h>
+#include <Mercator/GrassShader.h>
+
+#include <wfmath/MersenneTwister.h>
+#include <wfmath/axisbox.h>
+
+#include <sigc++/trackable.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+using namespace Ember::OgreView;
+using namespace Ember::OgreView::Terrain;
+
+namespace Ember
+{
+
+/**
+ * @brief Number of segments along each side of the synthetic terrain.
+ */
+static const int SEGMENTS_PER_SIDE = 8;
+
+/**
+ * @brief The size of each foliage page, in world units.
+ *
+ * This mirrors the page size normally used by the paged geometry foliage, so each segment is split into four pages.
+ */
+static const int PAGE_SIZE = 32;
+
+/**
+ * @brief Collects timing and size figures for a set of page queries and prints a summary.
+ */
+class BenchmarkStats
+{
+public:
+	LatencyStats latencies;
+	size_t plantCount;
+	size_t bytes;
+	double totalSeconds;
+
+	BenchmarkStats() :
+		plantCount(0), bytes(0), totalSeconds(0)
+	{
+	}
+
+	void addPage(const PlantAreaQueryResult& result, double microseconds)
+	{
+		latencies.add(microseconds);
+		plantCount += result.getStore().size();
+		bytes += sizeof(PlantAreaQueryResult) + result.getStore().capacity() * sizeof(PlantInstance);
+	}
+
+	void print(const std::string& name)
+	{
+		size_t pages = latencies.size();
+		std::cout << std::endl << name << ": " << pages << " pages, " << plantCount << " plants in " << std::fixed << std::setprecision(3) << totalSeconds << " s" << std::endl;
+		if (pages && totalSeconds > 0) {
+			std::cout << "  plants/sec:        " << std::setprecision(0) << (plantCount / totalSeconds) << std::endl;
+			std::cout << "  memory per page:   " << (bytes / pages) << " bytes (" << (plantCount / pages) << " plants)" << std::endl;
+			latencies.print("page latency");
+		}
+	}
+};
+
+/**
+ * @brief Sets up a Mercator terrain with a couple of shader layers and a vegetation instance, without any Ogre rendering.
+ */
+class FoliageSetup
+{
+public:
+	Mercator::Terrain terrain;
+	SegmentManager segmentManager;
+	Foliage::Vegetation vegetation;
+	TerrainLayerDefinition sandLayer;
+	TerrainLayerDefinition grassLayer;
+	std::vector<std::string> plantTypes;
+
+	FoliageSetup() :
+		terrain(Mercator::Terrain::SHADED), segmentManager(terrain, SEGMENTS_PER_SIDE * SEGMENTS_PER_SIDE)
+	{
+		//The same shaders as are used for the default terrain; see TerrainShaderParser::createDefaultShaders.
+		terrain.addShader(new Mercator::FillShader(), 0);
+		terrain.addShader(new Mercator::BandShader(-2.f, 1.5f), 1);
+		terrain.addShader(new Mercator::GrassShader(1.f, 80.f, .5f, 1.f), 2);
+
+		//Use a fixed seed so that all runs operate on the same terrain.
+		WFMath::MTRand rng(4711);
+		for (int x = 0; x <= SEGMENTS_PER_SIDE; ++x) {
+			for (int y = 0; y <= SEGMENTS_PER_SIDE; ++y) {
+				terrain.setBasePoint(x, y, Mercator::BasePoint(rng.rand(30.f) - 5.f));
+			}
+		}
+		segmentManager.syncWithTerrain();
+
+		sandLayer.setAreaId(1);
+		sandLayer.setShaderName("sand");
+		addFoliage(sandLayer, "reeds", 1, "0.04", "4");
+		grassLayer.setAreaId(2);
+		grassLayer.setShaderName("grass");
+		addFoliage(grassLayer, "grass", 2, "0.3", "8");
+		addFoliage(grassLayer, "flowers", 2, "0.05", "12");
+	}
+
+	void addFoliage(TerrainLayerDefinition& layer, const std::string& plantType, unsigned int layerIndex, const std::string& density, const std::string& clusterDistance)
+	{
+		TerrainFoliageDefinition foliage;
+		foliage.setPlantType(plantType);
+		foliage.setPopulationTechnique("cluster");
+		foliage.getParameters()["minScale"] = "0.5";
+		foliage.getParameters()["maxScale"] = "1.5";
+		foliage.getParameters()["clusterDistance"] = clusterDistance;
+		foliage.getParameters()["minClusterRadius"] = "2";
+		foliage.getParameters()["maxClusterRadius"] = "6";
+		foliage.getParameters()["density"] = density;
+		foliage.getParameters()["falloff"] = "0.7";
+		foliage.getParameters()["threshold"] = "100";
+		layer.getFoliages().push_back(foliage);
+		vegetation.createPopulator(foliage, layerIndex);
+		plantTypes.push_back(plantType);
+	}
+
+	const TerrainLayerDefinition& getLayerForPlantType(const std::string& plantType) const
+	{
+		return plantType == "reeds" ? sandLayer : grassLayer;
+	}
+
+	/**
+	 * @brief Creates a query for a page, using the same coordinate convention as the FoliageLoader (i.e. Ogre space).
+	 */
+	PlantAreaQuery createQuery(const std::string& plantType, int pageX, int pageY) const
+	{
+		float left = pageX * PAGE_SIZE;
+		float bottom = pageY * PAGE_SIZE;
+		Ogre::TRect<Ogre::Real> bounds(left, -(bottom + PAGE_SIZE), left + PAGE_SIZE, -bottom);
+		return PlantAreaQuery(getLayerForPlantType(plantType), plantType, bounds, Ogre::Vector2(left + PAGE_SIZE * 0.5f, -(bottom + PAGE_SIZE * 0.5f)));
+	}
+};
+
+/**
+ * @brief Records the wall clock time between a task being enqueued and its result being delivered on the main thread.
+ */
+class PlantQueryListener: public virtual sigc::trackable
+{
+public:
+	BenchmarkStats& stats;
+	std::chrono::steady_clock::time_point enqueueTime;
+	bool completed;
+
+	PlantQueryListener(BenchmarkStats& stats) :
+		stats(stats), completed(false)
+	{
+	}
+
+	void queryExecuted(const PlantAreaQueryResult& result)
+	{
+		stats.addPage(result, std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - enqueueTime).count());
+		completed = true;
+	}
+};
+
+class FoliageBenchmarkCase: public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE( FoliageBenchmarkCase);
+	CPPUNIT_TEST( testPopulateDirect);
+	CPPUNIT_TEST( testPlantQueryTasks);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+
+	/**
+	 * @brief Runs the populators directly on the calling thread, page by page.
+	 */
+	void testPopulateDirect()
+	{
+		FoliageSetup setup;
+		BenchmarkStats stats;
+		int pagesPerSide = SEGMENTS_PER_SIDE * setup.terrain.getResolution() / PAGE_SIZE;
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (std::vector<std::string>::const_iterator I = setup.plantTypes.begin(); I != setup.plantTypes.end(); ++I) {
+			for (int x = 0; x < pagesPerSide; ++x) {
+				for (int y = 0; y < pagesPerSide; ++y) {
+					int segmentX = (x * PAGE_SIZE) / setup.terrain.getResolution();
+					int segmentY = (y * PAGE_SIZE) / setup.terrain.getResolution();
+					SegmentRefPtr segmentRef = setup.segmentManager.getSegmentReference(segmentX, segmentY);
+					CPPUNIT_ASSERT(segmentRef);
+
+					PlantAreaQueryResult result(setup.createQuery(*I, x, y));
+					std::chrono::steady_clock::time_point pageStart = std::chrono::steady_clock::now();
+					setup.vegetation.getPopulator(*I)->populate(result, segmentRef);
+					stats.addPage(result, std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - pageStart).count());
+				}
+			}
+		}
+		stats.totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		stats.print("Direct population");
+
+		CPPUNIT_ASSERT(stats.plantCount > 0);
+	}
+
+	/**
+	 * @brief Runs the populators through PlantQueryTask instances on a task queue, the same way the TerrainHandler does.
+	 *
+	 * Latency is measured from enqueueing until the result is delivered in the main thread.
+	 */
+	void testPlantQueryTasks()
+	{
+		boost::asio::io_service io_service;
+		Eris::EventService eventService(io_service);
+		FoliageSetup setup;
+		BenchmarkStats stats;
+		int pagesPerSide = SEGMENTS_PER_SIDE * setup.terrain.getResolution() / PAGE_SIZE;
+
+		std::vector<PlantQueryListener*> listeners;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		{
+			Tasks::TaskQueue taskQueue(2, eventService);
+			for (std::vector<std::string>::const_iterator I = setup.plantTypes.begin(); I != setup.plantTypes.end(); ++I) {
+				for (int x = 0; x < pagesPerSide; ++x) {
+					for (int y = 0; y < pagesPerSide; ++y) {
+						int segmentX = (x * PAGE_SIZE) / setup.terrain.getResolution();
+						int segmentY = (y * PAGE_SIZE) / setup.terrain.getResolution();
+						SegmentRefPtr segmentRef = setup.segmentManager.getSegmentReference(segmentX, segmentY);
+						CPPUNIT_ASSERT(segmentRef);
+
+						PlantQueryListener* listener = new PlantQueryListener(stats);
+						listeners.push_back(listener);
+						listener->enqueueTime = std::chrono::steady_clock::now();
+						taskQueue.enqueueTask(new PlantQueryTask(segmentRef, *setup.vegetation.getPopulator(*I), setup.createQuery(*I, x, y), Ogre::ColourValue::White, sigc::mem_fun(*listener, &PlantQueryListener::queryExecuted)));
+					}
+				}
+			}
+
+			while (stats.latencies.size() < listeners.size()) {
+				eventService.processAllHandlers();
+			}
+		}
+		stats.totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		stats.print("PlantQueryTask population");
+
+		for (std::vector<PlantQueryListener*>::const_iterator I = listeners.begin(); I != listeners.end(); ++I) {
+			CPPUNIT_ASSERT((*I)->completed);
+			delete *I;
+		}
+		CPPUNIT_ASSERT(stats.plantCount > 0);
+	}
+};
+
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION( Ember::FoliageBenchmarkCase);
+
+int main(int argc, char **argv)
+{
+	CppUnit::TextUi::TestRunner runner;
+	CppUnit::TestFactoryRegistry &registry = CppUnit::TestFactoryRegistry::getRegistry();
+	runner.addTest(registry.makeTest());
+
+	// Shows a message as each test starts
+	CppUnit::BriefTestProgressListener listener;
+	runner.eventManager().addListener(&listener);
+
+	bool wasSuccessful = runner.run("", false);
+	return !wasSuccessful;
+}
@@ -0,0 +1,586 @@
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/BriefTestProgressListener.h>
+#include <cppunit/TestResult.h>
+
+#include "components/navigation/Awareness.h"
+#include "components/navigation/AwarenessUtils.h"
+#include "components/navigation/AreaIndex.h"
+#include "components/navigation/ObstacleAvoidanceSampler.h"
+#include "components/navigation/TileMemoryTracker.h"
+#include "domain/IHeightProvider.h"
+
+#include "BenchmarkStats.h"
+
+#include "DetourNavMesh.h"
+#include "DetourNavMeshQuery.h"
+#include "DetourTileCache.h"
+#include "DetourObstacleAvoidance.h"
+
+#include <wfmath/MersenneTwister.h>
+#include <wfmath/rotbox.h>
+#include <wfmath/intersect.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <list>
+#include <vector>
+
+using namespace Ember::Navigation;
+
+namespace Ember
+{
+
+/**
+ * @brief Number of tiles along each side of the synthetic world.
+ */
+static const int TILES_PER_SIDE = 8;
+
+/**
+ * @brief The default number of entities per hectare (100 * 100 meters) for the harness tests.
+ *
+ * This can be overridden with the NAVIGATION_BENCHMARK_DENSITY environment variable.
+ */
+static const size_t DEFAULT_ENTITY_DENSITY = 400;
+
+/**
+ * @brief Provides rolling hills, with the same data layout as the terrain handler.
+ */
+class SyntheticHeightProvider: public IHeightProvider
+{
+public:
+
+	static float heightAt(float x, float y)
+	{
+		return std::sin(x * 0.1f) * 3.0f + std::cos(y * 0.07f) * 2.0f;
+	}
+
+	virtual bool getHeight(const TerrainPosition& atPosition, float& height) const
+	{
+		height = heightAt(atPosition.x(), atPosition.y());
+		return true;
+	}
+
+	virtual void blitHeights(int xMin, int xMax, int yMin, int yMax, std::vector<float>& heights) const
+	{
+		heights.resize((xMax - xMin) * (yMax - yMin));
+		size_t i = 0;
+		for (int y = yMin; y < yMax; ++y) {
+			for (int x = xMin; x < xMax; ++x) {
+				heights[i++] = heightAt(x, y);
+			}
+		}
+	}
+};
+
+/**
+ * @brief Sets up a Recast configuration matching the one used by the Awareness for an avatar with a radius of 0.4 meters.
+ */
+class NavigationSetup
+{
+public:
+	rcConfig cfg;
+	float tileWorldSize;
+
+	NavigationSetup()
+	{
+		memset(&cfg, 0, sizeof(cfg));
+		cfg.cs = 0.2f;
+		cfg.ch = cfg.cs / 2.0f;
+		cfg.walkableHeight = std::ceil(2.0f / cfg.ch);
+		cfg.walkableClimb = 100;
+		cfg.walkableRadius = 2;
+		cfg.walkableSlopeAngle = 70;
+		cfg.maxEdgeLen = cfg.walkableRadius * 8.0f;
+		cfg.maxSimplificationError = 1.3f;
+		cfg.minRegionArea = 8 * 8;
+		cfg.mergeRegionArea = 20 * 20;
+		cfg.tileSize = 64;
+		cfg.borderSize = cfg.walkableRadius + 3;
+		cfg.width = cfg.tileSize + cfg.borderSize * 2;
+		cfg.height = cfg.tileSize + cfg.borderSize * 2;
+		cfg.bmin[0] = 0;
+		cfg.bmin[1] = -500;
+		cfg.bmin[2] = 0;
+		tileWorldSize = cfg.tileSize * cfg.cs;
+		cfg.bmax[0] = TILES_PER_SIDE * tileWorldSize;
+		cfg.bmax[1] = 500;
+		cfg.bmax[2] = TILES_PER_SIDE * tileWorldSize;
+	}
+
+	WFMath::AxisBox<2> tileArea(int tx, int ty) const
+	{
+		return WFMath::AxisBox<2>(WFMath::Point<2>(cfg.bmin[0] + tx * tileWorldSize, cfg.bmin[2] + ty * tileWorldSize), WFMath::Point<2>(cfg.bmin[0] + (tx + 1) * tileWorldSize, cfg.bmin[2] + (ty + 1) * tileWorldSize));
+	}
+
+	/**
+	 * @brief Fills in the build data for a tile the same way as Awareness::prepareTileBuild.
+	 */
+	void prepareTile(int tx, int ty, TileBuildData& data, const IHeightProvider& heightProvider) const
+	{
+		Awareness::prepareTileBounds(cfg, tx, ty, data);
+		heightProvider.blitHeights(data.heightsXMin, data.heightsXMax, data.heightsYMin, data.heightsYMax, data.heights);
+	}
+};
+
+/**
+ * @brief Creates randomly placed and rotated entity areas, between one and four meters wide.
+ */
+static std::vector<WFMath::RotBox<2>> createAreas(size_t count, float worldSize)
+{
+	//Use a fixed seed so that all runs operate on the same entities.
+	WFMath::MTRand rng(4711);
+	std::vector<WFMath::RotBox<2>> areas;
+	for (size_t i = 0; i < count; ++i) {
+		WFMath::Vector<2> size(1.0f + rng.rand(3.0f), 1.0f + rng.rand(3.0f));
+		WFMath::RotMatrix<2> rm;
+		rm.rotation(rng.rand(6.28f));
+		WFMath::RotBox<2> rotbox(WFMath::Point<2>::ZERO(), size, WFMath::RotMatrix<2>().identity());
+		rotbox.rotatePoint(rm, WFMath::Point<2>::ZERO());
+		rotbox.shift(WFMath::Vector<2>(rng.rand(worldSize), rng.rand(worldSize)));
+		areas.push_back(rotbox);
+	}
+	return areas;
+}
+
+/**
+ * @brief A complete navigation setup, with a tile cache and navmesh configured in the same way as the Awareness does.
+ *
+ * The Awareness itself requires a connected Eris::View, so this mirrors its setup, and uses the static parts of the
+ * Awareness for preparing and rasterizing tiles and for finding paths.
+ */
+class NavigationWorld
+{
+public:
+	NavigationSetup setup;
+	SyntheticHeightProvider heightProvider;
+	LinearAllocator allocator;
+	FastLZCompressor compressor;
+	MeshProcess meshProcess;
+	dtTileCache* tileCache;
+	dtNavMesh* navMesh;
+	dtNavMeshQuery* navQuery;
+	dtQueryFilter filter;
+	AreaIndex<size_t> entityAreas;
+	LatencyStats rasterizeStats;
+
+	NavigationWorld(size_t entityCount) :
+			allocator(128000), tileCache(dtAllocTileCache()), navMesh(dtAllocNavMesh()), navQuery(dtAllocNavMeshQuery()), entityAreas(setup.tileWorldSize)
+	{
+		const int maxTiles = TILES_PER_SIDE * TILES_PER_SIDE * 4;
+
+		dtTileCacheParams tcparams;
+		memset(&tcparams, 0, sizeof(tcparams));
+		rcVcopy(tcparams.orig, setup.cfg.bmin);
+		tcparams.cs = setup.cfg.cs;
+		tcparams.ch = setup.cfg.ch;
+		tcparams.width = setup.cfg.tileSize;
+		tcparams.height = setup.cfg.tileSize;
+		tcparams.walkableHeight = 2.0f;
+		tcparams.walkableRadius = 0.4f;
+		tcparams.walkableClimb = setup.cfg.walkableClimb;
+		tcparams.maxTiles = maxTiles;
+		tcparams.maxObstacles = 1024;
+		CPPUNIT_ASSERT(dtStatusSucceed(tileCache->init(&tcparams, &allocator, &compressor, &meshProcess)));
+
+		dtNavMeshParams params;
+		memset(&params, 0, sizeof(params));
+		rcVcopy(params.orig, setup.cfg.bmin);
+		params.tileWidth = setup.tileWorldSize;
+		params.tileHeight = setup.tileWorldSize;
+		params.maxTiles = maxTiles;
+		params.maxPolys = 1 << 14;
+		CPPUNIT_ASSERT(dtStatusSucceed(navMesh->init(&params)));
+		CPPUNIT_ASSERT(dtStatusSucceed(navQuery->init(navMesh, 2048)));
+
+		filter.setIncludeFlags(0xFFFF);
+		filter.setExcludeFlags(0);
+		filter.setAreaCost(POLYAREA_GROUND, 1.0f);
+
+		auto areas = createAreas(entityCount, TILES_PER_SIDE * setup.tileWorldSize);
+		for (size_t i = 0; i < areas.size(); ++i) {
+			entityAreas.insert(i, areas[i]);
+		}
+	}
+
+	~NavigationWorld()
+	{
+		dtFreeNavMeshQuery(navQuery);
+		dtFreeNavMesh(navMesh);
+		dtFreeTileCache(tileCache);
+	}
+
+	/**
+	 * @brief Rasterizes all tiles and adds them to the tile cache and navmesh, the same way as Awareness::commitTile.
+	 */
+	void build()
+	{
+		rcContext ctx(false);
+		for (int tx = 0; tx < TILES_PER_SIDE; ++tx) {
+			for (int ty = 0; ty < TILES_PER_SIDE; ++ty) {
+				TileBuildData data;
+				entityAreas.query(setup.tileArea(tx, ty), data.entityAreas);
+				setup.prepareTile(tx, ty, data, heightProvider);
+
+				auto start = std::chrono::steady_clock::now();
+				data.ntiles = Awareness::rasterizeTileLayers(ctx, data);
+				rasterizeStats.add(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+
+				for (int j = 0; j < data.ntiles; ++j) {
+					TileCacheData* tile = &data.tiles[j];
+					if (dtStatusFailed(tileCache->addTile(tile->data, tile->dataSize, DT_COMPRESSEDTILE_FREE_DATA, 0))) {
+						dtFree(tile->data);
+					}
+					tile->data = 0;
+				}
+				tileCache->buildNavMeshTilesAt(tx, ty, navMesh);
+			}
+		}
+	}
+
+	/**
+	 * @brief Gets the total size of the compressed tile layers held by the tile cache.
+	 */
+	size_t getCompressedBytes() const
+	{
+		size_t bytes = 0;
+		for (int i = 0; i < tileCache->getTileCount(); ++i) {
+			const dtCompressedTile* tile = tileCache->getTile(i);
+			if (tile->header) {
+				bytes += tile->dataSize;
+			}
+		}
+		return bytes;
+	}
+
+	/**
+	 * @brief Gets the total size of the navmesh tiles.
+	 */
+	size_t getNavMeshBytes() const
+	{
+		const dtNavMesh* mesh = navMesh;
+		size_t bytes = 0;
+		for (int i = 0; i < mesh->getMaxTiles(); ++i) {
+			const dtMeshTile* tile = mesh->getTile(i);
+			if (tile->header) {
+				bytes += tile->dataSize;
+			}
+		}
+		return bytes;
+	}
+
+	/**
+	 * @brief Finds a path through Awareness::findPath.
+	 * @return The number of waypoints, or a negative value if no path could be found.
+	 */
+	int findPath(const WFMath::Point<3>& start, const WFMath::Point<3>& end)
+	{
+		std::list<WFMath::Point<3>> path;
+		return Awareness::findPath(*navQuery, filter, start, end, path);
+	}
+};
+
+/**
+ * @brief Gets the number of entities to use for the harness tests, from the configured density.
+ */
+static size_t getEntityCount(float worldSize)
+{
+	size_t density = DEFAULT_ENTITY_DENSITY;
+	const char* densityString = std::getenv("NAVIGATION_BENCHMARK_DENSITY");
+	if (densityString) {
+		density = std::strtoul(densityString, nullptr, 10);
+	}
+	return static_cast<size_t>(density * (worldSize * worldSize) / 10000.0f);
+}
+
+class NavigationBenchmarkCase: public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE( NavigationBenchmarkCase);
+	CPPUNIT_TEST( testAreaIndex);
+	CPPUNIT_TEST( testTilePruning);
+	CPPUNIT_TEST( testTileRebuild);
+	CPPUNIT_TEST( testWorld);
+	CPPUNIT_TEST( testObstacleAvoidance);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+
+	/**
+	 * @brief Checks that the area index finds the same areas as a linear scan, also after areas have been moved and removed.
+	 */
+	void testAreaIndex()
+	{
+		NavigationSetup setup;
+		auto areas = createAreas(2000, TILES_PER_SIDE * setup.tileWorldSize);
+		AreaIndex<size_t> index(setup.tileWorldSize);
+		for (size_t i = 0; i < areas.size(); ++i) {
+			CPPUNIT_ASSERT(index.insert(i, areas[i]));
+		}
+		//Move every third area and remove every seventh.
+		for (size_t i = 0; i < areas.size(); i += 3) {
+			areas[i].shift(WFMath::Vector<2>(5.0f, -3.0f));
+			CPPUNIT_ASSERT(!index.insert(i, areas[i]));
+		}
+		std::vector<bool> removed(areas.size(), false);
+		for (size_t i = 0; i < areas.size(); i += 7) {
+			CPPUNIT_ASSERT(index.erase(i));
+			removed[i] = true;
+		}
+		CPPUNIT_ASSERT(!index.erase(0));
+		CPPUNIT_ASSERT(index.find(0) == nullptr);
+		CPPUNIT_ASSERT(index.find(1) != nullptr);
+
+		for (int tx = 0; tx < TILES_PER_SIDE; ++tx) {
+			for (int ty = 0; ty < TILES_PER_SIDE; ++ty) {
+				auto extent = setup.tileArea(tx, ty);
+				size_t expected = 0;
+				for (size_t i = 0; i < areas.size(); ++i) {
+					if (!removed[i] && (WFMath::Contains(extent, areas[i], false) || WFMath::Intersect(extent, areas[i], false))) {
+						expected++;
+					}
+				}
+				std::vector<WFMath::RotBox<2>> found;
+				index.query(extent, found);
+				CPPUNIT_ASSERT_EQUAL(expected, found.size());
+			}
+		}
+	}
+
+	/**
+	 * @brief Checks that tiles being built aren't pruned or forgotten, and that they can be pruned once committed.
+	 */
+	void testTilePruning()
+	{
+		typedef TileMemoryTracker::TileIndex TileIndex;
+		TileMemoryTracker tracker(1000);
+		TileIndex built(0, 0), inFlight(1, 0), unbuilt(2, 0);
+
+		tracker.touch(inFlight);
+		tracker.touch(unbuilt);
+		tracker.setTileMemory(built, 800);
+		CPPUNIT_ASSERT_EQUAL(size_t(3), tracker.getTileCount());
+		CPPUNIT_ASSERT(!tracker.isOverBudget());
+
+		//Prune while the tile is being built, after it has left the awareness area.
+		std::vector<TileIndex> candidates;
+		tracker.collectPruneCandidates(10, [&](const TileIndex& index) {return index == inFlight;}, candidates);
+		CPPUNIT_ASSERT_EQUAL(size_t(1), candidates.size());
+		CPPUNIT_ASSERT(candidates[0] == built);
+		//The unbuilt tile has nothing to remove, and is dropped from the list.
+		CPPUNIT_ASSERT_EQUAL(size_t(2), tracker.getTileCount());
+
+		tracker.removeTile(built);
+		CPPUNIT_ASSERT_EQUAL(size_t(0), tracker.getUsage());
+		CPPUNIT_ASSERT_EQUAL(size_t(1), tracker.getTileCount());
+
+		//The build finishes and the tile is committed; it must still be possible to prune it.
+		tracker.setTileMemory(inFlight, 1200);
+		CPPUNIT_ASSERT(tracker.isOverBudget());
+		candidates.clear();
+		tracker.collectPruneCandidates(10, [](const TileIndex&) {return false;}, candidates);
+		CPPUNIT_ASSERT_EQUAL(size_t(1), candidates.size());
+		CPPUNIT_ASSERT(candidates[0] == inFlight);
+		tracker.removeTile(inFlight);
+		CPPUNIT_ASSERT_EQUAL(size_t(0), tracker.getUsage());
+		CPPUNIT_ASSERT_EQUAL(size_t(0), tracker.getTileCount());
+
+		//Even if a tile is dropped from the list before it has been built, it is added again when committed.
+		tracker.touch(unbuilt);
+		candidates.clear();
+		tracker.collectPruneCandidates(10, [](const TileIndex&) {return false;}, candidates);
+		CPPUNIT_ASSERT_EQUAL(size_t(0), tracker.getTileCount());
+		tracker.setTileMemory(unbuilt, 2000);
+		CPPUNIT_ASSERT_EQUAL(size_t(1), tracker.getTileCount());
+		candidates.clear();
+		tracker.collectPruneCandidates(10, [](const TileIndex&) {return false;}, candidates);
+		CPPUNIT_ASSERT_EQUAL(size_t(1), candidates.size());
+	}
+
+	/**
+	 * @brief Measures the time to find the entities for, and rasterize, every tile in the world for an increasing number of entities.
+	 *
+	 * The entity lookup is measured both with a linear scan of all entities, as was done before, and with the area index.
+	 */
+	void testTileRebuild()
+	{
+		NavigationSetup setup;
+		SyntheticHeightProvider heightProvider;
+		rcContext ctx(false);
+		size_t tileCount = TILES_PER_SIDE * TILES_PER_SIDE;
+
+		std::cout << std::endl << "Tile rebuild time per tile, " << tileCount << " tiles:" << std::endl;
+		std::cout << std::setw(10) << "entities" << std::setw(16) << "linear (us)" << std::setw(16) << "index (us)" << std::setw(18) << "rasterize (us)" << std::setw(14) << "total (us)" << std::endl;
+
+		size_t counts[] = { 0, 100, 1000, 5000, 20000 };
+		for (size_t count : counts) {
+			auto areas = createAreas(count, TILES_PER_SIDE * setup.tileWorldSize);
+			AreaIndex<size_t> index(setup.tileWorldSize);
+			for (size_t i = 0; i < areas.size(); ++i) {
+				index.insert(i, areas[i]);
+			}
+
+			double linearMicroseconds = 0;
+			double indexMicroseconds = 0;
+			double rasterizeMicroseconds = 0;
+			for (int tx = 0; tx < TILES_PER_SIDE; ++tx) {
+				for (int ty = 0; ty < TILES_PER_SIDE; ++ty) {
+					auto extent = setup.tileArea(tx, ty);
+
+					auto start = std::chrono::steady_clock::now();
+					std::vector<WFMath::RotBox<2>> linearAreas;
+					for (auto& rotbox : areas) {
+						if (WFMath::Contains(extent, rotbox, false) || WFMath::Intersect(extent, rotbox, false)) {
+							linearAreas.push_back(rotbox);
+						}
+					}
+					linearMicroseconds += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+					TileBuildData data;
+					start = std::chrono::steady_clock::now();
+					index.query(extent, data.entityAreas);
+					indexMicroseconds += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+					CPPUNIT_ASSERT_EQUAL(linearAreas.size(), data.entityAreas.size());
+
+					setup.prepareTile(tx, ty, data, heightProvider);
+					start = std::chrono::steady_clock::now();
+					data.ntiles = Awareness::rasterizeTileLayers(ctx, data);
+					rasterizeMicroseconds += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+					CPPUNIT_ASSERT(data.ntiles > 0);
+				}
+			}
+
+			std::cout << std::setw(10) << count << std::fixed << std::setprecision(1) << std::setw(16) << (linearMicroseconds / tileCount) << std::setw(16) << (indexMicroseconds / tileCount) << std::setw(18) << (rasterizeMicroseconds / tileCount) << std::setw(14)
+					<< ((indexMicroseconds + rasterizeMicroseconds) / tileCount) << std::endl;
+		}
+	}
+
+	/**
+	 * @brief Builds a whole world at the configured entity density, and measures rasterization, memory use and path finding.
+	 */
+	void testWorld()
+	{
+		size_t entityCount = getEntityCount(TILES_PER_SIDE * NavigationSetup().tileWorldSize);
+		NavigationWorld world(entityCount);
+		world.build();
+
+		std::cout << std::endl << "Navigation world: " << (TILES_PER_SIDE * TILES_PER_SIDE) << " tiles, " << entityCount << " entities" << std::endl;
+		world.rasterizeStats.print("tile rasterization");
+		std::cout << "  compressed tile layers: " << world.getCompressedBytes() << " bytes" << std::endl;
+		std::cout << "  navmesh tiles:          " << world.getNavMeshBytes() << " bytes" << std::endl;
+		CPPUNIT_ASSERT(world.getCompressedBytes() > 0);
+		CPPUNIT_ASSERT(world.getNavMeshBytes() > 0);
+
+		//Use a fixed seed so that all runs search for the same paths.
+		WFMath::MTRand rng(1234);
+		float worldSize = TILES_PER_SIDE * world.setup.tileWorldSize;
+		LatencyStats pathStats;
+		size_t pathsFound = 0;
+		for (int i = 0; i < 500; ++i) {
+			float startX = rng.rand(worldSize), startY = rng.rand(worldSize);
+			float endX = rng.rand(worldSize), endY = rng.rand(worldSize);
+			WFMath::Point<3> startPos(startX, startY, SyntheticHeightProvider::heightAt(startX, startY));
+			WFMath::Point<3> endPos(endX, endY, SyntheticHeightProvider::heightAt(endX, endY));
+
+			auto start = std::chrono::steady_clock::now();
+			int result = world.findPath(startPos, endPos);
+			pathStats.add(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+			if (result > 0) {
+				pathsFound++;
+			}
+		}
+		pathStats.print("findPath");
+		std::cout << "  paths found: " << pathsFound << " of " << pathStats.latencies.size() << std::endl;
+		CPPUNIT_ASSERT(pathsFound > 0);
+	}
+
+	/**
+	 * @brief Measures the cost of obstacle avoidance, with the same parameters as the Awareness uses.
+	 *
+	 * The batched sampler is compared with the Detour implementation, which it should give the same results as.
+	 */
+	void testObstacleAvoidance()
+	{
+		for (int circles : { 4, 16 }) {
+			measureObstacleAvoidance(circles);
+		}
+	}
+
+	void measureObstacleAvoidance(int maxCircles)
+	{
+		dtObstacleAvoidanceQuery* query = dtAllocObstacleAvoidanceQuery();
+		query->init(maxCircles, 0);
+		Navigation::ObstacleAvoidanceSampler sampler(maxCircles);
+
+		dtObstacleAvoidanceParams params;
+		params.velBias = 0.4f;
+		params.weightDesVel = 2.0f;
+		params.weightCurVel = 0.75f;
+		params.weightSide = 0.75f;
+		params.weightToi = 2.5f;
+		params.horizTime = 2.5f;
+		params.gridSize = 33;
+		params.adaptiveDivs = 7;
+		params.adaptiveRings = 2;
+		params.adaptiveDepth = 5;
+
+		WFMath::MTRand rng(4711);
+		LatencyStats stats;
+		LatencyStats samplerStats;
+		for (int i = 0; i < 2000; ++i) {
+			query->reset();
+			sampler.reset();
+			for (int j = 0; j < maxCircles; ++j) {
+				float pos[] { rng.rand(8.0f) - 4.0f, 0, rng.rand(8.0f) - 4.0f };
+				float vel[] { rng.rand(2.0f) - 1.0f, 0, rng.rand(2.0f) - 1.0f };
+				query->addCircle(pos, 0.5f, vel, vel);
+				sampler.addCircle(pos, 0.5f, vel);
+			}
+			float pos[] { 0, 0, 0 };
+			float vel[] { 5, 0, 0 };
+			float dvel[] { 5, 0, 0 };
+			float nvel[] { 0, 0, 0 };
+			float samplerNvel[] { 0, 0, 0 };
+
+			auto start = std::chrono::steady_clock::now();
+			int samples = query->sampleVelocityAdaptive(pos, 0.4f, 5.0f, vel, dvel, nvel, &params, nullptr);
+			stats.add(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+			CPPUNIT_ASSERT(samples > 0);
+
+			start = std::chrono::steady_clock::now();
+			int samplerSamples = sampler.sampleVelocityAdaptive(pos, 0.4f, 5.0f, vel, dvel, samplerNvel, params);
+			samplerStats.add(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+			CPPUNIT_ASSERT_EQUAL(samples, samplerSamples);
+			CPPUNIT_ASSERT_DOUBLES_EQUAL(nvel[0], samplerNvel[0], 0.001);
+			CPPUNIT_ASSERT_DOUBLES_EQUAL(nvel[2], samplerNvel[2], 0.001);
+		}
+		dtFreeObstacleAvoidanceQuery(query);
+
+		std::cout << std::endl << "Obstacle avoidance with " << maxCircles << " obstacles:" << std::endl;
+		stats.print("dtObstacleAvoidanceQuery");
+		samplerStats.print("ObstacleAvoidanceSampler");
+	}
+};
+
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION( Ember::NavigationBenchmarkCase);
+
+int main(int argc, char **argv)
+{
+	CppUnit::TextUi::TestRunner runner;
+	CppUnit::TestFactoryRegistry &registry = CppUnit::TestFactoryRegistry::getRegistry();
+	runner.addTest(registry.makeTest());
+
+	// Shows a message as each test starts
+	CppUnit::BriefTestProgressListener listener;
+	runner.eventManager().addListener(&listener);
+
+	bool wasSuccessful = runner.run("", false);
+	return !wasSuccessful;
+}
@@ -0,0 +1,49 @@
+#ifndef BENCHMARKSTATS_H_
+#define BENCHMARKSTATS_H_
+
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+namespace Ember
+{
+
+/**
+ * @brief Collects latencies from a benchmark and prints percentiles.
+ */
+class LatencyStats
+{
+public:
+	std::vector<double> latencies;
+
+	void add(double microseconds)
+	{
+		latencies.push_back(microseconds);
+	}
+
+	size_t size() const
+	{
+		return latencies.size();
+	}
+
+	double percentile(double fraction)
+	{
+		if (latencies.empty()) {
+			return 0;
+		}
+		std::sort(latencies.begin(), latencies.end());
+		size_t index = std::min(latencies.size() - 1, static_cast<size_t>(fraction * latencies.size()));
+		return latencies[index];
+	}
+
+	void print(const std::string& name)
+	{
+		std::cout << "  " << name << " (us): p50 " << std::fixed << std::setprecision(1) << percentile(0.5) << ", p90 " << percentile(0.9) << ", p99 " << percentile(0.99) << ", max " << percentile(1.0) << " (" << latencies.size() << " samples)" << std::endl;
+	}
+};
+
+}
+
+#endif /* BENCHMARKSTATS_H_ */
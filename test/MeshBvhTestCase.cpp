@@ -0,0 +1,104 @@
+#include "MeshBvhTestCase.h"
+
+#include "components/ogre/MeshBvh.h"
+
+#include <wfmath/MersenneTwister.h>
+
+#include <vector>
+#include <cmath>
+
+using namespace Ember::OgreView;
+
+namespace Ember
+{
+
+/**
+ * Creates a rolling landscape of triangles, with a number of quads along each side.
+ */
+static void createLandscape(int quadsPerSide, std::vector<Ogre::Vector3>& vertices, std::vector<uint32_t>& indices)
+{
+	for (int y = 0; y <= quadsPerSide; ++y) {
+		for (int x = 0; x <= quadsPerSide; ++x) {
+			vertices.push_back(Ogre::Vector3(x, std::sin(x * 0.3f) * std::cos(y * 0.2f) * 3.0f, y));
+		}
+	}
+	for (int y = 0; y < quadsPerSide; ++y) {
+		for (int x = 0; x < quadsPerSide; ++x) {
+			uint32_t i = y * (quadsPerSide + 1) + x;
+			//Wound so that the triangles face upwards.
+			indices.push_back(i);
+			indices.push_back(i + quadsPerSide + 1);
+			indices.push_back(i + 1);
+			indices.push_back(i + 1);
+			indices.push_back(i + quadsPerSide + 1);
+			indices.push_back(i + quadsPerSide + 2);
+		}
+	}
+}
+
+void MeshBvhTestCase::testMatchesBruteForce()
+{
+	std::vector<Ogre::Vector3> vertices;
+	std::vector<uint32_t> indices;
+	createLandscape(64, vertices, indices);
+
+	MeshBvh bvh(vertices, indices);
+	CPPUNIT_ASSERT_EQUAL(indices.size() / 3, bvh.getTriangleCount());
+	CPPUNIT_ASSERT(bvh.getNodeCount() > 1);
+
+	WFMath::MTRand rng(4711);
+	int hits = 0;
+	for (int i = 0; i < 1000; ++i) {
+		Ogre::Vector3 origin(rng.rand(80.0f) - 8.0f, 10.0f + rng.rand(10.0f), rng.rand(80.0f) - 8.0f);
+		Ogre::Vector3 target(rng.rand(64.0f), -5.0f, rng.rand(64.0f));
+		//Use an unnormalized direction, as that's what transformed rays have.
+		Ogre::Ray ray(origin, (target - origin) * 0.5f);
+
+		std::pair<bool, Ogre::Real> expected(false, 0);
+		for (size_t j = 0; j < indices.size(); j += 3) {
+			std::pair<bool, Ogre::Real> hit = Ogre::Math::intersects(ray, vertices[indices[j]], vertices[indices[j + 1]], vertices[indices[j + 2]], true, false);
+			if (hit.first && (!expected.first || hit.second < expected.second)) {
+				expected = hit;
+			}
+		}
+
+		std::pair<bool, Ogre::Real> actual = bvh.intersects(ray);
+		CPPUNIT_ASSERT_EQUAL(expected.first, actual.first);
+		if (expected.first) {
+			CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.second, actual.second, 0.0001);
+			hits++;
+		}
+	}
+	CPPUNIT_ASSERT(hits > 0);
+}
+
+void MeshBvhTestCase::testFacing()
+{
+	std::vector<Ogre::Vector3> vertices;
+	std::vector<uint32_t> indices;
+	createLandscape(4, vertices, indices);
+	MeshBvh bvh(vertices, indices);
+
+	Ogre::Ray down(Ogre::Vector3(2.5f, 10.0f, 2.5f), Ogre::Vector3::NEGATIVE_UNIT_Y);
+	Ogre::Ray up(Ogre::Vector3(2.5f, -10.0f, 2.5f), Ogre::Vector3::UNIT_Y);
+
+	CPPUNIT_ASSERT(bvh.intersects(down, true, false).first);
+	CPPUNIT_ASSERT(!bvh.intersects(down, false, true).first);
+	CPPUNIT_ASSERT(!bvh.intersects(up, true, false).first);
+	CPPUNIT_ASSERT(bvh.intersects(up, false, true).first);
+
+	//Rays pointing away from the mesh should never hit.
+	Ogre::Ray away(Ogre::Vector3(2.5f, 10.0f, 2.5f), Ogre::Vector3::UNIT_Y);
+	CPPUNIT_ASSERT(!bvh.intersects(away, true, true).first);
+}
+
+void MeshBvhTestCase::testEmpty()
+{
+	std::vector<Ogre::Vector3> vertices;
+	std::vector<uint32_t> indices;
+	MeshBvh bvh(vertices, indices);
+	CPPUNIT_ASSERT_EQUAL(size_t(0), bvh.getTriangleCount());
+	CPPUNIT_ASSERT(!bvh.intersects(Ogre::Ray(Ogre::Vector3::ZERO, Ogre::Vector3::UNIT_X)).first);
+}
+
+}
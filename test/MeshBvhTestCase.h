@@ -0,0 +1,16 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace Ember {
+	class MeshBvhTestCase : public CppUnit::TestFixture {
+		CPPUNIT_TEST_SUITE(MeshBvhTestCase);
+		CPPUNIT_TEST(testMatchesBruteForce);
+		CPPUNIT_TEST(testFacing);
+		CPPUNIT_TEST(testEmpty);
+		CPPUNIT_TEST_SUITE_END();
+
+	public:
+		void testMatchesBruteForce();
+		void testFacing();
+		void testEmpty();
+	};
+}
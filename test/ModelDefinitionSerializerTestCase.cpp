@@ -0,0 +1,153 @@
+#include "ModelDefinitionSerializerTestCase.h"
+
+#include "components/ogre/model/ModelDefinition.h"
+#include "components/ogre/model/BinaryModelDefinitionSerializer.h"
+
+using namespace Ember::OgreView::Model;
+
+namespace Ember
+{
+
+/**
+ * Populates a definition with at least one of each kind of element.
+ */
+static void populateDefinition(ModelDefinition& modelDef)
+{
+	modelDef.setScale(2.5f);
+	modelDef.setUseScaleOf(ModelDefinition::MODEL_HEIGHT);
+	modelDef.setRenderingDistance(120.0f);
+	modelDef.setTranslate(Ogre::Vector3(1, 2, 3));
+	modelDef.setRotation(Ogre::Quaternion(Ogre::Degree(90), Ogre::Vector3::UNIT_Y));
+	modelDef.setContentOffset(Ogre::Vector3(0, 0.5f, 0));
+	modelDef.setShowContained(false);
+
+	SubModelDefinition* subModelDef = modelDef.createSubModelDefinition("body.mesh");
+	PartDefinition* partDef = subModelDef->createPartDefinition("main");
+	partDef->setShow(true);
+	partDef->setGroup("body");
+	partDef->createSubEntityDefinition("skin")->setMaterialName("skin/material");
+	partDef->createSubEntityDefinition(3)->setMaterialName("eyes/material");
+
+	ActionDefinition* actionDef = modelDef.createActionDefinition("walk");
+	actionDef->setAnimationSpeed(1.5f);
+	AnimationDefinition* animDef = actionDef->createAnimationDefinition(2);
+	AnimationPartDefinition* animPartDef = animDef->createAnimationPartDefinition("Walk");
+	BoneGroupRefDefinition boneGroupRef;
+	boneGroupRef.Name = "legs";
+	boneGroupRef.Weight = 0.75f;
+	animPartDef->BoneGroupRefs.push_back(boneGroupRef);
+	actionDef->createSoundDefinition("footsteps", 2);
+	actionDef->createActivationDefinition(ActivationDefinition::MOVEMENT, "walk");
+
+	AttachPointDefinition attachPointDef;
+	attachPointDef.Name = "right_hand";
+	attachPointDef.BoneName = "hand.R";
+	attachPointDef.Pose = "hold";
+	attachPointDef.Rotation = Ogre::Quaternion::IDENTITY;
+	attachPointDef.Translation = Ogre::Vector3(0.1f, 0, 0);
+	modelDef.addAttachPointDefinition(attachPointDef);
+
+	ViewDefinition* viewDef = modelDef.createViewDefinition("front");
+	viewDef->Rotation = Ogre::Quaternion::IDENTITY;
+	viewDef->Distance = 4.0f;
+
+	BoneGroupDefinition* boneGroupDef = modelDef.createBoneGroupDefinition("legs");
+	boneGroupDef->Bones.push_back(4);
+	boneGroupDef->Bones.push_back(5);
+
+	PoseDefinition poseDef;
+	poseDef.Rotate = Ogre::Quaternion::IDENTITY;
+	poseDef.Translate = Ogre::Vector3(0, 1, 0);
+	poseDef.IgnoreEntityData = true;
+	modelDef.addPoseDefinition("hold", poseDef);
+
+	ModelDefinition::ParticleSystemDefinition particleSystemDef;
+	particleSystemDef.Script = "fire";
+	particleSystemDef.Direction = Ogre::Vector3::UNIT_Y;
+	ModelDefinition::BindingDefinition binding;
+	binding.EmitterVar = "emission_rate";
+	binding.AtlasAttribute = "status";
+	particleSystemDef.Bindings.push_back(binding);
+	modelDef.addParticleSystemDefinition(particleSystemDef);
+
+	ModelDefinition::LightDefinition lightDef;
+	lightDef.type = Ogre::Light::LT_SPOTLIGHT;
+	lightDef.diffuseColour = Ogre::ColourValue(1, 0.5f, 0.25f);
+	lightDef.specularColour = Ogre::ColourValue(0.5f, 0.5f, 0.5f);
+	lightDef.range = 10;
+	lightDef.constant = 1;
+	lightDef.linear = 0.5f;
+	lightDef.quadratic = 0.25f;
+	lightDef.position = Ogre::Vector3(0, 2, 0);
+	modelDef.addLightDefinition(lightDef);
+
+	RenderingDefinition* renderingDef = modelDef.createRenderingDefinition("forest");
+	renderingDef->setParameter("density", "0.5");
+
+	modelDef.setIconPath("icons/model.png");
+}
+
+void ModelDefinitionSerializerTestCase::testRoundTrip()
+{
+	ModelDefinition original(0, "original", 1, "");
+	populateDefinition(original);
+
+	BinaryModelDefinitionSerializer serializer;
+	std::string data = serializer.serialize(original);
+
+	ModelDefinition copy(0, "copy", 2, "");
+	CPPUNIT_ASSERT(serializer.deserialize(copy, data));
+
+	//Serializing the copy should produce the very same data.
+	CPPUNIT_ASSERT(serializer.serialize(copy) == data);
+
+	CPPUNIT_ASSERT_EQUAL(2.5f, static_cast<float>(copy.getScale()));
+	CPPUNIT_ASSERT_EQUAL(ModelDefinition::MODEL_HEIGHT, copy.getUseScaleOf());
+	CPPUNIT_ASSERT(!copy.getShowContained());
+	CPPUNIT_ASSERT_EQUAL(size_t(1), copy.getSubModelDefinitions().size());
+	const PartDefinition* partDef = copy.getSubModelDefinitions().front()->getPartDefinitions().front();
+	CPPUNIT_ASSERT_EQUAL(std::string("body"), partDef->getGroup());
+	CPPUNIT_ASSERT_EQUAL(size_t(2), partDef->getSubEntityDefinitions().size());
+	CPPUNIT_ASSERT_EQUAL(std::string("skin"), partDef->getSubEntityDefinitions()[0]->getSubEntityName());
+	CPPUNIT_ASSERT_EQUAL(3u, partDef->getSubEntityDefinitions()[1]->getSubEntityIndex());
+	CPPUNIT_ASSERT_EQUAL(std::string("walk"), copy.getActionDefinitions().front()->getName());
+	CPPUNIT_ASSERT_EQUAL(size_t(2), copy.getBoneGroupDefinitions().find("legs")->second->Bones.size());
+	CPPUNIT_ASSERT(copy.getPoseDefinitions().find("hold")->second.IgnoreEntityData);
+
+	CPPUNIT_ASSERT_EQUAL(size_t(1), copy.getParticleSystemDefinitions().size());
+	const ModelDefinition::ParticleSystemDefinition& particleSystemDef = copy.getParticleSystemDefinitions().front();
+	CPPUNIT_ASSERT_EQUAL(std::string("fire"), particleSystemDef.Script);
+	CPPUNIT_ASSERT(particleSystemDef.Direction == Ogre::Vector3::UNIT_Y);
+	CPPUNIT_ASSERT_EQUAL(size_t(1), particleSystemDef.Bindings.size());
+	CPPUNIT_ASSERT_EQUAL(std::string("emission_rate"), particleSystemDef.Bindings.front().EmitterVar);
+	CPPUNIT_ASSERT_EQUAL(std::string("status"), particleSystemDef.Bindings.front().AtlasAttribute);
+
+	CPPUNIT_ASSERT_EQUAL(size_t(1), copy.getLightDefinitions().size());
+	const ModelDefinition::LightDefinition& lightDef = copy.getLightDefinitions().front();
+	CPPUNIT_ASSERT(lightDef.type == Ogre::Light::LT_SPOTLIGHT);
+	CPPUNIT_ASSERT(lightDef.diffuseColour == Ogre::ColourValue(1, 0.5f, 0.25f));
+	CPPUNIT_ASSERT(lightDef.specularColour == Ogre::ColourValue(0.5f, 0.5f, 0.5f));
+	CPPUNIT_ASSERT_EQUAL(10.0f, static_cast<float>(lightDef.range));
+	CPPUNIT_ASSERT_EQUAL(0.25f, static_cast<float>(lightDef.quadratic));
+	CPPUNIT_ASSERT(lightDef.position == Ogre::Vector3(0, 2, 0));
+
+	CPPUNIT_ASSERT(copy.getRenderingDefinition());
+	CPPUNIT_ASSERT_EQUAL(std::string("forest"), copy.getRenderingDefinition()->getScheme());
+	CPPUNIT_ASSERT_EQUAL(std::string("0.5"), copy.getRenderingDefinition()->getParameters().find("density")->second);
+
+	CPPUNIT_ASSERT_EQUAL(std::string("icons/model.png"), copy.getIconPath());
+}
+
+void ModelDefinitionSerializerTestCase::testTruncated()
+{
+	ModelDefinition original(0, "original", 1, "");
+	populateDefinition(original);
+
+	BinaryModelDefinitionSerializer serializer;
+	std::string data = serializer.serialize(original);
+
+	ModelDefinition copy(0, "copy", 2, "");
+	CPPUNIT_ASSERT(!serializer.deserialize(copy, data.substr(0, data.size() / 2)));
+}
+
+}
@@ -0,0 +1,14 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace Ember {
+	class ModelDefinitionSerializerTestCase : public CppUnit::TestFixture {
+		CPPUNIT_TEST_SUITE(ModelDefinitionSerializerTestCase);
+		CPPUNIT_TEST(testRoundTrip);
+		CPPUNIT_TEST(testTruncated);
+		CPPUNIT_TEST_SUITE_END();
+
+	public:
+		void testRoundTrip();
+		void testTruncated();
+	};
+}
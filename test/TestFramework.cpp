@@ -7,6 +7,7 @@
 #include "framework/TinyXmlCodec.h"
 #include "framework/AtlasMessageLoader.h"
 #include "framework/tinyxml/tinyxml.h"
+#include "framework/Profiler.h"
 
 #include <Atlas/Objects/SmartPtr.h>
 #include <Atlas/Objects/Root.h>
@@ -24,6 +25,7 @@ class FrameworkTestCase: public CppUnit::TestFixture
 {
 CPPUNIT_TEST_SUITE(FrameworkTestCase);
 	CPPUNIT_TEST(testTinyXmlCodec);
+	CPPUNIT_TEST(testProfiler);
 
 	CPPUNIT_TEST_SUITE_END()
 	;
@@ -71,6 +73,51 @@ public:
 		}
 	}
 
+	void testProfiler()
+	{
+		Profiler::clear();
+		{
+			ProfileZone zone("disabled");
+		}
+		std::stringstream ssDisabled;
+		CPPUNIT_ASSERT(Profiler::writeChromeTrace(ssDisabled) == 0);
+
+		Profiler::setEnabled(true);
+		Profiler::setThreadName("Test");
+		{
+			ProfileZone outer("outer");
+			ProfileZone inner;
+			inner.start("inner \"quoted\"");
+		}
+		//Zones recorded after the buffer is full should replace the oldest ones.
+		boost::thread thread([]() {
+			for (size_t i = 0; i < Profiler::ZonesPerThread + 10; ++i) {
+				ProfileZone zone("worker");
+			}
+		});
+		thread.join();
+		Profiler::setEnabled(false);
+		{
+			ProfileZone zone("disabled");
+		}
+
+		std::stringstream ss;
+		CPPUNIT_ASSERT(Profiler::writeChromeTrace(ss) == 2 + Profiler::ZonesPerThread);
+		std::string trace = ss.str();
+		CPPUNIT_ASSERT(trace.find("\"name\":\"outer\",\"ph\":\"X\"") != std::string::npos);
+		CPPUNIT_ASSERT(trace.find("\"name\":\"inner \\\"quoted\\\"\"") != std::string::npos);
+		CPPUNIT_ASSERT(trace.find("\"args\":{\"name\":\"Test\"}") != std::string::npos);
+		CPPUNIT_ASSERT(trace.find("disabled") == std::string::npos);
+
+		Profiler::clear();
+		std::stringstream ssCleared;
+		CPPUNIT_ASSERT(Profiler::writeChromeTrace(ssCleared) == 0);
+		//The buffer of the worker thread should be gone, since the thread has exited.
+		std::string clearedTrace = ssCleared.str();
+		CPPUNIT_ASSERT(clearedTrace.find("\"args\":{\"name\":\"Test\"}") != std::string::npos);
+		CPPUNIT_ASSERT(clearedTrace.find("thread_name") == clearedTrace.rfind("thread_name"));
+	}
+
 };
 
 }
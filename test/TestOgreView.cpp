@@ -3,9 +3,13 @@
 
 #include "ConvertTestCase.h"
 #include "ModelMountTestCase.h"
+#include "MeshBvhTestCase.h"
+#include "ModelDefinitionSerializerTestCase.h"
 
 CPPUNIT_TEST_SUITE_REGISTRATION( Ember::ConvertTestCase);
 CPPUNIT_TEST_SUITE_REGISTRATION( Ember::ModelMountTestCase );
+CPPUNIT_TEST_SUITE_REGISTRATION( Ember::MeshBvhTestCase );
+CPPUNIT_TEST_SUITE_REGISTRATION( Ember::ModelDefinitionSerializerTestCase );
 
 int main(int argc, char **argv)
 {